@@ -0,0 +1,203 @@
+#include "vk.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Прогон сцены без окна и сводка времени кадра в JSON.
+// Код возврата: 0 - успех, 1 - ошибка (в том числе незаписанные кадры захвата), 2 - регрессия относительно базового отчёта
+//
+// VulkanBenchmark [--scene файл] [--frames N] [--warmup N] [--width W] [--height H]
+//                 [--output отчёт.json] [--baseline база.json] [--tolerance 0.1]
+//                 [--capture каталог] [--format png|exr] [--turntable]
+//
+// --capture сохраняет замеряемые кадры в каталог; --turntable делает из них полный оборот модели
+// с шагом анимации по номеру кадра (миниатюры и облёты ассетов)
+
+typedef struct _BenchmarkOptions
+{
+	std::string scene; // пусто - сцена по умолчанию
+	uint32_t frames = 500;
+	uint32_t warmup = 50; // кадры до начала замеров: загрузка кэшей, выход частот на рабочий режим
+	uint32_t width = 1920;
+	uint32_t height = 1080;
+	std::string output; // пусто - стандартный вывод
+	std::string baseline;
+	double tolerance = 0.1; // допустимый рост времени относительно базы
+	std::string capture; // пусто - без захвата кадров
+	CaptureFormat format = CaptureFormat::PNG;
+	bool turntable = false;
+} BenchmarkOptions;
+
+typedef struct _TimeSummary
+{
+	double minMs;
+	double avgMs;
+	double p99Ms;
+	double maxMs;
+} TimeSummary;
+
+static BenchmarkOptions parseOptions(int argc, char* argv[]) {
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--turntable") {
+			options.turntable = true;
+			continue;
+		}
+		if (i + 1 >= argc)
+			throw std::runtime_error("Missing value for " + arg);
+		const char* value = argv[++i];
+
+		if (arg == "--scene") options.scene = value;
+		else if (arg == "--frames") options.frames = std::max(1, std::atoi(value));
+		else if (arg == "--warmup") options.warmup = std::max(0, std::atoi(value));
+		else if (arg == "--width") options.width = std::max(1, std::atoi(value));
+		else if (arg == "--height") options.height = std::max(1, std::atoi(value));
+		else if (arg == "--output") options.output = value;
+		else if (arg == "--baseline") options.baseline = value;
+		else if (arg == "--tolerance") options.tolerance = std::atof(value);
+		else if (arg == "--capture") options.capture = value;
+		else if (arg == "--format") {
+			std::string format = value;
+			if (format == "png") options.format = CaptureFormat::PNG;
+			else if (format == "exr") options.format = CaptureFormat::EXR;
+			else throw std::runtime_error("Unknown capture format " + format);
+		}
+		else throw std::runtime_error("Unknown option " + arg);
+	}
+	return options;
+}
+
+static TimeSummary summarize(std::vector<double> samples) {
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (double ms : samples)
+		sum += ms;
+	return {samples.front(), sum / samples.size(),
+			samples[std::min(samples.size() - 1, static_cast<size_t>(samples.size() * 0.99))], samples.back()};
+}
+
+static void writeSummary(std::ostream& out, const char* prefix, const TimeSummary& summary) {
+	out << "\"" << prefix << "MinMs\":" << summary.minMs << ","
+		<< "\"" << prefix << "AvgMs\":" << summary.avgMs << ","
+		<< "\"" << prefix << "P99Ms\":" << summary.p99Ms << ","
+		<< "\"" << prefix << "MaxMs\":" << summary.maxMs;
+}
+
+// Значение числового ключа верхнего уровня отчёта; отрицательное - ключа нет
+static double readNumber(const std::string& json, const std::string& key) {
+	size_t position = json.find("\"" + key + "\":");
+	if (position == std::string::npos)
+		return -1.0;
+	return std::strtod(json.c_str() + position + key.size() + 3, nullptr);
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		BenchmarkOptions options = parseOptions(argc, argv);
+
+		Vulkan vulkan;
+		if (!options.scene.empty())
+			vulkan.setScene(loadSceneConfig(options.scene));
+		// Модель поворачивается на 90 градусов в секунду: оборот за 4 секунды анимации
+		if (options.turntable)
+			vulkan.setFixedTimeStep(4.0f / options.frames);
+		vulkan.initHeadless(options.width, options.height);
+
+		for (uint32_t i = 0; i < options.warmup; i++)
+			vulkan.renderFrame();
+		vulkan.resetGpuStatistics(options.frames);
+		if (!options.capture.empty())
+			vulkan.startCapture(options.capture, options.format);
+
+		std::vector<double> cpuSamples;
+		cpuSamples.reserve(options.frames);
+		for (uint32_t i = 0; i < options.frames; i++) {
+			auto start = std::chrono::steady_clock::now();
+			vulkan.renderFrame();
+			cpuSamples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		// Запись последних кадров не входит в замеры
+		uint32_t captured = options.capture.empty() ? 0 : vulkan.finishCapture();
+		uint32_t captureFailed = options.capture.empty() ? 0 : vulkan.failedCaptures();
+
+		// Замеры GPU читаются с задержкой на кадры в работе: последние кадры в сводку не попадают
+		std::vector<GpuScopeStatistics> gpuStats;
+		vulkan.gpuStatistics(gpuStats);
+		std::string device = vulkan.deviceName();
+		vulkan.destroy();
+
+		TimeSummary cpu = summarize(cpuSamples);
+		TimeSummary gpu = {0.0, 0.0, 0.0, 0.0};
+		for (auto& scope : gpuStats)
+			if (scope.name == "frame")
+				gpu = {scope.minMs, scope.avgMs, scope.p99Ms, scope.maxMs};
+
+		std::ostringstream report;
+		report << "{\"device\":\"" << device << "\","
+			   << "\"width\":" << options.width << ",\"height\":" << options.height << ","
+			   << "\"frames\":" << options.frames << ",\"captured\":" << captured
+			   << ",\"captureFailed\":" << captureFailed << ",";
+		writeSummary(report, "cpu", cpu);
+		report << ",";
+		writeSummary(report, "gpu", gpu);
+		report << ",\"scopes\":[";
+		for (size_t i = 0; i < gpuStats.size(); i++) {
+			const GpuScopeStatistics& scope = gpuStats[i];
+			report << (i ? "," : "") << "{\"name\":\"" << scope.name << "\",\"samples\":" << scope.samples << ",";
+			writeSummary(report, "", {scope.minMs, scope.avgMs, scope.p99Ms, scope.maxMs});
+			report << ",\"vertexInvocations\":" << scope.vertexInvocations
+				   << ",\"fragmentInvocations\":" << scope.fragmentInvocations
+				   << ",\"clippingPrimitives\":" << scope.clippingPrimitives << "}";
+		}
+		report << "]}\n";
+
+		if (options.output.empty()) {
+			std::cout << report.str();
+		} else {
+			std::ofstream file(options.output);
+			file << report.str();
+		}
+
+		// Отчёт записан и при неудачной записи кадров, но пакетный запуск должен её заметить
+		if (captureFailed > 0) {
+			std::cerr << "Capture failed: " << captureFailed << " of " << captured + captureFailed << " frames not written" << std::endl;
+			return 1;
+		}
+
+		// Сравнение с базой: среднее и 99-й процентиль CPU и GPU
+		if (!options.baseline.empty()) {
+			std::ifstream file(options.baseline);
+			if (!file.is_open())
+				throw std::runtime_error("Can't open baseline " + options.baseline);
+			std::stringstream buffer;
+			buffer << file.rdbuf();
+			std::string baseline = buffer.str();
+
+			const char* keys[] = {"cpuAvgMs", "cpuP99Ms", "gpuAvgMs", "gpuP99Ms"};
+			double values[] = {cpu.avgMs, cpu.p99Ms, gpu.avgMs, gpu.p99Ms};
+			bool regression = false;
+			for (int i = 0; i < 4; i++) {
+				double base = readNumber(baseline, keys[i]);
+				if (base <= 0.0)
+					continue;
+				if (values[i] > base * (1.0 + options.tolerance)) {
+					std::cerr << "Regression: " << keys[i] << " " << values[i] << " ms vs baseline " << base << " ms" << std::endl;
+					regression = true;
+				}
+			}
+			if (regression)
+				return 2;
+		}
+	} catch (const std::exception& e) {
+		std::cerr << "Benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include "LightClusters.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+// Замеры эталонного распределения источников по кластерам без GPU: время в одном потоке и в пуле,
+// заполнение и переполнение кластеров (как счётчик переполнений прохода GPU). Проверка: в случайных точках пирамиды видимости каждый источник,
+// который освещает точку, есть в списке её кластера (если список не переполнен); средняя длина
+// списка в точке - число итераций цикла фрагментного шейдера, она не растёт с общим числом
+// источников при той же плотности.
+// Код возврата: 0 - успех, 1 - ошибка или пропущенный источник
+//
+// LightClustersBenchmark [--lights N] [--samples N] [--iterations N] [--threads N] [--output отчёт.json]
+
+typedef struct _ClusterOptions
+{
+	uint32_t lights = 4096;
+	uint32_t samples = 100000;
+	uint32_t iterations = 20;
+	uint32_t threads = 0; // 0 - по числу ядер
+	std::string output; // пусто - стандартный вывод
+} ClusterOptions;
+
+static ClusterOptions parseOptions(int argc, char* argv[]) {
+	ClusterOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error("Missing value for " + arg);
+		const char* value = argv[++i];
+
+		if (arg == "--lights") options.lights = std::clamp(std::atoi(value), 1, static_cast<int>(MAX_LIGHTS));
+		else if (arg == "--samples") options.samples = std::max(1, std::atoi(value));
+		else if (arg == "--iterations") options.iterations = std::max(1, std::atoi(value));
+		else if (arg == "--threads") options.threads = std::max(0, std::atoi(value));
+		else if (arg == "--output") options.output = value;
+		else throw std::runtime_error("Unknown option " + arg);
+	}
+	return options;
+}
+
+// Среднее время вызова в миллисекундах
+template<typename Function>
+static double measure(uint32_t iterations, Function function) {
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; i++)
+		function(i);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		ClusterOptions options = parseOptions(argc, argv);
+
+		WorkerPool pool;
+		pool.start(options.threads);
+
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.7f, 0.0f), glm::vec3(0.0f, 1.2f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+		proj[1][1] *= -1;
+		ClusterFrustum frustum = clusterFrustum(view, proj);
+
+		// Плотность источников постоянна: площадь растёт с их числом
+		float side = 10.0f * std::sqrt(static_cast<float>(options.lights) / 64.0f);
+		std::vector<Light> lights;
+		generateLights(options.lights, glm::vec3(-side, 0.5f, -2.0f * side), glm::vec3(side, 4.0f, 2.0f), 1, lights);
+
+		std::vector<LightCluster> clusters;
+		std::vector<uint32_t> indices;
+		uint32_t overflowedClusters = 0;
+		double singleMs = measure(options.iterations, [&](uint32_t) { overflowedClusters = assignLights(lights, frustum, clusters, indices); });
+		double pooledMs = measure(options.iterations, [&](uint32_t) { assignLights(lights, frustum, clusters, indices, &pool); });
+
+		uint32_t usedClusters = 0, longest = 0;
+		for (const LightCluster& cluster : clusters) {
+			usedClusters += cluster.count > 0 ? 1 : 0;
+			longest = std::max(longest, cluster.count);
+		}
+
+		// Точки равномерно по NDC, глубина - равномерно по логарифму, как срезы
+		glm::mat4 inverseView = glm::inverse(view);
+		std::mt19937 random(2);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		uint64_t listLength = 0, reaching = 0;
+		uint32_t missed = 0, truncated = 0;
+		for (uint32_t s = 0; s < options.samples; s++) {
+			float depth = frustum.znear * std::pow(frustum.zfar / frustum.znear, unit(random));
+			glm::vec2 ndc(unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f);
+			glm::vec3 point = glm::vec3(inverseView * glm::vec4(ndc.x * depth / frustum.p00, ndc.y * depth / frustum.p11, -depth, 1.0f));
+
+			uint32_t index = clusterIndex(point, frustum);
+			if (index == UINT32_MAX)
+				continue;
+			const LightCluster& cluster = clusters[index];
+			listLength += cluster.count;
+
+			for (uint32_t i = 0; i < lights.size(); i++) {
+				if (!lightReaches(lights[i], point))
+					continue;
+				reaching++;
+				const uint32_t* begin = indices.data() + cluster.offset;
+				if (std::find(begin, begin + cluster.count, i) == begin + cluster.count) {
+					if (cluster.count >= CLUSTER_MAX_LIGHTS)
+						truncated++;
+					else
+						missed++;
+				}
+			}
+		}
+
+		std::ostringstream report;
+		report << "{\"threads\":" << pool.size() << ",\"lights\":" << options.lights
+			   << ",\"clusters\":" << CLUSTER_COUNT << ",\"usedClusters\":" << usedClusters
+			   << ",\"overflowedClusters\":" << overflowedClusters << ",\"longestList\":" << longest
+			   << ",\"indices\":" << indices.size()
+			   << ",\"singleMs\":" << singleMs << ",\"pooledMs\":" << pooledMs
+			   << ",\"samples\":" << options.samples
+			   << ",\"lightsPerSample\":" << static_cast<double>(listLength) / options.samples
+			   << ",\"reachingPerSample\":" << static_cast<double>(reaching) / options.samples
+			   << ",\"truncated\":" << truncated << ",\"missed\":" << missed << "}";
+
+		if (options.output.empty()) {
+			std::cout << report.str() << std::endl;
+		} else {
+			std::ofstream file(options.output);
+			file << report.str() << std::endl;
+		}
+
+		pool.stop();
+		return missed == 0 ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cerr << "Light clusters benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,243 @@
+#include "OcclusionRasterizer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+// Замеры программного растеризатора заслонок без GPU: треугольников в миллисекунду в одном
+// потоке и в пуле, проверок AABB в миллисекунду. Буфер сверяется с попиксельным эталоном:
+// граница пикселя не ближе эталонной глубины, покрытые пиксели совпадают, и ни один
+// объект, видимый по эталону, не отсекается.
+// Код возврата: 0 - успех, 1 - ошибка или расхождение с эталоном
+//
+// OcclusionRasterizerBenchmark [--triangles N] [--objects N] [--iterations N] [--threads N]
+//                              [--width N] [--height N] [--output отчёт.json]
+
+typedef struct _OcclusionOptions
+{
+	uint32_t triangles = 2000; // заслонки - прямоугольники по два треугольника
+	uint32_t objects = 10000;
+	uint32_t iterations = 100;
+	uint32_t threads = 0; // 0 - по числу ядер
+	uint32_t width = 256;
+	uint32_t height = 128;
+	std::string output; // пусто - стандартный вывод
+} OcclusionOptions;
+
+static OcclusionOptions parseOptions(int argc, char* argv[]) {
+	OcclusionOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error("Missing value for " + arg);
+		const char* value = argv[++i];
+
+		if (arg == "--triangles") options.triangles = std::max(2, std::atoi(value));
+		else if (arg == "--objects") options.objects = std::max(1, std::atoi(value));
+		else if (arg == "--iterations") options.iterations = std::max(1, std::atoi(value));
+		else if (arg == "--threads") options.threads = std::max(0, std::atoi(value));
+		else if (arg == "--width") options.width = std::max(8, std::atoi(value));
+		else if (arg == "--height") options.height = std::max(4, std::atoi(value));
+		else if (arg == "--output") options.output = value;
+		else throw std::runtime_error("Unknown option " + arg);
+	}
+	return options;
+}
+
+// Среднее время вызова в миллисекундах
+template<typename Function>
+static double measure(uint32_t iterations, Function function) {
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; i++)
+		function(i);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// Попиксельный эталон: глубина плоскости ближайшего треугольника в центре пикселя.
+// Покрытие считается теми же выражениями и в том же порядке, что и в растеризаторе
+static void referenceDepth(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+						const glm::mat4& viewProj, uint32_t width, uint32_t height, std::vector<float>& depth) {
+	depth.assign(width * height, FLT_MAX);
+	for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+		float x[3], y[3], z[3];
+		bool behind = false;
+		for (int i = 0; i < 3; i++) {
+			glm::vec4 clip = viewProj * glm::vec4(vertices[indices[t + i]], 1.0f);
+			if (clip.w <= 1e-5f)
+				behind = true;
+			float inverse = 1.0f / clip.w;
+			x[i] = (clip.x * inverse * 0.5f + 0.5f) * width;
+			y[i] = (clip.y * inverse * 0.5f + 0.5f) * height;
+			z[i] = clip.z * inverse;
+		}
+		float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (behind || std::fabs(area) < 1e-6f)
+			continue;
+		if (area < 0.0f) {
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(z[1], z[2]);
+			area = -area;
+		}
+
+		float a[3], b[3], c[3];
+		for (int i = 0; i < 3; i++) {
+			int j = (i + 1) % 3;
+			a[i] = y[i] - y[j];
+			b[i] = x[j] - x[i];
+			c[i] = -(a[i] * x[i] + b[i] * y[i]);
+		}
+		float depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+		float depthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+		float depthC = z[0] - depthA * x[0] - depthB * y[0];
+
+		for (uint32_t py = 0; py < height; py++) {
+			for (uint32_t px = 0; px < width; px++) {
+				float x0 = static_cast<float>(px / OCCLUSION_TILE_WIDTH * OCCLUSION_TILE_WIDTH);
+				float y0 = static_cast<float>(py / OCCLUSION_TILE_HEIGHT * OCCLUSION_TILE_HEIGHT);
+				float column = static_cast<float>(px % OCCLUSION_TILE_WIDTH) + 0.5f;
+				float row = static_cast<float>(py % OCCLUSION_TILE_HEIGHT) + 0.5f;
+				bool covered = true;
+				for (int e = 0; e < 3; e++)
+					covered = covered && (a[e] * x0 + b[e] * y0 + c[e] + a[e] * column) + b[e] * row >= 0.0f;
+				if (covered) {
+					float z = depthA * (px + 0.5f) + depthB * (py + 0.5f) + depthC;
+					depth[py * width + px] = std::min(depth[py * width + px], z);
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		OcclusionOptions options = parseOptions(argc, argv);
+		options.width = options.width / OCCLUSION_TILE_WIDTH * OCCLUSION_TILE_WIDTH;
+		options.height = options.height / OCCLUSION_TILE_HEIGHT * OCCLUSION_TILE_HEIGHT;
+
+		WorkerPool pool;
+		pool.start(options.threads);
+
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.7f, 0.0f), glm::vec3(0.0f, 1.7f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 proj = glm::perspective(glm::radians(45.0f), 2.0f, 0.1f, 500.0f);
+		proj[1][1] *= -1;
+		glm::mat4 viewProj = proj * view;
+
+		// Заслонки - стены со случайным поворотом вокруг Y перед камерой
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<glm::vec3> vertices;
+		std::vector<uint32_t> indices;
+		for (uint32_t i = 0; i < options.triangles / 2; i++) {
+			glm::vec3 center((unit(random) - 0.5f) * 120.0f, 0.0f, -5.0f - unit(random) * 150.0f);
+			float angle = unit(random) * glm::pi<float>();
+			glm::vec3 along = glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * (1.0f + unit(random) * 6.0f);
+			float height = 1.0f + unit(random) * 8.0f;
+			uint32_t base = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(center - along);
+			vertices.push_back(center + along);
+			vertices.push_back(center + along + glm::vec3(0.0f, height, 0.0f));
+			vertices.push_back(center - along + glm::vec3(0.0f, height, 0.0f));
+			indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+		}
+
+		// Объекты - кубы со стороной 1 м по той же области
+		std::vector<glm::vec3> objects(options.objects);
+		for (glm::vec3& object : objects)
+			object = glm::vec3((unit(random) - 0.5f) * 120.0f, 0.0f, -5.0f - unit(random) * 150.0f);
+
+		OcclusionRasterizer rasterizer;
+		rasterizer.resize(options.width, options.height);
+		uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+		double singleMs = measure(options.iterations, [&](uint32_t) {
+			rasterizer.clear();
+			rasterizer.render(vertices, indices, viewProj);
+		});
+		double pooledMs = measure(options.iterations, [&](uint32_t) {
+			rasterizer.clear();
+			rasterizer.render(vertices, indices, viewProj, &pool);
+		});
+
+		uint32_t visibleCount = 0;
+		double testMs = measure(options.iterations, [&](uint32_t) {
+			visibleCount = 0;
+			for (const glm::vec3& object : objects)
+				visibleCount += rasterizer.visible(object - glm::vec3(0.5f, 0.0f, 0.5f), object + glm::vec3(0.5f, 1.0f, 0.5f), viewProj) ? 1 : 0;
+		});
+
+		// Сверка с эталоном
+		std::vector<float> reference;
+		referenceDepth(vertices, indices, viewProj, options.width, options.height, reference);
+		uint32_t depthErrors = 0, coverageErrors = 0;
+		for (uint32_t y = 0; y < options.height; y++) {
+			for (uint32_t x = 0; x < options.width; x++) {
+				float expected = reference[y * options.width + x];
+				float actual = rasterizer.depth(x, y);
+				if ((expected == FLT_MAX) != (actual == FLT_MAX))
+					coverageErrors++;
+				else if (actual < expected)
+					depthErrors++;
+			}
+		}
+
+		// Объект, отсечённый растеризатором, должен быть за эталонной глубиной во всех пикселях своего прямоугольника
+		uint32_t falseOcclusions = 0;
+		for (const glm::vec3& object : objects) {
+			glm::vec3 low = object - glm::vec3(0.5f, 0.0f, 0.5f), high = object + glm::vec3(0.5f, 1.0f, 0.5f);
+			if (rasterizer.visible(low, high, viewProj))
+				continue;
+
+			float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+			for (int i = 0; i < 8; i++) {
+				glm::vec4 clip = viewProj * glm::vec4((i & 1) ? high.x : low.x, (i & 2) ? high.y : low.y, (i & 4) ? high.z : low.z, 1.0f);
+				float x = (clip.x / clip.w * 0.5f + 0.5f) * options.width, y = (clip.y / clip.w * 0.5f + 0.5f) * options.height;
+				minX = std::min(minX, x); maxX = std::max(maxX, x);
+				minY = std::min(minY, y); maxY = std::max(maxY, y);
+				nearest = std::min(nearest, clip.z / clip.w);
+			}
+			int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(minX)));
+			int32_t x1 = std::min(static_cast<int32_t>(options.width) - 1, static_cast<int32_t>(std::ceil(maxX)) - 1);
+			int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(minY)));
+			int32_t y1 = std::min(static_cast<int32_t>(options.height) - 1, static_cast<int32_t>(std::ceil(maxY)) - 1);
+			bool seen = false;
+			for (int32_t y = y0; y <= y1 && !seen; y++)
+				for (int32_t x = x0; x <= x1 && !seen; x++)
+					seen = reference[y * options.width + x] > nearest;
+			falseOcclusions += seen ? 1 : 0;
+		}
+
+		std::ostringstream report;
+		report << "{\"threads\":" << pool.size()
+			   << ",\"width\":" << options.width << ",\"height\":" << options.height
+			   << ",\"triangles\":" << triangleCount << ",\"rasterized\":" << rasterizer.triangles()
+			   << ",\"singleMs\":" << singleMs << ",\"pooledMs\":" << pooledMs
+			   << ",\"trianglesPerMs\":" << triangleCount / singleMs
+			   << ",\"trianglesPerMsPooled\":" << triangleCount / pooledMs
+			   << ",\"objects\":" << options.objects << ",\"visible\":" << visibleCount
+			   << ",\"testsPerMs\":" << options.objects / testMs
+			   << ",\"depthErrors\":" << depthErrors << ",\"coverageErrors\":" << coverageErrors
+			   << ",\"falseOcclusions\":" << falseOcclusions << "}";
+
+		if (options.output.empty()) {
+			std::cout << report.str() << std::endl;
+		} else {
+			std::ofstream file(options.output);
+			file << report.str() << std::endl;
+		}
+
+		pool.stop();
+		return depthErrors == 0 && coverageErrors == 0 && falseOcclusions == 0 ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cerr << "Occlusion rasterizer benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,113 @@
+#include "Particles.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Эталон сортировки частиц по глубине без GPU: те же шаги и пары, что у particle_sort.comp.
+// Пул на capacity частиц, видимых - случайное число (или --count) при каждом прогоне, ключи
+// со случайными повторами. Проверки: первые count пар упорядочены по ключу и остаются
+// перестановкой исходных, элементы за count не тронуты.
+// Код возврата: 0 - успех, 1 - ошибка или нарушение проверки
+//
+// ParticleSortBenchmark [--capacity N] [--count N] [--runs N] [--seed N] [--output отчёт.json]
+
+typedef struct _SortOptions
+{
+	uint32_t capacity = 1000000;
+	uint32_t count = 0; // 0 - случайное при каждом прогоне
+	uint32_t runs = 5;
+	uint32_t seed = 1;
+	std::string output; // пусто - стандартный вывод
+} SortOptions;
+
+static SortOptions parseOptions(int argc, char* argv[]) {
+	SortOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error("Missing value for " + arg);
+		const char* value = argv[++i];
+
+		if (arg == "--capacity") options.capacity = std::max(1, std::atoi(value));
+		else if (arg == "--count") options.count = std::max(0, std::atoi(value));
+		else if (arg == "--runs") options.runs = std::max(1, std::atoi(value));
+		else if (arg == "--seed") options.seed = static_cast<uint32_t>(std::atoi(value));
+		else if (arg == "--output") options.output = value;
+		else throw std::runtime_error("Unknown option " + arg);
+	}
+	options.count = std::min(options.count, options.capacity);
+	return options;
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		SortOptions options = parseOptions(argc, argv);
+
+		std::vector<ParticleSortStep> steps;
+		particleSortSteps(options.capacity, steps);
+
+		std::mt19937 random(options.seed);
+		std::vector<glm::uvec2> entries(options.capacity);
+		std::vector<glm::uvec2> expected;
+		uint32_t unsorted = 0, lost = 0, moved = 0;
+		double sortMs = 0.0;
+
+		for (uint32_t run = 0; run < options.runs; run++) {
+			uint32_t count = options.count > 0 ? options.count : random() % (options.capacity + 1);
+			// Ключи из узкого диапазона, чтобы повторы были
+			uint32_t keyRange = std::max(1u, count / 4);
+			for (uint32_t i = 0; i < options.capacity; i++)
+				entries[i] = glm::uvec2(random() % keyRange, i);
+			expected.assign(entries.begin(), entries.end());
+
+			auto start = std::chrono::steady_clock::now();
+			for (const ParticleSortStep& step : steps)
+				particleSortStep(step, entries, count);
+			sortMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			for (uint32_t i = 1; i < count; i++)
+				if (entries[i - 1].x > entries[i].x)
+					unsorted++;
+			for (uint32_t i = count; i < options.capacity; i++)
+				if (entries[i] != expected[i])
+					moved++;
+
+			// Перестановка: номера частиц первых count пар - те же, с теми же ключами
+			auto byIndex = [](const glm::uvec2& a, const glm::uvec2& b) { return a.y < b.y; };
+			std::vector<glm::uvec2> sorted(entries.begin(), entries.begin() + count);
+			std::sort(sorted.begin(), sorted.end(), byIndex);
+			for (uint32_t i = 0; i < count; i++)
+				if (sorted[i] != expected[i])
+					lost++;
+		}
+
+		uint32_t globalSteps = 0;
+		for (const ParticleSortStep& step : steps)
+			if (step.mode == ParticleSortMode::Flip || step.mode == ParticleSortMode::Disperse)
+				globalSteps++;
+
+		std::ostringstream report;
+		report << "{\"capacity\":" << options.capacity << ",\"runs\":" << options.runs
+			<< ",\"dispatches\":" << steps.size() << ",\"globalDispatches\":" << globalSteps
+			<< ",\"sortMs\":" << sortMs / options.runs
+			<< ",\"unsortedPairs\":" << unsorted << ",\"lostEntries\":" << lost << ",\"movedPadding\":" << moved << "}";
+
+		if (options.output.empty()) {
+			std::cout << report.str() << std::endl;
+		} else {
+			std::ofstream file(options.output);
+			file << report.str() << std::endl;
+		}
+		return unsorted == 0 && lost == 0 && moved == 0 ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cerr << "Particle sort benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,166 @@
+#include "SceneGraph.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+// Замеры обновления графа сцены без GPU: полный пересчёт, 1% изменённых узлов и неподвижная
+// сцена, в одном потоке и в пуле. Результат сверяется с наивным пересчётом glm. partialNodes -
+// сколько узлов пересчитывает 1% изменённых вместе с их поддеревьями.
+// Код возврата: 0 - успех, 1 - ошибка или расхождение матриц
+//
+// SceneGraphBenchmark [--nodes N] [--iterations N] [--threads N] [--output отчёт.json]
+// Без --nodes замеряются 100 000 и 1 000 000 узлов
+
+typedef struct _SceneGraphOptions
+{
+	std::vector<uint32_t> nodes;
+	uint32_t iterations = 50;
+	uint32_t threads = 0; // 0 - по числу ядер
+	std::string output; // пусто - стандартный вывод
+} SceneGraphOptions;
+
+static SceneGraphOptions parseOptions(int argc, char* argv[]) {
+	SceneGraphOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error("Missing value for " + arg);
+		const char* value = argv[++i];
+
+		if (arg == "--nodes") options.nodes.push_back(std::max(1, std::atoi(value)));
+		else if (arg == "--iterations") options.iterations = std::max(1, std::atoi(value));
+		else if (arg == "--threads") options.threads = std::max(0, std::atoi(value));
+		else if (arg == "--output") options.output = value;
+		else throw std::runtime_error("Unknown option " + arg);
+	}
+	if (options.nodes.empty())
+		options.nodes = {100000, 1000000};
+	return options;
+}
+
+static glm::mat4 randomLocal(std::mt19937& random) {
+	std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angle(-0.5f, 0.5f);
+	glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(offset(random), offset(random), offset(random)));
+	return glm::rotate(local, angle(random), glm::normalize(glm::vec3(offset(random), 1.0f, offset(random))));
+}
+
+// Среднее время вызова в миллисекундах
+template<typename Function>
+static double measure(uint32_t iterations, Function function) {
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; i++)
+		function(i);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		SceneGraphOptions options = parseOptions(argc, argv);
+
+		WorkerPool pool;
+		pool.start(options.threads);
+
+		std::ostringstream report;
+		report << "{\"threads\":" << pool.size() << ",\"runs\":[";
+		bool mismatch = false;
+
+		for (size_t run = 0; run < options.nodes.size(); run++) {
+			uint32_t count = options.nodes[run];
+			std::mt19937 random(1);
+
+			// Случайное дерево: 16 корней, родитель каждого узла - любой из созданных раньше
+			SceneGraph graph;
+			std::vector<SceneNode> nodes(count);
+			std::vector<uint32_t> parents(count);
+			std::vector<glm::mat4> locals(count);
+			for (uint32_t i = 0; i < count; i++) {
+				parents[i] = i < 16 ? UINT32_MAX : std::uniform_int_distribution<uint32_t>(0, i - 1)(random);
+				locals[i] = randomLocal(random);
+				nodes[i] = graph.create(parents[i] == UINT32_MAX ? NO_SCENE_NODE : nodes[parents[i]], locals[i]);
+			}
+			graph.update(); // перестроение порядка не входит в замеры
+
+			// Полный пересчёт: меняются корни, пометка доходит до всех узлов
+			auto touchRoots = [&](uint32_t iteration) {
+				for (uint32_t i = 0; i < 16 && i < count; i++)
+					graph.setLocal(nodes[i], glm::rotate(locals[i], iteration * 0.01f, glm::vec3(0.0f, 1.0f, 0.0f)));
+			};
+			double fullSerial = measure(options.iterations, [&](uint32_t i) { touchRoots(i); graph.update(); });
+			double fullParallel = measure(options.iterations, [&](uint32_t i) { touchRoots(i); graph.update(&pool); });
+
+			// 1% узлов со своим движением
+			std::vector<uint32_t> animated;
+			for (uint32_t i = 0; i < count / 100; i++)
+				animated.push_back(std::uniform_int_distribution<uint32_t>(0, count - 1)(random));
+			auto touchAnimated = [&](uint32_t iteration) {
+				for (uint32_t i : animated)
+					graph.setLocal(nodes[i], glm::translate(locals[i], glm::vec3(0.0f, std::sin(iteration * 0.1f), 0.0f)));
+			};
+			std::vector<uint8_t> affected(count, 0);
+			for (uint32_t i : animated)
+				affected[i] = 1;
+			uint32_t partialNodes = 0;
+			for (uint32_t i = 0; i < count; i++) {
+				if (parents[i] != UINT32_MAX)
+					affected[i] |= affected[parents[i]];
+				partialNodes += affected[i];
+			}
+			double partialSerial = measure(options.iterations, [&](uint32_t i) { touchAnimated(i); graph.update(); });
+			double partialParallel = measure(options.iterations, [&](uint32_t i) { touchAnimated(i); graph.update(&pool); });
+
+			double staticScene = measure(options.iterations, [&](uint32_t) { graph.update(&pool); });
+
+			// Сверка: наивный пересчёт по исходному порядку создания (родитель раньше ребёнка)
+			for (uint32_t i = 0; i < count; i++)
+				locals[i] = graph.local(nodes[i]);
+			std::vector<glm::mat4> reference(count);
+			auto referenceStart = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < count; i++)
+				reference[i] = parents[i] == UINT32_MAX ? locals[i] : reference[parents[i]] * locals[i];
+			double referenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - referenceStart).count();
+
+			float maxError = 0.0f;
+			for (uint32_t i = 0; i < count; i++) {
+				const glm::mat4& world = graph.world(nodes[i]);
+				for (int c = 0; c < 4; c++)
+					for (int r = 0; r < 4; r++)
+						maxError = std::max(maxError, std::abs(world[c][r] - reference[i][c][r]));
+			}
+			// Погрешность накапливается с глубиной и смещениями до десятков единиц
+			if (maxError > 1e-3f) {
+				std::cerr << "Mismatch at " << count << " nodes: max error " << maxError << std::endl;
+				mismatch = true;
+			}
+
+			report << (run ? "," : "") << "{\"nodes\":" << count << ",\"levels\":" << graph.levelCount()
+				   << ",\"fullSerialMs\":" << fullSerial << ",\"fullParallelMs\":" << fullParallel
+				   << ",\"partialNodes\":" << partialNodes << ",\"partialSerialMs\":" << partialSerial << ",\"partialParallelMs\":" << partialParallel
+				   << ",\"staticMs\":" << staticScene << ",\"referenceMs\":" << referenceMs
+				   << ",\"maxError\":" << maxError << "}";
+		}
+		report << "]}\n";
+		pool.stop();
+
+		if (options.output.empty()) {
+			std::cout << report.str();
+		} else {
+			std::ofstream file(options.output);
+			file << report.str();
+		}
+		if (mismatch)
+			return 1;
+	} catch (const std::exception& e) {
+		std::cerr << "Benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include "ShadowCascades.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Каскады теней на облёте без GPU: сколько кадров каждый каскад перерисовывает статическую
+// геометрию и время update(). Проверки на каждом кадре: углы среза пирамиды видимости
+// лежат внутри своего каскада (u, v и глубина в [0, 1]), центр каскада в пространстве
+// света стоит на целом тексели, заслонка, центр которой попадает в каскад, не отсекается
+// проверкой cascadeTouches (доля оставленных заслонок - в отчёте).
+// Код возврата: 0 - успех, 1 - ошибка или нарушение проверки
+//
+// ShadowCascadesBenchmark [--frames N] [--speed м/кадр] [--turn градусов/кадр] [--far N] [--output отчёт.json]
+
+typedef struct _CascadeOptions
+{
+	uint32_t frames = 10000;
+	float speed = 0.2f; // ~12 м/с при 60 кадрах в секунду
+	float turn = 0.05f; // поворот камеры на кадр
+	float farPlane = 32256.0f; // дальняя плоскость с ландшафтом по умолчанию
+	std::string output; // пусто - стандартный вывод
+} CascadeOptions;
+
+static CascadeOptions parseOptions(int argc, char* argv[]) {
+	CascadeOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error("Missing value for " + arg);
+		const char* value = argv[++i];
+
+		if (arg == "--frames") options.frames = std::max(1, std::atoi(value));
+		else if (arg == "--speed") options.speed = static_cast<float>(std::atof(value));
+		else if (arg == "--turn") options.turn = static_cast<float>(std::atof(value));
+		else if (arg == "--far") options.farPlane = std::max(1.0f, static_cast<float>(std::atof(value)));
+		else if (arg == "--output") options.output = value;
+		else throw std::runtime_error("Unknown option " + arg);
+	}
+	return options;
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		CascadeOptions options = parseOptions(argc, argv);
+
+		const float fovY = glm::radians(45.0f);
+		const float aspect = 16.0f / 9.0f;
+		const float znear = 0.1f;
+		float tanHalfFovY = std::tan(0.5f * fovY);
+
+		ShadowCascades cascades;
+		cascades.setLight(glm::vec3(-0.4f, -0.8f, -0.3f));
+
+		uint32_t redraws[SHADOW_CASCADES] = {};
+		uint32_t uncovered = 0, unsnapped = 0, missedCasters = 0;
+		uint64_t keptCasters[SHADOW_CASCADES] = {}, casters = 0;
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		double updateMs = 0.0;
+		glm::vec3 position(0.0f, 30.0f, 0.0f);
+		float yaw = 0.0f;
+
+		for (uint32_t frame = 0; frame < options.frames; frame++) {
+			// Облёт: вперёд с медленным поворотом, взгляд чуть вниз
+			yaw += glm::radians(options.turn);
+			glm::vec3 front = glm::normalize(glm::vec3(std::sin(yaw), -0.2f, -std::cos(yaw)));
+			position += glm::vec3(front.x, 0.0f, front.z) * options.speed;
+			glm::mat4 view = glm::lookAt(position, position + front, glm::vec3(0.0f, 1.0f, 0.0f));
+
+			auto start = std::chrono::steady_clock::now();
+			uint32_t redraw = cascades.update(view, tanHalfFovY, aspect, znear, options.farPlane, 0);
+			updateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			// Заслонки размером с экземпляр толпы вокруг камеры
+			for (uint32_t c = 0; c < 16; c++) {
+				glm::vec3 caster = position + glm::vec3(unit(random) - 0.5f, 0.0f, unit(random) - 0.5f) * 2.0f * SHADOW_DISTANCE;
+				caster.y = 60.0f * unit(random);
+				casters++;
+				for (uint32_t i = 0; i < SHADOW_CASCADES; i++) {
+					const ShadowCascade& cascade = cascades.cascade(i);
+					bool touches = cascadeTouches(cascade, caster, 1.0f);
+					keptCasters[i] += touches ? 1 : 0;
+					glm::vec3 coord = glm::vec3(shadowMatrix(cascade) * glm::vec4(caster, 1.0f));
+					if (!touches && std::min(coord.x, std::min(coord.y, coord.z)) >= 0.0f &&
+						std::max(coord.x, std::max(coord.y, coord.z)) <= 1.0f)
+						missedCasters++;
+				}
+			}
+
+			glm::mat4 inverseView = glm::inverse(view);
+			float sliceNear = znear;
+			for (uint32_t i = 0; i < SHADOW_CASCADES; i++) {
+				const ShadowCascade& cascade = cascades.cascade(i);
+				if (redraw & (1u << i))
+					redraws[i]++;
+				else if (i < SHADOW_CACHED_FROM)
+					redraws[i]++; // ближние каскады рисуются каждый кадр
+
+				glm::mat4 matrix = shadowMatrix(cascade);
+				for (float depth : {sliceNear, cascade.splitFar})
+					for (float x : {-1.0f, 1.0f})
+						for (float y : {-1.0f, 1.0f}) {
+							glm::vec4 corner = inverseView * glm::vec4(x * depth * tanHalfFovY * aspect, y * depth * tanHalfFovY, -depth, 1.0f);
+							glm::vec3 coord = glm::vec3(matrix * corner);
+							const float epsilon = 1e-4f;
+							if (std::min(coord.x, std::min(coord.y, coord.z)) < -epsilon ||
+								std::max(coord.x, std::max(coord.y, coord.z)) > 1.0f + epsilon)
+								uncovered++;
+						}
+
+				// Перенос вида - центр в пространстве света; допуск - округление float вдали от начала координат
+				glm::vec3 local = -glm::vec3(cascade.view[3]) / (2.0f * cascade.radius / SHADOW_MAP_SIZE);
+				if (std::abs(local.x - std::round(local.x)) > 0.1f || std::abs(local.y - std::round(local.y)) > 0.1f)
+					unsnapped++;
+				sliceNear = cascade.splitFar;
+			}
+		}
+
+		std::ostringstream report;
+		report << "{\"frames\":" << options.frames << ",\"updateMs\":" << updateMs / options.frames << ",\"splits\":[";
+		for (uint32_t i = 0; i < SHADOW_CASCADES; i++)
+			report << (i ? "," : "") << cascades.cascade(i).splitFar;
+		report << "],\"radii\":[";
+		for (uint32_t i = 0; i < SHADOW_CASCADES; i++)
+			report << (i ? "," : "") << cascades.cascade(i).radius;
+		report << "],\"redraws\":[";
+		for (uint32_t i = 0; i < SHADOW_CASCADES; i++)
+			report << (i ? "," : "") << redraws[i];
+		report << "],\"keptCasters\":[";
+		for (uint32_t i = 0; i < SHADOW_CASCADES; i++)
+			report << (i ? "," : "") << static_cast<double>(keptCasters[i]) / casters;
+		report << "],\"uncoveredCorners\":" << uncovered << ",\"unsnappedCenters\":" << unsnapped
+			   << ",\"missedCasters\":" << missedCasters << "}";
+
+		if (options.output.empty()) {
+			std::cout << report.str() << std::endl;
+		} else {
+			std::ofstream file(options.output);
+			file << report.str() << std::endl;
+		}
+		return uncovered == 0 && unsnapped == 0 && missedCasters == 0 ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cerr << "Shadow cascades benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,258 @@
+#include "ResourceStateTracker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Проверка трекера состояний ресурсов без GPU: трекер обращается к устройству только в flush(),
+// поэтому дескрипторы здесь - просто числа. Сценарии: слияние последовательных чтений в один
+// барьер (и соседних уровней и слоёв изображения), чтение после чтения в той же раскладке без
+// барьера, все барьеры точки перехода в одном VkDependencyInfo. Случайная последовательность
+// использований сверяется с эталоном: каждая запись, после которой читатель ещё не видит
+// данных, даёт барьер, а лишних барьеров нет.
+// Код возврата: 0 - успех, 1 - ошибка или нарушение проверки
+//
+// ResourceStateTrackerBenchmark [--resources N] [--batches N] [--seed N] [--output отчёт.json]
+
+typedef struct _TrackerOptions
+{
+	uint32_t resources = 256;
+	uint32_t batches = 20000;
+	uint32_t seed = 1;
+	std::string output; // пусто - стандартный вывод
+} TrackerOptions;
+
+// Использование случайной последовательности и признак записи
+typedef struct _TrackerUse
+{
+	ResourceUsage usage;
+	bool write;
+} TrackerUse;
+
+static const TrackerUse RANDOM_USES[] = {
+	{ResourceUsage::ComputeShaderWrite, true}, {ResourceUsage::ComputeShaderReadWrite, true},
+	{ResourceUsage::TransferDst, true}, {ResourceUsage::TransferSrc, false},
+	{ResourceUsage::VertexShaderRead, false}, {ResourceUsage::FragmentShaderRead, false},
+	{ResourceUsage::ComputeShaderRead, false}, {ResourceUsage::VertexBuffer, false},
+	{ResourceUsage::IndirectBuffer, false}, {ResourceUsage::UniformBuffer, false}};
+
+// Эталон состояния буфера: последняя запись и стадии, которым она уже видна
+typedef struct _BufferModel
+{
+	VkPipelineStageFlags2 writeStages = 0;
+	VkPipelineStageFlags2 readStages = 0;
+	VkPipelineStageFlags2 visibleStages = 0;
+	VkAccessFlags2 visibleAccess = 0;
+} BufferModel;
+
+template<typename T>
+static T fakeHandle(uint64_t value) {
+	return reinterpret_cast<T>(static_cast<uintptr_t>(value));
+}
+
+static TrackerOptions parseOptions(int argc, char* argv[]) {
+	TrackerOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error("Missing value for " + arg);
+		const char* value = argv[++i];
+
+		if (arg == "--resources") options.resources = std::max(1, std::atoi(value));
+		else if (arg == "--batches") options.batches = std::max(1, std::atoi(value));
+		else if (arg == "--seed") options.seed = static_cast<uint32_t>(std::atoi(value));
+		else if (arg == "--output") options.output = value;
+		else throw std::runtime_error("Unknown option " + arg);
+	}
+	return options;
+}
+
+static const VkBufferMemoryBarrier2* findBarrier(const ResourceStateTracker& tracker, VkBuffer buffer) {
+	for (const VkBufferMemoryBarrier2& barrier : tracker.pendingBufferBarriers())
+		if (barrier.buffer == buffer)
+			return &barrier;
+	return nullptr;
+}
+
+// Сценарии с известным ответом; имена нарушенных проверок - в failed
+static void checkScenarios(std::vector<std::string>& failed) {
+	auto expect = [&failed](bool condition, const char* name) {
+		if (!condition)
+			failed.push_back(name);
+	};
+
+	ResourceStateTracker tracker;
+	ResourceState vertex = resourceState(ResourceUsage::VertexShaderRead);
+	ResourceState indirect = resourceState(ResourceUsage::IndirectBuffer);
+	ResourceState fragment = resourceState(ResourceUsage::FragmentShaderRead);
+
+	// Последовательные чтения после записи - один барьер с объединённым назначением
+	VkBuffer buffer = fakeHandle<VkBuffer>(1);
+	tracker.trackBuffer(buffer);
+	tracker.use(buffer, ResourceUsage::ComputeShaderWrite);
+	tracker.discardPending();
+	tracker.use(buffer, ResourceUsage::VertexShaderRead);
+	tracker.use(buffer, ResourceUsage::IndirectBuffer);
+	tracker.use(buffer, ResourceUsage::FragmentShaderRead);
+	const auto& bufferBarriers = tracker.pendingBufferBarriers();
+	expect(bufferBarriers.size() == 1, "merged reads: one buffer barrier");
+	expect(!bufferBarriers.empty() && bufferBarriers[0].srcStageMask == VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT
+			&& bufferBarriers[0].dstStageMask == (vertex.stages | indirect.stages | fragment.stages)
+			&& bufferBarriers[0].dstAccessMask == (vertex.access | indirect.access | fragment.access),
+			"merged reads: union of reader stages and access");
+	tracker.discardPending();
+
+	// Те же читатели в следующей точке перехода: запись им уже видна
+	tracker.use(buffer, ResourceUsage::VertexShaderRead);
+	tracker.use(buffer, ResourceUsage::FragmentShaderRead);
+	expect(!tracker.hasPending(), "read after read: no buffer barrier");
+	tracker.discardPending();
+
+	// Изображение 10 уровней x 6 слоёв: одинаковые соседние подресурсы - один диапазон
+	VkImage image = fakeHandle<VkImage>(2);
+	tracker.trackImage(image, VK_IMAGE_ASPECT_COLOR_BIT, 10, 6);
+	tracker.use(image, ResourceUsage::TransferDst);
+	const auto& imageBarriers = tracker.pendingImageBarriers();
+	expect(imageBarriers.size() == 1 && imageBarriers[0].subresourceRange.levelCount == 10
+			&& imageBarriers[0].subresourceRange.layerCount == 6, "merged subresources: one image barrier");
+	tracker.discardPending();
+
+	// Уровень 3 записан другой стадией: по слою три диапазона, слои объединены
+	tracker.use(image, resourceState(ResourceUsage::ComputeShaderWrite), 3, 1);
+	tracker.discardPending();
+	tracker.use(image, ResourceUsage::FragmentShaderRead);
+	bool layersMerged = imageBarriers.size() == 3;
+	for (const VkImageMemoryBarrier2& barrier : imageBarriers)
+		layersMerged = layersMerged && barrier.subresourceRange.layerCount == 6;
+	expect(layersMerged, "merged subresources: three level ranges across all layers");
+	tracker.discardPending();
+
+	// Чтение в той же раскладке - без барьера; смена раскладки - барьер даже между чтениями
+	tracker.use(image, ResourceUsage::FragmentShaderRead);
+	expect(!tracker.hasPending(), "read after read: no image barrier in same layout");
+	tracker.discardPending();
+	tracker.use(image, ResourceUsage::TransferSrc);
+	expect(imageBarriers.size() == 1 && imageBarriers[0].oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+			&& imageBarriers[0].newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+			&& imageBarriers[0].srcStageMask == VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+			"read after read: layout change waits for readers");
+	tracker.discardPending();
+
+	// Все записи точки перехода - в одном VkDependencyInfo
+	const uint32_t buffers = 64, images = 4;
+	for (uint32_t i = 0; i < buffers; i++) {
+		tracker.trackBuffer(fakeHandle<VkBuffer>(100 + i), resourceState(ResourceUsage::TransferDst));
+		tracker.use(fakeHandle<VkBuffer>(100 + i), ResourceUsage::ComputeShaderRead);
+	}
+	for (uint32_t i = 0; i < images; i++) {
+		tracker.trackImage(fakeHandle<VkImage>(200 + i), VK_IMAGE_ASPECT_COLOR_BIT, 4);
+		tracker.use(fakeHandle<VkImage>(200 + i), ResourceUsage::ColorAttachment);
+	}
+	VkDependencyInfo info = tracker.dependencyInfo();
+	expect(info.bufferMemoryBarrierCount == buffers && info.imageMemoryBarrierCount == images
+			&& info.pBufferMemoryBarriers == tracker.pendingBufferBarriers().data()
+			&& info.pImageMemoryBarriers == tracker.pendingImageBarriers().data(),
+			"single flush: one dependency info with every pending barrier");
+	tracker.discardPending();
+	info = tracker.dependencyInfo();
+	expect(!tracker.hasPending() && info.bufferMemoryBarrierCount == 0 && info.imageMemoryBarrierCount == 0,
+			"single flush: transition point closed");
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		TrackerOptions options = parseOptions(argc, argv);
+
+		std::vector<std::string> failed;
+		checkScenarios(failed);
+
+		// Случайные точки перехода: буфер используется не больше одного раза в точке
+		ResourceStateTracker tracker;
+		std::vector<BufferModel> models(options.resources);
+		std::vector<uint32_t> order(options.resources);
+		std::iota(order.begin(), order.end(), 0u);
+		for (uint32_t i = 0; i < options.resources; i++)
+			tracker.trackBuffer(fakeHandle<VkBuffer>(i + 1));
+
+		std::mt19937 random(options.seed);
+		uint64_t uses = 0, hazards = 0, barriers = 0, missed = 0, redundant = 0, wrongMasks = 0;
+		double useMs = 0.0;
+
+		for (uint32_t batch = 0; batch < options.batches; batch++) {
+			std::shuffle(order.begin(), order.end(), random);
+			uint32_t count = 1 + random() % options.resources;
+
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t index = order[i];
+				VkBuffer buffer = fakeHandle<VkBuffer>(index + 1);
+				const TrackerUse& use = RANDOM_USES[random() % (sizeof(RANDOM_USES) / sizeof(RANDOM_USES[0]))];
+				ResourceState state = resourceState(use.usage);
+				BufferModel& model = models[index];
+
+				// Запись ждёт прошлую запись и читателей; чтение - запись, ещё не видимую его стадиям
+				bool hazard;
+				VkPipelineStageFlags2 srcStages;
+				if (use.write) {
+					srcStages = model.writeStages | model.readStages;
+					hazard = srcStages != 0;
+					model = {state.stages, 0, 0, 0};
+				} else {
+					srcStages = model.writeStages;
+					hazard = model.writeStages != 0 && ((state.stages & ~model.visibleStages) != 0
+								|| (state.access & ~model.visibleAccess) != 0);
+					model.readStages |= state.stages;
+					if (hazard) {
+						model.visibleStages |= state.stages;
+						model.visibleAccess |= state.access;
+					}
+				}
+
+				auto start = std::chrono::steady_clock::now();
+				tracker.use(buffer, use.usage);
+				useMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				uses++;
+
+				const VkBufferMemoryBarrier2* barrier = findBarrier(tracker, buffer);
+				hazards += hazard;
+				if (hazard && !barrier)
+					missed++;
+				if (!hazard && barrier)
+					redundant++;
+				if (hazard && barrier && ((barrier->srcStageMask & srcStages) != srcStages
+						|| (barrier->dstStageMask & state.stages) != state.stages))
+					wrongMasks++;
+			}
+
+			barriers += tracker.pendingBufferBarriers().size();
+			tracker.discardPending();
+		}
+
+		for (const std::string& name : failed)
+			std::cerr << "Check failed: " << name << std::endl;
+
+		std::ostringstream report;
+		report << "{\"resources\":" << options.resources << ",\"batches\":" << options.batches
+			<< ",\"uses\":" << uses << ",\"useNs\":" << useMs * 1e6 / uses
+			<< ",\"barriers\":" << barriers << ",\"hazards\":" << hazards
+			<< ",\"missedHazards\":" << missed << ",\"redundantBarriers\":" << redundant
+			<< ",\"wrongMasks\":" << wrongMasks << ",\"failedChecks\":" << failed.size() << "}";
+
+		if (options.output.empty()) {
+			std::cout << report.str() << std::endl;
+		} else {
+			std::ofstream file(options.output);
+			file << report.str() << std::endl;
+		}
+		return failed.empty() && missed == 0 && redundant == 0 && wrongMasks == 0 ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cerr << "Resource state tracker benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
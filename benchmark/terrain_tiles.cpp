@@ -0,0 +1,102 @@
+#include "Terrain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+// Генерация плиток высот для клипмапа: фрактальный шум, центр мира (0, 0) - равнина
+// под моделью, дальше горы. Уровень детализации k + 1 прореживает уровень k через отсчёт.
+//
+// TerrainTiles [--output каталог] [--tiles N] [--seed N]
+// N - плиток уровня 0 по стороне (шаг отсчёта 1 м, плитка 256 м)
+
+typedef struct _TerrainTilesOptions
+{
+	std::string output = "terrain";
+	int32_t tiles = 16;
+	uint32_t seed = 1;
+} TerrainTilesOptions;
+
+static TerrainTilesOptions parseOptions(int argc, char* argv[]) {
+	TerrainTilesOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error("Missing value for " + arg);
+		const char* value = argv[++i];
+
+		if (arg == "--output") options.output = value;
+		else if (arg == "--tiles") options.tiles = std::max(1, std::atoi(value));
+		else if (arg == "--seed") options.seed = static_cast<uint32_t>(std::atoi(value));
+		else throw std::runtime_error("Unknown option " + arg);
+	}
+	return options;
+}
+
+static const float MIN_HEIGHT = -50.0f; // общий диапазон квантования: одинаковые отсчёты разных уровней
+static const float MAX_HEIGHT = 450.0f; // детализации дают одинаковые uint16
+
+static float lattice(int32_t x, int32_t z, uint32_t seed) {
+	uint32_t hash = static_cast<uint32_t>(x) * 374761393u + static_cast<uint32_t>(z) * 668265263u + seed * 2246822519u;
+	hash = (hash ^ (hash >> 13)) * 1274126177u;
+	return static_cast<float>((hash ^ (hash >> 16)) & 0xFFFF) / 65535.0f;
+}
+
+static float valueNoise(float x, float z, uint32_t seed) {
+	float fx = std::floor(x), fz = std::floor(z);
+	int32_t ix = static_cast<int32_t>(fx), iz = static_cast<int32_t>(fz);
+	float tx = x - fx, tz = z - fz;
+	tx = tx * tx * (3.0f - 2.0f * tx);
+	tz = tz * tz * (3.0f - 2.0f * tz);
+	float a = lattice(ix, iz, seed) + (lattice(ix + 1, iz, seed) - lattice(ix, iz, seed)) * tx;
+	float b = lattice(ix, iz + 1, seed) + (lattice(ix + 1, iz + 1, seed) - lattice(ix, iz + 1, seed)) * tx;
+	return a + (b - a) * tz;
+}
+
+// Высота в точке отсчёта уровня 0 (метры)
+static float height(int32_t x, int32_t z, uint32_t seed) {
+	float sum = 0.0f, amplitude = 1.0f, frequency = 1.0f / 2048.0f;
+	for (int octave = 0; octave < 10; octave++) {
+		sum += amplitude * valueNoise(x * frequency, z * frequency, seed + octave);
+		amplitude *= 0.5f;
+		frequency *= 2.0f;
+	}
+	float distance = std::sqrt(static_cast<float>(x) * x + static_cast<float>(z) * z);
+	float mountains = std::clamp((distance - 200.0f) / 1500.0f, 0.0f, 1.0f);
+	return -2.0f + mountains * sum * 220.0f;
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		TerrainTilesOptions options = parseOptions(argc, argv);
+		const int32_t tile = static_cast<int32_t>(TERRAIN_TILE);
+		int32_t half = options.tiles * tile / 2; // мир - [-half, half) отсчётов уровня 0
+
+		size_t written = 0;
+		std::vector<float> heights(TERRAIN_TILE * TERRAIN_TILE);
+		for (uint32_t mip = 0; mip < TERRAIN_LEVELS; mip++) {
+			std::filesystem::create_directories(options.output + "/" + std::to_string(mip));
+
+			int32_t step = 1 << mip;
+			int32_t first = -((half / step + tile - 1) / tile);
+			int32_t last = (half / step + tile - 1) / tile;
+			for (int32_t tz = first; tz < last; tz++) {
+				for (int32_t tx = first; tx < last; tx++) {
+					for (int32_t j = 0; j < tile; j++)
+						for (int32_t i = 0; i < tile; i++)
+							heights[j * tile + i] = height((tx * tile + i) * step, (tz * tile + j) * step, options.seed);
+					saveHeightTile(heightTilePath(options.output, mip, tx, tz), heights, MIN_HEIGHT, MAX_HEIGHT);
+					written++;
+				}
+			}
+		}
+		std::cout << "{\"tiles\":" << written << ",\"levels\":" << TERRAIN_LEVELS
+				  << ",\"worldMeters\":" << 2 * half << "}" << std::endl;
+	} catch (const std::exception& e) {
+		std::cerr << "Terrain tiles failed: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
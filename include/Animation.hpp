@@ -0,0 +1,141 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Vertex.hpp"
+#include "WorkerPool.hpp"
+
+struct aiScene;
+struct aiMesh;
+
+const uint32_t MAX_JOINTS = 256; // размер палитры в однородном буфере (16 КБ - гарантированный минимум maxUniformBufferRange)
+
+// Локальное преобразование сустава
+typedef struct _JointTransform
+{
+	glm::vec3 translation;
+	glm::quat rotation;
+	glm::vec3 scale;
+} JointTransform;
+
+// Скелет: суставы в порядке «родитель раньше ребёнка»
+typedef struct _Skeleton
+{
+	std::vector<std::string> names;
+	std::vector<uint32_t> parents; // UINT32_MAX у корня
+	std::vector<JointTransform> bindPose; // локальные преобразования узлов файла
+	std::vector<glm::mat4> inverseBind; // из пространства модели в пространство сустава
+	glm::mat4 globalInverse = glm::mat4(1.0f); // обратное преобразование корня сцены
+
+	uint32_t size() const { return static_cast<uint32_t>(parents.size()); }
+	uint32_t find(const std::string& name) const; // UINT32_MAX, если сустава нет
+} Skeleton;
+
+// Участок ключей одного канала сустава; keyCount == 0 - канал не анимирован
+typedef struct _AnimationTrack
+{
+	uint32_t firstKey;
+	uint32_t keyCount;
+} AnimationTrack;
+
+// Клип в компактном виде: ключи всех суставов в общих массивах, повороты квантованы
+// в 4 x int16, ключи, восстанавливаемые интерполяцией соседей, отброшены при импорте
+typedef struct _AnimationClip
+{
+	std::string name;
+	float duration; // секунды
+
+	std::vector<AnimationTrack> translationTracks; // по суставам
+	std::vector<AnimationTrack> rotationTracks;
+	std::vector<AnimationTrack> scaleTracks;
+
+	std::vector<float> translationTimes;
+	std::vector<glm::vec3> translationKeys;
+	std::vector<float> rotationTimes;
+	std::vector<glm::i16vec4> rotationKeys; // x, y, z, w * 32767
+	std::vector<float> scaleTimes;
+	std::vector<glm::vec3> scaleKeys;
+} AnimationClip;
+
+// Импорт (assimp): скелет и поток весов меша, клипы файла по именам суставов скелета.
+// Меш без костей получает один сустав, к которому привязаны все вершины
+void loadSkeleton(const aiScene* scene, const aiMesh* mesh, Skeleton& skeleton, std::vector<SkinnedVertex>& skin);
+void loadAnimationClips(const aiScene* scene, const Skeleton& skeleton, std::vector<AnimationClip>& clips);
+
+// Поза клипа в момент time (по кругу); суставы без каналов берут позу привязки
+void sampleClip(const AnimationClip& clip, const Skeleton& skeleton, float time, std::vector<JointTransform>& pose);
+void blendPoses(const std::vector<JointTransform>& from, const std::vector<JointTransform>& to, float weight,
+				std::vector<JointTransform>& result);
+// Палитра суставов: из пространства модели привязки в пространство модели позы
+void computePalette(const Skeleton& skeleton, const std::vector<JointTransform>& pose, glm::mat4* palette);
+
+// Клип, запечённый для толпы: кадры с постоянным шагом, в кадре - палитра всех суставов,
+// сустав - три строки аффинной матрицы. Кадр после последнего - снова первый
+typedef struct _BakedClip
+{
+	uint32_t firstRow; // первая строка клипа в общем массиве
+	uint32_t frameCount;
+	uint32_t jointCount;
+	float duration; // секунды
+} BakedClip;
+
+typedef struct _BakedAnimations
+{
+	float framesPerSecond;
+	std::vector<BakedClip> clips;
+	std::vector<glm::vec4> rows;
+} BakedAnimations;
+
+// Запекание палитр; без клипов - один кадр позы привязки
+void bakeAnimations(const Skeleton& skeleton, const std::vector<AnimationClip>& clips, float framesPerSecond, BakedAnimations& baked);
+// Файл запекания: false, если файла нет или он записан для другого скелета, других ключей клипов
+// или частоты кадров. В заголовке - хэш скелета и клипов, из которых запекали
+bool loadBakedAnimations(const std::string& path, const Skeleton& skeleton, const std::vector<AnimationClip>& clips,
+						float framesPerSecond, BakedAnimations& baked);
+void saveBakedAnimations(const std::string& path, const Skeleton& skeleton, const std::vector<AnimationClip>& clips,
+						const BakedAnimations& baked);
+
+// Проигрывание клипов для набора экземпляров. Выборка, смешивание и палитры считаются
+// в пуле потоков, по экземпляру на участок; результат - палитры подряд по экземплярам
+class Animator
+{
+	public:
+		void init(const Skeleton* skeleton, const std::vector<AnimationClip>* clips);
+
+		uint32_t add(uint32_t clip, float speed = 1.0f); // номер экземпляра
+		void play(uint32_t instance, uint32_t clip, float fadeSeconds = 0.25f); // плавный переход к клипу
+		void setSpeed(uint32_t instance, float speed) { instances[instance].speed = speed; }
+
+		void update(float deltaSeconds, WorkerPool* pool = nullptr);
+		const glm::mat4* palette(uint32_t instance) const { return palettes.data() + instance * skeleton->size(); }
+
+	private:
+		struct Instance
+		{
+			uint32_t clip; // UINT32_MAX - поза привязки
+			float time;
+			float speed;
+			uint32_t nextClip; // клип перехода, UINT32_MAX - нет перехода
+			float nextTime;
+			float fade; // прошедшее время перехода
+			float fadeDuration;
+			std::vector<JointTransform> pose; // рабочие позы экземпляра
+			std::vector<JointTransform> nextPose;
+		};
+
+		void evaluate(Instance& instance, float deltaSeconds, glm::mat4* palette);
+
+		const Skeleton* skeleton = nullptr;
+		const std::vector<AnimationClip>* clips = nullptr;
+		std::vector<Instance> instances;
+		std::vector<glm::mat4> palettes;
+};
+
+#endif // ANIMATION_H
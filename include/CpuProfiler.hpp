@@ -0,0 +1,109 @@
+#ifndef CPUPROFILER_H
+#define CPUPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Профилировщик CPU.
+// Каждый поток пишет завершённые области в свой кольцевой буфер без блокировок:
+// единственный писатель - сам поток, читатель (выгрузка) берёт снимок по индексу записи.
+// Старые события перезаписываются. Метки - такты TSC (на x86; переводятся в нс при выгрузке
+// по калибровке относительно steady_clock), так область стоит порядка десятка наносекунд.
+// Выгрузка - JSON формата Chrome trace, который открывают chrome://tracing и Perfetto UI.
+// Без определения CPU_PROFILER (опция CMake) макросы раскрываются в пустоту
+#ifdef CPU_PROFILER
+
+class CpuProfiler
+{
+	public:
+		typedef struct _Event
+		{
+			const char* name; // строка со статическим временем жизни
+			uint64_t start; // такты now()
+			uint64_t end;
+		} Event;
+
+		static uint64_t now() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+			return __rdtsc();
+#else
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+		}
+
+		// Кольцо событий одного потока
+		struct ThreadBuffer
+		{
+			static const uint32_t capacity = 1 << 16; // степень двойки
+
+			Event events[capacity];
+			std::atomic<uint64_t> head{0}; // число записанных событий
+			std::string name;
+			uint32_t id;
+		};
+
+		// Запись завершённой области: без блокировок и вызовов, кроме первой записи потока
+		static void record(const char* name, uint64_t start, uint64_t end) {
+			ThreadBuffer* buffer = local ? local : registerThread();
+			uint64_t index = buffer->head.load(std::memory_order_relaxed);
+			buffer->events[index & (ThreadBuffer::capacity - 1)] = {name, start, end};
+			buffer->head.store(index + 1, std::memory_order_release);
+		}
+
+		static void setThreadName(const char* name);
+		static bool writeChromeTrace(const std::string& path); // false, если файл не открылся
+
+	private:
+		static ThreadBuffer* registerThread();
+		inline static thread_local ThreadBuffer* local = nullptr;
+};
+
+// Область на время жизни объекта; next закрывает текущую фазу и открывает следующую одной меткой времени
+class CpuScope
+{
+	public:
+		explicit CpuScope(const char* name) : name(name), start(CpuProfiler::now()) {}
+		~CpuScope() { CpuProfiler::record(name, start, CpuProfiler::now()); }
+
+		void next(const char* phase) {
+			uint64_t time = CpuProfiler::now();
+			CpuProfiler::record(name, start, time);
+			name = phase;
+			start = time;
+		}
+
+	private:
+		const char* name;
+		uint64_t start;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) CpuScope PROFILE_CONCAT(cpuScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_PHASES(var, name) CpuScope var(name)
+#define PROFILE_NEXT(var, name) var.next(name)
+#define PROFILE_THREAD(name) CpuProfiler::setThreadName(name)
+#define PROFILE_DUMP(path) CpuProfiler::writeChromeTrace(path)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_PHASES(var, name)
+#define PROFILE_NEXT(var, name)
+#define PROFILE_THREAD(name)
+#define PROFILE_DUMP(path) false
+
+#endif // CPU_PROFILER
+
+#endif // CPUPROFILER_H
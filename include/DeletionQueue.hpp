@@ -0,0 +1,33 @@
+#ifndef DELETIONQUEUE_H
+#define DELETIONQUEUE_H
+
+#include <functional>
+#include <vector>
+
+// Очередь отложенного уничтожения.
+// Объекты, которые ещё могут использоваться GPU, не уничтожаются сразу,
+// а ставятся в очередь и освобождаются, когда временная шкала достигла значения очереди
+class DeletionQueue
+{
+	public:
+		void push(std::function<void()>&& deleter) { deleters.push_back(std::move(deleter)); }
+
+		// Перенос объектов другой очереди в конец этой (они будут уничтожены первыми)
+		void append(DeletionQueue&& other) {
+			for (auto& deleter : other.deleters)
+				deleters.push_back(std::move(deleter));
+			other.deleters.clear();
+		}
+
+		// Уничтожение в порядке, обратном добавлению
+		void flush() {
+			for (auto it = deleters.rbegin(); it != deleters.rend(); ++it)
+				(*it)();
+			deleters.clear();
+		}
+
+	private:
+		std::vector<std::function<void()>> deleters;
+};
+
+#endif // DELETIONQUEUE_H
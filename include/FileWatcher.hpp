@@ -0,0 +1,28 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Отслеживание изменений файлов.
+// В Linux используется inotify (следим за каталогами файлов),
+// на остальных платформах - опрос времени последней записи
+class FileWatcher
+{
+	public:
+		void init(); // инициализация
+		void shutdown(); // завершение работы
+		std::string add(const std::string& path); // добавить файл в отслеживаемые, возвращает нормализованный путь
+		std::vector<std::string> poll(); // файлы, изменившиеся с прошлого вызова
+
+	private:
+		std::unordered_map<std::string, std::filesystem::file_time_type> files; // файл -> время последней записи
+#ifdef __linux__
+		int inotifyFd = -1; // дескриптор inotify
+		std::unordered_map<int, std::string> directories; // дескриптор наблюдения -> каталог
+#endif
+};
+
+#endif // FILEWATCHER_H
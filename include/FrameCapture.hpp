@@ -0,0 +1,96 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GpuTimeline.hpp"
+#include "ResourceRegistry.hpp"
+#include "ResourceStateTracker.hpp"
+
+// Формат файлов последовательности
+enum class CaptureFormat
+{
+	PNG, // 8 бит, значения как в изображении кадра
+	EXR // 32-битные float, линейные значения, без сжатия
+};
+
+// Захват кадров в последовательность изображений.
+// Копирование кадра в один из буферов чтения пула записывается в тот же буфер команд, что
+// рисует кадр; буфер забирается, когда временная шкала достигла значения этой отправки
+// (через несколько кадров), и кодируется рабочими потоками. Поток рендера не ждёт ни GPU,
+// ни кодирования, пока в пуле есть свободный буфер
+class FrameCapture
+{
+	public:
+		void init(ResourceRegistry* registry, ResourceStateTracker* tracker, GpuTimeline* timeline, uint32_t workers = 2);
+		void destroy(); // дожидается записи всех файлов
+
+		// Начало последовательности: файлы directory/frame_00000.png, ...; буферы создаются под extent
+		void start(const std::string& directory, CaptureFormat format, VkExtent2D extent, VkFormat imageFormat, uint32_t poolSize = 4);
+		void finish(); // ожидание GPU и записи всех захваченных кадров, конец последовательности
+		bool active() const { return capturing; }
+
+		// Запись копирования изображения кадра; image до и после копирования в состоянии usage.
+		// При смене размера кадра пул пересоздаётся
+		void record(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D imageExtent, ResourceUsage usage);
+		void submitted(uint64_t value); // значение шкалы отправки с записанным копированием
+		void poll(); // передача готовых буферов на кодирование, без ожидания
+
+		uint32_t written(); // число записанных файлов
+		uint32_t failed(); // число кадров, файлы которых записать не удалось
+
+	private:
+		enum class SlotState { Free, Recorded, InFlight, Encoding };
+
+		struct Slot
+		{
+			BufferHandle buffer;
+			VkBuffer vkBuffer;
+			const uint8_t* mapped;
+			SlotState state;
+			uint64_t value; // значение шкалы, после которого в буфере готовый кадр
+			uint32_t frame; // номер кадра последовательности
+			VkExtent2D extent;
+		};
+
+		void createSlots(uint32_t count);
+		void releaseSlots();
+		uint32_t acquireSlot(); // свободный буфер; при его отсутствии - ожидание самого старого
+		void drain(); // ожидание всех буферов в работе
+		void pollLocked();
+		void workerLoop();
+		bool encode(const Slot& slot); // false - файл не записан
+
+		ResourceRegistry* registry = nullptr;
+		ResourceStateTracker* tracker = nullptr;
+		GpuTimeline* timeline = nullptr;
+
+		std::vector<Slot> slots;
+		std::string directory;
+		CaptureFormat format = CaptureFormat::PNG;
+		VkExtent2D extent{};
+		bool bgra = false; // порядок каналов источника
+		bool srgb = false; // значения источника в кодировке sRGB
+		bool capturing = false;
+		uint32_t nextFrame = 0;
+		uint32_t filesWritten = 0;
+		uint32_t filesFailed = 0;
+
+		// Очередь кодирования
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable jobReady;
+		std::condition_variable slotFreed;
+		std::deque<uint32_t> jobs; // индексы слотов
+		bool running = false;
+};
+
+#endif // FRAMECAPTURE_H
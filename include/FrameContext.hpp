@@ -0,0 +1,51 @@
+#ifndef FRAMECONTEXT_H
+#define FRAMECONTEXT_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "ResourceRegistry.hpp"
+
+// Линейный распределитель в отображённом участке буфера.
+// Сбрасывается целиком в начале кадра, когда GPU закончил с его данными
+class FrameArena
+{
+	public:
+		// Участок [base, base + size) буфера; смещения выровнены по alignment
+		void init(VkBuffer buffer, void* mapped, VkDeviceSize base, VkDeviceSize size, VkDeviceSize alignment);
+		void reset() { offset = 0; }
+
+		void* allocate(VkDeviceSize size, VkDeviceSize& bufferOffset); // память для записи и её смещение в буфере
+		VkDeviceSize push(const void* data, VkDeviceSize size); // копирование данных, возвращает смещение в буфере
+
+		VkBuffer buffer() const { return target; }
+		VkDeviceSize used() const { return offset; }
+
+	private:
+		VkBuffer target = VK_NULL_HANDLE;
+		uint8_t* mapped = nullptr;
+		VkDeviceSize base = 0;
+		VkDeviceSize capacity = 0;
+		VkDeviceSize alignment = 1;
+		VkDeviceSize offset = 0;
+};
+
+// Ресурсы одного кадра в работе. Число кадров в работе не связано
+// с числом изображений списка показа
+typedef struct _FrameContext
+{
+	VkCommandPool commandPool; // сбрасывается целиком в начале кадра
+	VkCommandBuffer commandBuffer;
+	VkSemaphore imageAvailable; // захват изображения списка показа
+	uint64_t timelineValue; // кадр выполнен на GPU, когда шкала достигла этого значения
+	FrameArena uniforms; // однородные данные кадра
+	VkDescriptorSet sceneSet; // набор 0 сцены: переписывается, только когда кадр слота выполнен
+	ImageViewHandle sceneTexture; // текстура модели, записанная в sceneSet
+	std::vector<VkDescriptorSet> pyramidSets; // уровни пирамиды глубины; переписываются так же, как sceneSet
+	VkDescriptorSet occlusionSet;
+	uint32_t pyramidGeneration; // поколение пирамиды, записанное в наборы слота
+} FrameContext;
+
+#endif // FRAMECONTEXT_H
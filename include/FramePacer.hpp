@@ -0,0 +1,70 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <chrono>
+#include <cstdint>
+
+// Режим снижения задержки ввода
+enum class LatencyMode
+{
+	Off, // ввод читается сразу после ожидания кадра
+	FenceBeforeInput // перед чтением ввода ждём барьер кадра: ввод сэмплируется как можно позже
+};
+
+// Статистика времени кадра за окно отчёта
+typedef struct _FrameStatistics
+{
+	uint32_t frames; // кадров в окне
+	double fps;
+	double meanMs; // среднее время кадра
+	double deviationMs; // стандартное отклонение времени кадра
+	double minMs;
+	double maxMs;
+} FrameStatistics;
+
+// Планировщик кадров.
+// До срока следующего кадра поток спит, последние миллисекунды (с запасом на
+// неточность таймера ОС) докручиваются активным ожиданием. Пропущенный срок не
+// догоняется серией кадров: отсчёт начинается заново от текущего момента
+class FramePacer
+{
+	public:
+		FramePacer();
+		~FramePacer();
+
+		void setTargetRate(double fps); // 0 - без ограничения
+		void setLatencyMode(LatencyMode mode) { latency = mode; }
+		LatencyMode latencyMode() const { return latency; }
+
+		void wait(); // ожидание начала следующего кадра и замер его времени
+		float delta() const { return smoothedDelta; } // сглаженное время кадра, с
+		float rawDelta() const { return lastDelta; } // последнее измеренное время кадра, с
+
+		// Статистика раз в reportInterval секунд; true, если окно закрыто и stats заполнена
+		bool report(FrameStatistics& stats, double reportInterval = 1.0);
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		void sleepUntil(Clock::time_point deadline);
+
+		Clock::duration interval{}; // период кадра, 0 - без ограничения
+		Clock::time_point deadline; // срок следующего кадра
+		Clock::time_point lastFrame; // начало предыдущего кадра
+		bool started = false;
+		LatencyMode latency = LatencyMode::Off;
+
+		double sleepError = 0.002; // оценка опоздания пробуждения, с
+		float lastDelta = 0.0f;
+		float smoothedDelta = 1.0f / 60.0f;
+
+		// Окно статистики (алгоритм Уэлфорда)
+		Clock::time_point windowStart;
+		uint32_t count = 0;
+		double mean = 0.0;
+		double m2 = 0.0;
+		double minDelta = 0.0;
+		double maxDelta = 0.0;
+};
+
+#endif // FRAMEPACER_H
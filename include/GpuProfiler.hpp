@@ -0,0 +1,108 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// Сводка по области замера за окно последних кадров
+typedef struct _GpuScopeStatistics
+{
+	std::string name;
+	uint32_t samples; // кадров в окне
+	double minMs;
+	double avgMs;
+	double p99Ms; // 99-й процентиль
+	double maxMs;
+	// Статистика конвейера последнего кадра (0, если не поддерживается или область вложенная)
+	uint64_t vertexInvocations;
+	uint64_t fragmentInvocations;
+	uint64_t clippingInvocations; // примитивов на входе отсечения
+	uint64_t clippingPrimitives; // примитивов на выходе отсечения
+} GpuScopeStatistics;
+
+// Профилировщик GPU.
+// Области замера отмечаются метками времени в пуле запросов кадра в работе; верхний уровень
+// вложенности дополнительно оборачивается запросом статистики конвейера (такие запросы
+// не могут быть вложенными). Результаты читаются без ожидания, когда кадр снова
+// начинается в том же слоте - через FRAMES_IN_FLIGHT кадров, его работа к этому моменту завершена
+class GpuProfiler
+{
+	public:
+		// timestampValidBits - из свойств семейства очереди; 0 - метки времени не поддерживаются
+		void init(VkDevice device, const VkPhysicalDeviceProperties& properties, uint32_t timestampValidBits,
+				bool pipelineStatistics, uint32_t framesInFlight, uint32_t maxScopes = 64);
+		void destroy();
+
+		// Начало кадра в слоте frame: чтение результатов его прошлого использования и сброс пулов.
+		// Вызывается, когда GPU завершил прошлый кадр этого слота, вне прохода рендера
+		void beginFrame(VkCommandBuffer commandBuffer, uint32_t frame);
+		void endFrame(VkCommandBuffer commandBuffer);
+
+		void begin(VkCommandBuffer commandBuffer, const std::string& name); // открытие области
+		void end(VkCommandBuffer commandBuffer); // закрытие последней открытой области
+
+		float frameTime() const { return lastFrameMs; } // время GPU последнего прочитанного кадра, мс; 0 - нет данных
+		void statistics(std::vector<GpuScopeStatistics>& result) const; // сводка по всем областям
+		void resetHistory(size_t frames) { history.clear(); historySize = frames; } // очистка сводки и новый размер окна
+
+	private:
+		struct Scope
+		{
+			std::string name; // копия: объявления графа могут смениться до чтения результатов
+			uint32_t depth; // уровень вложенности
+			int32_t statisticsQuery; // -1 - без статистики конвейера
+		};
+
+		struct FrameQueries
+		{
+			VkQueryPool timestamps = VK_NULL_HANDLE; // пара меток на область
+			VkQueryPool statistics = VK_NULL_HANDLE;
+			std::vector<Scope> scopes;
+			uint32_t statisticsCount = 0;
+			bool recorded = false;
+		};
+
+		struct History
+		{
+			std::deque<double> samples; // последние времена, мс
+			uint64_t counters[4] = {}; // статистика конвейера последнего кадра
+		};
+
+		void collect(FrameQueries& queries); // чтение результатов без ожидания
+
+		VkDevice device = VK_NULL_HANDLE;
+		bool enabled = false; // очередь поддерживает метки времени
+		bool pipelineStatistics = false;
+		double timestampPeriod = 1.0; // нс на единицу метки
+		uint64_t timestampMask = ~0ull;
+		uint32_t maxScopes = 0;
+
+		std::vector<FrameQueries> frames;
+		FrameQueries* current = nullptr;
+		std::vector<uint32_t> open; // индексы открытых областей
+		bool statisticsActive = false;
+
+		std::map<std::string, History> history;
+		size_t historySize = 240; // окно сводки, кадров
+		float lastFrameMs = 0.0f;
+};
+
+// Область замера на время жизни объекта
+class GpuScope
+{
+	public:
+		GpuScope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name)
+			: profiler(profiler), commandBuffer(commandBuffer) { profiler.begin(commandBuffer, name); }
+		~GpuScope() { profiler.end(commandBuffer); }
+
+	private:
+		GpuProfiler& profiler;
+		VkCommandBuffer commandBuffer;
+};
+
+#endif // GPUPROFILER_H
@@ -0,0 +1,47 @@
+#ifndef GPUTIMELINE_H
+#define GPUTIMELINE_H
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Временная шкала очереди: семафор с монотонно растущим значением - часы GPU.
+// Каждая отправка сигналит следующее значение и возвращает его; завершение работы,
+// освобождение ресурсов и зависимости между очередями выражаются как «дождаться значения X»
+class GpuTimeline
+{
+	public:
+		void init(VkDevice device, VkQueue queue);
+		void destroy();
+
+		// Отправка буфера команд; возвращает значение, которое шкала получит после его выполнения
+		uint64_t submit(VkCommandBuffer commandBuffer,
+						const std::vector<VkSemaphoreSubmitInfo>& waits = {},
+						const std::vector<VkSemaphoreSubmitInfo>& signals = {});
+
+		uint64_t submitted() const { return lastSubmitted.load(); } // значение последней отправки
+		uint64_t pending() const { return lastSubmitted.load() + 1; } // значение ближайшей будущей отправки
+		uint64_t completed(); // значение, достигнутое GPU
+		bool reached(uint64_t value); // без ожидания
+		void wait(uint64_t value); // ожидание на CPU
+
+		// Ожидание значения этой шкалы в отправке на другую очередь
+		VkSemaphoreSubmitInfo waitInfo(uint64_t value, VkPipelineStageFlags2 stages) const;
+		// Бинарный семафор для отправки (захват и показ изображений списка показа)
+		static VkSemaphoreSubmitInfo binary(VkSemaphore semaphore, VkPipelineStageFlags2 stages);
+
+		VkSemaphore semaphore() const { return timeline; }
+
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkQueue queue = VK_NULL_HANDLE;
+		VkSemaphore timeline = VK_NULL_HANDLE;
+		std::mutex mutex; // VkQueue требует внешней синхронизации
+		std::atomic<uint64_t> lastSubmitted{0};
+		std::atomic<uint64_t> lastCompleted{0}; // кэш, чтобы не опрашивать устройство лишний раз
+};
+
+#endif // GPUTIMELINE_H
@@ -0,0 +1,51 @@
+#ifndef HOTRELOAD_H
+#define HOTRELOAD_H
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "FileWatcher.hpp"
+
+// Сервис горячей перезагрузки шейдеров и ресурсов.
+// Тяжёлая работа (компиляция шейдера, сборка конвейера, чтение текстуры) выполняется
+// в фоновом потоке, а её результат применяется в потоке рендера на границе кадра
+class HotReload
+{
+	public:
+		// Действие на границе кадра: подмена ресурса, запись команд загрузки в буфер кадра.
+		// При остановке сервиса вызывается с VK_NULL_HANDLE и должно только освободить ресурсы
+		typedef std::function<void(VkCommandBuffer)> Commit;
+		// Задача фонового потока; пустой Commit означает, что перезагрузка не удалась
+		typedef std::function<Commit()> Job;
+
+		// Регистрация выполняется до start()
+		void watch(const std::string& path, Job job);
+		void start(); // запуск фонового потока
+		void stop(); // остановка фонового потока
+		void applyPending(VkCommandBuffer commandBuffer); // применение готовых результатов
+
+	private:
+		void workerLoop();
+
+		FileWatcher watcher;
+		std::vector<std::pair<std::string, Job>> jobs; // файл -> задача
+		std::thread worker;
+		std::atomic<bool> running{false};
+		std::mutex stopMutex;
+		std::condition_variable stopSignal;
+		std::mutex pendingMutex;
+		std::vector<Commit> pending; // готовые к применению результаты
+};
+
+// Компиляция GLSL в SPIR-V с помощью glslc. Возвращает false при ошибке компиляции
+bool compileShader(const std::string& source, const std::string& binary);
+
+#endif // HOTRELOAD_H
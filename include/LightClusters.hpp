@@ -0,0 +1,68 @@
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "WorkerPool.hpp"
+
+// Сетка кластеров пирамиды видимости: плитки NDC по X и Y, экспоненциальные срезы глубины по Z
+const uint32_t CLUSTER_X = 16;
+const uint32_t CLUSTER_Y = 9;
+const uint32_t CLUSTER_Z = 24;
+const uint32_t CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+// Источников в списке одного кластера. Лишние отбрасываются, такие кластеры считаются переполненными:
+// GPU считает их за кадр (Vulkan::overflowedLightClusters), эталон возвращает их число.
+// Список живёт в регистрах вызова, поэтому предел не поднят до худшего случая LightClustersBenchmark
+// (191 источник в кластере при 4096, 316 при MAX_LIGHTS)
+const uint32_t CLUSTER_MAX_LIGHTS = 128;
+const uint32_t LIGHT_INDEX_CAPACITY = CLUSTER_COUNT * 32; // общий список индексов всех кластеров
+const uint32_t MAX_LIGHTS = 8192;
+
+// Источник света, шаг 64 байта как у массива std430 в шейдерах
+typedef struct _Light
+{
+	glm::vec4 position; // xyz - мировое положение, w - радиус действия
+	glm::vec4 color; // rgb - цвет, умноженный на яркость
+	glm::vec4 direction; // xyz - направление прожектора
+	glm::vec4 cone; // x - косинус внутреннего угла, y - внешнего, z - синус внешнего, w - 1 у прожектора, 0 у точечного
+} Light;
+
+// Кластер: первый индекс в общем списке и число источников
+typedef struct _LightCluster
+{
+	uint32_t offset;
+	uint32_t count;
+} LightCluster;
+
+// Вид и проекция, по которым строится сетка (glm::perspective с отражённым Y)
+typedef struct _ClusterFrustum
+{
+	glm::mat4 view;
+	float p00, p11; // proj[0][0], proj[1][1]
+	float znear, zfar;
+} ClusterFrustum;
+
+ClusterFrustum clusterFrustum(const glm::mat4& view, const glm::mat4& proj);
+glm::vec2 clusterDepthParams(float znear, float zfar); // срез = floor(log(глубина) * x + y)
+uint32_t clusterIndex(const glm::vec3& world, const ClusterFrustum& frustum); // UINT32_MAX - вне пирамиды
+
+// Границы кластера в пространстве вида (z < 0 перед камерой)
+void clusterBounds(uint32_t x, uint32_t y, uint32_t z, const ClusterFrustum& frustum, glm::vec3& low, glm::vec3& high);
+// Источник в пространстве вида задевает прямоугольник: сфера действия, у прожектора ещё и конус
+bool lightTouchesBox(const Light& viewLight, const glm::vec3& low, const glm::vec3& high);
+// Точка освещается источником (мировые координаты): внутри радиуса и внешнего конуса
+bool lightReaches(const Light& light, const glm::vec3& point);
+
+// Эталон вычислительного прохода light_cull.comp: те же проверки, списки кластеров по порядку.
+// GPU раздаёт участки общего списка атомарным счётчиком, поэтому смещения могут отличаться,
+// но множества источников кластеров совпадают. Возвращает число переполненных кластеров
+uint32_t assignLights(const std::vector<Light>& lights, const ClusterFrustum& frustum,
+				std::vector<LightCluster>& clusters, std::vector<uint32_t>& indices, WorkerPool* workers = nullptr);
+
+// Случайные точечные источники и прожекторы в прямоугольнике; половина - прожекторы, светящие вниз
+void generateLights(uint32_t count, const glm::vec3& low, const glm::vec3& high, uint32_t seed, std::vector<Light>& lights);
+
+#endif // LIGHTCLUSTERS_H
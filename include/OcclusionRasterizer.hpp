@@ -0,0 +1,65 @@
+#ifndef OCCLUSIONRASTERIZER_H
+#define OCCLUSIONRASTERIZER_H
+
+#include "WorkerPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+const uint32_t OCCLUSION_TILE_WIDTH = 8; // пикселей плитки по X: плитка 8 x 4 - 32 бита маски покрытия
+const uint32_t OCCLUSION_TILE_HEIGHT = 4;
+
+// Программный растеризатор заслонок с масками покрытия (masked occlusion culling).
+// Буфер низкого разрешения разбит на плитки 8 x 4; плитка хранит не глубины пикселей, а
+// дальнюю границу глубины всей плитки, маску пикселей рабочего слоя и его дальнюю границу.
+// Треугольник покрывает плитку маской (рёбра считаются SSE по четыре пикселя) с одной
+// консервативной глубиной; когда рабочий слой покрывает плитку целиком, он становится
+// границей плитки. Граница пикселя никогда не ближе настоящей глубины заслонок, поэтому
+// проверка прямоугольника объекта может дать лишнюю видимость, но не ложное перекрытие.
+// Строки плиток растеризуются рабочими потоками независимо.
+// Глубина - z / w матрицы viewProj, меньше - ближе; треугольники с вершиной за камерой
+// (w <= 0) пропускаются, как и объекты с такими углами считаются видимыми
+class OcclusionRasterizer
+{
+	public:
+		void resize(uint32_t width = 256, uint32_t height = 128); // кратно размеру плитки
+		void clear();
+
+		// Заслонки: треугольники по индексам, обе стороны
+		void render(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+					const glm::mat4& viewProj, WorkerPool* workers = nullptr);
+
+		// Прямоугольник проекции AABB хотя бы в одном пикселе ближе границы; вне экрана - false
+		bool visible(const glm::vec3& low, const glm::vec3& high, const glm::mat4& viewProj) const;
+
+		float depth(uint32_t x, uint32_t y) const; // граница глубины пикселя; FLT_MAX - не покрыт
+		uint32_t width() const { return tilesX * OCCLUSION_TILE_WIDTH; }
+		uint32_t height() const { return tilesY * OCCLUSION_TILE_HEIGHT; }
+		uint32_t triangles() const { return rasterized; } // растеризованных треугольников с последнего clear()
+
+	private:
+		// Треугольник в пикселях: рёбра A x + B y + C >= 0 внутри, плоскость глубины, границы
+		struct Triangle
+		{
+			float edgeA[3], edgeB[3], edgeC[3];
+			float depthA, depthB, depthC;
+			float depthMax;
+			int32_t minX, maxX, minY, maxY;
+			bool valid;
+		};
+
+		void setup(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::mat4& viewProj, Triangle& triangle) const;
+		void rasterizeRow(uint32_t tileRow);
+		void insert(uint32_t tile, uint32_t mask, float depth); // слияние покрытия треугольника с плиткой
+
+		uint32_t tilesX = 0, tilesY = 0;
+		std::vector<float> tileDepth; // граница всей плитки
+		std::vector<float> layerDepth; // граница пикселей маски
+		std::vector<uint32_t> layerMask;
+		std::vector<Triangle> setups;
+		uint32_t rasterized = 0;
+};
+
+#endif // OCCLUSIONRASTERIZER_H
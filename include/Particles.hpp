@@ -0,0 +1,84 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+const uint32_t PARTICLE_GROUP = 64; // частиц на рабочую группу particle_emit/simulate/compact.comp
+const uint32_t MAX_PARTICLES = 65535 * PARTICLE_GROUP; // косвенный запуск - не больше 65535 групп
+const uint32_t PARTICLE_SORT_BLOCK = 1024; // элементов, которые particle_sort.comp сортирует в общей памяти
+const uint32_t PARTICLE_SORT_GROUP = PARTICLE_SORT_BLOCK / 2; // поток на пару сравнения
+const float PARTICLE_LIFETIME_MIN = 2.0f; // время жизни частицы в секундах
+const float PARTICLE_LIFETIME_MAX = 4.0f;
+const float PARTICLE_MAX_STEP = 0.1f; // больше шаг симуляции не бывает (пауза, загрузка)
+const uint32_t PARTICLE_SORT_SENTINEL = 0xFFFFFFFFu; // ключ элементов за числом видимых
+
+// Частица в буфере устройства (std430)
+typedef struct _Particle
+{
+	glm::vec4 position; // xyz, w - оставшаяся жизнь в секундах
+	glm::vec4 velocity; // xyz, w - полное время жизни
+} Particle;
+
+// Счётчики списков. Живые частицы - в одном из двух списков, list - номер списка текущего кадра;
+// сжатие переписывает выживших в другой список, погибших - в список свободных
+typedef struct _ParticleCounters
+{
+	uint32_t list;
+	uint32_t alive[2];
+	uint32_t dead;
+	uint32_t emit; // рождается в этом кадре: запрос, ограниченный числом свободных
+} ParticleCounters;
+
+// Аргументы косвенных запусков, которые пишет particle_kickoff.comp (VkDispatchIndirectCommand)
+typedef struct _ParticleDispatch
+{
+	uint32_t emit[3];
+	uint32_t simulate[3]; // на живых после рождения: его же использует сжатие
+} ParticleDispatch;
+
+// Push-константы particle_kickoff/emit/simulate/compact.comp
+typedef struct _ParticleParams
+{
+	glm::mat4 viewProj; // отсечение видимых при сжатии
+	glm::vec4 emitter; // положение, w - разброс горизонтальной скорости
+	glm::vec4 camera; // положение камеры, w - шаг времени
+	uint32_t capacity;
+	uint32_t emitRequest; // рождений в этом кадре, если хватит свободных
+	uint32_t seed;
+} ParticleParams;
+
+// Шаг битонной сортировки: Local - блок целиком в общей памяти, Flip и Disperse - одно
+// сравнение на поток по всему буферу, Merge - шаги j < PARTICLE_SORT_BLOCK внутри блока
+enum class ParticleSortMode : uint32_t
+{
+	Local,
+	Flip,
+	Disperse,
+	Merge
+};
+
+typedef struct _ParticleSortStep
+{
+	ParticleSortMode mode;
+	uint32_t k; // размер сортируемых последовательностей
+	uint32_t j; // расстояние сравнения для Disperse
+} ParticleSortStep;
+
+// Частиц в секунду, при которых пул почти заполнен, но не переполняется
+inline float particleEmitRate(uint32_t capacity) { return capacity / PARTICLE_LIFETIME_MAX; }
+
+// Шаги сортировки буфера из capacity элементов (округляется до степени двойки, не меньше блока).
+// Вариант битонной сортировки без смены направления: каждая последовательность k сначала
+// сравнивается зеркально (Flip), затем половинами (Disperse), и меньший ключ всегда уходит
+// к меньшему номеру. Поэтому элементы за числом видимых никуда не двигаются: шейдер считает
+// их ключи бесконечными, не читает и не пишет, и буфер не нужно дополнять
+void particleSortSteps(uint32_t capacity, std::vector<ParticleSortStep>& steps);
+
+// Эталон шага на CPU, как его выполняет particle_sort.comp: пары (ключ, номер частицы),
+// сортируются первые count элементов
+void particleSortStep(const ParticleSortStep& step, std::vector<glm::uvec2>& entries, uint32_t count);
+
+#endif // PARTICLES_H
@@ -0,0 +1,189 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ResourceRegistry.hpp"
+#include "ResourceStateTracker.hpp"
+#include "GpuProfiler.hpp"
+
+typedef Handle<struct GraphResourceTag> GraphResource; // ресурс графа
+
+// Описание изображения графа
+typedef struct _GraphImageDesc
+{
+	VkExtent2D extent;
+	VkFormat format;
+	VkImageAspectFlags aspectMask;
+	VkImageUsageFlags usage; // флаги сверх выведенных из объявленных использований
+} GraphImageDesc;
+
+class RenderGraph;
+
+// Объявление ресурсов прохода
+class PassBuilder
+{
+	public:
+		PassBuilder& read(GraphResource resource, ResourceUsage usage);
+		PassBuilder& write(GraphResource resource, ResourceUsage usage);
+		// Вложения; операция сохранения выводится графом: STORE, только если содержимое нужно дальше
+		PassBuilder& color(GraphResource resource, VkAttachmentLoadOp loadOp, VkClearColorValue clear = {});
+		PassBuilder& depth(GraphResource resource, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clear = {1.0f, 0}, bool readOnly = false);
+		PassBuilder& sideEffect(); // проход не отсекается, даже если его результат не читается
+
+	private:
+		friend class RenderGraph;
+		PassBuilder(RenderGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+
+		RenderGraph& graph;
+		uint32_t pass;
+};
+
+// Граф кадра.
+// Проходы объявляют чтения и записи ресурсов, граф при компиляции отсекает проходы,
+// результат которых не используется, определяет время жизни временных изображений
+// и совмещает в памяти те, чьи времена жизни не пересекаются. При выполнении барьеры
+// строятся трекером состояний перед каждым проходом, проходы с вложениями
+// оборачиваются в проход рендера с кэшированными буферами кадра или, в режиме
+// динамического рендера, в vkCmdBeginRendering без проходов и буферов кадра.
+// Временные изображения, которые живут только во вложениях и не сохраняются,
+// создаются с VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT в лениво выделяемой памяти.
+// Компиляция кэшируется до изменения объявлений
+class RenderGraph
+{
+	public:
+		typedef std::function<void(VkCommandBuffer)> Execute;
+
+		void init(VkDevice device, ResourceRegistry* registry, ResourceStateTracker* tracker, bool dynamicRendering);
+		void destroy(); // устройство должно простаивать
+		void setProfiler(GpuProfiler* profiler) { this->profiler = profiler; } // проходы замеряются как области профилировщика
+		void reset(); // удаление объявлений, ресурсы освобождаются при следующей компиляции
+
+		GraphResource createImage(const std::string& name, const GraphImageDesc& desc); // временное изображение
+		// Внешнее изображение: после графа переводится в finalUsage.
+		// С initial изображение каждый кадр начинает с этого состояния (например, захваченное из списка показа),
+		// иначе оно должно отслеживаться трекером вызывающей стороной
+		GraphResource importImage(const std::string& name, const GraphImageDesc& desc, ResourceUsage finalUsage,
+								const ResourceState* initial = nullptr);
+		GraphResource importBuffer(const std::string& name, ResourceUsage finalUsage); // буфер отслеживается вызывающей стороной
+		void bindImage(GraphResource resource, VkImage image, VkImageView view); // привязка внешнего изображения на кадр
+		void bindBuffer(GraphResource resource, VkBuffer buffer);
+
+		PassBuilder addPass(const std::string& name, Execute execute);
+
+		void compile(); // отсечение, времена жизни, совмещение памяти, проходы рендера
+		void execute(VkCommandBuffer commandBuffer); // запись кадра, при изменении объявлений - с компиляцией
+
+		VkImage image(GraphResource resource) const;
+		VkImageView view(GraphResource resource) const;
+		VkBuffer buffer(GraphResource resource) const;
+		VkRenderPass renderPass(const std::string& pass) const; // для создания конвейеров; при динамическом рендере - VK_NULL_HANDLE
+		// Форматы вложений прохода для VkPipelineRenderingCreateInfo
+		void attachmentFormats(const std::string& pass, std::vector<VkFormat>& colorFormats, VkFormat& depthFormat) const;
+		bool active(const std::string& pass) const; // проход не отсечён
+
+		VkDeviceSize transientMemory() const { return aliasedSize; } // память временных изображений
+		VkDeviceSize transientMemoryUnaliased() const { return unaliasedSize; } // та же память без совмещения
+		VkDeviceSize transientMemoryLazy() const { return lazySize; } // лениво выделяемая память (может не занимать места)
+
+	private:
+		friend class PassBuilder;
+
+		struct Resource
+		{
+			std::string name;
+			bool imported;
+			bool isBuffer;
+			GraphImageDesc desc;
+			ResourceUsage finalUsage;
+			bool resetEachFrame; // внешнее изображение начинает кадр с состояния initial
+			ResourceState initial; // для временных - состояние, оставленное предыдущим владельцем памяти
+			VkImage image;
+			VkImageView view;
+			VkBuffer buffer;
+
+			// Результаты компиляции
+			ImageHandle imageHandle;
+			ImageViewHandle viewHandle;
+			uint32_t firstPass, lastPass; // время жизни в проходах
+			VkImageUsageFlags usage;
+			ResourceState lastState; // состояние после последнего использования
+			VkMemoryRequirements requirements;
+			uint32_t block; // блок памяти
+			VkDeviceSize offset; // смещение в блоке
+		};
+
+		struct Access
+		{
+			uint32_t resource;
+			ResourceUsage usage;
+			bool read; // содержимое до прохода нужно
+			bool write; // проход меняет содержимое
+		};
+
+		struct Attachment
+		{
+			uint32_t resource;
+			VkAttachmentLoadOp loadOp;
+			VkAttachmentStoreOp storeOp;
+			VkClearValue clear;
+			VkImageLayout layout;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			Execute execute;
+			std::vector<Access> accesses;
+			std::vector<Attachment> attachments; // цветовые, затем глубина
+			bool hasDepth = false;
+			bool sideEffect = false;
+			bool alive = false;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+		};
+
+		struct MemoryBlock
+		{
+			uint32_t memoryType;
+			bool lazy; // лениво выделяемая память
+			VkDeviceSize size;
+			VkDeviceMemory memory;
+		};
+
+		void cull();
+		void computeLifetimes();
+		void allocateTransients();
+		VkRenderPass findRenderPass(const Pass& pass); // из кэша по форматам, операциям и раскладкам
+		VkFramebuffer findFramebuffer(Pass& pass);
+		void beginRendering(VkCommandBuffer commandBuffer, Pass& pass); // начало прохода с вложениями
+		bool memoryless(uint32_t resource) const; // изображение не покидает вложения и не сохраняется
+		void releaseCompiled(bool immediate); // освобождение результатов прошлой компиляции
+		uint32_t passIndex(const std::string& name) const;
+		const Resource& resource(GraphResource handle) const;
+
+		VkDevice device = VK_NULL_HANDLE;
+		ResourceRegistry* registry = nullptr;
+		ResourceStateTracker* tracker = nullptr;
+		GpuProfiler* profiler = nullptr;
+		bool dynamicRendering = false;
+
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		bool dirty = true;
+		uint32_t generation = 0; // поколение объявлений: сброс делает дескрипторы ресурсов недействительными
+
+		std::vector<MemoryBlock> blocks;
+		std::map<std::vector<uint64_t>, VkRenderPass> renderPasses; // переживают перекомпиляцию
+		std::map<std::pair<VkRenderPass, std::vector<VkImageView>>, VkFramebuffer> framebuffers;
+		VkDeviceSize aliasedSize = 0;
+		VkDeviceSize unaliasedSize = 0;
+		VkDeviceSize lazySize = 0;
+};
+
+#endif // RENDERGRAPH_H
@@ -0,0 +1,39 @@
+#ifndef RESOLUTIONSCALER_H
+#define RESOLUTIONSCALER_H
+
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+
+// Регулятор внутреннего разрешения.
+// Стоимость кадра примерно пропорциональна числу пикселей, поэтому масштаб по осям
+// меняется как корень отношения бюджета к сглаженному времени GPU. Зона нечувствительности
+// и ограничение шага не дают разрешению дрожать от кадра к кадру
+class ResolutionScaler
+{
+	public:
+		// Границы масштаба по каждой оси относительно разрешения списка показа
+		void setBounds(glm::vec2 minScale, glm::vec2 maxScale);
+		void setBudget(float milliseconds) { budget = milliseconds; } // 0 - масштаб не меняется
+
+		void update(float gpuMilliseconds); // время GPU завершённого кадра
+		glm::vec2 scale() const { return current; }
+		glm::vec2 maxScale() const { return upper; }
+
+		VkExtent2D extent(VkExtent2D full) const; // внутреннее разрешение для текущего масштаба
+		VkExtent2D maxExtent(VkExtent2D full) const; // размер цели рендера: с ним масштаб меняется без пересоздания
+
+	private:
+		glm::vec2 lower = glm::vec2(0.5f);
+		glm::vec2 upper = glm::vec2(1.0f);
+		glm::vec2 current = glm::vec2(1.0f);
+		float budget = 0.0f;
+		float smoothed = 0.0f; // сглаженное время GPU, мс
+
+		const float headroom = 0.9f; // целевая доля бюджета: запас на всплески
+		const float deadZone = 0.05f; // относительное отклонение, на которое регулятор не реагирует
+		const float maxStep = 0.05f; // наибольшее изменение масштаба за кадр
+		const float smoothing = 0.1f; // вес нового замера
+};
+
+#endif // RESOLUTIONSCALER_H
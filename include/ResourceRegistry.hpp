@@ -0,0 +1,142 @@
+#ifndef RESOURCEREGISTRY_H
+#define RESOURCEREGISTRY_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "DeletionQueue.hpp"
+#include "GpuTimeline.hpp"
+
+// Дескриптор ресурса с поколением: после освобождения слот получает новое поколение,
+// и старые дескрипторы перестают проходить проверку
+template<typename Tag>
+struct Handle
+{
+	uint32_t index = UINT32_MAX; // слот в хранилище
+	uint32_t generation = 0; // поколение слота
+
+	bool valid() const { return index != UINT32_MAX; }
+	bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+typedef Handle<struct BufferTag> BufferHandle;
+typedef Handle<struct ImageTag> ImageHandle;
+typedef Handle<struct ImageViewTag> ImageViewHandle;
+
+// Выдача слотов и учёт поколений
+typedef struct _SlotAllocator
+{
+	std::vector<uint32_t> generations; // текущее поколение каждого слота
+	std::vector<uint32_t> freeSlots; // освобождённые слоты
+
+	uint32_t allocate(); // индекс свободного слота
+	void free(uint32_t index) { generations[index]++; freeSlots.push_back(index); }
+	bool alive(uint32_t index, uint32_t generation) const { return index < generations.size() && generations[index] == generation; }
+} SlotAllocator;
+
+// Реестр ресурсов GPU.
+// Буферы, изображения и их виды хранятся в массивах по полям (SoA) и адресуются дескрипторами.
+// Освобождение отложенное: объекты копятся в открытой очереди, которая при отправке кадра
+// помечается значением временной шкалы (seal), и уничтожаются, когда GPU достиг этого значения (collect)
+class ResourceRegistry
+{
+	public:
+		void init(VkDevice device, const VkPhysicalDeviceMemoryProperties& memory, GpuTimeline* timeline);
+		void destroy(); // уничтожение всех ресурсов, устройство должно простаивать
+
+		BufferHandle createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+		ImageHandle createImage(uint32_t width, uint32_t height, VkFormat format,
+								VkImageTiling tiling, VkImageUsageFlags usage,
+								VkMemoryPropertyFlags properties, uint32_t mipLevels = 1, uint32_t arrayLayers = 1);
+		// Вид части уровней и слоёв; по умолчанию - первый уровень первого слоя
+		ImageViewHandle createImageView(ImageHandle image, VkFormat format, VkImageAspectFlags aspectFlags,
+										VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D, uint32_t baseMipLevel = 0, uint32_t levelCount = 1,
+										uint32_t baseArrayLayer = 0, uint32_t layerCount = 1);
+
+		// Изображение без собственной памяти: память выделяет и освобождает владелец (совмещение памяти)
+		ImageHandle createUnboundImage(uint32_t width, uint32_t height, VkFormat format,
+										VkImageTiling tiling, VkImageUsageFlags usage);
+		VkMemoryRequirements memoryRequirements(ImageHandle handle);
+		void bindMemory(ImageHandle handle, VkDeviceMemory memory, VkDeviceSize offset);
+
+		// Доступ к объектам Vulkan
+		VkBuffer buffer(BufferHandle handle);
+		VkDeviceSize bufferSize(BufferHandle handle);
+		void* map(BufferHandle handle); // постоянное отображение памяти буфера
+		VkImage image(ImageHandle handle);
+		VkExtent2D imageExtent(ImageHandle handle);
+		VkImageView view(ImageViewHandle handle);
+
+		// Отложенное освобождение: дескриптор становится недействительным сразу,
+		// объекты уничтожаются после завершения кадров, которые могли их использовать
+		void release(BufferHandle handle);
+		void release(ImageHandle handle);
+		void release(ImageViewHandle handle);
+		void release(std::function<void()>&& deleter); // произвольный объект (конвейер, набор дескрипторов)
+
+		// Немедленное освобождение ресурса, который гарантированно не использовался GPU
+		void destroyNow(BufferHandle handle);
+		void destroyNow(ImageHandle handle);
+		void destroyNow(ImageViewHandle handle);
+
+		// Открытая очередь уничтожается после достижения шкалой значения value.
+		// Вызывается после отправки, которая могла использовать освобождённые ресурсы
+		void seal(uint64_t value);
+		// Уничтожение объектов, значения которых GPU уже достиг
+		void collect();
+
+		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+	private:
+		VkImage newImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
+						uint32_t mipLevels = 1, uint32_t arrayLayers = 1);
+		ImageHandle addImage(VkImage image, VkDeviceMemory memory, uint32_t width, uint32_t height, VkFormat format);
+		std::function<void()> takeBuffer(BufferHandle handle); // изъятие объектов слота
+		std::function<void()> takeImage(ImageHandle handle);
+		std::function<void()> takeImageView(ImageViewHandle handle);
+
+		VkDevice device = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties memory{};
+		std::mutex mutex; // ресурсы создаются и из фоновых потоков
+
+		// Буферы
+		struct
+		{
+			SlotAllocator slots;
+			std::vector<VkBuffer> buffers;
+			std::vector<VkDeviceMemory> memories;
+			std::vector<VkDeviceSize> sizes;
+			std::vector<void*> mapped;
+		} buffers;
+
+		// Изображения
+		struct
+		{
+			SlotAllocator slots;
+			std::vector<VkImage> images;
+			std::vector<VkDeviceMemory> memories;
+			std::vector<VkExtent2D> extents;
+			std::vector<VkFormat> formats;
+		} images;
+
+		// Виды изображений
+		struct
+		{
+			SlotAllocator slots;
+			std::vector<VkImageView> views;
+			std::vector<ImageHandle> images;
+		} views;
+
+		GpuTimeline* timeline = nullptr;
+		DeletionQueue openQueue; // освобождённые после последней seal
+		std::deque<std::pair<uint64_t, DeletionQueue>> retiring; // по возрастанию значения шкалы
+};
+
+#endif // RESOURCEREGISTRY_H
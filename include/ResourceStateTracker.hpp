@@ -0,0 +1,114 @@
+#ifndef RESOURCESTATETRACKER_H
+#define RESOURCESTATETRACKER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Объявленное использование ресурса
+enum class ResourceUsage
+{
+	Undefined, // содержимое не нужно
+	TransferSrc, // источник копирования
+	TransferDst, // приёмник копирования
+	VertexShaderRead, // чтение в вершинном шейдере
+	FragmentShaderRead, // чтение во фрагментном шейдере
+	ComputeShaderRead, // чтение в вычислительном шейдере
+	ComputeShaderWrite, // запись в вычислительном шейдере
+	ComputeShaderReadWrite, // чтение и запись в вычислительном шейдере
+	ColorAttachment, // цветовое вложение
+	DepthAttachment, // вложение глубины с записью
+	DepthAttachmentRead, // вложение глубины только для теста
+	DepthShaderRead, // чтение глубины в шейдерах
+	Present, // показ
+	VertexBuffer, // буфер вершин
+	IndexBuffer, // буфер индексов
+	UniformBuffer, // однородный буфер
+	IndirectBuffer, // аргументы косвенной отрисовки
+	HostRead // чтение на CPU
+};
+
+// Состояние синхронизации: стадии, доступ и раскладка (для буферов раскладка не используется)
+typedef struct _ResourceState
+{
+	VkPipelineStageFlags2 stages;
+	VkAccessFlags2 access;
+	VkImageLayout layout;
+} ResourceState;
+
+ResourceState resourceState(ResourceUsage usage); // состояние, соответствующее использованию
+
+// Отслеживание состояния ресурсов и построение минимального набора барьеров.
+// Для каждого подресурса изображения (уровень, слой) и каждого буфера хранятся
+// раскладка, последняя запись и стадии, которым она уже видна. Барьеры копятся
+// до точки перехода и записываются одним vkCmdPipelineBarrier2.
+// Вся логика, кроме flush(), не обращается к устройству
+class ResourceStateTracker
+{
+	public:
+		void trackImage(VkImage image, VkImageAspectFlags aspectMask, uint32_t mipLevels = 1, uint32_t arrayLayers = 1,
+						ResourceState initial = resourceState(ResourceUsage::Undefined));
+		void trackBuffer(VkBuffer buffer, ResourceState initial = resourceState(ResourceUsage::Undefined));
+		void forget(VkImage image); // перед уничтожением: дескрипторы Vulkan могут использоваться повторно
+		void forget(VkBuffer buffer);
+
+		// Объявление использования; при необходимости добавляет барьер в текущую точку перехода
+		void use(VkImage image, ResourceUsage usage);
+		void use(VkImage image, const ResourceState& state, uint32_t baseMipLevel = 0, uint32_t levelCount = VK_REMAINING_MIP_LEVELS,
+				uint32_t baseArrayLayer = 0, uint32_t layerCount = VK_REMAINING_ARRAY_LAYERS);
+		void use(VkBuffer buffer, ResourceUsage usage);
+		void use(VkBuffer buffer, const ResourceState& state);
+
+		// Состояние изменено вне трекера (например, финальной раскладкой прохода рендера)
+		void assume(VkImage image, ResourceUsage usage);
+
+		ResourceState state(VkImage image, uint32_t mipLevel = 0, uint32_t arrayLayer = 0) const;
+		ResourceState state(VkBuffer buffer) const;
+
+		// Накопленные барьеры текущей точки перехода
+		const std::vector<VkImageMemoryBarrier2>& pendingImageBarriers() const { return imageBarriers; }
+		const std::vector<VkBufferMemoryBarrier2>& pendingBufferBarriers() const { return bufferBarriers; }
+		bool hasPending() const { return !imageBarriers.empty() || !bufferBarriers.empty(); }
+		VkDependencyInfo dependencyInfo() const; // все барьеры точки перехода, как их записывает flush()
+
+		void flush(VkCommandBuffer commandBuffer); // запись барьеров и закрытие точки перехода
+		void discardPending(); // закрытие точки перехода без записи
+
+	private:
+		// Состояние подресурса
+		struct Subresource
+		{
+			VkImageLayout layout;
+			VkPipelineStageFlags2 writeStages; // стадии последней записи (или смены раскладки)
+			VkAccessFlags2 writeAccess; // доступ последней записи
+			VkPipelineStageFlags2 readStages; // стадии, читавшие после записи
+			VkPipelineStageFlags2 visibleStages; // стадии, которым запись видна
+			VkAccessFlags2 visibleAccess; // доступы, которым запись видна
+			uint32_t batch; // точка перехода, в которой для подресурса создан барьер
+			uint32_t barrier; // индекс этого барьера
+		};
+
+		struct Image
+		{
+			VkImageAspectFlags aspectMask;
+			uint32_t mipLevels;
+			uint32_t arrayLayers;
+			std::vector<Subresource> subresources; // [слой * mipLevels + уровень]
+		};
+
+		// Переход подресурса в новое состояние. Возвращает true, если нужен барьер,
+		// и заполняет его маски и раскладки
+		bool transition(Subresource& subresource, const ResourceState& state,
+						VkPipelineStageFlags2& srcStages, VkAccessFlags2& srcAccess, VkImageLayout& oldLayout);
+		static Subresource initialSubresource(const ResourceState& state);
+
+		std::unordered_map<VkImage, Image> images;
+		std::unordered_map<VkBuffer, Subresource> buffers;
+		std::vector<VkImageMemoryBarrier2> imageBarriers;
+		std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+		uint32_t batch = 1; // номер текущей точки перехода
+};
+
+#endif // RESOURCESTATETRACKER_H
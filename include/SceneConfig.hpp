@@ -0,0 +1,31 @@
+#ifndef SCENECONFIG_H
+#define SCENECONFIG_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Описание сцены: модель, текстура и начальная камера
+typedef struct _SceneConfig
+{
+	std::string model = "models/Model.fbx";
+	std::string texture = "models/ork_body_D.png";
+	glm::vec3 cameraPos = glm::vec3(0.0f, 1.25f, 4.0f);
+	glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+	std::vector<std::string> animations; // файлы с клипами для скелета модели (кроме клипов самой модели)
+	uint32_t crowd = 0; // экземпляров модели в толпе
+	uint32_t heightfield = 0; // вершин по стороне анимированной сетки высот, 0 - без сетки
+	std::string terrain; // каталог плиток высот ландшафта, пусто - без ландшафта
+	uint32_t lights = 0; // случайных точечных источников и прожекторов над сценой, 0 - без освещения
+	glm::vec3 sun = glm::vec3(0.4f, 0.8f, 0.3f); // направление на солнце
+	uint32_t particles = 0; // частиц в пуле GPU, 0 - без частиц
+	glm::vec3 emitter = glm::vec3(0.0f, 0.0f, -3.0f); // фонтан частиц
+} SceneConfig;
+
+// Чтение файла сцены из строк «ключ = значение» (model, texture, camera, front, animation, crowd, heightfield, terrain, lights, sun, particles, emitter; # - комментарий).
+// Ключ animation может повторяться.
+// Отсутствующие ключи сохраняют значения по умолчанию
+SceneConfig loadSceneConfig(const std::string& path);
+
+#endif // SCENECONFIG_H
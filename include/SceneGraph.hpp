@@ -0,0 +1,62 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "WorkerPool.hpp"
+
+typedef uint32_t SceneNode; // постоянный номер узла
+const SceneNode NO_SCENE_NODE = UINT32_MAX;
+
+// Иерархия преобразований в плоских массивах по полям (SoA).
+// Узлы хранятся в порядке обхода в ширину: уровни глубины подряд, дети одного родителя рядом,
+// родитель всегда раньше ребёнка. Мировые матрицы считаются уровень за уровнем, по умножению
+// SSE на узел; список уровня делится на участки для пула потоков. Изменённый узел попадает
+// в список своего уровня, при обновлении в список следующего уровня добавляются его дети
+// (участок подряд в порядке обхода) - неизменённые поддеревья не посещаются.
+// Изменения структуры (создание, удаление, смена родителя) применяются перестроением порядка
+// в начале update()
+class SceneGraph
+{
+	public:
+		SceneNode create(SceneNode parent = NO_SCENE_NODE, const glm::mat4& local = glm::mat4(1.0f));
+		void remove(SceneNode node); // вместе с поддеревом
+		void setParent(SceneNode node, SceneNode parent);
+		void setLocal(SceneNode node, const glm::mat4& local);
+
+		const glm::mat4& local(SceneNode node) const { return locals[indices[node]]; }
+		const glm::mat4& world(SceneNode node) const { return worlds[indices[node]]; } // на момент последнего update()
+		bool alive(SceneNode node) const { return node < indices.size() && indices[node] != UINT32_MAX; }
+		uint32_t size() const { return static_cast<uint32_t>(parents.size()); }
+		uint32_t levelCount() const { return levels.empty() ? 0 : static_cast<uint32_t>(levels.size()) - 1; }
+
+		// Пересчёт мировых матриц изменённых узлов; без пула - в вызывающем потоке
+		void update(WorkerPool* pool = nullptr, uint32_t grain = 4096);
+
+	private:
+		void rebuild(); // порядок обхода в ширину и границы уровней
+		void updateSlice(const uint32_t* list, uint32_t begin, uint32_t end); // list == nullptr - индексы подряд
+		void mark(uint32_t index); // пометка узла и постановка в список изменённых
+
+		// Поля узлов по индексу в порядке обхода
+		std::vector<uint32_t> parents; // индекс родителя или UINT32_MAX
+		std::vector<glm::mat4> locals;
+		std::vector<glm::mat4> worlds;
+		std::vector<uint8_t> dirty; // локальная матрица или родитель изменились
+		std::vector<uint32_t> firstChild; // дети узла - участок [firstChild, firstChild + childCount)
+		std::vector<uint32_t> childCount;
+		std::vector<uint8_t> removed;
+		std::vector<SceneNode> nodes; // номер узла по индексу
+
+		std::vector<uint32_t> indices; // индекс по номеру узла, UINT32_MAX - свободный номер
+		std::vector<SceneNode> freeNodes;
+		std::vector<uint32_t> levels; // начало каждого уровня и конец последнего
+		bool structureChanged = false;
+		std::vector<uint32_t> marked; // помеченные с прошлого update() индексы; после rebuild() - заново по флагам
+		std::vector<std::vector<uint32_t>> dirtyLevels; // изменённые узлы по уровням во время update()
+};
+
+#endif // SCENEGRAPH_H
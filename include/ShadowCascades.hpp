@@ -0,0 +1,67 @@
+#ifndef SHADOWCASCADES_H
+#define SHADOWCASCADES_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+const uint32_t SHADOW_CASCADES = 4; // каскадов - слоёв карты теней
+const uint32_t SHADOW_MAP_SIZE = 2048; // текселей по стороне слоя
+const uint32_t SHADOW_CACHED_FROM = 2; // каскады с этого номера кэшируют статическую геометрию
+const float SHADOW_DISTANCE = 500.0f; // дальше тени не строятся
+const float SHADOW_SPLIT_LAMBDA = 0.9f; // доля логарифмического разбиения в практическом
+const float SHADOW_CACHE_MARGIN = 0.25f; // запас кэшируемого каскада в долях радиуса среза
+const float SHADOW_CASTER_DISTANCE = 300.0f; // насколько заслонки могут быть ближе к свету, чем срез
+
+// Каскад: ортографическая проекция вдоль света вокруг описанной сферы среза пирамиды видимости
+typedef struct _ShadowCascade
+{
+	glm::mat4 view; // поворот к свету и перенос в центр
+	glm::mat4 proj; // glm::orthoRH_ZO: глубина 0 у света
+	glm::vec3 center; // центр в мировых координатах, привязан к текселю
+	float radius; // половина стороны квадрата каскада
+	float splitFar; // дальняя граница среза по глубине вида
+} ShadowCascade;
+
+// Описанная сфера среза [sliceNear, sliceFar] симметричной пирамиды: радиус зависит только
+// от границ и угла обзора, а не от поворота камеры; центр - на оси взгляда на глубине depth
+float sliceSphere(float tanHalfFovY, float aspect, float sliceNear, float sliceFar, float& depth);
+
+// Каскад со стабильными краями: поворот к свету один на все кадры, сторона постоянна,
+// центр сдвигается на целое число текселей - при движении камеры тени не мерцают
+ShadowCascade fitCascade(const glm::vec3& center, float radius, const glm::mat4& lightRotation);
+
+glm::mat4 lightRotation(const glm::vec3& direction); // вид из начала координат вдоль лучей света
+glm::mat4 shadowMatrix(const ShadowCascade& cascade); // мир -> (u, v, глубина) слоя карты
+// Сфера (мировые координаты) задевает объём ортографической проекции каскада, включая заслонки у света
+bool cascadeTouches(const ShadowCascade& cascade, const glm::vec3& center, float radius);
+
+// Каскадные тени направленного света с кэшем дальних каскадов.
+// Ближние каскады рисуются каждый кадр. Кэшируемые строятся вокруг сферы среза, увеличенной
+// на SHADOW_CACHE_MARGIN, и хранят свою матрицу, пока срез текущего кадра помещается в них:
+// статическая геометрия (ландшафт) перерисовывается только при повороте света, выходе
+// среза за запас или смене статической геометрии. Динамические заслонки в кэшируемых
+// каскадах рисуются поверх копии статической глубины
+class ShadowCascades
+{
+	public:
+		void setLight(const glm::vec3& direction); // направление лучей, от солнца
+		void invalidate() { staticMask = (1u << SHADOW_CASCADES) - 1; }
+
+		// Каскады кадра по камере. staticRevision меняется вместе со статической геометрией.
+		// Возвращает маску кэшируемых каскадов, статическую глубину которых нужно перерисовать
+		uint32_t update(const glm::mat4& view, float tanHalfFovY, float aspect, float znear, float zfar, uint64_t staticRevision);
+
+		const ShadowCascade& cascade(uint32_t index) const { return cascades[index]; }
+		glm::vec4 splits() const; // дальние границы срезов по глубине вида
+		glm::vec3 direction() const { return lightDirection; }
+
+	private:
+		glm::vec3 lightDirection = glm::normalize(glm::vec3(-0.4f, -0.8f, -0.3f));
+		glm::mat4 rotation = lightRotation(glm::normalize(glm::vec3(-0.4f, -0.8f, -0.3f)));
+		ShadowCascade cascades[SHADOW_CASCADES] = {};
+		uint32_t staticMask = (1u << SHADOW_CASCADES) - 1; // кэш каскада недействителен
+		uint64_t revision = 0;
+};
+
+#endif // SHADOWCASCADES_H
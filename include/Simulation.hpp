@@ -0,0 +1,68 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "TripleBuffer.hpp"
+
+// Кнопки управления, считываемые потоком окна
+enum SimulationInput : uint32_t
+{
+	INPUT_FORWARD = 1 << 0,
+	INPUT_BACK = 1 << 1,
+	INPUT_LEFT = 1 << 2,
+	INPUT_RIGHT = 1 << 3,
+	INPUT_UP = 1 << 4,
+	INPUT_DOWN = 1 << 5
+};
+
+// Состояние мира, которое нужно рендеру
+typedef struct _SimulationState
+{
+	glm::vec3 cameraPos;
+	glm::vec3 cameraFront;
+	glm::vec3 cameraUp;
+	float animationTime;
+} SimulationState;
+
+// Симуляция с фиксированным шагом в отдельном потоке.
+// После каждого шага публикуются два последних состояния и момент шага;
+// рендер интерполирует между ними, отставая ровно на один шаг.
+// Медленный кадр GPU не задерживает шаги, а шаг может быть чаще кадров
+class Simulation
+{
+	public:
+		void start(const SimulationState& initial, double step = 1.0 / 120.0);
+		void stop();
+
+		void setInput(uint32_t buttons) { input.store(buttons, std::memory_order_relaxed); } // поток окна
+		SimulationState sample(); // интерполированное состояние на текущий момент, поток рендера
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		// Публикуемый снимок: предыдущее и текущее состояния
+		struct Snapshot
+		{
+			SimulationState previous;
+			SimulationState current;
+			Clock::time_point time; // момент текущего состояния
+		};
+
+		void loop();
+		static void tick(SimulationState& state, uint32_t buttons, float dt);
+
+		std::thread worker;
+		std::atomic<bool> running{false};
+		std::atomic<uint32_t> input{0};
+		TripleBuffer<Snapshot> snapshots;
+		SimulationState state{};
+		Clock::duration step{};
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,118 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+const uint32_t TERRAIN_TILE = 256; // отсчётов высоты по стороне файла плитки
+const uint32_t TERRAIN_LEVELS = 8; // уровней клипмапа; уровень l читает плитки уровня детализации l
+const uint32_t TERRAIN_BLOCK = 63; // m: сетка уровня - 4m ячеек по стороне
+const uint32_t TERRAIN_WINDOW = 256; // текселей по стороне слоя высот уровня (тороидальная адресация)
+const uint32_t TERRAIN_OCCLUDER_LEVEL = 2; // уровень, по которому строится заслонка для программного отсечения
+const uint32_t TERRAIN_OCCLUDER_STEP = 8; // ячеек уровня в ячейке заслонки
+
+// Файл плитки: заголовок и TERRAIN_TILE x TERRAIN_TILE отсчётов uint16 в диапазоне [minHeight, maxHeight].
+// Плитки уровня детализации k + 1 - прореживание уровня k через отсчёт, без фильтрации:
+// чётные вершины соседних колец совпадают точно
+bool loadHeightTile(const std::string& path, std::vector<float>& heights); // false - файла нет
+void saveHeightTile(const std::string& path, const std::vector<float>& heights, float minHeight, float maxHeight);
+std::string heightTilePath(const std::string& directory, uint32_t mip, int32_t x, int32_t z); // <dir>/<mip>/<x>_<z>.tile
+
+// Прямоугольник слоя высот для загрузки на GPU, в текселях окна (уже свёрнут по модулю)
+typedef struct _TerrainUpload
+{
+	uint32_t level;
+	uint32_t x, z;
+	uint32_t width, height;
+	size_t offset; // первый отсчёт в массиве высот update(), строки подряд
+} TerrainUpload;
+
+// Прямоугольник ячеек кольца для отрисовки
+typedef struct _TerrainBlock
+{
+	uint32_t level;
+	glm::ivec2 origin; // угол сетки уровня в вершинах уровня
+	glm::ivec2 offset; // первая ячейка блока от угла
+	glm::uvec2 cells;
+} TerrainBlock;
+
+// Клипмап ландшафта с подгрузкой плиток высот.
+// Уровень l - сетка 4m x 4m ячеек с шагом spacing * 2^l вокруг камеры, без области,
+// которую покрывает уровень l - 1. Высоты уровня живут в слое текстуры с тороидальной адресацией:
+// при сдвиге камеры загружаются только открывшиеся ряды и столбцы. Плитки читаются фоновым
+// потоком и вытесняются по давности использования; пока плитки нет, её высоты равны 0,
+// после прихода слой уровня загружается заново. Число отрисовок и треугольников
+// не зависит от размера мира
+class Terrain
+{
+	public:
+		void start(const std::string& directory, float spacing = 1.0f, uint32_t capacity = 128);
+		void stop();
+
+		// Сдвиг уровней к камере; участки слоёв для загрузки и их высоты
+		void update(const glm::vec3& camera, std::vector<TerrainUpload>& uploads, std::vector<float>& heights);
+		void blocks(std::vector<TerrainBlock>& result) const; // кольца текущего кадра: 1 + 4 (TERRAIN_LEVELS - 1) блоков
+		void reload(uint32_t level); // участки уровня не дошли до GPU (кадр пропущен): слой целиком в следующем update()
+
+		glm::ivec2 origin(uint32_t level) const { return origins[level]; }
+		float spacing(uint32_t level) const { return baseSpacing * static_cast<float>(1u << level); }
+		float extent() const { return spacing(TERRAIN_LEVELS - 1) * 4 * TERRAIN_BLOCK; } // сторона внешнего кольца
+		size_t residentTiles();
+		uint64_t revision() const { return heightRevision; } // растёт, когда пришедшие плитки меняют высоты окон
+
+		// Грубая сетка ландшафта вокруг камеры для программного растеризатора заслонок.
+		// Вершина - наименьшая высота отсчётов уровня в соседних ячейках, поэтому сетка нигде
+		// не выше поверхности этого уровня; перестраивается в update(), когда сдвигается или загружается её уровень
+		const std::vector<glm::vec3>& occluderVertices() const { return occluderMesh; }
+		const std::vector<uint32_t>& occluderIndices() const { return occluderTriangles; }
+
+	private:
+		typedef std::tuple<uint32_t, int32_t, int32_t> TileKey; // уровень детализации, x, z
+
+		struct Tile
+		{
+			std::vector<float> heights; // пусто - файла нет, высоты 0
+			uint64_t lastUse;
+		};
+
+		void loaderLoop();
+		// Прямоугольник вершин уровня в окне: до четырёх участков загрузки
+		void uploadRegion(uint32_t level, int32_t x, int32_t z, uint32_t width, uint32_t height,
+						std::vector<TerrainUpload>& uploads, std::vector<float>& heights);
+		void buildOccluder(); // под mutex
+		void sampleRow(uint32_t mip, int32_t x, int32_t z, uint32_t count, float* out); // под mutex
+		void request(const TileKey& key); // под mutex
+		void evict(); // под mutex
+
+		std::string directory;
+		float baseSpacing = 1.0f;
+		uint32_t capacity = 128;
+
+		glm::ivec2 origins[TERRAIN_LEVELS] = {};
+		bool loaded[TERRAIN_LEVELS] = {}; // слой уровня заполнен
+		uint64_t frame = 0;
+		uint64_t heightRevision = 0;
+		std::vector<glm::vec3> occluderMesh;
+		std::vector<uint32_t> occluderTriangles;
+
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::map<TileKey, Tile> tiles;
+		std::deque<TileKey> requests; // очередь фонового потока
+		std::set<TileKey> requested;
+		std::vector<TileKey> arrived; // прочитанные с прошлого update()
+		std::thread loader;
+		bool running = false;
+};
+
+#endif // TERRAIN_H
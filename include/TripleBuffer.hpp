@@ -0,0 +1,37 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Тройной буфер для одного писателя и одного читателя без блокировок.
+// Писатель заполняет back() и публикует его, читатель забирает последнюю
+// опубликованную копию; ни одна из сторон не ждёт другую
+template<typename T>
+class TripleBuffer
+{
+	public:
+		// Писатель
+		T& back() { return buffers[backIndex]; }
+		void publish() { backIndex = middle.exchange(backIndex | FRESH) & INDEX; }
+
+		// Читатель: true, если с прошлого вызова опубликована новая копия
+		bool update() {
+			if ((middle.load() & FRESH) == 0)
+				return false;
+			frontIndex = middle.exchange(frontIndex) & INDEX;
+			return true;
+		}
+		const T& front() const { return buffers[frontIndex]; }
+
+	private:
+		static const uint32_t INDEX = 3; // маска индекса
+		static const uint32_t FRESH = 4; // средний буфер ещё не прочитан
+
+		T buffers[3]{};
+		std::atomic<uint32_t> middle{1};
+		uint32_t backIndex = 0;
+		uint32_t frontIndex = 2;
+};
+
+#endif // TRIPLEBUFFER_H
@@ -3,10 +3,27 @@
 
 #include <GLM/glm.hpp>
 
+#include <cstdint>
+
 typedef struct _Vertex {
     glm::vec3 position;
     glm::vec3 normal;
     glm::vec2 texCoord;
 } Vertex;
 
+// Поток скиннинга: четыре сустава и их веса (сумма весов 255), отдельная привязка вершин
+typedef struct _SkinnedVertex {
+    uint16_t joints[4];
+    uint8_t weights[4];
+} SkinnedVertex;
+
+// Экземпляр толпы: положение и поворот вокруг Y, запечённый клип, сдвиг по времени и скорость
+typedef struct _CrowdInstance {
+    glm::vec4 placement; // xyz - положение, w - поворот, радианы
+    uint32_t clip;
+    float timeOffset;
+    float speed;
+    float padding; // шаг 32 байта, как у массива структур std430 в шейдере отсечения
+} CrowdInstance;
+
 #endif // VERTEX_H
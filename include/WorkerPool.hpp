@@ -0,0 +1,48 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул рабочих потоков для параллельных циклов кадра.
+// parallelFor делит диапазон на участки по grain элементов; участки разбираются атомарным
+// счётчиком рабочими потоками и вызывающим, который возвращается после выполнения всех.
+// Задания выдаются из одного потока (потока рендера)
+class WorkerPool
+{
+	public:
+		typedef std::function<void(uint32_t begin, uint32_t end)> Slice;
+
+		void start(uint32_t threadCount = 0); // 0 - по числу ядер без вызывающего потока
+		void stop();
+		uint32_t size() const { return static_cast<uint32_t>(threads.size()) + 1; } // вместе с вызывающим
+
+		void parallelFor(uint32_t begin, uint32_t end, uint32_t grain, const Slice& slice);
+
+	private:
+		void workerLoop();
+		void runSlices(); // разбор участков текущего задания
+
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable wake;
+		uint64_t generation = 0; // номер последнего выданного задания
+		uint32_t active = 0; // рабочие потоки внутри задания
+		bool running = false;
+
+		// Текущее задание: меняется, только когда ни один рабочий поток в нём не находится
+		const Slice* slice = nullptr;
+		uint32_t begin = 0;
+		uint32_t end = 0;
+		uint32_t grain = 1;
+		uint32_t sliceCount = 0;
+		std::atomic<uint32_t> nextSlice{0};
+		std::atomic<uint32_t> pendingSlices{0};
+};
+
+#endif // WORKERPOOL_H
@@ -12,8 +12,37 @@
 #include "Surface.hpp"
 #include "Queue.hpp"
 #include "Vertex.hpp"
+#include "HotReload.hpp"
+#include "ResourceRegistry.hpp"
+#include "ResourceStateTracker.hpp"
+#include "RenderGraph.hpp"
+#include "Simulation.hpp"
+#include "FrameContext.hpp"
+#include "GpuTimeline.hpp"
+#include "ResolutionScaler.hpp"
+#include "GpuProfiler.hpp"
+#include "CpuProfiler.hpp"
+#include "SceneConfig.hpp"
+#include "FrameCapture.hpp"
+#include "SceneGraph.hpp"
+#include "WorkerPool.hpp"
+#include "Animation.hpp"
+#include "Terrain.hpp"
+#include "OcclusionRasterizer.hpp"
+#include "LightClusters.hpp"
+#include "ShadowCascades.hpp"
+#include "Particles.hpp"
 
 
+// Фаза отрисовки при отсечении по пирамиде глубины
+enum class CullPhase : uint32_t
+{
+	Early, // видимые в прошлом кадре
+	Late // перекрытые в прошлом кадре и ставшие видимыми
+};
+
+const uint32_t MAX_PYRAMID_LEVELS = 16; // уровней пирамиды глубины: цель сцены до 32768 по стороне
+
 typedef struct _Material {
     VkImage diffuseImage;
     VkImage normalImage;
@@ -26,37 +55,54 @@ typedef struct _Material {
 class Vulkan
 {
 	public:
-		const uint32_t size_of_field = 100;
 		void init(GLFWwindow* window); // инициализация
+		void initHeadless(uint32_t width, uint32_t height); // инициализация без окна и поверхности: кадры рисуются во внеэкранные изображения
+		void setScene(const SceneConfig& config) { scene = config; } // до инициализации
 		void destroy(); // завершение работы
 		void renderFrame(); // рендер кадра
-		void setDeltaTime(float dt) { deltaTime = dt; }
+		void waitForFrame(); // ожидание барьера следующего кадра (режим низкой задержки)
+		void setFrameBudget(float milliseconds) { resolution.setBudget(milliseconds); } // бюджет времени GPU на кадр
+		void gpuStatistics(std::vector<GpuScopeStatistics>& result) const { profiler.statistics(result); } // замеры GPU по проходам
+		void resetGpuStatistics(size_t frames) { profiler.resetHistory(frames); } // новое окно замеров GPU
+		uint32_t overflowedLightClusters(); // наибольшее за кадр число переполненных кластеров с прошлого вызова
+		std::string deviceName() const { return physicalDevice.properties.deviceName; }
+		void startCapture(const std::string& directory, CaptureFormat format); // запись кадров в последовательность изображений
+		uint32_t finishCapture(); // дозапись захваченных кадров; число записанных файлов
+		uint32_t failedCaptures() { return capture.failed(); } // кадры последней последовательности, не записанные в файл
+		void setFixedTimeStep(float seconds) { fixedTimeStep = seconds; } // анимация по номеру кадра вместо часов (0 - по часам)
+		uint32_t animationCount() const { return static_cast<uint32_t>(clips.size()); }
+		void playAnimation(uint32_t clip, float fadeSeconds = 0.25f) { animator.play(modelAnimation, clip, fadeSeconds); } // UINT32_MAX - поза привязки
 		glm::vec3 getCameraPos() const ;
 
 	private:
-		VkImage depthImage;
-		VkDeviceMemory depthImageMemory;
-		VkImageView depthImageView;
-    	void createDepthResources();
+		// Граф кадра
+		RenderGraph renderGraph;
+		GpuProfiler profiler; // Метки времени и статистика конвейера по проходам
+		GraphResource backbuffer; // изображение списка показа текущего кадра
+		void buildRenderGraph(); // Объявление проходов кадра
+		void recordScene(VkCommandBuffer commandBuffer); // Отрисовка модели в проходе сцены
+		void setSceneViewport(VkCommandBuffer commandBuffer); // Область просмотра и отсечение по внутреннему разрешению
+
+		// Динамическое разрешение: сцена рисуется в часть цели максимального размера и растягивается на список показа
+		ResolutionScaler resolution;
+		VkExtent2D renderExtent; // внутреннее разрешение текущего кадра
+		GraphResource sceneColor; // цель рендера сцены
+		void recordUpscale(VkCommandBuffer commandBuffer); // Растяжение сцены на изображение списка показа
+
+		// Захват кадров: копирование в буферы чтения и кодирование в рабочих потоках
+		FrameCapture capture;
+		float fixedTimeStep = 0.0f; // шаг анимации на кадр для воспроизводимого облёта
+		uint32_t fixedFrame = 0;
 
 		VkFormat findDepthFormat();
 
-		VkImage textureImage;
-		VkDeviceMemory textureImageMemory;
-		VkImageView textureImageView;
+		ImageHandle textureImage;
+		ImageViewHandle textureImageView;
 		VkSampler textureSampler;
 
 		void createTextureImage();
-		void createImage(uint32_t width, uint32_t height, VkFormat format,
-                        VkImageTiling tiling, VkImageUsageFlags usage,
-                        VkMemoryPropertyFlags properties,
-                        VkImage& image, VkDeviceMemory& imageMemory);
-		void transitionImageLayout(VkImage image, VkFormat format,
-					VkImageLayout oldLayout, VkImageLayout newLayout);
-		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+		void recordTextureUpload(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 		void createTextureSampler();
-		void createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView* imageView);
-		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
 		// Для однократных команд
 		VkCommandBuffer beginSingleTimeCommands();
@@ -64,31 +110,266 @@ class Vulkan
 
 		std::vector<Vertex> modelVertices;
 		std::vector<uint32_t> modelIndices;
-		VkBuffer modelVertexBuffer;
-		VkDeviceMemory modelVertexBufferMemory;
-		VkBuffer modelIndexBuffer;
-		VkDeviceMemory modelIndexBufferMemory;
+		BufferHandle modelVertexBuffer;
+		BufferHandle modelIndexBuffer;
+
+		// Скелетная анимация модели: веса вершин отдельным потоком, палитра суставов - участок однородного буфера кадра
+		Skeleton skeleton;
+		std::vector<AnimationClip> clips;
+		std::vector<SkinnedVertex> modelSkin;
+		BufferHandle modelSkinBuffer;
+		Animator animator;
+		uint32_t modelAnimation = 0; // экземпляр аниматора модели
+		float previousAnimationTime = 0.0f;
+		VkDeviceSize paletteSize; // MAX_JOINTS матриц
+		uint32_t paletteOffset = 0; // динамическое смещение палитры текущего кадра
+
+		// Толпа: экземпляры модели с запечённой анимацией. CPU задаёт экземпляру только клип, сдвиг
+		// и скорость при создании; кадр клипа выбирает вершинный шейдер по времени из однородных данных
+		BakedAnimations bakedAnimations;
+		BufferHandle crowdInstanceBuffer;
+		BufferHandle bakedRowBuffer;
+		BufferHandle bakedClipBuffer;
+		VkDescriptorSetLayout crowdSetLayout = VK_NULL_HANDLE; // набор 1: строки палитр и таблица клипов
+		VkPipelineLayout crowdPipelineLayout = VK_NULL_HANDLE;
+		VkPipeline crowdPipeline = VK_NULL_HANDLE;
+		VkDescriptorSet crowdSet = VK_NULL_HANDLE;
+		std::vector<CrowdInstance> crowdInstances; // копия буфера экземпляров для отсечения на CPU
+		glm::vec4 crowdBounds; // сфера модели: центр и радиус с запасом на анимацию
+		void createCrowd(); // Запекание (или чтение файла запекания), экземпляры и конвейер
+		VkPipeline buildCrowdPipeline(bool shadow = false); // shadow - только глубина в карту теней
+		void recordCrowd(VkCommandBuffer commandBuffer, CullPhase phase);
+		void destroyCrowd();
+
+		// Отсечение перекрытых экземпляров толпы в две фазы по пирамиде глубины (Hi-Z).
+		// Ранняя фаза рисует экземпляры, видимые в прошлом кадре; по её глубине строится пирамида
+		// наибольших глубин, затем каждый экземпляр проверяется по пирамиде, и поздняя фаза
+		// дорисовывает только те, что были перекрыты и стали видимы. Списки экземпляров и число
+		// экземпляров в командах косвенной отрисовки пишет вычислительный шейдер, CPU их не читает
+		BufferHandle crowdVisibilityBuffer; // флаг видимости экземпляра после прошлого кадра
+		BufferHandle crowdDrawBuffer; // две команды VkDrawIndexedIndirectCommand: ранняя и поздняя фазы
+		BufferHandle crowdEarlyBuffer; // копии CrowdInstance, которые рисует ранняя фаза
+		BufferHandle crowdLateBuffer; // и поздняя
+		GraphResource crowdVisibilityResource;
+		GraphResource crowdDrawResource;
+		GraphResource crowdEarlyResource;
+		GraphResource crowdLateResource;
+		GraphResource sceneDepth;
+		ImageHandle depthPyramid; // R32F, уровень 0 - степень двойки не больше цели сцены
+		ImageViewHandle depthPyramidView; // все уровни для проверки
+		std::vector<ImageViewHandle> depthPyramidLevelViews; // по уровню: запись и чтение следующим уровнем
+		GraphResource depthPyramidResource;
+		VkExtent2D depthPyramidExtent;
+		uint32_t depthPyramidLevels = 0;
+		VkDescriptorSetLayout depthPyramidSetLayout = VK_NULL_HANDLE; // источник уровня и записываемый уровень
+		VkDescriptorSetLayout occlusionSetLayout = VK_NULL_HANDLE; // буферы толпы и пирамида
+		VkPipelineLayout depthPyramidLayout = VK_NULL_HANDLE;
+		VkPipelineLayout occlusionLayout = VK_NULL_HANDLE;
+		VkPipeline depthPyramidPipeline = VK_NULL_HANDLE;
+		VkPipeline occlusionPipeline = VK_NULL_HANDLE;
+		uint32_t depthPyramidGeneration = 0; // растёт с каждым пересозданием пирамиды
+		void createOcclusion(); // Буферы фаз, раскладки и конвейеры; после createCrowd
+		void createDepthPyramid(); // Пирамида по скомпилированному графу
+		void updatePyramidSets(FrameContext& frame); // После ожидания кадра слота: наборы на текущую пирамиду
+		void recordOcclusionReset(VkCommandBuffer commandBuffer); // Обнуление числа экземпляров обеих фаз
+		void recordOcclusionCull(VkCommandBuffer commandBuffer, CullPhase phase);
+		void recordDepthPyramid(VkCommandBuffer commandBuffer);
+		void recordSceneLate(VkCommandBuffer commandBuffer); // Поздняя фаза поверх глубины ранней
+		void destroyOcclusion();
+
+		// Программное отсечение толпы без GPU: ландшафт вокруг камеры растеризуется рабочими
+		// потоками в маленький буфер глубины, видимые экземпляры копируются в участок кадра
+		// буфера экземпляров до записи команд
+		OcclusionRasterizer occlusionRasterizer;
+		std::vector<uint8_t> crowdVisible; // флаг экземпляра текущего кадра
+		BufferHandle crowdVisibleBuffer; // участок на каждый кадр в работе
+		VkDeviceSize crowdVisibleOffset = 0;
+		uint32_t crowdVisibleCount = 0;
+		void createCpuOcclusion(); // Растеризатор и буфер видимых экземпляров; после createCrowd
+		void cullCrowdOnCpu(); // После ожидания кадра и updateTerrain
+
+		// Кластерное прямое освещение: пирамида видимости делится на CLUSTER_X x CLUSTER_Y x CLUSTER_Z
+		// кластеров, вычислительный проход каждый кадр раздаёт источники по кластерам через общий
+		// список индексов, фрагментный шейдер перебирает только источники своего кластера.
+		// Буферы кластеров есть и без источников: их читает набор 0
+		std::vector<Light> lights;
+		ClusterFrustum lightFrustum; // вид и проекция текущего кадра
+		BufferHandle lightBuffer;
+		BufferHandle lightClusterBuffer; // LightCluster на кластер
+		BufferHandle lightIndexBuffer; // счётчик и общий список индексов
+		GraphResource lightClusterResource;
+		GraphResource lightIndexResource;
+		BufferHandle lightOverflowBuffer; // переполненные кластеры, счётчик на слот кадра; видим CPU
+		GraphResource lightOverflowResource;
+		uint32_t lightOverflow = 0; // наибольший прочитанный счётчик с прошлого overflowedLightClusters
+		VkDescriptorSetLayout lightCullSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout lightCullLayout = VK_NULL_HANDLE;
+		VkPipeline lightCullPipeline = VK_NULL_HANDLE; // без источников не создаётся
+		VkDescriptorSet lightCullSet = VK_NULL_HANDLE;
+		void createLights(); // Источники сцены, буферы кластеров и конвейер; до createDescriptorSet
+		void writeLightingUniforms(char* uniformData);
+		void recordLightReset(VkCommandBuffer commandBuffer);
+		void recordLightCull(VkCommandBuffer commandBuffer);
+		void readLightOverflow(); // После ожидания кадра: счётчик слота читается и обнуляется
+		void destroyLights();
+
+		// Анимированная сетка высот: вычислительный проход каждый кадр пишет высоты и нормали
+		// в буфер устройства, вершинный шейдер строит сетку по номерам вершины и экземпляра
+		// (полоса треугольников на ряд) - ни вершинных атрибутов, ни буфера индексов, ни работы CPU
+		BufferHandle heightfieldBuffer;
+		GraphResource heightfieldResource;
+		VkDescriptorSetLayout heightfieldSetLayout = VK_NULL_HANDLE; // буфер сетки для обеих стадий
+		VkPipelineLayout heightfieldComputeLayout = VK_NULL_HANDLE;
+		VkPipelineLayout heightfieldPipelineLayout = VK_NULL_HANDLE; // набор 0 сцены и набор 1 сетки
+		VkPipeline heightfieldComputePipeline = VK_NULL_HANDLE;
+		VkPipeline heightfieldPipeline = VK_NULL_HANDLE;
+		VkDescriptorSet heightfieldSet = VK_NULL_HANDLE;
+		void createHeightfield(); // Буфер сетки, раскладки и конвейеры
+		VkPipeline buildHeightfieldPipeline();
+		void recordHeightfieldUpdate(VkCommandBuffer commandBuffer); // Вычислительный проход
+		void recordHeightfield(VkCommandBuffer commandBuffer); // Отрисовка в проходе сцены
+		void destroyHeightfield();
+
+		// Ландшафт: кольца клипмапа вокруг камеры, высоты уровней - слои текстуры с тороидальной
+		// адресацией, плитки высот читает фоновый поток. Открывшиеся ряды загружаются проходом графа
+		Terrain terrain;
+		ImageHandle terrainImage;
+		ImageViewHandle terrainView;
+		GraphResource terrainResource;
+		BufferHandle terrainStaging; // участок на каждый кадр в работе
+		std::vector<TerrainUpload> terrainUploads;
+		std::vector<float> terrainHeights;
+		std::vector<VkBufferImageCopy> terrainCopies; // загрузки текущего кадра
+		std::vector<TerrainBlock> terrainBlocks;
+		VkDescriptorSetLayout terrainSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout terrainPipelineLayout = VK_NULL_HANDLE; // набор 0 сцены и набор 1 высот
+		VkPipeline terrainPipeline = VK_NULL_HANDLE;
+		VkDescriptorSet terrainSet = VK_NULL_HANDLE;
+		float farPlane = 100.0f; // с ландшафтом - до внешнего кольца
+		void createTerrain(); // Слои высот, буфер загрузки, конвейер и поток чтения плиток
+		VkPipeline buildTerrainPipeline(bool shadow = false);
+		void updateTerrain(); // Сдвиг колец к камере и копирование высот в участок кадра
+		void recordTerrainUpload(VkCommandBuffer commandBuffer);
+		void recordTerrain(VkCommandBuffer commandBuffer);
+		void recordTerrain(VkCommandBuffer commandBuffer, VkPipeline pipeline, uint32_t uniformOffset);
+		void destroyTerrain();
+
+		// Каскадные тени солнца: слой глубины на каскад, конвейеры глубины без фрагментного шейдера
+		// с потоком положений модели. Ближние каскады рисуются каждый кадр; кэшируемые хранят глубину
+		// ландшафта в отдельном изображении и перерисовывают её, только когда ShadowCascades
+		// сдвигает каскад, поворачивается свет или приходят плитки высот. Модель и толпа
+		// в кэшируемых каскадах рисуются поверх копии этой глубины
+		ShadowCascades shadowCascades;
+		uint32_t shadowRedraw = 0; // маска каскадов, статическая глубина которых перерисовывается в этом кадре
+		ImageHandle shadowMap; // D32, слой на каскад
+		ImageHandle shadowStaticMap; // глубина ландшафта кэшируемых каскадов
+		ImageViewHandle shadowMapView; // все слои для сэмплера сравнения
+		std::vector<ImageViewHandle> shadowLayerViews; // слой shadowMap - вложение глубины
+		std::vector<ImageViewHandle> shadowStaticViews;
+		GraphResource shadowResource;
+		VkSampler shadowSampler = VK_NULL_HANDLE;
+		VkPipeline shadowPipeline = VK_NULL_HANDLE; // модель; без него теней нет
+		VkPipeline crowdShadowPipeline = VK_NULL_HANDLE;
+		VkPipeline terrainShadowPipeline = VK_NULL_HANDLE;
+		uint32_t shadowUniformOffsets[SHADOW_CASCADES] = {}; // однородные данные с видом и проекцией каскада
+		BufferHandle crowdShadowBuffer; // экземпляры толпы, задевающие каскад: участок на каскад в каждом кадре в работе
+		std::vector<uint8_t> crowdShadowMask; // каскады экземпляра текущего кадра, бит на каскад
+		VkDeviceSize crowdShadowOffsets[SHADOW_CASCADES] = {};
+		uint32_t crowdShadowCounts[SHADOW_CASCADES] = {};
+		void createShadows(); // Карта теней и сэмплер; до createDescriptorSet
+		void createShadowPipelines(); // После модели, толпы и ландшафта
+		VkPipeline buildShadowPipeline(const char * vertPath, const VkPipelineVertexInputStateCreateInfo& vertexInput,
+				VkPipelineLayout layout, VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+		VkPipeline buildModelShadowPipeline();
+		void updateShadows(FrameContext& frame, char* uniformData); // Каскады кадра; после записи однородных данных сцены
+		void cullShadowCasters(); // Экземпляры толпы по каскадам кадра; из updateShadows
+		void recordShadows(VkCommandBuffer commandBuffer);
+		void recordShadowCasters(VkCommandBuffer commandBuffer, uint32_t cascade, bool terrainCasters);
+		void destroyShadows();
+
+		// Частицы целиком на GPU: пул, список свободных и два списка живых с атомарными счётчиками.
+		// Начальный проход одним потоком меняет списки местами и пишет аргументы косвенных запусков
+		// рождения, симуляции и сжатия; сжатие возвращает погибших в список свободных и набирает
+		// видимых с числом экземпляров косвенной отрисовки, битонная сортировка упорядочивает их
+		// от дальних к ближним. CPU передаёт только шаг и запрос рождений и ничего не читает
+		uint32_t particleCapacity = 0;
+		BufferHandle particleBuffer; // Particle на место пула
+		BufferHandle particleDeadBuffer; // номера свободных
+		BufferHandle particleAliveBuffer; // два списка живых подряд
+		BufferHandle particleCounterBuffer; // ParticleCounters
+		BufferHandle particleDispatchBuffer; // ParticleDispatch
+		BufferHandle particleDrawBuffer; // VkDrawIndirectCommand: экземпляр - видимая частица
+		BufferHandle particleDrawListBuffer; // ключ глубины и номер видимой частицы
+		GraphResource particleResource;
+		GraphResource particleDeadResource;
+		GraphResource particleAliveResource;
+		GraphResource particleCounterResource;
+		GraphResource particleDispatchResource;
+		GraphResource particleDrawResource;
+		GraphResource particleDrawListResource;
+		VkDescriptorSetLayout particleSetLayout = VK_NULL_HANDLE; // все буферы частиц
+		VkPipelineLayout particleComputeLayout = VK_NULL_HANDLE;
+		VkPipelineLayout particleSortLayout = VK_NULL_HANDLE;
+		VkPipelineLayout particlePipelineLayout = VK_NULL_HANDLE; // набор 0 сцены и набор 1 частиц
+		VkPipeline particleKickoffPipeline = VK_NULL_HANDLE;
+		VkPipeline particleEmitPipeline = VK_NULL_HANDLE;
+		VkPipeline particleSimulatePipeline = VK_NULL_HANDLE;
+		VkPipeline particleCompactPipeline = VK_NULL_HANDLE;
+		VkPipeline particleSortPipeline = VK_NULL_HANDLE; // без PARTICLE_SORT не создаётся
+		VkPipeline particlePipeline = VK_NULL_HANDLE;
+		VkDescriptorSet particleSet = VK_NULL_HANDLE;
+		std::vector<ParticleSortStep> particleSortSchedule;
+		ParticleParams particleParams{}; // push-константы кадра
+		float particleTime = 0.0f; // время анимации прошлого шага
+		float particleEmitCarry = 0.0f; // дробная часть запроса рождений
+		void createParticles(); // Буферы, списки и конвейеры
+		VkPipeline buildParticlePipeline();
+		void updateParticles(); // Шаг и запрос рождений кадра; после ожидания кадра
+		void recordParticleKickoff(VkCommandBuffer commandBuffer);
+		void recordParticleStage(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkDeviceSize dispatchOffset);
+		void recordParticleSort(VkCommandBuffer commandBuffer);
+		void recordParticleDraw(VkCommandBuffer commandBuffer); // Проход поверх непрозрачной сцены
+		void destroyParticles();
 
 		void loadModel(const std::string& path);
+		void loadAnimations(const std::string& path); // Клипы для скелета модели из другого файла
 		void createModelBuffers();
 
-		VkBuffer stagingVertexBuffer;
-		VkDeviceMemory stagingVertexBufferMemory;
-		void* stagingVertexBufferMapped;
-
 		VkDescriptorPool descriptorPool;
-		VkDescriptorSet descriptorSet;
+		VkDescriptorSet descriptorSet; // набор 0 записываемого кадра
 
 		void createDescriptorPool();
-		void createDescriptorSet();
+		void createDescriptorSet(); // По набору на кадр в работе; после createFrameContexts
+		void updateSceneSet(FrameContext& frame); // Перезагруженная текстура - в набор слота
+		VkDescriptorSet allocateDescriptorSet(VkImageView imageView); // Набор дескрипторов для текстуры
+
+		// Горячая перезагрузка
+		HotReload hotReload;
+		void setupHotReload(); // Регистрация отслеживаемых шейдеров и текстур
+		typedef std::pair<VkPipeline*, std::function<VkPipeline()>> PipelineBuild; // конвейер и его сборка
+		void watchShader(const char * source, const char * binary, const std::vector<PipelineBuild>& users); // Перезагрузка конвейеров, использующих шейдер
+
+		GLFWwindow* window = nullptr;  // Добавляем в private-секцию
+		SceneConfig scene; // Модель, текстура и начальная камера
 
-		GLFWwindow* window;  // Добавляем в private-секцию
-		VkBuffer uniformBuffer;
-		VkDeviceMemory uniformBufferMemory;
-		void* uniformBufferMapped;
+		// Режим без окна: вместо списка показа - внеэкранные изображения по кругу
+		bool headless = false;
+		uint32_t nextOffscreenImage = 0;
+		std::vector<ImageHandle> offscreenImages;
+		std::vector<ImageViewHandle> offscreenViews;
+		void createOffscreenTargets(); // Внеэкранные изображения размера surface.selectedExtent
+		void initResources(); // Общая часть инициализации после создания устройства
+		BufferHandle uniformBuffer; // Участки кадров в работе, распределяются через FrameArena
+		VkDeviceSize uniformSize; // Однородные данные сцены: model, view, proj + time + освещение
+		uint32_t sceneUniformOffset = 0; // Динамическое смещение данных сцены текущего кадра
 
 		VkDescriptorSetLayout descriptorSetLayout; // Для uniform buffer
 
+		// Иерархия преобразований сцены и рабочие потоки кадра
+		WorkerPool workers;
+		SceneGraph sceneGraph;
+		SceneNode modelNode = NO_SCENE_NODE;
+
 		// Матрицы и камера
 		glm::mat4 modelMatrix;
 		glm::mat4 viewMatrix;
@@ -106,32 +387,49 @@ class Vulkan
 		PhysicalDevice physicalDevice; // Физическое устройство
 		VkDevice logicalDevice; // логическое устройство
 		Queue queue; // очередь
+		GpuTimeline timeline; // Временная шкала очереди: значения отправок вместо барьеров (fence)
 		Surface surface; // Поверхность окна
-		VkSwapchainKHR swapChain; // Список показа
+		VkSwapchainKHR swapChain = VK_NULL_HANDLE; // Список показа
 		std::vector<VkImage> swapChainImages; // Изображения из списка показа
 		std::vector<VkImageView> swapChainImageViews; // Информация об изображениях из списка показа
-		std::vector<VkFramebuffer> swapChainFramebuffers; // Буферы кадра из списка показа
-		VkRenderPass renderPass; // Проходы рендера
+		// Список показа, заменённый при пересоздании: его семафоры может ещё ждать отправленный показ
+		typedef struct _RetiredSwapchain
+		{
+			VkSwapchainKHR swapChain;
+			std::vector<VkImageView> views;
+			std::vector<VkSemaphore> semaphores;
+		} RetiredSwapchain;
+		std::vector<RetiredSwapchain> retiredSwapchains;
+		void releaseRetiredSwapchains(); // Отложенное уничтожение после показа из нового списка
+		VkRenderPass renderPass; // Проход рендера сцены (создаётся графом кадра)
+		std::vector<VkFormat> sceneColorFormats; // Форматы вложений сцены для динамического рендера
+		VkFormat sceneDepthFormat;
 		VkPipelineLayout pipelineLayout; // Раскладка конвейера
 		VkPipeline graphicsPipeline; // Графический конвейер
-		VkCommandPool commandPool; // Пул команд
-		std::vector<VkCommandBuffer> commandBuffers; // Буферы команд
-		VkBuffer vertexBuffer; // Буфер вершин
-		VkDeviceMemory vertexBufferMemory; // Память буфера вершин
-		VkBuffer indexBuffer; // Буфер индексов
-		VkDeviceMemory indexBufferMemory; // Память буфера индексов
-		std::vector<VkSemaphore> imageAvailableSemaphores; // семафор доступности изображения
-		std::vector<VkSemaphore> renderFinishedSemaphores; // семафор окончания рендера
-		std::vector<VkFence> inWorkFences; // барьер кадра в работе
+		VkCommandPool commandPool; // Пул команд для однократных загрузок
+		std::vector<FrameContext> frames; // Кадры в работе
+		ResourceRegistry registry; // Реестр буферов и изображений
+		ResourceStateTracker tracker; // Состояния ресурсов и барьеры
+		std::vector<VkSemaphore> renderFinishedSemaphores; // семафор окончания рендера, по изображению списка показа
+		std::vector<uint64_t> imageValues; // значение шкалы кадра, последним рисовавшего в изображение списка показа
 		uint32_t currentFrame = 0; // Текущий кадр рендера
 		float animationTime = 0.0f;
-		float deltaTime = 0.01f; // Примерное значение по умолчанию (60 FPS)
-		std::vector<Vertex> vertices;  // Динамические вершины (вместо статичного массива)
+		Simulation simulation; // Камера и анимация с фиксированным шагом в своём потоке
 
 		// Структура для хранения флагов
 		struct
 		{
 			const bool VALIDATION = true; // Использование слоев проверки
+			const bool HOT_RELOAD = true; // Горячая перезагрузка шейдеров и текстур
+			const bool DYNAMIC_RENDERING = true; // Динамический рендер вместо проходов рендера и буферов кадра
+			const uint32_t FRAMES_IN_FLIGHT = 2; // Кадров в работе: больше - выше пропускная способность, меньше - задержка
+			const bool DYNAMIC_RESOLUTION = true; // Внутреннее разрешение по времени GPU
+			const float MIN_RENDER_SCALE = 0.5f; // Границы масштаба внутреннего разрешения по осям
+			const float MAX_RENDER_SCALE = 1.0f;
+			const bool OCCLUSION_CULLING = true; // Двухфазное отсечение толпы по пирамиде глубины
+			const bool CPU_OCCLUSION_CULLING = true; // Программное отсечение толпы ландшафтом, если OCCLUSION_CULLING выключено
+			const bool SHADOWS = true; // Каскадные тени солнца
+			const bool PARTICLE_SORT = true; // Сортировка видимых частиц по глубине для смешивания
 		} states;
 
 
@@ -141,16 +439,20 @@ class Vulkan
 		void createLogicalDevice(std::vector<const char*> &deviceExtensions); // Создание логического устройства
 		void createWindowSurface(GLFWwindow* window); // Создание поверхности окна
 		void createSwapchain(GLFWwindow* window); // Создание цепочки показа
-		void createRenderpass(); // Создание проходов рендера
+		void recreateSwapchain(); // Пересоздание цепочки показа и зависящих от размера ресурсов
+		bool framebufferResized = false; // Размер окна изменился
+		static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
 		VkShaderModule createShaderModule(const char * filename); // Создание шейдерного модуля
 		void createGraphicPipeline(); // Создание графического конвеера
-		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory); // Создание произвольного буфера данных
+		VkPipeline buildGraphicsPipeline(const char * vertPath, const char * fragPath,
+				const VkPipelineVertexInputStateCreateInfo* vertexInput = nullptr, VkPipelineLayout layout = VK_NULL_HANDLE,
+				VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+				bool transparent = false); // Сборка графического конвейера из шейдеров; transparent - смешивание без записи глубины
+		VkPipeline buildComputePipeline(const char * compPath, VkPipelineLayout layout); // Сборка вычислительного конвейера
 		void createCommandPool(); // Создание пула команд
 		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size); // Копирование между буферами данных
-		void createVertexBuffer(); // Создание буфера вершин
-		void createIndexBuffer(); // Создание буфера индексов
-		void createSyncObjects(); // Создание объектов синхронизации
-		void createFramebuffers(); // Создание буферов кадра
+		void createSyncObjects(); // Создание объектов синхронизации изображений списка показа
+		void createFrameContexts(); // Создание пулов команд, объектов синхронизации и распределителей кадров
 };
 
 #endif // VK_H
@@ -0,0 +1,78 @@
+#version 450
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in uvec4 inJoints;    // Суставы вершины
+layout(location = 4) in vec4 inWeights;    // Их веса, сумма 1
+layout(location = 5) in vec4 inPlacement;  // Экземпляр: позиция и поворот вокруг Y
+layout(location = 6) in uint inClip;       // Запечённый клип экземпляра
+layout(location = 7) in vec2 inTiming;     // Сдвиг по времени и скорость
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec3 fragPosition; // мировое положение для освещения
+layout(location = 2) out vec3 fragNormal;
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    float time;
+} ubo;
+
+// Палитры всех кадров всех клипов: на сустав три строки аффинной матрицы
+layout(std430, set = 1, binding = 0) readonly buffer BakedRows {
+    vec4 rows[];
+} baked;
+
+struct BakedClip {
+    uint firstRow;
+    uint frameCount;
+    uint jointCount;
+    float duration;
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer BakedClips {
+    BakedClip clips[];
+} table;
+
+// Сустав в позе между двумя соседними кадрами, взвешенный весом вершины
+void addJoint(uint frame0, uint frame1, float blend, BakedClip clip, uint joint, float weight,
+              inout vec4 row0, inout vec4 row1, inout vec4 row2) {
+    uint a = clip.firstRow + (frame0 * clip.jointCount + joint) * 3;
+    uint b = clip.firstRow + (frame1 * clip.jointCount + joint) * 3;
+    row0 += weight * mix(baked.rows[a], baked.rows[b], blend);
+    row1 += weight * mix(baked.rows[a + 1], baked.rows[b + 1], blend);
+    row2 += weight * mix(baked.rows[a + 2], baked.rows[b + 2], blend);
+}
+
+void main() {
+    BakedClip clip = table.clips[inClip];
+
+    // Кадр клипа по времени экземпляра, последний кадр переходит в первый
+    float position = fract((ubo.time * inTiming.y + inTiming.x) / clip.duration) * float(clip.frameCount);
+    uint frame0 = min(uint(position), clip.frameCount - 1);
+    uint frame1 = (frame0 + 1) % clip.frameCount;
+    float blend = position - float(frame0);
+
+    vec4 row0 = vec4(0.0);
+    vec4 row1 = vec4(0.0);
+    vec4 row2 = vec4(0.0);
+    addJoint(frame0, frame1, blend, clip, inJoints.x, inWeights.x, row0, row1, row2);
+    addJoint(frame0, frame1, blend, clip, inJoints.y, inWeights.y, row0, row1, row2);
+    addJoint(frame0, frame1, blend, clip, inJoints.z, inWeights.z, row0, row1, row2);
+    addJoint(frame0, frame1, blend, clip, inJoints.w, inWeights.w, row0, row1, row2);
+
+    vec4 local = vec4(inPosition, 1.0);
+    vec3 skinned = vec3(dot(row0, local), dot(row1, local), dot(row2, local));
+    vec3 normal = vec3(dot(row0.xyz, inNormal), dot(row1.xyz, inNormal), dot(row2.xyz, inNormal));
+
+    // Поворот вокруг Y и перенос экземпляра
+    float s = sin(inPlacement.w);
+    float c = cos(inPlacement.w);
+    vec3 world = vec3(c * skinned.x + s * skinned.z, skinned.y, -s * skinned.x + c * skinned.z) + inPlacement.xyz;
+
+    gl_Position = ubo.proj * ubo.view * vec4(world, 1.0);
+    fragTexCoord = inTexCoord;
+    fragPosition = world;
+    fragNormal = vec3(c * normal.x + s * normal.z, normal.y, -s * normal.x + c * normal.z);
+}
@@ -0,0 +1,16 @@
+#version 450
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in float fragHeight;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 sunDirection = normalize(vec3(0.4, 0.8, 0.3));
+
+void main() {
+    // Цвет по высоте и рассеянный свет солнца
+    vec3 low = vec3(0.05, 0.20, 0.35);
+    vec3 high = vec3(0.55, 0.75, 0.85);
+    vec3 albedo = mix(low, high, clamp(fragHeight * 1.2 + 0.5, 0.0, 1.0));
+    float diffuse = max(dot(normalize(fragNormal), sunDirection), 0.0);
+    outColor = vec4(albedo * (0.25 + 0.75 * diffuse), 1.0);
+}
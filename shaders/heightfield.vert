@@ -0,0 +1,46 @@
+#version 450
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out float fragHeight;
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    float time;
+} ubo;
+
+struct HeightfieldVertex {
+    float height;
+    uint normal;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Heightfield {
+    HeightfieldVertex vertices[];
+} field;
+
+layout(push_constant) uniform Params {
+    uint size;
+    float spacing;
+    float time;
+} params;
+
+vec3 unpackNormal(uint packed) {
+    vec2 p = unpackSnorm2x16(packed);
+    vec3 n = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+    if (n.y < 0.0)
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main() {
+    // Экземпляр - ряд ячеек между столбцами x и x + 1, вершины полосы чередуют столбцы
+    // (сначала x + 1, чтобы треугольники смотрели вверх против часовой стрелки)
+    uint x = gl_InstanceIndex + 1 - (gl_VertexIndex & 1);
+    uint z = gl_VertexIndex >> 1;
+    HeightfieldVertex vertex = field.vertices[z * params.size + x];
+
+    vec2 position = (vec2(x, z) - 0.5 * float(params.size - 1)) * params.spacing;
+    gl_Position = ubo.proj * ubo.view * vec4(position.x, vertex.height, position.y, 1.0);
+    fragNormal = unpackNormal(vertex.normal);
+    fragHeight = vertex.height;
+}
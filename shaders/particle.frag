@@ -0,0 +1,13 @@
+#version 450
+layout(location = 0) in vec2 fragOffset;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Круглый спрайт с мягким краем
+    float falloff = 1.0 - dot(fragOffset, fragOffset);
+    if (falloff <= 0.0)
+        discard;
+    outColor = vec4(fragColor.rgb, fragColor.a * falloff);
+}
@@ -0,0 +1,45 @@
+#version 450
+layout(location = 0) out vec2 fragOffset; // от центра спрайта, [-1, 1]
+layout(location = 1) out vec4 fragColor;
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    float time;
+} ubo;
+
+struct Particle {
+    vec4 position; // xyz, w - оставшаяся жизнь в секундах
+    vec4 velocity; // xyz, w - полное время жизни
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Particles {
+    Particle particles[];
+} pool;
+
+layout(std430, set = 1, binding = 6) readonly buffer DrawList {
+    uvec2 entries[]; // ключ и номер частицы
+} drawList;
+
+const float PARTICLE_SIZE = 0.08; // половина стороны спрайта при рождении
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main() {
+    // Экземпляр - видимая частица из списка отрисовки, вершины - углы спрайта к камере
+    Particle particle = pool.particles[drawList.entries[gl_InstanceIndex].y];
+    vec2 corner = corners[gl_VertexIndex];
+    vec3 right = vec3(ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]);
+    vec3 up = vec3(ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]);
+
+    float age = clamp(1.0 - particle.position.w / particle.velocity.w, 0.0, 1.0); // 0 при рождении
+    float size = PARTICLE_SIZE * mix(0.6, 1.4, age);
+    vec3 position = particle.position.xyz + (right * corner.x + up * corner.y) * size;
+
+    gl_Position = ubo.proj * ubo.view * vec4(position, 1.0);
+    fragOffset = corner;
+    fragColor = vec4(mix(vec3(1.0, 0.85, 0.4), vec3(0.9, 0.25, 0.1), age), 1.0 - age);
+}
@@ -1,17 +1,107 @@
 #version 450
 
 layout(location = 0) in vec2 fragTexCoord;  // Получаем текстурные координаты
+layout(location = 1) in vec3 fragPosition;  // Мировое положение
+layout(location = 2) in vec3 fragNormal;
 layout(location = 0) out vec4 outColor;
 
+// Сетка кластеров - как в LightClusters.hpp
+const uint CLUSTER_X = 16;
+const uint CLUSTER_Y = 9;
+const uint CLUSTER_Z = 24;
+
 layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
     mat4 proj;
     float time;
+    uint lightCount;   // 0 - без освещения, цвет текстуры как есть
+    vec2 clusterDepth; // срез = floor(log(глубина) * x + y)
+    float ambient;
+    vec4 sun;               // xyz - направление на солнце, w - яркость (0 - без солнца и теней)
+    vec4 cascadeSplits;     // дальние границы каскадов теней по глубине вида
+    mat4 shadowMatrices[4]; // мир -> (u, v, глубина) слоя карты теней
 } ubo;
 
 layout(binding = 1) uniform sampler2D texSampler;  // Сэмплер для текстуры
 
+struct Light {
+    vec4 position;  // xyz, w - радиус действия
+    vec4 color;
+    vec4 direction; // направление прожектора
+    vec4 cone;      // косинусы внутреннего и внешнего углов, синус внешнего, 1 - прожектор
+};
+
+layout(std430, binding = 3) readonly buffer Lights {
+    Light lights[];
+} lightBuffer;
+
+layout(std430, binding = 4) readonly buffer Clusters {
+    uvec2 clusters[]; // первый индекс и число источников
+} grid;
+
+layout(std430, binding = 5) readonly buffer LightIndices {
+    uint count;
+    uint indices[];
+} lightList;
+
+layout(binding = 6) uniform sampler2DArrayShadow shadowMap; // слой на каскад
+
+// Доля солнечного света: каскад по глубине вида, 3 x 3 билинейных выборки сравнения
+float sunShadow(vec3 position, float viewDepth) {
+    if (viewDepth > ubo.cascadeSplits[3])
+        return 1.0;
+    uint cascade = 0u;
+    while (cascade < 3u && viewDepth > ubo.cascadeSplits[cascade])
+        cascade++;
+
+    vec4 coord = ubo.shadowMatrices[cascade] * vec4(position, 1.0);
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(cascade), coord.z));
+    return lit / 9.0;
+}
+
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
-}
\ No newline at end of file
+    vec4 albedo = texture(texSampler, fragTexCoord);
+    if (ubo.lightCount == 0u && ubo.sun.w == 0.0) {
+        outColor = albedo;
+        return;
+    }
+
+    // w отсечения - глубина вида: по ней выбираются каскад теней и срез кластеров
+    vec4 clip = ubo.proj * ubo.view * vec4(fragPosition, 1.0);
+    vec3 normal = normalize(fragNormal);
+    vec3 lighting = vec3(ubo.ambient);
+    if (ubo.sun.w > 0.0)
+        lighting += ubo.sun.w * max(dot(normal, ubo.sun.xyz), 0.0) * sunShadow(fragPosition, clip.w);
+    if (ubo.lightCount == 0u) {
+        outColor = vec4(albedo.rgb * lighting, albedo.a);
+        return;
+    }
+
+    // Кластер фрагмента: плитка NDC и срез глубины
+    uvec2 tile = min(uvec2((clip.xy / clip.w * 0.5 + 0.5) * vec2(CLUSTER_X, CLUSTER_Y)), uvec2(CLUSTER_X - 1, CLUSTER_Y - 1));
+    uint slice = uint(clamp(floor(log(clip.w) * ubo.clusterDepth.x + ubo.clusterDepth.y), 0.0, float(CLUSTER_Z - 1)));
+    uvec2 cluster = grid.clusters[(slice * CLUSTER_Y + tile.y) * CLUSTER_X + tile.x];
+
+    // Цикл только по источникам своего кластера
+    for (uint i = 0u; i < cluster.y; i++) {
+        Light light = lightBuffer.lights[lightList.indices[cluster.x + i]];
+        vec3 toLight = light.position.xyz - fragPosition;
+        float lightDistance = length(toLight);
+        vec3 direction = toLight / max(lightDistance, 1e-4);
+
+        // Обратный квадрат с плавным обнулением к радиусу действия
+        float ratio = lightDistance / light.position.w;
+        float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+        float attenuation = window * window / (1.0 + lightDistance * lightDistance);
+        if (light.cone.w != 0.0)
+            attenuation *= smoothstep(light.cone.y, light.cone.x, dot(-direction, light.direction.xyz));
+
+        lighting += light.color.rgb * attenuation * max(dot(normal, direction), 0.0);
+    }
+    outColor = vec4(albedo.rgb * lighting, albedo.a);
+}
@@ -2,8 +2,12 @@
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;  // Добавляем текстурные координаты
+layout(location = 3) in uvec4 inJoints;   // Суставы вершины
+layout(location = 4) in vec4 inWeights;   // Их веса, сумма 1
 
 layout(location = 0) out vec2 fragTexCoord;  // Передаем текстурные координаты во фрагментный шейдер
+layout(location = 1) out vec3 fragPosition; // мировое положение для освещения
+layout(location = 2) out vec3 fragNormal;
 
 layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
@@ -11,7 +15,20 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 proj;
 } ubo;
 
+// Палитра суставов: из позы привязки в текущую позу
+layout(binding = 2) uniform JointPalette {
+    mat4 joints[256];
+} palette;
+
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    mat4 skin = inWeights.x * palette.joints[inJoints.x]
+              + inWeights.y * palette.joints[inJoints.y]
+              + inWeights.z * palette.joints[inJoints.z]
+              + inWeights.w * palette.joints[inJoints.w];
+    mat4 world = ubo.model * skin;
+    vec4 position = world * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * position;
     fragTexCoord = inTexCoord;  // Просто передаем текстурные координаты
+    fragPosition = position.xyz;
+    fragNormal = mat3(world) * inNormal;
 }
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 450
+// Глубина модели в слой карты теней: только положение и скиннинг, без фрагментного шейдера
+layout(location = 0) in vec3 inPosition;
+layout(location = 3) in uvec4 inJoints;   // Суставы вершины
+layout(location = 4) in vec4 inWeights;   // Их веса, сумма 1
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view; // вид каскада
+    mat4 proj; // проекция каскада
+} ubo;
+
+layout(binding = 2) uniform JointPalette {
+    mat4 joints[256];
+} palette;
+
+void main() {
+    mat4 skin = inWeights.x * palette.joints[inJoints.x]
+              + inWeights.y * palette.joints[inJoints.y]
+              + inWeights.z * palette.joints[inJoints.z]
+              + inWeights.w * palette.joints[inJoints.w];
+    gl_Position = ubo.proj * ubo.view * ubo.model * skin * vec4(inPosition, 1.0);
+}
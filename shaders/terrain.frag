@@ -0,0 +1,52 @@
+#version 450
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in float fragHeight;
+layout(location = 2) in vec3 fragPosition;
+
+layout(location = 0) out vec4 outColor;
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    float time;
+    uint lightCount;
+    vec2 clusterDepth;
+    float ambient;
+    vec4 sun;               // xyz - направление на солнце, w - яркость (0 - без теней)
+    vec4 cascadeSplits;     // дальние границы каскадов теней по глубине вида
+    mat4 shadowMatrices[4]; // мир -> (u, v, глубина) слоя карты теней
+} ubo;
+
+layout(binding = 6) uniform sampler2DArrayShadow shadowMap; // слой на каскад
+
+// Доля солнечного света - как в shader.frag
+float sunShadow(vec3 position, float viewDepth) {
+    if (viewDepth > ubo.cascadeSplits[3])
+        return 1.0;
+    uint cascade = 0u;
+    while (cascade < 3u && viewDepth > ubo.cascadeSplits[cascade])
+        cascade++;
+
+    vec4 coord = ubo.shadowMatrices[cascade] * vec4(position, 1.0);
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(cascade), coord.z));
+    return lit / 9.0;
+}
+
+void main() {
+    // Трава на пологих склонах, камень на крутых, снег выше 150 м
+    vec3 normal = normalize(fragNormal);
+    vec3 grass = vec3(0.22, 0.35, 0.12);
+    vec3 rock = vec3(0.38, 0.34, 0.30);
+    vec3 snow = vec3(0.90, 0.92, 0.95);
+    vec3 albedo = mix(rock, grass, smoothstep(0.70, 0.85, normal.y));
+    albedo = mix(albedo, snow, smoothstep(140.0, 160.0, fragHeight) * smoothstep(0.5, 0.7, normal.y));
+    float diffuse = max(dot(normal, ubo.sun.xyz), 0.0);
+    if (ubo.sun.w > 0.0 && diffuse > 0.0)
+        diffuse *= sunShadow(fragPosition, -(ubo.view * vec4(fragPosition, 1.0)).z);
+    outColor = vec4(albedo * (0.25 + 0.75 * diffuse), 1.0);
+}
@@ -0,0 +1,66 @@
+#version 450
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out float fragHeight;
+layout(location = 2) out vec3 fragPosition; // мировое положение для теней
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    float time;
+} ubo;
+
+// Высоты уровней клипмапа: слой на уровень, тексель вершины - её номер по модулю 256
+layout(set = 1, binding = 0) uniform sampler2DArray heights;
+
+layout(push_constant) uniform Params {
+    ivec2 origin;  // угол сетки уровня в вершинах уровня
+    ivec2 offset;  // первая ячейка блока
+    uint level;
+    float spacing;
+    uint morph;    // край уровня перетекает в высоты следующего
+} params;
+
+const int BLOCK = 63;      // m: сетка уровня - 4m ячеек
+const int MORPH_CELLS = 16; // ширина полосы перехода у края уровня
+
+float fetchHeight(ivec2 vertex, uint level) {
+    return texelFetch(heights, ivec3(vertex & 255, level), 0).r;
+}
+
+void main() {
+    // Экземпляр - столбец ячеек блока, вершины полосы чередуют столбцы (сначала правый)
+    ivec2 local = params.offset + ivec2(gl_InstanceIndex + 1 - (gl_VertexIndex & 1), gl_VertexIndex >> 1);
+    ivec2 vertex = params.origin + local;
+    float height = fetchHeight(vertex, params.level);
+
+    // У края уровня высота переходит в линейную интерполяцию следующего уровня: на самом краю
+    // нечётные вершины ложатся на рёбра крупной сетки, и Т-стыки не дают трещин
+    if (params.morph != 0) {
+        ivec2 fromCenter = abs(local - ivec2(2 * BLOCK));
+        float blend = clamp(float(max(fromCenter.x, fromCenter.y) - (2 * BLOCK - MORPH_CELLS)) / float(MORPH_CELLS), 0.0, 1.0);
+        if (blend > 0.0) {
+            ivec2 coarse = vertex >> 1;
+            vec2 fraction = vec2(vertex & 1) * 0.5;
+            float h00 = fetchHeight(coarse, params.level + 1);
+            float h10 = fetchHeight(coarse + ivec2(1, 0), params.level + 1);
+            float h01 = fetchHeight(coarse + ivec2(0, 1), params.level + 1);
+            float h11 = fetchHeight(coarse + ivec2(1, 1), params.level + 1);
+            float coarseHeight = mix(mix(h00, h10, fraction.x), mix(h01, h11, fraction.x), fraction.y);
+            height = mix(height, coarseHeight, blend);
+        }
+    }
+
+    // Нормаль по соседям уровня (окно слоя шире сетки на вершину с каждой стороны)
+    float left = fetchHeight(vertex - ivec2(1, 0), params.level);
+    float right = fetchHeight(vertex + ivec2(1, 0), params.level);
+    float down = fetchHeight(vertex - ivec2(0, 1), params.level);
+    float up = fetchHeight(vertex + ivec2(0, 1), params.level);
+
+    vec2 position = vec2(vertex) * params.spacing;
+    vec3 world = vec3(position.x, height, position.y);
+    gl_Position = ubo.proj * ubo.view * vec4(world, 1.0);
+    fragNormal = normalize(vec3(left - right, 2.0 * params.spacing, down - up));
+    fragHeight = height;
+    fragPosition = world;
+}
@@ -0,0 +1,553 @@
+#include "Animation.hpp"
+#include "CpuProfiler.hpp"
+
+#include "assimp/scene.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/matrix_decompose.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+// Допуски отбрасывания ключей: единицы модели, компоненты кватерниона, доли масштаба
+static const float TRANSLATION_TOLERANCE = 1e-3f;
+static const float ROTATION_TOLERANCE = 1e-4f;
+static const float SCALE_TOLERANCE = 1e-4f;
+
+uint32_t Skeleton::find(const std::string& name) const {
+	for (uint32_t i = 0; i < names.size(); i++)
+		if (names[i] == name)
+			return i;
+	return UINT32_MAX;
+}
+
+// Матрицы assimp хранятся по строкам
+static glm::mat4 toGlm(const aiMatrix4x4& matrix) {
+	return glm::transpose(glm::make_mat4(&matrix.a1));
+}
+
+static JointTransform decomposeTransform(const glm::mat4& matrix) {
+	JointTransform transform;
+	glm::vec3 skew;
+	glm::vec4 perspective;
+	glm::decompose(matrix, transform.scale, transform.rotation, transform.translation, skew, perspective);
+	return transform;
+}
+
+static glm::mat4 composeTransform(const JointTransform& transform) {
+	glm::mat4 matrix = glm::mat4_cast(transform.rotation);
+	matrix[0] *= transform.scale.x;
+	matrix[1] *= transform.scale.y;
+	matrix[2] *= transform.scale.z;
+	matrix[3] = glm::vec4(transform.translation, 1.0f);
+	return matrix;
+}
+
+// Поворот к полусфере reference: q и -q - один поворот, интерполяция идёт коротким путём
+static glm::quat alignQuat(const glm::quat& q, const glm::quat& reference) {
+	return glm::dot(q, reference) < 0.0f ? -q : q;
+}
+
+static glm::quat nlerp(const glm::quat& a, const glm::quat& b, float t) {
+	glm::quat aligned = alignQuat(b, a);
+	return glm::normalize(glm::quat(a.w + (aligned.w - a.w) * t, a.x + (aligned.x - a.x) * t,
+									a.y + (aligned.y - a.y) * t, a.z + (aligned.z - a.z) * t));
+}
+
+static glm::i16vec4 packQuat(const glm::quat& q) {
+	return glm::i16vec4(glm::round(glm::vec4(q.x, q.y, q.z, q.w) * 32767.0f));
+}
+
+static glm::quat unpackQuat(const glm::i16vec4& packed) {
+	glm::vec4 v = glm::vec4(packed) / 32767.0f;
+	return glm::normalize(glm::quat(v.w, v.x, v.y, v.z));
+}
+
+void loadSkeleton(const aiScene* scene, const aiMesh* mesh, Skeleton& skeleton, std::vector<SkinnedVertex>& skin) {
+	skeleton = Skeleton();
+	skin.assign(mesh->mNumVertices, SkinnedVertex{{0, 0, 0, 0}, {0, 0, 0, 0}});
+
+	// Без костей - один сустав с единичной палитрой
+	if (!mesh->HasBones()) {
+		skeleton.names.push_back("root");
+		skeleton.parents.push_back(UINT32_MAX);
+		skeleton.bindPose.push_back({glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f)});
+		skeleton.inverseBind.push_back(glm::mat4(1.0f));
+		for (SkinnedVertex& vertex : skin)
+			vertex.weights[0] = 255;
+		return;
+	}
+
+	std::unordered_map<std::string, const aiBone*> bones;
+	for (unsigned int i = 0; i < mesh->mNumBones; i++)
+		bones[mesh->mBones[i]->mName.C_Str()] = mesh->mBones[i];
+
+	// Суставы - узлы костей и все их предки: цепочка до корня сцены полная
+	std::unordered_set<const aiNode*> needed;
+	std::function<void(const aiNode*)> mark = [&](const aiNode* node) {
+		if (bones.count(node->mName.C_Str()))
+			for (const aiNode* ancestor = node; ancestor && needed.insert(ancestor).second; ancestor = ancestor->mParent) {}
+		for (unsigned int i = 0; i < node->mNumChildren; i++)
+			mark(node->mChildren[i]);
+	};
+	mark(scene->mRootNode);
+
+	// Обход в глубину: родитель раньше ребёнка
+	std::unordered_map<std::string, uint32_t> jointIndex;
+	std::function<void(const aiNode*, uint32_t)> add = [&](const aiNode* node, uint32_t parent) {
+		if (!needed.count(node))
+			return;
+		uint32_t index = skeleton.size();
+		auto bone = bones.find(node->mName.C_Str());
+		skeleton.names.push_back(node->mName.C_Str());
+		skeleton.parents.push_back(parent);
+		skeleton.bindPose.push_back(decomposeTransform(toGlm(node->mTransformation)));
+		skeleton.inverseBind.push_back(bone != bones.end() ? toGlm(bone->second->mOffsetMatrix) : glm::mat4(1.0f));
+		jointIndex[node->mName.C_Str()] = index;
+		for (unsigned int i = 0; i < node->mNumChildren; i++)
+			add(node->mChildren[i], index);
+	};
+	add(scene->mRootNode, UINT32_MAX);
+	skeleton.globalInverse = glm::inverse(toGlm(scene->mRootNode->mTransformation));
+
+	if (skeleton.size() > MAX_JOINTS)
+		throw std::runtime_error("Skeleton has more than " + std::to_string(MAX_JOINTS) + " joints");
+
+	// Четыре наибольших веса вершины
+	std::vector<glm::vec4> weights(mesh->mNumVertices, glm::vec4(0.0f));
+	std::vector<glm::uvec4> joints(mesh->mNumVertices, glm::uvec4(0));
+	for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+		const aiBone* bone = mesh->mBones[b];
+		uint32_t joint = jointIndex[bone->mName.C_Str()];
+		for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+			uint32_t vertex = bone->mWeights[w].mVertexId;
+			float weight = bone->mWeights[w].mWeight;
+			int smallest = 0;
+			for (int k = 1; k < 4; k++)
+				if (weights[vertex][k] < weights[vertex][smallest])
+					smallest = k;
+			if (weight > weights[vertex][smallest]) {
+				weights[vertex][smallest] = weight;
+				joints[vertex][smallest] = joint;
+			}
+		}
+	}
+
+	// Нормировка и квантование: сумма весов ровно 255, остаток округления - наибольшему весу
+	for (size_t v = 0; v < skin.size(); v++) {
+		float sum = weights[v].x + weights[v].y + weights[v].z + weights[v].w;
+		if (sum <= 0.0f) {
+			skin[v].weights[0] = 255; // вершина без весов следует за корнем
+			continue;
+		}
+		int total = 0;
+		int largest = 0;
+		for (int k = 0; k < 4; k++) {
+			skin[v].joints[k] = static_cast<uint16_t>(joints[v][k]);
+			skin[v].weights[k] = static_cast<uint8_t>(std::lround(weights[v][k] / sum * 255.0f));
+			total += skin[v].weights[k];
+			if (weights[v][k] > weights[v][largest])
+				largest = k;
+		}
+		skin[v].weights[largest] = static_cast<uint8_t>(skin[v].weights[largest] + 255 - total);
+	}
+}
+
+// Отбрасывание ключей, которые восстанавливаются интерполяцией между оставленными соседями
+template<typename T, typename Lerp, typename Distance>
+static void reduceKeys(std::vector<float>& times, std::vector<T>& values, Lerp lerp, Distance distance, float tolerance) {
+	size_t count = times.size();
+	std::vector<float> keptTimes = {times[0]};
+	std::vector<T> keptValues = {values[0]};
+
+	size_t anchor = 0;
+	for (size_t k = 1; k + 1 < count; k++) {
+		// Можно ли перейти от anchor сразу к k + 1, не потеряв ключи между ними
+		bool removable = true;
+		for (size_t m = anchor + 1; m <= k && removable; m++) {
+			float t = (times[m] - times[anchor]) / (times[k + 1] - times[anchor]);
+			removable = distance(lerp(values[anchor], values[k + 1], t), values[m]) <= tolerance;
+		}
+		if (!removable) {
+			keptTimes.push_back(times[k]);
+			keptValues.push_back(values[k]);
+			anchor = k;
+		}
+	}
+	if (count > 1) {
+		keptTimes.push_back(times[count - 1]);
+		keptValues.push_back(values[count - 1]);
+	}
+
+	// Постоянный канал - один ключ
+	if (keptTimes.size() == 2 && distance(keptValues[0], keptValues[1]) <= tolerance) {
+		keptTimes.pop_back();
+		keptValues.pop_back();
+	}
+	times.swap(keptTimes);
+	values.swap(keptValues);
+}
+
+void loadAnimationClips(const aiScene* scene, const Skeleton& skeleton, std::vector<AnimationClip>& clips) {
+	auto vectorLerp = [](const glm::vec3& a, const glm::vec3& b, float t) { return a + (b - a) * t; };
+	auto vectorDistance = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); };
+	auto quatDistance = [](const glm::quat& a, const glm::quat& b) {
+		glm::quat aligned = alignQuat(b, a);
+		return std::max(std::max(std::abs(a.x - aligned.x), std::abs(a.y - aligned.y)),
+						std::max(std::abs(a.z - aligned.z), std::abs(a.w - aligned.w)));
+	};
+
+	for (unsigned int a = 0; a < scene->mNumAnimations; a++) {
+		const aiAnimation* animation = scene->mAnimations[a];
+		double ticksPerSecond = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : 25.0;
+
+		AnimationClip clip;
+		clip.name = animation->mName.C_Str();
+		clip.duration = static_cast<float>(animation->mDuration / ticksPerSecond);
+		clip.translationTracks.assign(skeleton.size(), {0, 0});
+		clip.rotationTracks.assign(skeleton.size(), {0, 0});
+		clip.scaleTracks.assign(skeleton.size(), {0, 0});
+
+		for (unsigned int c = 0; c < animation->mNumChannels; c++) {
+			const aiNodeAnim* channel = animation->mChannels[c];
+			uint32_t joint = skeleton.find(channel->mNodeName.C_Str());
+			if (joint == UINT32_MAX)
+				continue; // узел не влияет на меш
+
+			std::vector<float> times;
+			std::vector<glm::vec3> vectors;
+			for (unsigned int k = 0; k < channel->mNumPositionKeys; k++) {
+				times.push_back(static_cast<float>(channel->mPositionKeys[k].mTime / ticksPerSecond));
+				const aiVector3D& value = channel->mPositionKeys[k].mValue;
+				vectors.push_back(glm::vec3(value.x, value.y, value.z));
+			}
+			if (!times.empty()) {
+				reduceKeys(times, vectors, vectorLerp, vectorDistance, TRANSLATION_TOLERANCE);
+				clip.translationTracks[joint] = {static_cast<uint32_t>(clip.translationTimes.size()), static_cast<uint32_t>(times.size())};
+				clip.translationTimes.insert(clip.translationTimes.end(), times.begin(), times.end());
+				clip.translationKeys.insert(clip.translationKeys.end(), vectors.begin(), vectors.end());
+			}
+
+			times.clear();
+			std::vector<glm::quat> rotations;
+			for (unsigned int k = 0; k < channel->mNumRotationKeys; k++) {
+				times.push_back(static_cast<float>(channel->mRotationKeys[k].mTime / ticksPerSecond));
+				const aiQuaternion& value = channel->mRotationKeys[k].mValue;
+				glm::quat rotation = glm::normalize(glm::quat(value.w, value.x, value.y, value.z));
+				rotations.push_back(rotations.empty() ? rotation : alignQuat(rotation, rotations.back()));
+			}
+			if (!times.empty()) {
+				reduceKeys(times, rotations, nlerp, quatDistance, ROTATION_TOLERANCE);
+				clip.rotationTracks[joint] = {static_cast<uint32_t>(clip.rotationTimes.size()), static_cast<uint32_t>(times.size())};
+				clip.rotationTimes.insert(clip.rotationTimes.end(), times.begin(), times.end());
+				for (const glm::quat& rotation : rotations)
+					clip.rotationKeys.push_back(packQuat(rotation));
+			}
+
+			times.clear();
+			vectors.clear();
+			for (unsigned int k = 0; k < channel->mNumScalingKeys; k++) {
+				times.push_back(static_cast<float>(channel->mScalingKeys[k].mTime / ticksPerSecond));
+				const aiVector3D& value = channel->mScalingKeys[k].mValue;
+				vectors.push_back(glm::vec3(value.x, value.y, value.z));
+			}
+			if (!times.empty()) {
+				reduceKeys(times, vectors, vectorLerp, vectorDistance, SCALE_TOLERANCE);
+				clip.scaleTracks[joint] = {static_cast<uint32_t>(clip.scaleTimes.size()), static_cast<uint32_t>(times.size())};
+				clip.scaleTimes.insert(clip.scaleTimes.end(), times.begin(), times.end());
+				clip.scaleKeys.insert(clip.scaleKeys.end(), vectors.begin(), vectors.end());
+			}
+		}
+		clips.push_back(std::move(clip));
+	}
+}
+
+// Пара соседних ключей канала и доля между ними в момент time
+static uint32_t findKey(const std::vector<float>& times, const AnimationTrack& track, float time, float& t) {
+	const float* begin = times.data() + track.firstKey;
+	const float* end = begin + track.keyCount;
+	const float* next = std::upper_bound(begin, end, time);
+	if (next == begin) {
+		t = 0.0f;
+		return track.firstKey;
+	}
+	if (next == end) {
+		t = 0.0f;
+		return track.firstKey + track.keyCount - 1;
+	}
+	t = (time - next[-1]) / (next[0] - next[-1]);
+	return static_cast<uint32_t>(next - 1 - times.data());
+}
+
+void sampleClip(const AnimationClip& clip, const Skeleton& skeleton, float time, std::vector<JointTransform>& pose) {
+	if (clip.duration > 0.0f) {
+		time = std::fmod(time, clip.duration);
+		if (time < 0.0f)
+			time += clip.duration;
+	}
+
+	pose.resize(skeleton.size());
+	for (uint32_t joint = 0; joint < skeleton.size(); joint++) {
+		JointTransform transform = skeleton.bindPose[joint];
+		float t;
+
+		const AnimationTrack& translation = clip.translationTracks[joint];
+		if (translation.keyCount) {
+			uint32_t key = findKey(clip.translationTimes, translation, time, t);
+			transform.translation = t > 0.0f ? glm::mix(clip.translationKeys[key], clip.translationKeys[key + 1], t) : clip.translationKeys[key];
+		}
+
+		const AnimationTrack& rotation = clip.rotationTracks[joint];
+		if (rotation.keyCount) {
+			uint32_t key = findKey(clip.rotationTimes, rotation, time, t);
+			glm::quat q = unpackQuat(clip.rotationKeys[key]);
+			transform.rotation = t > 0.0f ? nlerp(q, unpackQuat(clip.rotationKeys[key + 1]), t) : q;
+		}
+
+		const AnimationTrack& scale = clip.scaleTracks[joint];
+		if (scale.keyCount) {
+			uint32_t key = findKey(clip.scaleTimes, scale, time, t);
+			transform.scale = t > 0.0f ? glm::mix(clip.scaleKeys[key], clip.scaleKeys[key + 1], t) : clip.scaleKeys[key];
+		}
+
+		pose[joint] = transform;
+	}
+}
+
+void blendPoses(const std::vector<JointTransform>& from, const std::vector<JointTransform>& to, float weight,
+				std::vector<JointTransform>& result) {
+	result.resize(from.size());
+	for (size_t joint = 0; joint < from.size(); joint++) {
+		result[joint].translation = glm::mix(from[joint].translation, to[joint].translation, weight);
+		result[joint].rotation = nlerp(from[joint].rotation, to[joint].rotation, weight);
+		result[joint].scale = glm::mix(from[joint].scale, to[joint].scale, weight);
+	}
+}
+
+void computePalette(const Skeleton& skeleton, const std::vector<JointTransform>& pose, glm::mat4* palette) {
+	// Сначала преобразования суставов в пространстве модели: родитель посчитан раньше ребёнка
+	for (uint32_t joint = 0; joint < skeleton.size(); joint++) {
+		glm::mat4 local = composeTransform(pose[joint]);
+		uint32_t parent = skeleton.parents[joint];
+		palette[joint] = parent == UINT32_MAX ? local : palette[parent] * local;
+	}
+	for (uint32_t joint = 0; joint < skeleton.size(); joint++)
+		palette[joint] = skeleton.globalInverse * palette[joint] * skeleton.inverseBind[joint];
+}
+
+void Animator::init(const Skeleton* skeleton, const std::vector<AnimationClip>* clips) {
+	this->skeleton = skeleton;
+	this->clips = clips;
+	instances.clear();
+	palettes.clear();
+}
+
+uint32_t Animator::add(uint32_t clip, float speed) {
+	Instance instance;
+	instance.clip = clip < clips->size() ? clip : UINT32_MAX;
+	instance.time = 0.0f;
+	instance.speed = speed;
+	instance.nextClip = UINT32_MAX;
+	instance.nextTime = 0.0f;
+	instance.fade = 0.0f;
+	instance.fadeDuration = 0.0f;
+	instance.pose.resize(skeleton->size());
+	instance.nextPose.resize(skeleton->size());
+	instances.push_back(std::move(instance));
+
+	palettes.resize(instances.size() * skeleton->size(), glm::mat4(1.0f));
+	return static_cast<uint32_t>(instances.size()) - 1;
+}
+
+void Animator::play(uint32_t index, uint32_t clip, float fadeSeconds) {
+	Instance& instance = instances[index];
+	if (clip >= clips->size())
+		clip = UINT32_MAX;
+	if (fadeSeconds <= 0.0f || instance.clip == clip) {
+		instance.clip = clip;
+		instance.time = 0.0f;
+		instance.nextClip = UINT32_MAX;
+		instance.fade = instance.fadeDuration = 0.0f;
+		return;
+	}
+	instance.nextClip = clip;
+	instance.nextTime = 0.0f;
+	instance.fade = 0.0f;
+	instance.fadeDuration = fadeSeconds;
+}
+
+void Animator::evaluate(Instance& instance, float deltaSeconds, glm::mat4* palette) {
+	instance.time += deltaSeconds * instance.speed;
+	if (instance.clip == UINT32_MAX)
+		instance.pose = skeleton->bindPose;
+	else
+		sampleClip((*clips)[instance.clip], *skeleton, instance.time, instance.pose);
+
+	// Переход: поза следующего клипа подмешивается с растущим весом
+	bool fading = instance.fade < instance.fadeDuration;
+	if (instance.nextClip != UINT32_MAX || fading) {
+		instance.nextTime += deltaSeconds * instance.speed;
+		instance.fade += deltaSeconds;
+		if (instance.nextClip == UINT32_MAX)
+			instance.nextPose = skeleton->bindPose;
+		else
+			sampleClip((*clips)[instance.nextClip], *skeleton, instance.nextTime, instance.nextPose);
+
+		float weight = std::min(1.0f, instance.fade / instance.fadeDuration);
+		blendPoses(instance.pose, instance.nextPose, weight, instance.pose);
+		if (weight >= 1.0f) {
+			instance.clip = instance.nextClip;
+			instance.time = instance.nextTime;
+			instance.nextClip = UINT32_MAX;
+			instance.fade = instance.fadeDuration = 0.0f;
+		}
+	}
+
+	computePalette(*skeleton, instance.pose, palette);
+}
+
+void Animator::update(float deltaSeconds, WorkerPool* pool) {
+	if (instances.empty())
+		return;
+	PROFILE_FUNCTION();
+
+	uint32_t joints = skeleton->size();
+	WorkerPool::Slice slice = [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+			evaluate(instances[i], deltaSeconds, palettes.data() + i * joints);
+	};
+	// Участки по несколько экземпляров: на каждый поток их приходится с запасом для балансировки
+	uint32_t count = static_cast<uint32_t>(instances.size());
+	if (pool)
+		pool->parallelFor(0, count, std::max(1u, count / (pool->size() * 8)), slice);
+	else
+		slice(0, count);
+}
+
+void bakeAnimations(const Skeleton& skeleton, const std::vector<AnimationClip>& clips, float framesPerSecond, BakedAnimations& baked) {
+	PROFILE_FUNCTION();
+	baked.framesPerSecond = framesPerSecond;
+	baked.clips.clear();
+	baked.rows.clear();
+
+	uint32_t joints = skeleton.size();
+	std::vector<JointTransform> pose;
+	std::vector<glm::mat4> palette(joints);
+	auto appendFrame = [&]() {
+		for (const glm::mat4& matrix : palette)
+			for (int row = 0; row < 3; row++)
+				baked.rows.push_back(glm::vec4(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]));
+	};
+
+	if (clips.empty()) {
+		baked.clips.push_back({0, 1, joints, 1.0f});
+		computePalette(skeleton, skeleton.bindPose, palette.data());
+		appendFrame();
+		return;
+	}
+
+	for (const AnimationClip& clip : clips) {
+		float duration = clip.duration > 0.0f ? clip.duration : 1.0f;
+		uint32_t frames = std::max(1u, static_cast<uint32_t>(std::lround(duration * framesPerSecond)));
+		baked.clips.push_back({static_cast<uint32_t>(baked.rows.size()), frames, joints, duration});
+		for (uint32_t frame = 0; frame < frames; frame++) {
+			sampleClip(clip, skeleton, duration * frame / frames, pose);
+			computePalette(skeleton, pose, palette.data());
+			appendFrame();
+		}
+	}
+}
+
+// Заголовок файла запекания
+typedef struct _BakedHeader
+{
+	char magic[4]; // "BAKE"
+	uint32_t version;
+	uint32_t jointCount;
+	uint32_t clipCount;
+	float framesPerSecond;
+	uint32_t rowCount;
+	uint64_t sourceHash; // скелет и ключи клипов: после правки источника файл не подойдёт
+} BakedHeader;
+
+static const uint32_t BAKE_VERSION = 2;
+
+// FNV-1a по байтам массива
+template<typename T>
+static void hashBytes(uint64_t& hash, const T* data, size_t count) {
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < count * sizeof(T); i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+}
+
+template<typename T>
+static void hashVector(uint64_t& hash, const std::vector<T>& values) {
+	uint64_t size = values.size();
+	hashBytes(hash, &size, 1);
+	hashBytes(hash, values.data(), values.size());
+}
+
+// Всё, от чего зависят палитры: иерархия, поза привязки и ключи клипов
+static uint64_t sourceHash(const Skeleton& skeleton, const std::vector<AnimationClip>& clips) {
+	uint64_t hash = 14695981039346656037ull;
+	for (const std::string& name : skeleton.names)
+		hashBytes(hash, name.c_str(), name.size() + 1);
+	hashVector(hash, skeleton.parents);
+	hashVector(hash, skeleton.bindPose);
+	hashVector(hash, skeleton.inverseBind);
+	hashBytes(hash, &skeleton.globalInverse, 1);
+
+	for (const AnimationClip& clip : clips) {
+		hashBytes(hash, &clip.duration, 1);
+		hashVector(hash, clip.translationTracks);
+		hashVector(hash, clip.rotationTracks);
+		hashVector(hash, clip.scaleTracks);
+		hashVector(hash, clip.translationTimes);
+		hashVector(hash, clip.translationKeys);
+		hashVector(hash, clip.rotationTimes);
+		hashVector(hash, clip.rotationKeys);
+		hashVector(hash, clip.scaleTimes);
+		hashVector(hash, clip.scaleKeys);
+	}
+	return hash;
+}
+
+bool loadBakedAnimations(const std::string& path, const Skeleton& skeleton, const std::vector<AnimationClip>& clips,
+						float framesPerSecond, BakedAnimations& baked) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	BakedHeader header;
+	uint32_t clipCount = std::max(1u, static_cast<uint32_t>(clips.size()));
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::string(header.magic, 4) != "BAKE" ||
+		header.version != BAKE_VERSION || header.jointCount != skeleton.size() || header.clipCount != clipCount ||
+		header.framesPerSecond != framesPerSecond || header.sourceHash != sourceHash(skeleton, clips))
+		return false;
+
+	baked.framesPerSecond = header.framesPerSecond;
+	baked.clips.resize(header.clipCount);
+	baked.rows.resize(header.rowCount);
+	file.read(reinterpret_cast<char*>(baked.clips.data()), baked.clips.size() * sizeof(BakedClip));
+	file.read(reinterpret_cast<char*>(baked.rows.data()), baked.rows.size() * sizeof(glm::vec4));
+	return static_cast<bool>(file);
+}
+
+void saveBakedAnimations(const std::string& path, const Skeleton& skeleton, const std::vector<AnimationClip>& clips,
+						const BakedAnimations& baked) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("Can't write baked animations: " + path);
+
+	BakedHeader header = {{'B', 'A', 'K', 'E'}, BAKE_VERSION, skeleton.size(), static_cast<uint32_t>(baked.clips.size()),
+						baked.framesPerSecond, static_cast<uint32_t>(baked.rows.size()), sourceHash(skeleton, clips)};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(baked.clips.data()), baked.clips.size() * sizeof(BakedClip));
+	file.write(reinterpret_cast<const char*>(baked.rows.data()), baked.rows.size() * sizeof(glm::vec4));
+}
@@ -0,0 +1,106 @@
+#include "CpuProfiler.hpp"
+
+#ifdef CPU_PROFILER
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+typedef CpuProfiler::ThreadBuffer ThreadBuffer;
+
+// Буферы переживают свои потоки: события завершившихся потоков тоже попадают в выгрузку
+static std::mutex buffersMutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+// Калибровка тактов: пара (такты, нс) при первой записи и при выгрузке
+typedef std::chrono::steady_clock Clock;
+static uint64_t calibrationTicks;
+static Clock::time_point calibrationTime;
+
+ThreadBuffer* CpuProfiler::registerThread() {
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	if (buffers.empty()) {
+		calibrationTicks = now();
+		calibrationTime = Clock::now();
+	}
+	buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+	local = buffers.back().get();
+	local->id = static_cast<uint32_t>(buffers.size());
+	local->name = "thread " + std::to_string(local->id);
+	return local;
+}
+
+void CpuProfiler::setThreadName(const char* name) {
+	ThreadBuffer* buffer = local ? local : registerThread();
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	buffer->name = name;
+}
+
+// Экранирование строки для JSON
+static void writeString(std::ofstream& out, const char* text) {
+	out << '"';
+	for (const char* c = text; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			out << '\\';
+		out << *c;
+	}
+	out << '"';
+}
+
+bool CpuProfiler::writeChromeTrace(const std::string& path) {
+	std::ofstream out(path);
+	if (!out.is_open())
+		return false;
+
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	uint64_t origin = UINT64_MAX;
+	std::vector<std::vector<Event>> snapshots(buffers.size());
+
+	// Снимок колец: события, которые могли быть перезаписаны во время копирования, отбрасываются
+	for (size_t i = 0; i < buffers.size(); i++) {
+		ThreadBuffer& buffer = *buffers[i];
+		uint64_t head = buffer.head.load(std::memory_order_acquire);
+		uint64_t first = head > ThreadBuffer::capacity ? head - ThreadBuffer::capacity : 0;
+
+		std::vector<Event>& events = snapshots[i];
+		for (uint64_t index = first; index < head; index++)
+			events.push_back(buffer.events[index & (ThreadBuffer::capacity - 1)]);
+
+		uint64_t after = buffer.head.load(std::memory_order_acquire);
+		if (after >= first + ThreadBuffer::capacity) {
+			uint64_t overwritten = after - ThreadBuffer::capacity + 1 - first;
+			events.erase(events.begin(), events.begin() + std::min<uint64_t>(overwritten, events.size()));
+		}
+		for (const Event& event : events)
+			origin = std::min(origin, event.start);
+	}
+
+	// Такты в микросекундах от первого события
+	double nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - calibrationTime).count();
+	uint64_t ticks = CpuProfiler::now() - calibrationTicks;
+	double microsecondsPerTick = ticks > 0 ? nanoseconds / ticks / 1000.0 : 0.0;
+
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	for (size_t i = 0; i < buffers.size(); i++) {
+		out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffers[i]->id
+			<< ",\"args\":{\"name\":";
+		writeString(out, buffers[i]->name.c_str());
+		out << "}}";
+		first = false;
+
+		for (const Event& event : snapshots[i]) {
+			out << ",\n{\"name\":";
+			writeString(out, event.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffers[i]->id
+				<< ",\"ts\":" << (event.start - origin) * microsecondsPerTick
+				<< ",\"dur\":" << (event.end - event.start) * microsecondsPerTick << "}";
+		}
+	}
+	out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+	return true;
+}
+
+#endif // CPU_PROFILER
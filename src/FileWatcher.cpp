@@ -0,0 +1,100 @@
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Единый вид пути, чтобы события inotify совпадали с зарегистрированными файлами
+static std::string normalizePath(const std::filesystem::path& path) {
+	return path.lexically_normal().generic_string();
+}
+
+// Время последней записи; при ошибке (файл пересохраняется редактором) - пустое значение
+static std::filesystem::file_time_type lastWriteTime(const std::string& path) {
+	std::error_code error;
+	auto time = std::filesystem::last_write_time(path, error);
+	return error ? std::filesystem::file_time_type() : time;
+}
+
+void FileWatcher::init() {
+#ifdef __linux__
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	// Если inotify недоступен - работаем опросом
+#endif
+}
+
+void FileWatcher::shutdown() {
+#ifdef __linux__
+	if (inotifyFd >= 0) {
+		close(inotifyFd); // наблюдения снимаются вместе с дескриптором
+		inotifyFd = -1;
+	}
+	directories.clear();
+#endif
+	files.clear();
+}
+
+std::string FileWatcher::add(const std::string& path) {
+	std::string file = normalizePath(path);
+	files[file] = lastWriteTime(file);
+
+#ifdef __linux__
+	if (inotifyFd < 0)
+		return file;
+
+	// Следим за каталогом, а не за файлом: редакторы часто сохраняют через переименование
+	std::string directory = normalizePath(std::filesystem::path(file).parent_path());
+	if (directory.empty())
+		directory = ".";
+	for (auto& watch : directories)
+		if (watch.second == directory)
+			return file;
+
+	int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (wd >= 0)
+		directories[wd] = directory;
+#endif
+	return file;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+	std::vector<std::string> changed;
+
+#ifdef __linux__
+	if (inotifyFd >= 0) {
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+			for (char* ptr = buffer; ptr < buffer + length; ) {
+				inotify_event* event = reinterpret_cast<inotify_event*>(ptr);
+				ptr += sizeof(inotify_event) + event->len;
+
+				auto directory = directories.find(event->wd);
+				if (directory == directories.end() || event->len == 0)
+					continue;
+
+				std::string file = normalizePath(std::filesystem::path(directory->second) / event->name);
+				if (files.count(file) && std::find(changed.begin(), changed.end(), file) == changed.end())
+					changed.push_back(file);
+			}
+		}
+		for (auto& file : changed)
+			files[file] = lastWriteTime(file);
+		return changed;
+	}
+#endif
+
+	// Опрос времени последней записи
+	for (auto& file : files) {
+		auto time = lastWriteTime(file.first);
+		if (time != std::filesystem::file_time_type() && time != file.second) {
+			file.second = time;
+			changed.push_back(file.first);
+		}
+	}
+	return changed;
+}
@@ -0,0 +1,372 @@
+#include "FrameCapture.hpp"
+#include "CpuProfiler.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+void FrameCapture::init(ResourceRegistry* registry, ResourceStateTracker* tracker, GpuTimeline* timeline, uint32_t workers) {
+	this->registry = registry;
+	this->tracker = tracker;
+	this->timeline = timeline;
+
+	running = true;
+	for (uint32_t i = 0; i < std::max(1u, workers); i++)
+		threads.emplace_back(&FrameCapture::workerLoop, this);
+}
+
+void FrameCapture::destroy() {
+	if (!running)
+		return;
+
+	drain();
+	releaseSlots();
+	capturing = false;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	jobReady.notify_all();
+	for (auto& thread : threads)
+		thread.join();
+	threads.clear();
+}
+
+void FrameCapture::start(const std::string& directory, CaptureFormat format, VkExtent2D extent, VkFormat imageFormat, uint32_t poolSize) {
+	// Копирование побайтовое: поддерживаются только 8-битные четырёхканальные форматы
+	switch (imageFormat) {
+		case VK_FORMAT_B8G8R8A8_SRGB: bgra = true; srgb = true; break;
+		case VK_FORMAT_B8G8R8A8_UNORM: bgra = true; srgb = false; break;
+		case VK_FORMAT_R8G8B8A8_SRGB: bgra = false; srgb = true; break;
+		case VK_FORMAT_R8G8B8A8_UNORM: bgra = false; srgb = false; break;
+		default: throw std::runtime_error("Frame capture: unsupported image format");
+	}
+
+	finish();
+	std::filesystem::create_directories(directory);
+	this->directory = directory;
+	this->format = format;
+	this->extent = extent;
+	nextFrame = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		filesWritten = 0;
+		filesFailed = 0;
+	}
+
+	// Кадров в работе может быть до FRAMES_IN_FLIGHT, и ещё несколько кодируются
+	releaseSlots();
+	createSlots(std::max(2u, poolSize));
+	capturing = true;
+}
+
+void FrameCapture::finish() {
+	drain();
+	capturing = false;
+}
+
+uint32_t FrameCapture::written() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return filesWritten;
+}
+
+uint32_t FrameCapture::failed() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return filesFailed;
+}
+
+void FrameCapture::createSlots(uint32_t count) {
+	VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+	slots.resize(count);
+	for (Slot& slot : slots) {
+		// Память для чтения CPU; копирование GPU в неё последовательное, CPU читает один раз
+		slot.buffer = registry->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		slot.vkBuffer = registry->buffer(slot.buffer);
+		slot.mapped = static_cast<const uint8_t*>(registry->map(slot.buffer));
+		slot.state = SlotState::Free;
+		slot.value = 0;
+		slot.frame = 0;
+		slot.extent = extent;
+		tracker->trackBuffer(slot.vkBuffer);
+	}
+}
+
+void FrameCapture::releaseSlots() {
+	// Вызывается после drain(): буферы не используются ни GPU, ни рабочими потоками
+	for (Slot& slot : slots) {
+		tracker->forget(slot.vkBuffer);
+		registry->release(slot.buffer);
+	}
+	slots.clear();
+}
+
+void FrameCapture::record(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D imageExtent, ResourceUsage usage) {
+	if (!capturing)
+		return;
+	PROFILE_FUNCTION();
+
+	// Размер кадра изменился (окно) - буферы пересоздаются, нумерация продолжается
+	if (imageExtent.width != extent.width || imageExtent.height != extent.height) {
+		uint32_t count = static_cast<uint32_t>(slots.size());
+		drain();
+		releaseSlots();
+		extent = imageExtent;
+		createSlots(count);
+	}
+
+	uint32_t index = acquireSlot();
+	Slot& slot = slots[index];
+
+	tracker->use(image, ResourceUsage::TransferSrc);
+	tracker->use(slot.vkBuffer, ResourceUsage::TransferDst);
+	tracker->flush(commandBuffer);
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0; // строки без выравнивания
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = {0, 0, 0};
+	region.imageExtent = {extent.width, extent.height, 1};
+	vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.vkBuffer, 1, &region);
+
+	// Запись копирования становится видимой CPU; изображение возвращается в прежнее состояние
+	tracker->use(slot.vkBuffer, ResourceUsage::HostRead);
+	tracker->use(image, usage);
+	tracker->flush(commandBuffer);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	slot.state = SlotState::Recorded;
+	slot.frame = nextFrame++;
+	slot.extent = extent;
+}
+
+void FrameCapture::submitted(uint64_t value) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (Slot& slot : slots) {
+		if (slot.state == SlotState::Recorded) {
+			slot.state = SlotState::InFlight;
+			slot.value = value;
+		}
+	}
+}
+
+void FrameCapture::poll() {
+	std::lock_guard<std::mutex> lock(mutex);
+	pollLocked();
+}
+
+void FrameCapture::pollLocked() {
+	for (uint32_t i = 0; i < slots.size(); i++) {
+		if (slots[i].state == SlotState::InFlight && timeline->reached(slots[i].value)) {
+			slots[i].state = SlotState::Encoding;
+			jobs.push_back(i);
+			jobReady.notify_one();
+		}
+	}
+}
+
+uint32_t FrameCapture::acquireSlot() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		pollLocked();
+
+		uint64_t oldest = UINT64_MAX;
+		bool encoding = false;
+		for (uint32_t i = 0; i < slots.size(); i++) {
+			if (slots[i].state == SlotState::Free)
+				return i;
+			if (slots[i].state == SlotState::InFlight)
+				oldest = std::min(oldest, slots[i].value);
+			encoding |= slots[i].state == SlotState::Encoding;
+		}
+
+		// Пул исчерпан: захват упирается в GPU или в кодирование, рендер ждёт
+		PROFILE_SCOPE("capture backpressure");
+		if (oldest != UINT64_MAX) {
+			lock.unlock();
+			timeline->wait(oldest);
+			lock.lock();
+		} else if (encoding) {
+			slotFreed.wait(lock);
+		} else {
+			throw std::runtime_error("Frame capture: readback pool exhausted within one submission");
+		}
+	}
+}
+
+void FrameCapture::drain() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		pollLocked();
+
+		uint64_t latest = 0;
+		bool encoding = false;
+		for (const Slot& slot : slots) {
+			if (slot.state == SlotState::InFlight)
+				latest = std::max(latest, slot.value);
+			encoding |= slot.state == SlotState::Encoding;
+		}
+
+		if (latest != 0) {
+			lock.unlock();
+			timeline->wait(latest);
+			lock.lock();
+		} else if (encoding) {
+			slotFreed.wait(lock);
+		} else {
+			return;
+		}
+	}
+}
+
+void FrameCapture::workerLoop() {
+	PROFILE_THREAD("capture");
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		jobReady.wait(lock, [this] { return !running || !jobs.empty(); });
+		if (jobs.empty())
+			return;
+
+		uint32_t index = jobs.front();
+		jobs.pop_front();
+		Slot slot = slots[index]; // слоты не пересоздаются, пока есть кодируемые
+
+		lock.unlock();
+		bool ok = encode(slot);
+		lock.lock();
+
+		slots[index].state = SlotState::Free;
+		if (ok)
+			filesWritten++;
+		else
+			filesFailed++;
+		slotFreed.notify_all();
+	}
+}
+
+// Несжатый однослойный scanline OpenEXR с каналами B, G, R типа FLOAT.
+// Числа в файле little-endian, как на целевых платформах
+static bool writeExr(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgb) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	auto writeInt = [&](int32_t value) { file.write(reinterpret_cast<const char*>(&value), 4); };
+	auto writeFloat = [&](float value) { file.write(reinterpret_cast<const char*>(&value), 4); };
+	auto writeAttribute = [&](const char* name, const char* type, int32_t size) {
+		file.write(name, strlen(name) + 1);
+		file.write(type, strlen(type) + 1);
+		writeInt(size);
+	};
+
+	const uint8_t magic[] = {0x76, 0x2f, 0x31, 0x01, 0x02, 0x00, 0x00, 0x00}; // версия 2, scanline
+	file.write(reinterpret_cast<const char*>(magic), sizeof(magic));
+
+	// Каналы по алфавиту: имя, тип (2 - FLOAT), pLinear, 3 резервных байта, шаги выборки
+	writeAttribute("channels", "chlist", 3 * 18 + 1);
+	for (const char* channel : {"B", "G", "R"}) {
+		file.write(channel, 2);
+		writeInt(2);
+		const char reserved[4] = {0, 0, 0, 0};
+		file.write(reserved, 4);
+		writeInt(1);
+		writeInt(1);
+	}
+	file.put(0);
+
+	writeAttribute("compression", "compression", 1);
+	file.put(0); // NO_COMPRESSION
+	for (const char* window : {"dataWindow", "displayWindow"}) {
+		writeAttribute(window, "box2i", 16);
+		writeInt(0); writeInt(0);
+		writeInt(static_cast<int32_t>(width) - 1); writeInt(static_cast<int32_t>(height) - 1);
+	}
+	writeAttribute("lineOrder", "lineOrder", 1);
+	file.put(0); // INCREASING_Y
+	writeAttribute("pixelAspectRatio", "float", 4);
+	writeFloat(1.0f);
+	writeAttribute("screenWindowCenter", "v2f", 8);
+	writeFloat(0.0f); writeFloat(0.0f);
+	writeAttribute("screenWindowWidth", "float", 4);
+	writeFloat(1.0f);
+	file.put(0); // конец заголовка
+
+	// Таблица смещений строк: строка - номер, размер данных и каналы строки подряд
+	uint64_t lineSize = 8 + static_cast<uint64_t>(width) * 3 * 4;
+	uint64_t offset = static_cast<uint64_t>(file.tellp()) + static_cast<uint64_t>(height) * 8;
+	for (uint32_t y = 0; y < height; y++) {
+		file.write(reinterpret_cast<const char*>(&offset), 8);
+		offset += lineSize;
+	}
+
+	std::vector<float> line(width * 3);
+	for (uint32_t y = 0; y < height; y++) {
+		const float* row = rgb.data() + static_cast<size_t>(y) * width * 3;
+		for (uint32_t x = 0; x < width; x++) {
+			line[x] = row[x * 3 + 2];
+			line[width + x] = row[x * 3 + 1];
+			line[2 * width + x] = row[x * 3 + 0];
+		}
+		writeInt(static_cast<int32_t>(y));
+		writeInt(static_cast<int32_t>(width * 3 * 4));
+		file.write(reinterpret_cast<const char*>(line.data()), line.size() * 4);
+	}
+	return file.good();
+}
+
+bool FrameCapture::encode(const Slot& slot) {
+	PROFILE_FUNCTION();
+	uint32_t width = slot.extent.width;
+	uint32_t height = slot.extent.height;
+	size_t pixels = static_cast<size_t>(width) * height;
+	int red = bgra ? 2 : 0;
+	int blue = bgra ? 0 : 2;
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "frame_%05u.%s", slot.frame, format == CaptureFormat::PNG ? "png" : "exr");
+	std::string path = (std::filesystem::path(directory) / name).string();
+
+	bool ok;
+	if (format == CaptureFormat::PNG) {
+		// Альфа списка показа не несёт смысла (непрозрачная композиция) - сохраняется RGB
+		std::vector<uint8_t> rgb(pixels * 3);
+		for (size_t i = 0; i < pixels; i++) {
+			rgb[i * 3 + 0] = slot.mapped[i * 4 + red];
+			rgb[i * 3 + 1] = slot.mapped[i * 4 + 1];
+			rgb[i * 3 + 2] = slot.mapped[i * 4 + blue];
+		}
+		ok = stbi_write_png(path.c_str(), width, height, 3, rgb.data(), width * 3) != 0;
+	} else {
+		// EXR хранит линейные значения: sRGB декодируется по таблице
+		float table[256];
+		for (int i = 0; i < 256; i++) {
+			float value = i / 255.0f;
+			table[i] = !srgb ? value : value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+		std::vector<float> rgb(pixels * 3);
+		for (size_t i = 0; i < pixels; i++) {
+			rgb[i * 3 + 0] = table[slot.mapped[i * 4 + red]];
+			rgb[i * 3 + 1] = table[slot.mapped[i * 4 + 1]];
+			rgb[i * 3 + 2] = table[slot.mapped[i * 4 + blue]];
+		}
+		ok = writeExr(path, width, height, rgb);
+	}
+
+	if (!ok)
+		std::cout << "Unable to write captured frame: " << path << std::endl;
+	return ok;
+}
@@ -0,0 +1,29 @@
+#include "FrameContext.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+void FrameArena::init(VkBuffer buffer, void* mapped, VkDeviceSize base, VkDeviceSize size, VkDeviceSize alignment) {
+	target = buffer;
+	this->mapped = static_cast<uint8_t*>(mapped);
+	this->base = base;
+	capacity = size;
+	this->alignment = alignment ? alignment : 1;
+	offset = 0;
+}
+
+void* FrameArena::allocate(VkDeviceSize size, VkDeviceSize& bufferOffset) {
+	VkDeviceSize start = (offset + alignment - 1) / alignment * alignment;
+	if (start + size > capacity)
+		throw std::runtime_error("Frame arena overflow");
+
+	offset = start + size;
+	bufferOffset = base + start;
+	return mapped + bufferOffset;
+}
+
+VkDeviceSize FrameArena::push(const void* data, VkDeviceSize size) {
+	VkDeviceSize bufferOffset;
+	memcpy(allocate(size, bufferOffset), data, static_cast<size_t>(size));
+	return bufferOffset;
+}
@@ -0,0 +1,110 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+FramePacer::FramePacer() {
+#ifdef _WIN32
+	// Разрешение системного таймера 1 мс вместо 15.6 мс
+	timeBeginPeriod(1);
+#endif
+}
+
+FramePacer::~FramePacer() {
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::setTargetRate(double fps) {
+	if (fps > 0.0)
+		interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+	else
+		interval = Clock::duration::zero();
+	started = false;
+}
+
+// Сон короткими отрезками, пока до срока больше оценки опоздания; затем активное ожидание.
+// Оценка опоздания следует за худшими пробуждениями и медленно снижается
+void FramePacer::sleepUntil(Clock::time_point deadline) {
+	for (;;) {
+		Clock::time_point now = Clock::now();
+		double remaining = std::chrono::duration<double>(deadline - now).count();
+		if (remaining <= sleepError)
+			break;
+
+		const double slice = 0.001;
+		std::this_thread::sleep_for(std::chrono::duration<double>(std::min(slice, remaining - sleepError)));
+
+		double slept = std::chrono::duration<double>(Clock::now() - now).count();
+		double overshoot = slept - std::min(slice, remaining - sleepError);
+		if (overshoot > sleepError)
+			sleepError = overshoot;
+		else
+			sleepError += (overshoot - sleepError) * 0.02;
+		sleepError = std::max(sleepError, 0.0002);
+	}
+
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+}
+
+void FramePacer::wait() {
+	if (!started) {
+		deadline = Clock::now();
+		lastFrame = deadline;
+		windowStart = deadline;
+		started = true;
+	}
+
+	if (interval != Clock::duration::zero()) {
+		deadline += interval;
+		Clock::time_point now = Clock::now();
+		if (deadline < now - interval)
+			deadline = now; // кадр сильно опоздал - не догоняем
+		else
+			sleepUntil(deadline);
+	}
+
+	Clock::time_point now = Clock::now();
+	double frameDelta = std::chrono::duration<double>(now - lastFrame).count();
+	lastFrame = now;
+
+	// Экспоненциальное сглаживание; выбросы (остановка в отладчике, перетаскивание окна) ограничиваются
+	lastDelta = static_cast<float>(frameDelta);
+	float clamped = std::min(lastDelta, 0.25f);
+	smoothedDelta += (clamped - smoothedDelta) * 0.1f;
+
+	count++;
+	double difference = frameDelta - mean;
+	mean += difference / count;
+	m2 += difference * (frameDelta - mean);
+	minDelta = count == 1 ? frameDelta : std::min(minDelta, frameDelta);
+	maxDelta = count == 1 ? frameDelta : std::max(maxDelta, frameDelta);
+}
+
+bool FramePacer::report(FrameStatistics& stats, double reportInterval) {
+	double window = std::chrono::duration<double>(lastFrame - windowStart).count();
+	if (!started || count == 0 || window < reportInterval)
+		return false;
+
+	stats.frames = count;
+	stats.fps = count / window;
+	stats.meanMs = mean * 1000.0;
+	stats.deviationMs = std::sqrt(count > 1 ? m2 / (count - 1) : 0.0) * 1000.0;
+	stats.minMs = minDelta * 1000.0;
+	stats.maxMs = maxDelta * 1000.0;
+
+	windowStart = lastFrame;
+	count = 0;
+	mean = 0.0;
+	m2 = 0.0;
+	return true;
+}
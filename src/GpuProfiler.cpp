@@ -0,0 +1,187 @@
+#include "GpuProfiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+void GpuProfiler::init(VkDevice device, const VkPhysicalDeviceProperties& properties, uint32_t timestampValidBits,
+					bool pipelineStatistics, uint32_t framesInFlight, uint32_t maxScopes) {
+	this->device = device;
+	this->maxScopes = maxScopes;
+	this->pipelineStatistics = pipelineStatistics;
+	enabled = properties.limits.timestampComputeAndGraphics && timestampValidBits > 0;
+	timestampPeriod = properties.limits.timestampPeriod;
+	timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+
+	frames.resize(framesInFlight);
+	if (!enabled)
+		return;
+
+	for (FrameQueries& queries : frames) {
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = maxScopes * 2;
+		if (vkCreateQueryPool(device, &poolInfo, nullptr, &queries.timestamps) != VK_SUCCESS) {
+			throw std::runtime_error("Unable to create timestamp query pool");
+		}
+
+		if (!pipelineStatistics)
+			continue;
+
+		poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		poolInfo.queryCount = maxScopes;
+		// Порядок результатов - по возрастанию битов
+		poolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+									| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+									| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+									| VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+		if (vkCreateQueryPool(device, &poolInfo, nullptr, &queries.statistics) != VK_SUCCESS) {
+			throw std::runtime_error("Unable to create pipeline statistics query pool");
+		}
+	}
+}
+
+void GpuProfiler::destroy() {
+	for (FrameQueries& queries : frames) {
+		vkDestroyQueryPool(device, queries.timestamps, nullptr);
+		vkDestroyQueryPool(device, queries.statistics, nullptr);
+	}
+	frames.clear();
+	current = nullptr;
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frame) {
+	if (!enabled)
+		return;
+
+	current = &frames[frame];
+	if (current->recorded)
+		collect(*current);
+
+	current->scopes.clear();
+	current->statisticsCount = 0;
+	current->recorded = false;
+	open.clear();
+	statisticsActive = false;
+
+	vkCmdResetQueryPool(commandBuffer, current->timestamps, 0, maxScopes * 2);
+	if (current->statistics != VK_NULL_HANDLE)
+		vkCmdResetQueryPool(commandBuffer, current->statistics, 0, maxScopes);
+
+	begin(commandBuffer, "frame");
+}
+
+void GpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+	if (!enabled)
+		return;
+
+	while (!open.empty())
+		end(commandBuffer);
+	current->recorded = true;
+}
+
+void GpuProfiler::begin(VkCommandBuffer commandBuffer, const std::string& name) {
+	if (!enabled)
+		return;
+
+	// Переполнение: область не замеряется, но end остаётся парным
+	if (current->scopes.size() >= maxScopes) {
+		open.push_back(UINT32_MAX);
+		return;
+	}
+
+	uint32_t index = static_cast<uint32_t>(current->scopes.size());
+	Scope scope{name, static_cast<uint32_t>(open.size()), -1};
+
+	// Статистика конвейера - для областей первого уровня под кадром (проходов)
+	if (current->statistics != VK_NULL_HANDLE && scope.depth == 1 && !statisticsActive) {
+		scope.statisticsQuery = static_cast<int32_t>(current->statisticsCount++);
+		vkCmdBeginQuery(commandBuffer, current->statistics, scope.statisticsQuery, 0);
+		statisticsActive = true;
+	}
+
+	vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, current->timestamps, index * 2);
+	current->scopes.push_back(scope);
+	open.push_back(index);
+}
+
+void GpuProfiler::end(VkCommandBuffer commandBuffer) {
+	if (!enabled || open.empty())
+		return;
+
+	uint32_t index = open.back();
+	open.pop_back();
+	if (index == UINT32_MAX)
+		return;
+
+	vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, current->timestamps, index * 2 + 1);
+
+	const Scope& scope = current->scopes[index];
+	if (scope.statisticsQuery >= 0) {
+		vkCmdEndQuery(commandBuffer, current->statistics, scope.statisticsQuery);
+		statisticsActive = false;
+	}
+}
+
+void GpuProfiler::collect(FrameQueries& queries) {
+	uint32_t count = static_cast<uint32_t>(queries.scopes.size());
+	if (count == 0)
+		return;
+
+	std::vector<uint64_t> timestamps(count * 2);
+	if (vkGetQueryPoolResults(device, queries.timestamps, 0, count * 2, timestamps.size() * sizeof(uint64_t),
+							timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+		return; // кадр ещё не завершён - замер пропускается, ожидания нет
+
+	std::vector<uint64_t> counters(queries.statisticsCount * 4);
+	bool haveCounters = queries.statisticsCount > 0
+		&& vkGetQueryPoolResults(device, queries.statistics, 0, queries.statisticsCount,
+								counters.size() * sizeof(uint64_t), counters.data(),
+								4 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+
+	for (uint32_t i = 0; i < count; i++) {
+		const Scope& scope = queries.scopes[i];
+		uint64_t ticks = (timestamps[i * 2 + 1] - timestamps[i * 2]) & timestampMask;
+		double ms = ticks * timestampPeriod / 1e6;
+
+		History& entry = history[scope.name];
+		entry.samples.push_back(ms);
+		if (entry.samples.size() > historySize)
+			entry.samples.pop_front();
+		if (haveCounters && scope.statisticsQuery >= 0)
+			std::copy_n(&counters[scope.statisticsQuery * 4], 4, entry.counters);
+
+		if (scope.depth == 0)
+			lastFrameMs = static_cast<float>(ms);
+	}
+}
+
+void GpuProfiler::statistics(std::vector<GpuScopeStatistics>& result) const {
+	result.clear();
+	std::vector<double> sorted;
+	for (const auto& entry : history) {
+		const History& h = entry.second;
+		if (h.samples.empty())
+			continue;
+
+		sorted.assign(h.samples.begin(), h.samples.end());
+		std::sort(sorted.begin(), sorted.end());
+		double sum = 0.0;
+		for (double ms : sorted)
+			sum += ms;
+
+		GpuScopeStatistics stats;
+		stats.name = entry.first;
+		stats.samples = static_cast<uint32_t>(sorted.size());
+		stats.minMs = sorted.front();
+		stats.avgMs = sum / sorted.size();
+		stats.p99Ms = sorted[std::min(sorted.size() - 1, static_cast<size_t>(sorted.size() * 0.99))];
+		stats.maxMs = sorted.back();
+		// Порядок результатов пула: вершины, вход отсечения, выход отсечения, фрагменты
+		stats.vertexInvocations = h.counters[0];
+		stats.clippingInvocations = h.counters[1];
+		stats.clippingPrimitives = h.counters[2];
+		stats.fragmentInvocations = h.counters[3];
+		result.push_back(stats);
+	}
+}
@@ -0,0 +1,107 @@
+#include "GpuTimeline.hpp"
+
+#include <stdexcept>
+
+void GpuTimeline::init(VkDevice device, VkQueue queue) {
+	this->device = device;
+	this->queue = queue;
+
+	VkSemaphoreTypeCreateInfo typeInfo{};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &typeInfo;
+
+	if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create timeline semaphore");
+	}
+}
+
+void GpuTimeline::destroy() {
+	vkDestroySemaphore(device, timeline, nullptr);
+	timeline = VK_NULL_HANDLE;
+}
+
+uint64_t GpuTimeline::submit(VkCommandBuffer commandBuffer,
+							const std::vector<VkSemaphoreSubmitInfo>& waits,
+							const std::vector<VkSemaphoreSubmitInfo>& signals) {
+	std::lock_guard<std::mutex> lock(mutex);
+	uint64_t value = lastSubmitted.load() + 1;
+
+	std::vector<VkSemaphoreSubmitInfo> signalInfos(signals);
+	VkSemaphoreSubmitInfo signal{};
+	signal.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	signal.semaphore = timeline;
+	signal.value = value;
+	signal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	signalInfos.push_back(signal);
+
+	VkCommandBufferSubmitInfo commandBufferInfo{};
+	commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+	commandBufferInfo.commandBuffer = commandBuffer;
+
+	VkSubmitInfo2 submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	submitInfo.waitSemaphoreInfoCount = static_cast<uint32_t>(waits.size());
+	submitInfo.pWaitSemaphoreInfos = waits.data();
+	submitInfo.commandBufferInfoCount = commandBuffer != VK_NULL_HANDLE ? 1 : 0;
+	submitInfo.pCommandBufferInfos = &commandBufferInfo;
+	submitInfo.signalSemaphoreInfoCount = static_cast<uint32_t>(signalInfos.size());
+	submitInfo.pSignalSemaphoreInfos = signalInfos.data();
+
+	if (vkQueueSubmit2(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to submit command buffer");
+	}
+
+	lastSubmitted = value;
+	return value;
+}
+
+uint64_t GpuTimeline::completed() {
+	uint64_t value;
+	if (vkGetSemaphoreCounterValue(device, timeline, &value) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to read timeline semaphore");
+	}
+	lastCompleted = value;
+	return value;
+}
+
+bool GpuTimeline::reached(uint64_t value) {
+	return value <= lastCompleted.load() || value <= completed();
+}
+
+void GpuTimeline::wait(uint64_t value) {
+	if (value <= lastCompleted.load())
+		return;
+
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &timeline;
+	waitInfo.pValues = &value;
+
+	if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to wait for timeline semaphore");
+	}
+	completed();
+}
+
+VkSemaphoreSubmitInfo GpuTimeline::waitInfo(uint64_t value, VkPipelineStageFlags2 stages) const {
+	VkSemaphoreSubmitInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	info.semaphore = timeline;
+	info.value = value;
+	info.stageMask = stages;
+	return info;
+}
+
+VkSemaphoreSubmitInfo GpuTimeline::binary(VkSemaphore semaphore, VkPipelineStageFlags2 stages) {
+	VkSemaphoreSubmitInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	info.semaphore = semaphore;
+	info.stageMask = stages;
+	return info;
+}
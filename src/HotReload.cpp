@@ -0,0 +1,110 @@
+#include "HotReload.hpp"
+#include "CpuProfiler.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+// Путь к компилятору шейдеров: из Vulkan SDK, если он установлен, иначе из PATH
+static std::string glslcPath() {
+	const char* sdk = std::getenv("VULKAN_SDK");
+	return sdk ? std::string(sdk) + "/bin/glslc" : std::string("glslc");
+}
+
+bool compileShader(const std::string& source, const std::string& binary) {
+	// Компилируем во временный файл, чтобы при ошибке не испортить рабочий SPIR-V
+	std::string temporary = binary + ".tmp";
+	std::string command = glslcPath() + " \"" + source + "\" -o \"" + temporary + "\"";
+	if (std::system(command.c_str()) != 0) {
+		std::cout << "Shader compilation failed: " << source << std::endl;
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary, binary, error);
+	if (error) {
+		std::cout << "Unable to replace shader binary: " << binary << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void HotReload::watch(const std::string& path, Job job) {
+	if (!running) {
+		jobs.emplace_back(path, std::move(job));
+	}
+}
+
+void HotReload::start() {
+	watcher.init();
+	// Пути сохраняются в нормализованном виде, как их возвращает watcher
+	for (auto& job : jobs)
+		job.first = watcher.add(job.first);
+
+	running = true;
+	worker = std::thread(&HotReload::workerLoop, this);
+}
+
+void HotReload::stop() {
+	if (!running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(stopMutex);
+		running = false;
+	}
+	stopSignal.notify_all();
+	worker.join();
+	watcher.shutdown();
+
+	// Неприменённые результаты вызываются без буфера команд, чтобы освободить подготовленные ресурсы
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	for (auto& commit : pending)
+		commit(VK_NULL_HANDLE);
+	pending.clear();
+}
+
+void HotReload::applyPending(VkCommandBuffer commandBuffer) {
+	std::vector<Commit> ready;
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		ready.swap(pending);
+	}
+
+	for (auto& commit : ready)
+		commit(commandBuffer);
+}
+
+void HotReload::workerLoop() {
+	PROFILE_THREAD("hot reload");
+	const auto pollInterval = std::chrono::milliseconds(200);
+
+	while (running) {
+		for (auto& file : watcher.poll()) {
+			std::cout << "Reloading: " << file << std::endl;
+
+			for (auto& job : jobs) {
+				if (job.first != file)
+					continue;
+
+				Commit commit;
+				PROFILE_SCOPE("hot reload: load");
+				try {
+					commit = job.second();
+				} catch (const std::exception& e) {
+					std::cout << "Hot reload failed: " << e.what() << std::endl;
+				}
+
+				if (commit) {
+					std::lock_guard<std::mutex> lock(pendingMutex);
+					pending.push_back(std::move(commit));
+				}
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(stopMutex);
+		stopSignal.wait_for(lock, pollInterval, [this] { return !running; });
+	}
+}
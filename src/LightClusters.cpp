@@ -0,0 +1,170 @@
+#include "LightClusters.hpp"
+#include "CpuProfiler.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+ClusterFrustum clusterFrustum(const glm::mat4& view, const glm::mat4& proj) {
+	// proj[2][2] = -(f + n) / (f - n), proj[3][2] = -2 f n / (f - n)
+	ClusterFrustum frustum;
+	frustum.view = view;
+	frustum.p00 = proj[0][0];
+	frustum.p11 = proj[1][1];
+	frustum.znear = proj[3][2] / (proj[2][2] - 1.0f);
+	frustum.zfar = proj[3][2] / (proj[2][2] + 1.0f);
+	return frustum;
+}
+
+glm::vec2 clusterDepthParams(float znear, float zfar) {
+	float scale = static_cast<float>(CLUSTER_Z) / std::log(zfar / znear);
+	return glm::vec2(scale, -std::log(znear) * scale);
+}
+
+uint32_t clusterIndex(const glm::vec3& world, const ClusterFrustum& frustum) {
+	glm::vec4 view = frustum.view * glm::vec4(world, 1.0f);
+	float depth = -view.z;
+	if (depth < frustum.znear || depth > frustum.zfar)
+		return UINT32_MAX;
+
+	glm::vec2 ndc(frustum.p00 * view.x / depth, frustum.p11 * view.y / depth);
+	if (std::abs(ndc.x) > 1.0f || std::abs(ndc.y) > 1.0f)
+		return UINT32_MAX;
+
+	// Те же выражения, что во фрагментном шейдере
+	glm::vec2 depthParams = clusterDepthParams(frustum.znear, frustum.zfar);
+	uint32_t x = std::min(static_cast<uint32_t>((ndc.x * 0.5f + 0.5f) * CLUSTER_X), CLUSTER_X - 1);
+	uint32_t y = std::min(static_cast<uint32_t>((ndc.y * 0.5f + 0.5f) * CLUSTER_Y), CLUSTER_Y - 1);
+	uint32_t z = static_cast<uint32_t>(std::clamp(std::floor(std::log(depth) * depthParams.x + depthParams.y),
+												  0.0f, static_cast<float>(CLUSTER_Z - 1)));
+	return (z * CLUSTER_Y + y) * CLUSTER_X + x;
+}
+
+void clusterBounds(uint32_t x, uint32_t y, uint32_t z, const ClusterFrustum& frustum, glm::vec3& low, glm::vec3& high) {
+	// Срез чуть шире своих границ: срез фрагмента считается через логарифм, границы - через степень
+	const float slack = 1e-3f;
+	float ratio = frustum.zfar / frustum.znear;
+	float nearDepth = frustum.znear * std::pow(ratio, static_cast<float>(z) / CLUSTER_Z) * (1.0f - slack);
+	float farDepth = frustum.znear * std::pow(ratio, static_cast<float>(z + 1) / CLUSTER_Z) * (1.0f + slack);
+
+	// Плитка NDC на глубине d: x = ndc.x d / p00; стенки плитки расходятся, крайние значения - на торцах
+	float tileX[2] = {-1.0f + 2.0f * x / CLUSTER_X, -1.0f + 2.0f * (x + 1) / CLUSTER_X};
+	float tileY[2] = {-1.0f + 2.0f * y / CLUSTER_Y, -1.0f + 2.0f * (y + 1) / CLUSTER_Y};
+	low = glm::vec3(FLT_MAX, FLT_MAX, -farDepth);
+	high = glm::vec3(-FLT_MAX, -FLT_MAX, -nearDepth);
+	for (float depth : {nearDepth, farDepth})
+		for (int i = 0; i < 2; i++) {
+			float viewX = tileX[i] * depth / frustum.p00;
+			float viewY = tileY[i] * depth / frustum.p11; // p11 < 0: порядок по Y меняется, берутся крайние
+			low.x = std::min(low.x, viewX);
+			high.x = std::max(high.x, viewX);
+			low.y = std::min(low.y, viewY);
+			high.y = std::max(high.y, viewY);
+		}
+}
+
+bool lightTouchesBox(const Light& viewLight, const glm::vec3& low, const glm::vec3& high) {
+	glm::vec3 center(viewLight.position);
+	float radius = viewLight.position.w;
+	glm::vec3 offset = glm::clamp(center, low, high) - center;
+	if (glm::dot(offset, offset) > radius * radius)
+		return false;
+	if (viewLight.cone.w == 0.0f)
+		return true;
+
+	// Конус против описанной сферы прямоугольника: ближайшая к оси точка сферы вне внешнего угла,
+	// сфера дальше радиуса действия или позади вершины конуса
+	glm::vec3 sphere = 0.5f * (low + high);
+	float sphereRadius = 0.5f * glm::length(high - low);
+	glm::vec3 toSphere = sphere - center;
+	float along = glm::dot(toSphere, glm::vec3(viewLight.direction));
+	float across = std::sqrt(std::max(glm::dot(toSphere, toSphere) - along * along, 0.0f));
+	float distance = viewLight.cone.y * across - along * viewLight.cone.z;
+	return distance <= sphereRadius && along <= sphereRadius + radius && along >= -sphereRadius;
+}
+
+bool lightReaches(const Light& light, const glm::vec3& point) {
+	glm::vec3 offset = point - glm::vec3(light.position);
+	float distance = glm::length(offset);
+	if (distance > light.position.w)
+		return false;
+	return light.cone.w == 0.0f || distance == 0.0f ||
+		glm::dot(offset / distance, glm::vec3(light.direction)) >= light.cone.y;
+}
+
+uint32_t assignLights(const std::vector<Light>& lights, const ClusterFrustum& frustum,
+				std::vector<LightCluster>& clusters, std::vector<uint32_t>& indices, WorkerPool* workers) {
+	PROFILE_FUNCTION();
+	uint32_t lightCount = static_cast<uint32_t>(std::min<size_t>(lights.size(), MAX_LIGHTS));
+
+	// Источники переводятся в пространство вида один раз, как в общей памяти шейдера
+	std::vector<Light> viewLights(lights.begin(), lights.begin() + lightCount);
+	glm::mat3 rotation(frustum.view);
+	for (Light& light : viewLights) {
+		light.position = glm::vec4(glm::vec3(frustum.view * glm::vec4(glm::vec3(light.position), 1.0f)), light.position.w);
+		light.direction = glm::vec4(rotation * glm::vec3(light.direction), 0.0f);
+	}
+
+	clusters.resize(CLUSTER_COUNT);
+	std::vector<uint32_t> lists(CLUSTER_COUNT * CLUSTER_MAX_LIGHTS);
+	std::vector<uint8_t> overflowed(CLUSTER_COUNT);
+	auto slice = [&](uint32_t begin, uint32_t end) {
+		for (uint32_t cluster = begin; cluster < end; cluster++) {
+			glm::vec3 low, high;
+			clusterBounds(cluster % CLUSTER_X, cluster / CLUSTER_X % CLUSTER_Y, cluster / (CLUSTER_X * CLUSTER_Y), frustum, low, high);
+
+			uint32_t* list = lists.data() + cluster * CLUSTER_MAX_LIGHTS;
+			uint32_t count = 0;
+			bool overflow = false;
+			for (uint32_t i = 0; i < lightCount && !overflow; i++) {
+				if (!lightTouchesBox(viewLights[i], low, high))
+					continue;
+				if (count == CLUSTER_MAX_LIGHTS)
+					overflow = true;
+				else
+					list[count++] = i;
+			}
+			clusters[cluster].count = count;
+			overflowed[cluster] = overflow ? 1 : 0;
+		}
+	};
+	if (workers)
+		workers->parallelFor(0, CLUSTER_COUNT, 16, slice);
+	else
+		slice(0, CLUSTER_COUNT);
+
+	// Участки общего списка подряд; переполненный список обрезается, как у атомарного счётчика GPU
+	indices.clear();
+	uint32_t overflowCount = 0;
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+		uint32_t offset = static_cast<uint32_t>(indices.size());
+		uint32_t count = std::min(clusters[cluster].count, LIGHT_INDEX_CAPACITY - offset);
+		if (overflowed[cluster] || count < clusters[cluster].count)
+			overflowCount++;
+		clusters[cluster] = {offset, count};
+		const uint32_t* list = lists.data() + cluster * CLUSTER_MAX_LIGHTS;
+		indices.insert(indices.end(), list, list + count);
+	}
+	return overflowCount;
+}
+
+void generateLights(uint32_t count, const glm::vec3& low, const glm::vec3& high, uint32_t seed, std::vector<Light>& lights) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	auto range = [&](float from, float to) { return from + (to - from) * unit(random); };
+
+	lights.resize(count);
+	for (Light& light : lights) {
+		light.position = glm::vec4(range(low.x, high.x), range(low.y, high.y), range(low.z, high.z), range(1.5f, 5.0f));
+		glm::vec3 color = glm::vec3(unit(random), unit(random), unit(random)) + 0.2f;
+		light.color = glm::vec4(color / std::max(color.r, std::max(color.g, color.b)) * range(1.0f, 3.0f), 0.0f);
+		light.direction = glm::vec4(glm::normalize(glm::vec3(range(-0.5f, 0.5f), -1.0f, range(-0.5f, 0.5f))), 0.0f);
+
+		bool spot = unit(random) < 0.5f;
+		float outer = glm::radians(range(20.0f, 50.0f));
+		light.cone = glm::vec4(std::cos(0.7f * outer), std::cos(outer), std::sin(outer), spot ? 1.0f : 0.0f);
+		if (spot)
+			light.position.w *= 2.0f; // прожектор светит дальше
+	}
+}
@@ -0,0 +1,241 @@
+#include "OcclusionRasterizer.hpp"
+#include "CpuProfiler.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OCCLUSION_SSE
+#endif
+
+static const uint32_t FULL_MASK = 0xFFFFFFFFu;
+static const float MIN_W = 1e-5f; // вершина ближе - за камерой или в её плоскости
+
+void OcclusionRasterizer::resize(uint32_t width, uint32_t height) {
+	if (width == 0 || height == 0 || width % OCCLUSION_TILE_WIDTH != 0 || height % OCCLUSION_TILE_HEIGHT != 0)
+		throw std::runtime_error("Occlusion buffer size must be a multiple of the tile size");
+
+	tilesX = width / OCCLUSION_TILE_WIDTH;
+	tilesY = height / OCCLUSION_TILE_HEIGHT;
+	tileDepth.resize(tilesX * tilesY);
+	layerDepth.resize(tilesX * tilesY);
+	layerMask.resize(tilesX * tilesY);
+	clear();
+}
+
+void OcclusionRasterizer::clear() {
+	std::fill(tileDepth.begin(), tileDepth.end(), FLT_MAX);
+	std::fill(layerDepth.begin(), layerDepth.end(), 0.0f);
+	std::fill(layerMask.begin(), layerMask.end(), 0u);
+	rasterized = 0;
+}
+
+void OcclusionRasterizer::render(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+								const glm::mat4& viewProj, WorkerPool* workers) {
+	PROFILE_FUNCTION();
+	if (tilesX == 0)
+		resize();
+
+	uint32_t count = static_cast<uint32_t>(indices.size() / 3);
+	setups.resize(count);
+	auto setupSlice = [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+			setup(vertices[indices[3 * i]], vertices[indices[3 * i + 1]], vertices[indices[3 * i + 2]], viewProj, setups[i]);
+	};
+	if (workers)
+		workers->parallelFor(0, count, 1024, setupSlice);
+	else
+		setupSlice(0, count);
+
+	for (const Triangle& triangle : setups)
+		rasterized += triangle.valid ? 1 : 0;
+
+	// Строка плиток пишется только своим потоком: без синхронизации между потоками
+	auto rowSlice = [this](uint32_t begin, uint32_t end) {
+		for (uint32_t row = begin; row < end; row++)
+			rasterizeRow(row);
+	};
+	if (workers)
+		workers->parallelFor(0, tilesY, 1, rowSlice);
+	else
+		rowSlice(0, tilesY);
+}
+
+void OcclusionRasterizer::setup(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2,
+								const glm::mat4& viewProj, Triangle& triangle) const {
+	triangle.valid = false;
+
+	glm::vec4 clip[3] = {viewProj * glm::vec4(p0, 1.0f), viewProj * glm::vec4(p1, 1.0f), viewProj * glm::vec4(p2, 1.0f)};
+	float x[3], y[3], z[3];
+	for (int i = 0; i < 3; i++) {
+		if (clip[i].w <= MIN_W)
+			return; // без отсечения по ближней плоскости заслонка просто пропускается
+		float inverse = 1.0f / clip[i].w;
+		x[i] = (clip[i].x * inverse * 0.5f + 0.5f) * width();
+		y[i] = (clip[i].y * inverse * 0.5f + 0.5f) * height();
+		z[i] = clip[i].z * inverse;
+	}
+
+	// Обход против часовой в координатах буфера: площадь положительна, рёбра >= 0 внутри
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (std::fabs(area) < 1e-6f)
+		return;
+	if (area < 0.0f) {
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+
+	triangle.minX = std::max(0, static_cast<int32_t>(std::floor(std::min({x[0], x[1], x[2]}))));
+	triangle.maxX = std::min(static_cast<int32_t>(width()) - 1, static_cast<int32_t>(std::ceil(std::max({x[0], x[1], x[2]}))));
+	triangle.minY = std::max(0, static_cast<int32_t>(std::floor(std::min({y[0], y[1], y[2]}))));
+	triangle.maxY = std::min(static_cast<int32_t>(height()) - 1, static_cast<int32_t>(std::ceil(std::max({y[0], y[1], y[2]}))));
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		return;
+
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		triangle.edgeA[i] = y[i] - y[j];
+		triangle.edgeB[i] = x[j] - x[i];
+		triangle.edgeC[i] = -(triangle.edgeA[i] * x[i] + triangle.edgeB[i] * y[i]);
+	}
+
+	// z / w линейна в экранных координатах
+	triangle.depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	triangle.depthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0];
+	triangle.depthMax = std::max({z[0], z[1], z[2]});
+	triangle.valid = true;
+}
+
+void OcclusionRasterizer::rasterizeRow(uint32_t tileRow) {
+	int32_t rowY = static_cast<int32_t>(tileRow * OCCLUSION_TILE_HEIGHT);
+	int32_t rowEnd = rowY + static_cast<int32_t>(OCCLUSION_TILE_HEIGHT) - 1;
+
+	for (const Triangle& triangle : setups) {
+		if (!triangle.valid || triangle.maxY < rowY || triangle.minY > rowEnd)
+			continue;
+
+		uint32_t firstTile = static_cast<uint32_t>(triangle.minX) / OCCLUSION_TILE_WIDTH;
+		uint32_t lastTile = static_cast<uint32_t>(triangle.maxX) / OCCLUSION_TILE_WIDTH;
+		for (uint32_t tileX = firstTile; tileX <= lastTile; tileX++) {
+			float x0 = static_cast<float>(tileX * OCCLUSION_TILE_WIDTH);
+			float y0 = static_cast<float>(rowY);
+
+			// Покрытие центров пикселей: бит ряда r, столбца c - r * 8 + c
+			uint32_t mask = 0;
+#ifdef OCCLUSION_SSE
+			__m128 inside[8];
+			for (int i = 0; i < 8; i++)
+				inside[i] = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps()); // все биты
+			for (int e = 0; e < 3; e++) {
+				float a = triangle.edgeA[e], b = triangle.edgeB[e];
+				__m128 base = _mm_set1_ps(a * x0 + b * y0 + triangle.edgeC[e]);
+				__m128 left = _mm_add_ps(base, _mm_mul_ps(_mm_set1_ps(a), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f)));
+				__m128 right = _mm_add_ps(base, _mm_mul_ps(_mm_set1_ps(a), _mm_setr_ps(4.5f, 5.5f, 6.5f, 7.5f)));
+				for (int r = 0; r < 4; r++) {
+					__m128 step = _mm_set1_ps(b * (r + 0.5f));
+					inside[2 * r] = _mm_and_ps(inside[2 * r], _mm_cmpge_ps(_mm_add_ps(left, step), _mm_setzero_ps()));
+					inside[2 * r + 1] = _mm_and_ps(inside[2 * r + 1], _mm_cmpge_ps(_mm_add_ps(right, step), _mm_setzero_ps()));
+				}
+			}
+			for (int i = 0; i < 8; i++)
+				mask |= static_cast<uint32_t>(_mm_movemask_ps(inside[i])) << (4 * i);
+#else
+			for (int r = 0; r < 4; r++) {
+				for (int c = 0; c < 8; c++) {
+					bool covered = true;
+					for (int e = 0; e < 3; e++) {
+						float a = triangle.edgeA[e], b = triangle.edgeB[e];
+						float base = a * x0 + b * y0 + triangle.edgeC[e];
+						covered = covered && (base + a * (c + 0.5f)) + b * (r + 0.5f) >= 0.0f;
+					}
+					if (covered)
+						mask |= 1u << (r * 8 + c);
+				}
+			}
+#endif
+			if (mask == 0)
+				continue;
+
+			// Дальняя глубина плоскости по углам центров плитки, не дальше дальней вершины
+			float cornerX = triangle.depthA > 0.0f ? x0 + OCCLUSION_TILE_WIDTH - 0.5f : x0 + 0.5f;
+			float cornerY = triangle.depthB > 0.0f ? y0 + OCCLUSION_TILE_HEIGHT - 0.5f : y0 + 0.5f;
+			float depth = std::min(triangle.depthA * cornerX + triangle.depthB * cornerY + triangle.depthC, triangle.depthMax);
+
+			insert(tileRow * tilesX + tileX, mask, depth);
+		}
+	}
+}
+
+// Граница пикселя маски - layerDepth, остальных - tileDepth; обе только уменьшаются или
+// заменяются не меньшей настоящей глубины, поэтому остаются консервативными
+void OcclusionRasterizer::insert(uint32_t tile, uint32_t mask, float depth) {
+	if (depth >= tileDepth[tile])
+		return; // треугольник не ближе границы плитки: ничего не уточняет
+
+	layerDepth[tile] = layerMask[tile] ? std::max(layerDepth[tile], depth) : depth;
+	layerMask[tile] |= mask;
+
+	// Рабочий слой закрыл плитку: его граница становится границей плитки
+	if (layerMask[tile] == FULL_MASK) {
+		tileDepth[tile] = layerDepth[tile];
+		layerMask[tile] = 0;
+	}
+}
+
+bool OcclusionRasterizer::visible(const glm::vec3& low, const glm::vec3& high, const glm::mat4& viewProj) const {
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+	for (int i = 0; i < 8; i++) {
+		glm::vec3 corner((i & 1) ? high.x : low.x, (i & 2) ? high.y : low.y, (i & 4) ? high.z : low.z);
+		glm::vec4 clip = viewProj * glm::vec4(corner, 1.0f);
+		if (clip.w <= MIN_W)
+			return true;
+		float inverse = 1.0f / clip.w;
+		float x = (clip.x * inverse * 0.5f + 0.5f) * width();
+		float y = (clip.y * inverse * 0.5f + 0.5f) * height();
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z * inverse);
+	}
+
+	// Все пиксели, которых касается прямоугольник
+	int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(minX)));
+	int32_t x1 = std::min(static_cast<int32_t>(width()) - 1, static_cast<int32_t>(std::ceil(maxX)) - 1);
+	int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(minY)));
+	int32_t y1 = std::min(static_cast<int32_t>(height()) - 1, static_cast<int32_t>(std::ceil(maxY)) - 1);
+	if (x0 > x1 || y0 > y1)
+		return false;
+
+	const int32_t tw = static_cast<int32_t>(OCCLUSION_TILE_WIDTH), th = static_cast<int32_t>(OCCLUSION_TILE_HEIGHT);
+	for (int32_t tileY = y0 / th; tileY <= y1 / th; tileY++) {
+		// Ряды плитки внутри прямоугольника
+		int32_t r0 = std::max(y0 - tileY * th, 0), r1 = std::min(y1 - tileY * th, th - 1);
+		for (int32_t tileX = x0 / tw; tileX <= x1 / tw; tileX++) {
+			int32_t c0 = std::max(x0 - tileX * tw, 0), c1 = std::min(x1 - tileX * tw, tw - 1);
+			uint32_t columns = ((1u << (c1 + 1)) - 1) & ~((1u << c0) - 1);
+			uint32_t rect = 0;
+			for (int32_t r = r0; r <= r1; r++)
+				rect |= columns << (r * tw);
+
+			uint32_t tile = static_cast<uint32_t>(tileY) * tilesX + static_cast<uint32_t>(tileX);
+			if ((rect & ~layerMask[tile]) && tileDepth[tile] > nearest)
+				return true;
+			if ((rect & layerMask[tile]) && layerDepth[tile] > nearest)
+				return true;
+		}
+	}
+	return false;
+}
+
+float OcclusionRasterizer::depth(uint32_t x, uint32_t y) const {
+	uint32_t tile = (y / OCCLUSION_TILE_HEIGHT) * tilesX + x / OCCLUSION_TILE_WIDTH;
+	uint32_t bit = 1u << ((y % OCCLUSION_TILE_HEIGHT) * OCCLUSION_TILE_WIDTH + x % OCCLUSION_TILE_WIDTH);
+	return (layerMask[tile] & bit) ? layerDepth[tile] : tileDepth[tile];
+}
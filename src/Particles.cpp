@@ -0,0 +1,84 @@
+#include "Particles.hpp"
+
+#include <algorithm>
+#include <utility>
+
+// Пара зеркального шага: в последовательности k первый элемент с последним и т. д.
+static void flipPair(uint32_t thread, uint32_t k, uint32_t& a, uint32_t& b) {
+	uint32_t half = k / 2;
+	uint32_t base = (thread / half) * k;
+	a = base + thread % half;
+	b = base + k - 1 - thread % half;
+}
+
+// Пара шага половинами: элементы на расстоянии j
+static void dispersePair(uint32_t thread, uint32_t j, uint32_t& a, uint32_t& b) {
+	a = (thread / j) * 2 * j + thread % j;
+	b = a + j;
+}
+
+static void compareSwap(std::vector<glm::uvec2>& entries, uint32_t a, uint32_t b, uint32_t count) {
+	// b > a: за числом видимых ключ бесконечен, обмена нет
+	if (b < count && entries[a].x > entries[b].x)
+		std::swap(entries[a], entries[b]);
+}
+
+void particleSortSteps(uint32_t capacity, std::vector<ParticleSortStep>& steps) {
+	uint32_t size = PARTICLE_SORT_BLOCK;
+	while (size < capacity)
+		size *= 2;
+
+	steps.clear();
+	steps.push_back({ParticleSortMode::Local, PARTICLE_SORT_BLOCK, 0});
+	for (uint32_t k = 2 * PARTICLE_SORT_BLOCK; k <= size; k *= 2) {
+		steps.push_back({ParticleSortMode::Flip, k, k / 2});
+		for (uint32_t j = k / 4; j >= PARTICLE_SORT_BLOCK; j /= 2)
+			steps.push_back({ParticleSortMode::Disperse, k, j});
+		steps.push_back({ParticleSortMode::Merge, k, PARTICLE_SORT_BLOCK / 2});
+	}
+}
+
+void particleSortStep(const ParticleSortStep& step, std::vector<glm::uvec2>& entries, uint32_t count) {
+	uint32_t size = PARTICLE_SORT_BLOCK;
+	while (size < count)
+		size *= 2;
+	uint32_t threads = size / 2;
+	uint32_t a, b;
+
+	switch (step.mode) {
+	case ParticleSortMode::Local:
+		for (uint32_t block = 0; block < size; block += PARTICLE_SORT_BLOCK)
+			for (uint32_t k = 2; k <= PARTICLE_SORT_BLOCK; k *= 2) {
+				for (uint32_t thread = 0; thread < PARTICLE_SORT_GROUP; thread++) {
+					flipPair(thread, k, a, b);
+					compareSwap(entries, block + a, block + b, count);
+				}
+				for (uint32_t j = k / 4; j > 0; j /= 2)
+					for (uint32_t thread = 0; thread < PARTICLE_SORT_GROUP; thread++) {
+						dispersePair(thread, j, a, b);
+						compareSwap(entries, block + a, block + b, count);
+					}
+			}
+		break;
+	case ParticleSortMode::Flip:
+		for (uint32_t thread = 0; thread < threads; thread++) {
+			flipPair(thread, step.k, a, b);
+			compareSwap(entries, a, b, count);
+		}
+		break;
+	case ParticleSortMode::Disperse:
+		for (uint32_t thread = 0; thread < threads; thread++) {
+			dispersePair(thread, step.j, a, b);
+			compareSwap(entries, a, b, count);
+		}
+		break;
+	case ParticleSortMode::Merge:
+		for (uint32_t block = 0; block < size; block += PARTICLE_SORT_BLOCK)
+			for (uint32_t j = PARTICLE_SORT_BLOCK / 2; j > 0; j /= 2)
+				for (uint32_t thread = 0; thread < PARTICLE_SORT_GROUP; thread++) {
+					dispersePair(thread, j, a, b);
+					compareSwap(entries, block + a, block + b, count);
+				}
+		break;
+	}
+}
@@ -0,0 +1,690 @@
+#include "RenderGraph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Флаги использования изображения, необходимые для объявленного использования
+static VkImageUsageFlags imageUsage(ResourceUsage usage) {
+	switch (usage) {
+	case ResourceUsage::TransferSrc:
+		return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	case ResourceUsage::TransferDst:
+		return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	case ResourceUsage::VertexShaderRead:
+	case ResourceUsage::FragmentShaderRead:
+	case ResourceUsage::ComputeShaderRead:
+	case ResourceUsage::DepthShaderRead:
+		return VK_IMAGE_USAGE_SAMPLED_BIT;
+	case ResourceUsage::ComputeShaderWrite:
+	case ResourceUsage::ComputeShaderReadWrite:
+		return VK_IMAGE_USAGE_STORAGE_BIT;
+	case ResourceUsage::ColorAttachment:
+		return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	case ResourceUsage::DepthAttachment:
+	case ResourceUsage::DepthAttachmentRead:
+		return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	default:
+		return 0;
+	}
+}
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+PassBuilder& PassBuilder::read(GraphResource resource, ResourceUsage usage) {
+	graph.resource(resource);
+	graph.passes[pass].accesses.push_back({resource.index, usage, true, false});
+	graph.dirty = true;
+	return *this;
+}
+
+PassBuilder& PassBuilder::write(GraphResource resource, ResourceUsage usage) {
+	graph.resource(resource);
+	// Чтение-запись в шейдере зависит от прежнего содержимого
+	bool read = usage == ResourceUsage::ComputeShaderReadWrite;
+	graph.passes[pass].accesses.push_back({resource.index, usage, read, true});
+	graph.dirty = true;
+	return *this;
+}
+
+PassBuilder& PassBuilder::color(GraphResource resource, VkAttachmentLoadOp loadOp, VkClearColorValue clear) {
+	graph.resource(resource);
+	RenderGraph::Pass& target = graph.passes[pass];
+	if (target.hasDepth)
+		throw std::runtime_error("Color attachments must be declared before depth");
+
+	RenderGraph::Attachment attachment{};
+	attachment.resource = resource.index;
+	attachment.loadOp = loadOp;
+	attachment.clear.color = clear;
+	attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	target.attachments.push_back(attachment);
+	target.accesses.push_back({resource.index, ResourceUsage::ColorAttachment, loadOp == VK_ATTACHMENT_LOAD_OP_LOAD, true});
+	graph.dirty = true;
+	return *this;
+}
+
+PassBuilder& PassBuilder::depth(GraphResource resource, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clear, bool readOnly) {
+	graph.resource(resource);
+	RenderGraph::Pass& target = graph.passes[pass];
+	if (target.hasDepth)
+		throw std::runtime_error("Pass already has a depth attachment");
+
+	RenderGraph::Attachment attachment{};
+	attachment.resource = resource.index;
+	attachment.loadOp = readOnly ? VK_ATTACHMENT_LOAD_OP_LOAD : loadOp;
+	attachment.clear.depthStencil = clear;
+	attachment.layout = readOnly ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	target.attachments.push_back(attachment);
+	target.hasDepth = true;
+	if (readOnly)
+		target.accesses.push_back({resource.index, ResourceUsage::DepthAttachmentRead, true, false});
+	else
+		target.accesses.push_back({resource.index, ResourceUsage::DepthAttachment, loadOp == VK_ATTACHMENT_LOAD_OP_LOAD, true});
+	graph.dirty = true;
+	return *this;
+}
+
+PassBuilder& PassBuilder::sideEffect() {
+	graph.passes[pass].sideEffect = true;
+	graph.dirty = true;
+	return *this;
+}
+
+void RenderGraph::init(VkDevice device, ResourceRegistry* registry, ResourceStateTracker* tracker, bool dynamicRendering) {
+	this->device = device;
+	this->registry = registry;
+	this->tracker = tracker;
+	this->dynamicRendering = dynamicRendering;
+}
+
+void RenderGraph::destroy() {
+	releaseCompiled(true);
+	for (auto& cached : renderPasses)
+		vkDestroyRenderPass(device, cached.second, nullptr);
+	renderPasses.clear();
+	passes.clear();
+	resources.clear();
+}
+
+void RenderGraph::reset() {
+	releaseCompiled(false);
+	passes.clear();
+	resources.clear();
+	generation++;
+	dirty = true;
+}
+
+GraphResource RenderGraph::createImage(const std::string& name, const GraphImageDesc& desc) {
+	Resource resource{};
+	resource.name = name;
+	resource.desc = desc;
+	resource.finalUsage = ResourceUsage::Undefined;
+	resources.push_back(resource);
+	dirty = true;
+	return GraphResource{static_cast<uint32_t>(resources.size() - 1), generation};
+}
+
+GraphResource RenderGraph::importImage(const std::string& name, const GraphImageDesc& desc, ResourceUsage finalUsage,
+									const ResourceState* initial) {
+	Resource resource{};
+	resource.name = name;
+	resource.imported = true;
+	resource.desc = desc;
+	resource.finalUsage = finalUsage;
+	resource.resetEachFrame = initial != nullptr;
+	if (initial)
+		resource.initial = *initial;
+	resources.push_back(resource);
+	dirty = true;
+	return GraphResource{static_cast<uint32_t>(resources.size() - 1), generation};
+}
+
+GraphResource RenderGraph::importBuffer(const std::string& name, ResourceUsage finalUsage) {
+	Resource resource{};
+	resource.name = name;
+	resource.imported = true;
+	resource.isBuffer = true;
+	resource.finalUsage = finalUsage;
+	resources.push_back(resource);
+	dirty = true;
+	return GraphResource{static_cast<uint32_t>(resources.size() - 1), generation};
+}
+
+void RenderGraph::bindImage(GraphResource handle, VkImage image, VkImageView view) {
+	this->resource(handle);
+	Resource& resource = resources[handle.index];
+	if (!resource.imported || resource.isBuffer)
+		throw std::runtime_error("Only imported images can be bound");
+	resource.image = image;
+	resource.view = view;
+}
+
+void RenderGraph::bindBuffer(GraphResource handle, VkBuffer buffer) {
+	this->resource(handle);
+	Resource& resource = resources[handle.index];
+	if (!resource.isBuffer)
+		throw std::runtime_error("Only imported buffers can be bound");
+	resource.buffer = buffer;
+}
+
+PassBuilder RenderGraph::addPass(const std::string& name, Execute execute) {
+	Pass pass;
+	pass.name = name;
+	pass.execute = std::move(execute);
+	passes.push_back(pass);
+	dirty = true;
+	return PassBuilder(*this, static_cast<uint32_t>(passes.size() - 1));
+}
+
+void RenderGraph::compile() {
+	releaseCompiled(false);
+	cull();
+	computeLifetimes();
+	allocateTransients();
+
+	for (Pass& pass : passes)
+		pass.renderPass = pass.alive && !pass.attachments.empty() && !dynamicRendering ? findRenderPass(pass) : VK_NULL_HANDLE;
+
+	dirty = false;
+}
+
+// Отсечение проходов: обход с конца, проход жив, если пишет ресурс, нужный дальше.
+// Внешние ресурсы нужны после кадра; запись без чтения закрывает предыдущую версию ресурса
+void RenderGraph::cull() {
+	std::vector<bool> needed(resources.size());
+	for (size_t i = 0; i < resources.size(); i++)
+		needed[i] = resources[i].imported;
+
+	for (size_t i = passes.size(); i-- > 0;) {
+		Pass& pass = passes[i];
+		pass.alive = pass.sideEffect;
+		for (const Access& access : pass.accesses)
+			if (access.write && needed[access.resource])
+				pass.alive = true;
+
+		if (!pass.alive)
+			continue;
+
+		for (const Access& access : pass.accesses)
+			if (access.write && !access.read)
+				needed[access.resource] = false;
+		for (const Access& access : pass.accesses)
+			if (access.read)
+				needed[access.resource] = true;
+	}
+}
+
+void RenderGraph::computeLifetimes() {
+	for (Resource& resource : resources) {
+		resource.firstPass = UINT32_MAX;
+		resource.lastPass = 0;
+		resource.usage = resource.desc.usage;
+		resource.lastState = resourceState(ResourceUsage::Undefined);
+	}
+
+	for (uint32_t i = 0; i < passes.size(); i++) {
+		if (!passes[i].alive)
+			continue;
+		for (const Access& access : passes[i].accesses) {
+			Resource& resource = resources[access.resource];
+			resource.firstPass = std::min(resource.firstPass, i);
+			resource.lastPass = i;
+			resource.usage |= imageUsage(access.usage);
+			resource.lastState = resourceState(access.usage);
+		}
+	}
+
+	// Содержимое вложения сохраняется, только если его читают позже или оно внешнее
+	for (uint32_t i = 0; i < passes.size(); i++) {
+		for (Attachment& attachment : passes[i].attachments) {
+			const Resource& resource = resources[attachment.resource];
+			bool keep = resource.imported || resource.lastPass > i;
+			attachment.storeOp = keep ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		}
+	}
+}
+
+// Временные изображения размещаются в общих блоках памяти: первое подходящее смещение,
+// не пересекающееся с изображениями, живущими одновременно. Крупные размещаются первыми
+void RenderGraph::allocateTransients() {
+	std::vector<uint32_t> transients;
+	for (uint32_t i = 0; i < resources.size(); i++) {
+		Resource& resource = resources[i];
+		if (resource.imported || resource.firstPass == UINT32_MAX)
+			continue;
+
+		if (memoryless(i))
+			resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		resource.imageHandle = registry->createUnboundImage(resource.desc.extent.width, resource.desc.extent.height,
+											resource.desc.format, VK_IMAGE_TILING_OPTIMAL, resource.usage);
+		resource.requirements = registry->memoryRequirements(resource.imageHandle);
+		transients.push_back(i);
+	}
+
+	std::sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+		return resources[a].requirements.size > resources[b].requirements.size;
+	});
+
+	auto livesWith = [this](const Resource& a, const Resource& b) {
+		return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+	};
+	auto sharesMemory = [](const Resource& a, const Resource& b) {
+		return a.block == b.block
+			&& a.offset < b.offset + b.requirements.size
+			&& b.offset < a.offset + a.requirements.size;
+	};
+
+	unaliasedSize = 0;
+	std::vector<uint32_t> placed;
+	for (uint32_t index : transients) {
+		Resource& resource = resources[index];
+		const VkMemoryRequirements& requirements = resource.requirements;
+
+		// Лениво выделяемая память есть не везде (в основном на тайловых GPU)
+		const VkMemoryPropertyFlags localProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		const VkMemoryPropertyFlags lazyProperties = localProperties | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		bool lazy = (resource.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+				&& registry->hasMemoryType(requirements.memoryTypeBits, lazyProperties);
+		uint32_t memoryType = registry->findMemoryType(requirements.memoryTypeBits,
+									lazy ? lazyProperties : localProperties);
+		if (!lazy)
+			unaliasedSize += requirements.size;
+
+		resource.block = UINT32_MAX;
+		for (uint32_t i = 0; i < blocks.size(); i++)
+			if (blocks[i].memoryType == memoryType && blocks[i].lazy == lazy)
+				resource.block = i;
+		if (resource.block == UINT32_MAX) {
+			resource.block = static_cast<uint32_t>(blocks.size());
+			blocks.push_back({memoryType, lazy, 0, VK_NULL_HANDLE});
+		}
+
+		// Занятые одновременно живущими изображениями диапазоны блока
+		std::vector<std::pair<VkDeviceSize, VkDeviceSize>> occupied;
+		for (uint32_t other : placed) {
+			const Resource& neighbour = resources[other];
+			if (neighbour.block == resource.block && livesWith(resource, neighbour))
+				occupied.push_back({neighbour.offset, neighbour.offset + neighbour.requirements.size});
+		}
+		std::sort(occupied.begin(), occupied.end());
+
+		VkDeviceSize offset = 0;
+		for (const auto& range : occupied) {
+			if (offset + requirements.size <= range.first)
+				break;
+			offset = std::max(offset, alignUp(range.second, requirements.alignment));
+		}
+
+		resource.offset = offset;
+		blocks[resource.block].size = std::max(blocks[resource.block].size, offset + requirements.size);
+		placed.push_back(index);
+	}
+
+	aliasedSize = 0;
+	lazySize = 0;
+	for (MemoryBlock& block : blocks) {
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = block.size;
+		allocInfo.memoryTypeIndex = block.memoryType;
+
+		if (vkAllocateMemory(device, &allocInfo, nullptr, &block.memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate render graph memory!");
+		}
+		if (block.lazy)
+			lazySize += block.size;
+		else
+			aliasedSize += block.size;
+	}
+
+	for (uint32_t index : transients) {
+		Resource& resource = resources[index];
+		registry->bindMemory(resource.imageHandle, blocks[resource.block].memory, resource.offset);
+		resource.viewHandle = registry->createImageView(resource.imageHandle, resource.desc.format, resource.desc.aspectMask);
+		resource.image = registry->image(resource.imageHandle);
+		resource.view = registry->view(resource.viewHandle);
+
+		// Начальное состояние - последнее использование предыдущих владельцев той же памяти:
+		// раньше в этом кадре, а если таких нет - в прошлом кадре (включая само изображение)
+		VkPipelineStageFlags2 stages = 0;
+		VkAccessFlags2 access = 0;
+		for (uint32_t other : transients) {
+			const Resource& neighbour = resources[other];
+			if (sharesMemory(resource, neighbour) && neighbour.lastPass < resource.firstPass) {
+				stages |= neighbour.lastState.stages;
+				access |= neighbour.lastState.access;
+			}
+		}
+		if (stages == 0) {
+			for (uint32_t other : transients) {
+				const Resource& neighbour = resources[other];
+				if (sharesMemory(resource, neighbour)) {
+					stages |= neighbour.lastState.stages;
+					access |= neighbour.lastState.access;
+				}
+			}
+		}
+		resource.initial = {stages, access, VK_IMAGE_LAYOUT_UNDEFINED};
+	}
+}
+
+// Содержимое изображения не загружается и не сохраняется, а сами использования - только вложения:
+// на тайловых GPU такое изображение может вообще не получить памяти
+bool RenderGraph::memoryless(uint32_t resource) const {
+	const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+									| VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+									| VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+	if (resources[resource].usage & ~attachmentUsage)
+		return false;
+
+	for (const Pass& pass : passes) {
+		if (!pass.alive)
+			continue;
+		for (const Access& access : pass.accesses)
+			if (access.resource == resource && access.read)
+				return false;
+		for (const Attachment& attachment : pass.attachments)
+			if (attachment.resource == resource && attachment.storeOp != VK_ATTACHMENT_STORE_OP_DONT_CARE)
+				return false;
+	}
+	return true;
+}
+
+VkRenderPass RenderGraph::findRenderPass(const Pass& pass) {
+	std::vector<uint64_t> key;
+	key.push_back(pass.hasDepth);
+	for (const Attachment& attachment : pass.attachments) {
+		key.push_back(resources[attachment.resource].desc.format);
+		key.push_back(attachment.loadOp);
+		key.push_back(attachment.storeOp);
+		key.push_back(attachment.layout);
+	}
+
+	auto found = renderPasses.find(key);
+	if (found != renderPasses.end())
+		return found->second;
+
+	// Раскладки не меняются внутри прохода: переходы выполняют барьеры графа
+	std::vector<VkAttachmentDescription> descriptions;
+	std::vector<VkAttachmentReference> colorReferences;
+	VkAttachmentReference depthReference{};
+	for (uint32_t i = 0; i < pass.attachments.size(); i++) {
+		const Attachment& attachment = pass.attachments[i];
+
+		VkAttachmentDescription description{};
+		description.format = resources[attachment.resource].desc.format;
+		description.samples = VK_SAMPLE_COUNT_1_BIT;
+		description.loadOp = attachment.loadOp;
+		description.storeOp = attachment.storeOp;
+		description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		description.initialLayout = attachment.layout;
+		description.finalLayout = attachment.layout;
+		descriptions.push_back(description);
+
+		if (pass.hasDepth && i + 1 == pass.attachments.size())
+			depthReference = {i, attachment.layout};
+		else
+			colorReferences.push_back({i, attachment.layout});
+	}
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+	subpass.pColorAttachments = colorReferences.data();
+	subpass.pDepthStencilAttachment = pass.hasDepth ? &depthReference : nullptr;
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+	renderPassInfo.pAttachments = descriptions.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+
+	VkRenderPass renderPass;
+	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create render pass");
+	}
+	renderPasses[key] = renderPass;
+	return renderPass;
+}
+
+VkFramebuffer RenderGraph::findFramebuffer(Pass& pass) {
+	std::vector<VkImageView> views;
+	for (const Attachment& attachment : pass.attachments)
+		views.push_back(resources[attachment.resource].view);
+
+	auto key = std::make_pair(pass.renderPass, views);
+	auto found = framebuffers.find(key);
+	if (found != framebuffers.end())
+		return found->second;
+
+	VkExtent2D extent = resources[pass.attachments[0].resource].desc.extent;
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = pass.renderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+	framebufferInfo.pAttachments = views.data();
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer framebuffer;
+	if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create framebuffer");
+	}
+	framebuffers[key] = framebuffer;
+	return framebuffer;
+}
+
+void RenderGraph::beginRendering(VkCommandBuffer commandBuffer, Pass& pass) {
+	VkRect2D renderArea{};
+	renderArea.offset = {0, 0};
+	renderArea.extent = resources[pass.attachments[0].resource].desc.extent;
+
+	if (dynamicRendering) {
+		std::vector<VkRenderingAttachmentInfo> colorAttachments;
+		VkRenderingAttachmentInfo depthAttachment{};
+		for (uint32_t i = 0; i < pass.attachments.size(); i++) {
+			const Attachment& attachment = pass.attachments[i];
+
+			VkRenderingAttachmentInfo info{};
+			info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+			info.imageView = resources[attachment.resource].view;
+			info.imageLayout = attachment.layout;
+			info.loadOp = attachment.loadOp;
+			info.storeOp = attachment.storeOp;
+			info.clearValue = attachment.clear;
+
+			if (pass.hasDepth && i + 1 == pass.attachments.size())
+				depthAttachment = info;
+			else
+				colorAttachments.push_back(info);
+		}
+
+		VkRenderingInfo renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+		renderingInfo.renderArea = renderArea;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+		renderingInfo.pColorAttachments = colorAttachments.data();
+		renderingInfo.pDepthAttachment = pass.hasDepth ? &depthAttachment : nullptr;
+
+		vkCmdBeginRendering(commandBuffer, &renderingInfo);
+		return;
+	}
+
+	std::vector<VkClearValue> clearValues;
+	for (const Attachment& attachment : pass.attachments)
+		clearValues.push_back(attachment.clear);
+
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = pass.renderPass;
+	renderPassInfo.framebuffer = findFramebuffer(pass);
+	renderPassInfo.renderArea = renderArea;
+	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues = clearValues.data();
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer) {
+	if (dirty)
+		compile();
+
+	// Состояния на начало кадра
+	for (const Resource& resource : resources) {
+		if (resource.isBuffer) {
+			if (resource.buffer == VK_NULL_HANDLE)
+				throw std::runtime_error("Render graph buffer is not bound: " + resource.name);
+			continue;
+		}
+		if (resource.imported && resource.image == VK_NULL_HANDLE)
+			throw std::runtime_error("Render graph image is not bound: " + resource.name);
+		if (resource.imageHandle.valid() || resource.resetEachFrame)
+			tracker->trackImage(resource.image, resource.desc.aspectMask, 1, 1, resource.initial);
+	}
+
+	for (Pass& pass : passes) {
+		if (!pass.alive)
+			continue;
+
+		// Барьеры прохода одной точкой перехода
+		for (const Access& access : pass.accesses) {
+			const Resource& resource = resources[access.resource];
+			if (resource.isBuffer)
+				tracker->use(resource.buffer, access.usage);
+			else
+				tracker->use(resource.image, access.usage);
+		}
+		tracker->flush(commandBuffer);
+
+		// Область замера - вне прохода рендера: запросы статистики не могут начинаться внутри него
+		if (profiler)
+			profiler->begin(commandBuffer, pass.name);
+
+		if (pass.attachments.empty()) {
+			pass.execute(commandBuffer);
+		} else {
+			beginRendering(commandBuffer, pass);
+			pass.execute(commandBuffer);
+			if (dynamicRendering)
+				vkCmdEndRendering(commandBuffer);
+			else
+				vkCmdEndRenderPass(commandBuffer);
+		}
+
+		if (profiler)
+			profiler->end(commandBuffer);
+	}
+
+	// Внешние ресурсы покидают граф в заявленном состоянии
+	for (const Resource& resource : resources) {
+		if (!resource.imported || resource.finalUsage == ResourceUsage::Undefined)
+			continue;
+		if (resource.isBuffer)
+			tracker->use(resource.buffer, resource.finalUsage);
+		else
+			tracker->use(resource.image, resource.finalUsage);
+	}
+	tracker->flush(commandBuffer);
+}
+
+void RenderGraph::releaseCompiled(bool immediate) {
+	for (Resource& resource : resources) {
+		if (!resource.imageHandle.valid())
+			continue;
+
+		tracker->forget(resource.image);
+		if (immediate) {
+			registry->destroyNow(resource.viewHandle);
+			registry->destroyNow(resource.imageHandle);
+		} else {
+			registry->release(resource.viewHandle);
+			registry->release(resource.imageHandle);
+		}
+		resource.imageHandle = ImageHandle();
+		resource.viewHandle = ImageViewHandle();
+		resource.image = VK_NULL_HANDLE;
+		resource.view = VK_NULL_HANDLE;
+	}
+
+	for (MemoryBlock& block : blocks) {
+		VkDevice device = this->device;
+		VkDeviceMemory memory = block.memory;
+		if (immediate)
+			vkFreeMemory(device, memory, nullptr);
+		else
+			registry->release([=]() { vkFreeMemory(device, memory, nullptr); });
+	}
+	blocks.clear();
+
+	for (auto& cached : framebuffers) {
+		VkDevice device = this->device;
+		VkFramebuffer framebuffer = cached.second;
+		if (immediate)
+			vkDestroyFramebuffer(device, framebuffer, nullptr);
+		else
+			registry->release([=]() { vkDestroyFramebuffer(device, framebuffer, nullptr); });
+	}
+	framebuffers.clear();
+
+	aliasedSize = 0;
+	unaliasedSize = 0;
+	lazySize = 0;
+	dirty = true;
+}
+
+uint32_t RenderGraph::passIndex(const std::string& name) const {
+	for (uint32_t i = 0; i < passes.size(); i++)
+		if (passes[i].name == name)
+			return i;
+	throw std::runtime_error("Unknown render graph pass: " + name);
+}
+
+const RenderGraph::Resource& RenderGraph::resource(GraphResource handle) const {
+	if (handle.generation != generation || handle.index >= resources.size())
+		throw std::runtime_error("Stale render graph resource");
+	return resources[handle.index];
+}
+
+VkImage RenderGraph::image(GraphResource handle) const {
+	return resource(handle).image;
+}
+
+VkImageView RenderGraph::view(GraphResource handle) const {
+	return resource(handle).view;
+}
+
+VkBuffer RenderGraph::buffer(GraphResource handle) const {
+	return resource(handle).buffer;
+}
+
+VkRenderPass RenderGraph::renderPass(const std::string& pass) const {
+	if (dirty)
+		throw std::runtime_error("Render graph is not compiled");
+	return passes[passIndex(pass)].renderPass;
+}
+
+bool RenderGraph::active(const std::string& pass) const {
+	if (dirty)
+		throw std::runtime_error("Render graph is not compiled");
+	return passes[passIndex(pass)].alive;
+}
+
+void RenderGraph::attachmentFormats(const std::string& pass, std::vector<VkFormat>& colorFormats, VkFormat& depthFormat) const {
+	const Pass& target = passes[passIndex(pass)];
+	colorFormats.clear();
+	depthFormat = VK_FORMAT_UNDEFINED;
+	for (uint32_t i = 0; i < target.attachments.size(); i++) {
+		VkFormat format = resources[target.attachments[i].resource].desc.format;
+		if (target.hasDepth && i + 1 == target.attachments.size())
+			depthFormat = format;
+		else
+			colorFormats.push_back(format);
+	}
+}
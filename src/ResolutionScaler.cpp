@@ -0,0 +1,39 @@
+#include "ResolutionScaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void ResolutionScaler::setBounds(glm::vec2 minScale, glm::vec2 maxScale) {
+	lower = minScale;
+	upper = glm::max(minScale, maxScale);
+	current = glm::clamp(current, lower, upper);
+}
+
+void ResolutionScaler::update(float gpuMilliseconds) {
+	if (budget <= 0.0f || gpuMilliseconds <= 0.0f)
+		return;
+
+	smoothed = smoothed > 0.0f ? smoothed + (gpuMilliseconds - smoothed) * smoothing : gpuMilliseconds;
+
+	// Всплеск выше бюджета учитывается сразу, без сглаживания
+	float frameTime = std::max(smoothed, gpuMilliseconds > budget ? gpuMilliseconds : 0.0f);
+	float ratio = budget * headroom / frameTime;
+	if (std::fabs(ratio - 1.0f) < deadZone)
+		return;
+
+	float factor = std::sqrt(ratio);
+	factor = std::min(std::max(factor, 1.0f - maxStep), 1.0f + maxStep);
+	current = glm::clamp(current * factor, lower, upper);
+}
+
+static uint32_t scaled(uint32_t size, float scale) {
+	return std::max(1u, static_cast<uint32_t>(std::lround(size * scale)));
+}
+
+VkExtent2D ResolutionScaler::extent(VkExtent2D full) const {
+	return {scaled(full.width, current.x), scaled(full.height, current.y)};
+}
+
+VkExtent2D ResolutionScaler::maxExtent(VkExtent2D full) const {
+	return {scaled(full.width, upper.x), scaled(full.height, upper.y)};
+}
@@ -0,0 +1,394 @@
+#include "ResourceRegistry.hpp"
+
+#include <stdexcept>
+
+uint32_t SlotAllocator::allocate() {
+	if (!freeSlots.empty()) {
+		uint32_t index = freeSlots.back();
+		freeSlots.pop_back();
+		return index;
+	}
+	generations.push_back(0);
+	return static_cast<uint32_t>(generations.size() - 1);
+}
+
+// Увеличение массива поля до размера, покрывающего слот
+template<typename T>
+static void ensureSlot(std::vector<T>& field, uint32_t index) {
+	if (field.size() <= index)
+		field.resize(index + 1);
+}
+
+void ResourceRegistry::init(VkDevice device, const VkPhysicalDeviceMemoryProperties& memory, GpuTimeline* timeline) {
+	this->device = device;
+	this->memory = memory;
+	this->timeline = timeline;
+}
+
+void ResourceRegistry::destroy() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& entry : retiring)
+			entry.second.flush();
+		retiring.clear();
+		openQueue.flush();
+	}
+
+	// Виды раньше изображений, которым они принадлежат
+	for (uint32_t i = 0; i < views.views.size(); i++)
+		if (views.views[i] != VK_NULL_HANDLE)
+			destroyNow(ImageViewHandle{i, views.slots.generations[i]});
+	for (uint32_t i = 0; i < images.images.size(); i++)
+		if (images.images[i] != VK_NULL_HANDLE)
+			destroyNow(ImageHandle{i, images.slots.generations[i]});
+	for (uint32_t i = 0; i < buffers.buffers.size(); i++)
+		if (buffers.buffers[i] != VK_NULL_HANDLE)
+			destroyNow(BufferHandle{i, buffers.slots.generations[i]});
+}
+
+uint32_t ResourceRegistry::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+	for (uint32_t i = 0; i < memory.memoryTypeCount; i++) {
+		if ((typeFilter & (1 << i))
+		&&  (memory.memoryTypes[i].propertyFlags & properties) == properties
+		) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error("Unable to find suitable memory type");
+}
+
+bool ResourceRegistry::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+	for (uint32_t i = 0; i < memory.memoryTypeCount; i++) {
+		if ((typeFilter & (1 << i))
+		&&  (memory.memoryTypes[i].propertyFlags & properties) == properties
+		) {
+			return true;
+		}
+	}
+	return false;
+}
+
+BufferHandle ResourceRegistry::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+	// Информация о создаваемом буфере
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer;
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create buffer");
+	}
+
+	// Требования к памяти
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+
+	VkDeviceMemory bufferMemory;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+		vkDestroyBuffer(device, buffer, nullptr);
+		throw std::runtime_error("Unable to allocate buffer memory");
+	}
+
+	// Привязка выделенной памяти к буферу
+	vkBindBufferMemory(device, buffer, bufferMemory, 0);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	uint32_t index = buffers.slots.allocate();
+	ensureSlot(buffers.buffers, index);
+	ensureSlot(buffers.memories, index);
+	ensureSlot(buffers.sizes, index);
+	ensureSlot(buffers.mapped, index);
+	buffers.buffers[index] = buffer;
+	buffers.memories[index] = bufferMemory;
+	buffers.sizes[index] = size;
+	buffers.mapped[index] = nullptr;
+
+	return BufferHandle{index, buffers.slots.generations[index]};
+}
+
+ImageHandle ResourceRegistry::createImage(uint32_t width, uint32_t height, VkFormat format,
+										VkImageTiling tiling, VkImageUsageFlags usage,
+										VkMemoryPropertyFlags properties, uint32_t mipLevels, uint32_t arrayLayers) {
+	VkImage image = newImage(width, height, format, tiling, usage, mipLevels, arrayLayers);
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+
+	VkDeviceMemory imageMemory;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+		vkDestroyImage(device, image, nullptr);
+		throw std::runtime_error("failed to allocate image memory!");
+	}
+
+	vkBindImageMemory(device, image, imageMemory, 0);
+
+	return addImage(image, imageMemory, width, height, format);
+}
+
+ImageHandle ResourceRegistry::createUnboundImage(uint32_t width, uint32_t height, VkFormat format,
+												VkImageTiling tiling, VkImageUsageFlags usage) {
+	VkImage image = newImage(width, height, format, tiling, usage);
+	return addImage(image, VK_NULL_HANDLE, width, height, format);
+}
+
+VkMemoryRequirements ResourceRegistry::memoryRequirements(ImageHandle handle) {
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, image(handle), &memRequirements);
+	return memRequirements;
+}
+
+void ResourceRegistry::bindMemory(ImageHandle handle, VkDeviceMemory memory, VkDeviceSize offset) {
+	if (vkBindImageMemory(device, image(handle), memory, offset) != VK_SUCCESS) {
+		throw std::runtime_error("failed to bind image memory!");
+	}
+}
+
+VkImage ResourceRegistry::newImage(uint32_t width, uint32_t height, VkFormat format,
+									VkImageTiling tiling, VkImageUsageFlags usage, uint32_t mipLevels, uint32_t arrayLayers) {
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width = width;
+	imageInfo.extent.height = height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = mipLevels;
+	imageInfo.arrayLayers = arrayLayers;
+	imageInfo.format = format;
+	imageInfo.tiling = tiling;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = usage;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkImage image;
+	if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create image!");
+	}
+	return image;
+}
+
+ImageHandle ResourceRegistry::addImage(VkImage image, VkDeviceMemory memory, uint32_t width, uint32_t height, VkFormat format) {
+	std::lock_guard<std::mutex> lock(mutex);
+	uint32_t index = images.slots.allocate();
+	ensureSlot(images.images, index);
+	ensureSlot(images.memories, index);
+	ensureSlot(images.extents, index);
+	ensureSlot(images.formats, index);
+	images.images[index] = image;
+	images.memories[index] = memory;
+	images.extents[index] = {width, height};
+	images.formats[index] = format;
+
+	return ImageHandle{index, images.slots.generations[index]};
+}
+
+ImageViewHandle ResourceRegistry::createImageView(ImageHandle image, VkFormat format, VkImageAspectFlags aspectFlags,
+												VkImageViewType viewType, uint32_t baseMipLevel, uint32_t levelCount,
+												uint32_t baseArrayLayer, uint32_t layerCount) {
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = this->image(image);
+	viewInfo.viewType = viewType;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = aspectFlags;
+	viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+	viewInfo.subresourceRange.levelCount = levelCount;
+	viewInfo.subresourceRange.baseArrayLayer = baseArrayLayer;
+	viewInfo.subresourceRange.layerCount = layerCount;
+
+	VkImageView imageView;
+	if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture image view!");
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	uint32_t index = views.slots.allocate();
+	ensureSlot(views.views, index);
+	ensureSlot(views.images, index);
+	views.views[index] = imageView;
+	views.images[index] = image;
+
+	return ImageViewHandle{index, views.slots.generations[index]};
+}
+
+VkBuffer ResourceRegistry::buffer(BufferHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!buffers.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale buffer handle");
+	return buffers.buffers[handle.index];
+}
+
+VkDeviceSize ResourceRegistry::bufferSize(BufferHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!buffers.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale buffer handle");
+	return buffers.sizes[handle.index];
+}
+
+void* ResourceRegistry::map(BufferHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!buffers.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale buffer handle");
+
+	// Отображение держится до уничтожения памяти
+	void*& mapped = buffers.mapped[handle.index];
+	if (!mapped)
+		vkMapMemory(device, buffers.memories[handle.index], 0, VK_WHOLE_SIZE, 0, &mapped);
+	return mapped;
+}
+
+VkImage ResourceRegistry::image(ImageHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!images.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale image handle");
+	return images.images[handle.index];
+}
+
+VkExtent2D ResourceRegistry::imageExtent(ImageHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!images.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale image handle");
+	return images.extents[handle.index];
+}
+
+VkImageView ResourceRegistry::view(ImageViewHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!views.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale image view handle");
+	return views.views[handle.index];
+}
+
+// Изъятие объектов из слота: слот освобождается, объекты уничтожит возвращённая функция.
+// Вызывается под блокировкой
+std::function<void()> ResourceRegistry::takeBuffer(BufferHandle handle) {
+	if (!buffers.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale buffer handle");
+
+	VkDevice device = this->device;
+	VkBuffer buffer = buffers.buffers[handle.index];
+	VkDeviceMemory bufferMemory = buffers.memories[handle.index];
+	buffers.buffers[handle.index] = VK_NULL_HANDLE;
+	buffers.memories[handle.index] = VK_NULL_HANDLE;
+	buffers.mapped[handle.index] = nullptr;
+	buffers.slots.free(handle.index);
+
+	return [=]() {
+		vkDestroyBuffer(device, buffer, nullptr);
+		vkFreeMemory(device, bufferMemory, nullptr);
+	};
+}
+
+std::function<void()> ResourceRegistry::takeImage(ImageHandle handle) {
+	if (!images.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale image handle");
+
+	VkDevice device = this->device;
+	VkImage image = images.images[handle.index];
+	VkDeviceMemory imageMemory = images.memories[handle.index];
+	images.images[handle.index] = VK_NULL_HANDLE;
+	images.memories[handle.index] = VK_NULL_HANDLE;
+	images.slots.free(handle.index);
+
+	return [=]() {
+		vkDestroyImage(device, image, nullptr);
+		vkFreeMemory(device, imageMemory, nullptr);
+	};
+}
+
+std::function<void()> ResourceRegistry::takeImageView(ImageViewHandle handle) {
+	if (!views.slots.alive(handle.index, handle.generation))
+		throw std::runtime_error("Stale image view handle");
+
+	VkDevice device = this->device;
+	VkImageView imageView = views.views[handle.index];
+	views.views[handle.index] = VK_NULL_HANDLE;
+	views.slots.free(handle.index);
+
+	return [=]() {
+		vkDestroyImageView(device, imageView, nullptr);
+	};
+}
+
+void ResourceRegistry::release(BufferHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	openQueue.push(takeBuffer(handle));
+}
+
+void ResourceRegistry::release(ImageHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	openQueue.push(takeImage(handle));
+}
+
+void ResourceRegistry::release(ImageViewHandle handle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	openQueue.push(takeImageView(handle));
+}
+
+void ResourceRegistry::release(std::function<void()>&& deleter) {
+	std::lock_guard<std::mutex> lock(mutex);
+	openQueue.push(std::move(deleter));
+}
+
+void ResourceRegistry::destroyNow(BufferHandle handle) {
+	std::function<void()> deleter;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		deleter = takeBuffer(handle);
+	}
+	deleter();
+}
+
+void ResourceRegistry::destroyNow(ImageHandle handle) {
+	std::function<void()> deleter;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		deleter = takeImage(handle);
+	}
+	deleter();
+}
+
+void ResourceRegistry::destroyNow(ImageViewHandle handle) {
+	std::function<void()> deleter;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		deleter = takeImageView(handle);
+	}
+	deleter();
+}
+
+void ResourceRegistry::seal(uint64_t value) {
+	std::lock_guard<std::mutex> lock(mutex);
+	DeletionQueue sealed;
+	std::swap(sealed, openQueue);
+	if (!retiring.empty() && retiring.back().first == value)
+		retiring.back().second.append(std::move(sealed));
+	else
+		retiring.emplace_back(value, std::move(sealed));
+}
+
+void ResourceRegistry::collect() {
+	uint64_t completed = timeline->completed();
+	DeletionQueue ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while (!retiring.empty() && retiring.front().first <= completed) {
+			ready.append(std::move(retiring.front().second));
+			retiring.pop_front();
+		}
+	}
+	// Уничтожение вне блокировки: фоновые потоки могут продолжать создавать ресурсы
+	ready.flush();
+}
@@ -0,0 +1,354 @@
+#include "ResourceStateTracker.hpp"
+
+#include <stdexcept>
+
+// Доступы, которые изменяют память
+static const VkAccessFlags2 WRITE_ACCESS =
+	VK_ACCESS_2_SHADER_WRITE_BIT |
+	VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+	VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_2_TRANSFER_WRITE_BIT |
+	VK_ACCESS_2_HOST_WRITE_BIT |
+	VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+ResourceState resourceState(ResourceUsage usage) {
+	switch (usage) {
+	case ResourceUsage::TransferSrc:
+		return {VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+	case ResourceUsage::TransferDst:
+		return {VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+	case ResourceUsage::VertexShaderRead:
+		return {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	case ResourceUsage::FragmentShaderRead:
+		return {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	case ResourceUsage::ComputeShaderRead:
+		return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	case ResourceUsage::ComputeShaderWrite:
+		return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+	case ResourceUsage::ComputeShaderReadWrite:
+		return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+	case ResourceUsage::ColorAttachment:
+		return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+	case ResourceUsage::DepthAttachment:
+		return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+	case ResourceUsage::DepthAttachmentRead:
+		return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+	case ResourceUsage::DepthShaderRead:
+		return {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+	case ResourceUsage::Present:
+		return {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+	case ResourceUsage::VertexBuffer:
+		return {VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+	case ResourceUsage::IndexBuffer:
+		return {VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+	case ResourceUsage::UniformBuffer:
+		return {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+	case ResourceUsage::IndirectBuffer:
+		return {VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+	case ResourceUsage::HostRead:
+		return {VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+	case ResourceUsage::Undefined:
+	default:
+		return {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED};
+	}
+}
+
+ResourceStateTracker::Subresource ResourceStateTracker::initialSubresource(const ResourceState& state) {
+	Subresource subresource{};
+	subresource.layout = state.layout;
+	// Исходное состояние считается последней записью: например, ожидание семафора захвата изображения
+	subresource.writeStages = state.stages;
+	subresource.writeAccess = state.access & WRITE_ACCESS;
+	return subresource;
+}
+
+void ResourceStateTracker::trackImage(VkImage image, VkImageAspectFlags aspectMask, uint32_t mipLevels, uint32_t arrayLayers, ResourceState initial) {
+	Image& tracked = images[image];
+	tracked.aspectMask = aspectMask;
+	tracked.mipLevels = mipLevels;
+	tracked.arrayLayers = arrayLayers;
+	tracked.subresources.assign(mipLevels * arrayLayers, initialSubresource(initial));
+}
+
+void ResourceStateTracker::trackBuffer(VkBuffer buffer, ResourceState initial) {
+	initial.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	buffers[buffer] = initialSubresource(initial);
+}
+
+void ResourceStateTracker::forget(VkImage image) {
+	images.erase(image);
+}
+
+void ResourceStateTracker::forget(VkBuffer buffer) {
+	buffers.erase(buffer);
+}
+
+bool ResourceStateTracker::transition(Subresource& subresource, const ResourceState& state,
+									VkPipelineStageFlags2& srcStages, VkAccessFlags2& srcAccess, VkImageLayout& oldLayout) {
+	bool write = (state.access & WRITE_ACCESS) != 0;
+	bool layoutChange = state.layout != subresource.layout;
+	bool barrier;
+
+	oldLayout = subresource.layout;
+
+	if (write || layoutChange) {
+		// Запись или смена раскладки ждёт и прошлую запись, и всех читателей после неё
+		srcStages = subresource.writeStages | subresource.readStages;
+		srcAccess = subresource.writeAccess;
+		barrier = layoutChange || srcStages != 0;
+
+		subresource.layout = state.layout;
+		if (write) {
+			subresource.writeStages = state.stages;
+			subresource.writeAccess = state.access & WRITE_ACCESS;
+			subresource.readStages = 0;
+			subresource.visibleStages = 0;
+			subresource.visibleAccess = 0;
+		} else {
+			// Смена раскладки сама является записью, видимой стадиям назначения
+			subresource.writeStages = state.stages;
+			subresource.writeAccess = 0;
+			subresource.readStages = state.stages;
+			subresource.visibleStages = state.stages;
+			subresource.visibleAccess = state.access;
+		}
+		return barrier;
+	}
+
+	// Чтение в той же раскладке: барьер нужен, только если запись ещё не видна этим стадиям
+	bool visible = (state.stages & ~subresource.visibleStages) == 0
+				&& (state.access & ~subresource.visibleAccess) == 0;
+	barrier = subresource.writeStages != 0 && !visible;
+
+	srcStages = subresource.writeStages;
+	srcAccess = subresource.writeAccess;
+	subresource.readStages |= state.stages;
+	if (barrier) {
+		subresource.visibleStages |= state.stages;
+		subresource.visibleAccess |= state.access;
+	}
+	return barrier;
+}
+
+void ResourceStateTracker::use(VkImage image, ResourceUsage usage) {
+	use(image, resourceState(usage));
+}
+
+void ResourceStateTracker::use(VkImage image, const ResourceState& state, uint32_t baseMipLevel, uint32_t levelCount,
+							uint32_t baseArrayLayer, uint32_t layerCount) {
+	auto found = images.find(image);
+	if (found == images.end())
+		throw std::runtime_error("Untracked image");
+	Image& tracked = found->second;
+
+	if (levelCount == VK_REMAINING_MIP_LEVELS)
+		levelCount = tracked.mipLevels - baseMipLevel;
+	if (layerCount == VK_REMAINING_ARRAY_LAYERS)
+		layerCount = tracked.arrayLayers - baseArrayLayer;
+
+	// Барьеры предыдущего слоя этого вызова: одинаковые слои объединяются в один барьер
+	std::vector<uint32_t> previousLayer, currentLayer;
+
+	for (uint32_t layer = baseArrayLayer; layer < baseArrayLayer + layerCount; layer++) {
+		currentLayer.clear();
+
+		for (uint32_t mip = baseMipLevel; mip < baseMipLevel + levelCount; mip++) {
+			Subresource& subresource = tracked.subresources[layer * tracked.mipLevels + mip];
+
+			// Для подресурса уже есть барьер в этой точке перехода
+			if (subresource.batch == batch) {
+				VkImageMemoryBarrier2& existing = imageBarriers[subresource.barrier];
+				bool readOnly = (existing.dstAccessMask & WRITE_ACCESS) == 0 && (state.access & WRITE_ACCESS) == 0;
+				if (!readOnly || existing.newLayout != state.layout)
+					throw std::runtime_error("Conflicting image usage within one barrier batch");
+
+				// Ещё один читатель в той же раскладке - расширяем назначение барьера
+				existing.dstStageMask |= state.stages;
+				existing.dstAccessMask |= state.access;
+				subresource.readStages |= state.stages;
+				subresource.visibleStages |= state.stages;
+				subresource.visibleAccess |= state.access;
+				continue;
+			}
+
+			VkPipelineStageFlags2 srcStages;
+			VkAccessFlags2 srcAccess;
+			VkImageLayout oldLayout;
+			if (!transition(subresource, state, srcStages, srcAccess, oldLayout))
+				continue;
+
+			// Соседний уровень с теми же параметрами продолжает предыдущий барьер
+			if (!currentLayer.empty()) {
+				VkImageMemoryBarrier2& last = imageBarriers[currentLayer.back()];
+				if (last.srcStageMask == srcStages && last.srcAccessMask == srcAccess && last.oldLayout == oldLayout
+				&&  last.subresourceRange.baseMipLevel + last.subresourceRange.levelCount == mip
+				) {
+					last.subresourceRange.levelCount++;
+					subresource.batch = batch;
+					subresource.barrier = currentLayer.back();
+					continue;
+				}
+			}
+
+			VkImageMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+			barrier.srcStageMask = srcStages;
+			barrier.srcAccessMask = srcAccess;
+			barrier.dstStageMask = state.stages;
+			barrier.dstAccessMask = state.access;
+			barrier.oldLayout = oldLayout;
+			barrier.newLayout = state.layout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = tracked.aspectMask;
+			barrier.subresourceRange.baseMipLevel = mip;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.baseArrayLayer = layer;
+			barrier.subresourceRange.layerCount = 1;
+
+			subresource.batch = batch;
+			subresource.barrier = static_cast<uint32_t>(imageBarriers.size());
+			currentLayer.push_back(subresource.barrier);
+			imageBarriers.push_back(barrier);
+		}
+
+		// Слой повторяет предыдущий - расширяем барьеры предыдущего слоя
+		bool sameAsPrevious = !previousLayer.empty() && previousLayer.size() == currentLayer.size();
+		for (size_t i = 0; sameAsPrevious && i < currentLayer.size(); i++) {
+			const VkImageMemoryBarrier2& a = imageBarriers[previousLayer[i]];
+			const VkImageMemoryBarrier2& b = imageBarriers[currentLayer[i]];
+			sameAsPrevious = a.srcStageMask == b.srcStageMask && a.srcAccessMask == b.srcAccessMask
+						&& a.oldLayout == b.oldLayout
+						&& a.subresourceRange.baseMipLevel == b.subresourceRange.baseMipLevel
+						&& a.subresourceRange.levelCount == b.subresourceRange.levelCount
+						&& a.subresourceRange.baseArrayLayer + a.subresourceRange.layerCount == layer;
+		}
+
+		if (sameAsPrevious) {
+			for (uint32_t index : previousLayer)
+				imageBarriers[index].subresourceRange.layerCount++;
+			for (uint32_t mip = baseMipLevel; mip < baseMipLevel + levelCount; mip++) {
+				Subresource& subresource = tracked.subresources[layer * tracked.mipLevels + mip];
+				for (size_t i = 0; i < currentLayer.size(); i++)
+					if (subresource.batch == batch && subresource.barrier == currentLayer[i])
+						subresource.barrier = previousLayer[i];
+			}
+			// Барьеры текущего слоя добавлены последними
+			imageBarriers.resize(imageBarriers.size() - currentLayer.size());
+		} else {
+			previousLayer = currentLayer;
+		}
+	}
+}
+
+void ResourceStateTracker::use(VkBuffer buffer, ResourceUsage usage) {
+	use(buffer, resourceState(usage));
+}
+
+void ResourceStateTracker::use(VkBuffer buffer, const ResourceState& state) {
+	auto found = buffers.find(buffer);
+	if (found == buffers.end())
+		throw std::runtime_error("Untracked buffer");
+	Subresource& subresource = found->second;
+
+	ResourceState bufferState = state;
+	bufferState.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (subresource.batch == batch) {
+		VkBufferMemoryBarrier2& existing = bufferBarriers[subresource.barrier];
+		if ((existing.dstAccessMask & WRITE_ACCESS) != 0 || (bufferState.access & WRITE_ACCESS) != 0)
+			throw std::runtime_error("Conflicting buffer usage within one barrier batch");
+
+		existing.dstStageMask |= bufferState.stages;
+		existing.dstAccessMask |= bufferState.access;
+		subresource.readStages |= bufferState.stages;
+		subresource.visibleStages |= bufferState.stages;
+		subresource.visibleAccess |= bufferState.access;
+		return;
+	}
+
+	VkPipelineStageFlags2 srcStages;
+	VkAccessFlags2 srcAccess;
+	VkImageLayout oldLayout;
+	if (!transition(subresource, bufferState, srcStages, srcAccess, oldLayout))
+		return;
+
+	VkBufferMemoryBarrier2 barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+	barrier.srcStageMask = srcStages;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstStageMask = bufferState.stages;
+	barrier.dstAccessMask = bufferState.access;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = buffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+
+	subresource.batch = batch;
+	subresource.barrier = static_cast<uint32_t>(bufferBarriers.size());
+	bufferBarriers.push_back(barrier);
+}
+
+void ResourceStateTracker::assume(VkImage image, ResourceUsage usage) {
+	auto found = images.find(image);
+	if (found == images.end())
+		throw std::runtime_error("Untracked image");
+
+	ResourceState state = resourceState(usage);
+	for (auto& subresource : found->second.subresources)
+		subresource = initialSubresource(state);
+}
+
+ResourceState ResourceStateTracker::state(VkImage image, uint32_t mipLevel, uint32_t arrayLayer) const {
+	auto found = images.find(image);
+	if (found == images.end())
+		throw std::runtime_error("Untracked image");
+
+	const Subresource& subresource = found->second.subresources[arrayLayer * found->second.mipLevels + mipLevel];
+	return {subresource.writeStages | subresource.readStages, subresource.writeAccess, subresource.layout};
+}
+
+ResourceState ResourceStateTracker::state(VkBuffer buffer) const {
+	auto found = buffers.find(buffer);
+	if (found == buffers.end())
+		throw std::runtime_error("Untracked buffer");
+
+	const Subresource& subresource = found->second;
+	return {subresource.writeStages | subresource.readStages, subresource.writeAccess, subresource.layout};
+}
+
+VkDependencyInfo ResourceStateTracker::dependencyInfo() const {
+	VkDependencyInfo dependencyInfo{};
+	dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+	dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+	dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+	dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+	return dependencyInfo;
+}
+
+void ResourceStateTracker::flush(VkCommandBuffer commandBuffer) {
+	if (hasPending()) {
+		VkDependencyInfo info = dependencyInfo();
+		vkCmdPipelineBarrier2(commandBuffer, &info);
+	}
+	discardPending();
+}
+
+void ResourceStateTracker::discardPending() {
+	imageBarriers.clear();
+	bufferBarriers.clear();
+	batch++;
+}
@@ -0,0 +1,71 @@
+#include "SceneConfig.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// Обрезка пробелов по краям
+static std::string trim(const std::string& text) {
+	size_t begin = text.find_first_not_of(" \t\r");
+	if (begin == std::string::npos)
+		return "";
+	size_t end = text.find_last_not_of(" \t\r");
+	return text.substr(begin, end - begin + 1);
+}
+
+static glm::vec3 parseVec3(const std::string& key, const std::string& value) {
+	glm::vec3 result;
+	char separator1, separator2;
+	std::istringstream stream(value);
+	if (!(stream >> result.x >> separator1 >> result.y >> separator2 >> result.z))
+		throw std::runtime_error("Scene config: expected x, y, z for " + key);
+	return result;
+}
+
+SceneConfig loadSceneConfig(const std::string& path) {
+	std::ifstream file(path);
+	if (!file.is_open())
+		throw std::runtime_error("Can't open scene config: " + path);
+
+	SceneConfig config;
+	std::string line;
+	while (std::getline(file, line)) {
+		line = trim(line.substr(0, line.find('#')));
+		if (line.empty())
+			continue;
+
+		size_t equals = line.find('=');
+		if (equals == std::string::npos)
+			throw std::runtime_error("Scene config: expected key = value: " + line);
+		std::string key = trim(line.substr(0, equals));
+		std::string value = trim(line.substr(equals + 1));
+
+		if (key == "model")
+			config.model = value;
+		else if (key == "texture")
+			config.texture = value;
+		else if (key == "camera")
+			config.cameraPos = parseVec3(key, value);
+		else if (key == "crowd")
+			config.crowd = static_cast<uint32_t>(std::stoul(value));
+		else if (key == "heightfield")
+			config.heightfield = static_cast<uint32_t>(std::stoul(value));
+		else if (key == "lights")
+			config.lights = static_cast<uint32_t>(std::stoul(value));
+		else if (key == "terrain")
+			config.terrain = value;
+		else if (key == "animation")
+			config.animations.push_back(value);
+		else if (key == "front")
+			config.cameraFront = glm::normalize(parseVec3(key, value));
+		else if (key == "sun")
+			config.sun = glm::normalize(parseVec3(key, value));
+		else if (key == "particles")
+			config.particles = static_cast<uint32_t>(std::stoul(value));
+		else if (key == "emitter")
+			config.emitter = parseVec3(key, value);
+		else
+			throw std::runtime_error("Scene config: unknown key " + key);
+	}
+	return config;
+}
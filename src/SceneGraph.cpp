@@ -0,0 +1,239 @@
+#include "SceneGraph.hpp"
+#include "CpuProfiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SCENE_GRAPH_SSE
+#endif
+
+// result = a * b для матриц по столбцам: столбец j результата - сумма столбцов a с весами из столбца j матрицы b.
+// Четыре столбца a загружаются один раз, каждый столбец результата - 4 умножения и 3 сложения векторов
+static inline void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result) {
+#ifdef SCENE_GRAPH_SSE
+	__m128 a0 = _mm_loadu_ps(&a[0][0]);
+	__m128 a1 = _mm_loadu_ps(&a[1][0]);
+	__m128 a2 = _mm_loadu_ps(&a[2][0]);
+	__m128 a3 = _mm_loadu_ps(&a[3][0]);
+	for (int j = 0; j < 4; j++) {
+		__m128 column = _mm_loadu_ps(&b[j][0]);
+		__m128 sum = _mm_mul_ps(a0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+		_mm_storeu_ps(&result[j][0], sum);
+	}
+#else
+	result = a * b;
+#endif
+}
+
+SceneNode SceneGraph::create(SceneNode parent, const glm::mat4& local) {
+	if (parent != NO_SCENE_NODE && !alive(parent))
+		throw std::runtime_error("Scene graph: invalid parent node");
+
+	SceneNode node;
+	if (freeNodes.empty()) {
+		node = static_cast<SceneNode>(indices.size());
+		indices.push_back(0);
+	} else {
+		node = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	indices[node] = size();
+
+	// Новый узел в конце массивов: родитель раньше него, порядок уровней восстановит rebuild()
+	parents.push_back(parent == NO_SCENE_NODE ? UINT32_MAX : indices[parent]);
+	locals.push_back(local);
+	worlds.push_back(local);
+	dirty.push_back(1);
+	removed.push_back(0);
+	nodes.push_back(node);
+	structureChanged = true; // список помеченных соберёт rebuild()
+	return node;
+}
+
+void SceneGraph::remove(SceneNode node) {
+	if (!alive(node))
+		return;
+	removed[indices[node]] = 1; // поддерево отбрасывается при перестроении
+	structureChanged = true;
+}
+
+void SceneGraph::setParent(SceneNode node, SceneNode parent) {
+	if (!alive(node) || (parent != NO_SCENE_NODE && !alive(parent)))
+		throw std::runtime_error("Scene graph: invalid node");
+
+	uint32_t index = indices[node];
+	uint32_t parentIndex = parent == NO_SCENE_NODE ? UINT32_MAX : indices[parent];
+	for (uint32_t ancestor = parentIndex; ancestor != UINT32_MAX; ancestor = parents[ancestor])
+		if (ancestor == index)
+			throw std::runtime_error("Scene graph: node can't be parented to its descendant");
+
+	parents[index] = parentIndex;
+	dirty[index] = 1;
+	structureChanged = true;
+}
+
+void SceneGraph::setLocal(SceneNode node, const glm::mat4& local) {
+	uint32_t index = indices[node];
+	locals[index] = local;
+	mark(index);
+}
+
+void SceneGraph::mark(uint32_t index) {
+	if (dirty[index])
+		return;
+	dirty[index] = 1;
+	marked.push_back(index);
+}
+
+void SceneGraph::rebuild() {
+	PROFILE_FUNCTION();
+	uint32_t count = size();
+
+	// Списки детей по текущим индексам
+	std::vector<uint32_t> childStart(count + 1, 0);
+	for (uint32_t i = 0; i < count; i++)
+		if (parents[i] != UINT32_MAX)
+			childStart[parents[i] + 1]++;
+	for (uint32_t i = 0; i < count; i++)
+		childStart[i + 1] += childStart[i];
+	std::vector<uint32_t> children(childStart[count]);
+	std::vector<uint32_t> cursor(childStart.begin(), childStart.end() - 1);
+	for (uint32_t i = 0; i < count; i++)
+		if (parents[i] != UINT32_MAX)
+			children[cursor[parents[i]]++] = i;
+
+	// Обход в ширину от корней: удалённые узлы и их поддеревья не посещаются
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	for (uint32_t i = 0; i < count; i++)
+		if (parents[i] == UINT32_MAX && !removed[i])
+			order.push_back(i);
+
+	// Дети узла добавляются подряд: их участок запоминается по новому индексу узла
+	levels.assign(1, 0);
+	firstChild.assign(count, 0);
+	childCount.assign(count, 0);
+	uint32_t levelBegin = 0;
+	while (levelBegin < order.size()) {
+		uint32_t levelEnd = static_cast<uint32_t>(order.size());
+		for (uint32_t k = levelBegin; k < levelEnd; k++) {
+			firstChild[k] = static_cast<uint32_t>(order.size());
+			for (uint32_t c = childStart[order[k]]; c < childStart[order[k] + 1]; c++)
+				if (!removed[children[c]])
+					order.push_back(children[c]);
+			childCount[k] = static_cast<uint32_t>(order.size()) - firstChild[k];
+		}
+		levels.push_back(levelEnd);
+		levelBegin = levelEnd;
+	}
+
+	// Перестановка полей в новый порядок
+	std::vector<uint32_t> newIndex(count, UINT32_MAX);
+	for (uint32_t k = 0; k < order.size(); k++)
+		newIndex[order[k]] = k;
+	for (uint32_t i = 0; i < count; i++) {
+		if (newIndex[i] == UINT32_MAX) {
+			indices[nodes[i]] = UINT32_MAX;
+			freeNodes.push_back(nodes[i]);
+		}
+	}
+
+	uint32_t kept = static_cast<uint32_t>(order.size());
+	std::vector<uint32_t> newParents(kept);
+	std::vector<glm::mat4> newLocals(kept);
+	std::vector<glm::mat4> newWorlds(kept);
+	std::vector<uint8_t> newDirty(kept);
+	std::vector<SceneNode> newNodes(kept);
+	for (uint32_t k = 0; k < kept; k++) {
+		uint32_t i = order[k];
+		newParents[k] = parents[i] == UINT32_MAX ? UINT32_MAX : newIndex[parents[i]];
+		newLocals[k] = locals[i];
+		newWorlds[k] = worlds[i];
+		newDirty[k] = dirty[i];
+		newNodes[k] = nodes[i];
+		indices[nodes[i]] = k;
+	}
+	parents.swap(newParents);
+	locals.swap(newLocals);
+	worlds.swap(newWorlds);
+	dirty.swap(newDirty);
+	nodes.swap(newNodes);
+	removed.assign(kept, 0);
+	firstChild.resize(kept);
+	childCount.resize(kept);
+	structureChanged = false;
+
+	marked.clear();
+	for (uint32_t k = 0; k < kept; k++)
+		if (dirty[k])
+			marked.push_back(k);
+}
+
+void SceneGraph::updateSlice(const uint32_t* list, uint32_t begin, uint32_t end) {
+	for (uint32_t k = begin; k < end; k++) {
+		uint32_t i = list ? list[k] : k;
+		uint32_t parent = parents[i];
+		// Уровень родителя уже посчитан и в этом проходе не меняется
+		if (parent == UINT32_MAX)
+			worlds[i] = locals[i];
+		else
+			multiply(worlds[parent], locals[i], worlds[i]);
+	}
+}
+
+void SceneGraph::update(WorkerPool* pool, uint32_t grain) {
+	if (structureChanged)
+		rebuild();
+	if (marked.empty())
+		return; // неподвижная сцена
+	PROFILE_FUNCTION();
+
+	// Помеченные узлы - по спискам своих уровней
+	uint32_t levelTotal = levelCount();
+	dirtyLevels.resize(levelTotal);
+	for (uint32_t i : marked) {
+		uint32_t level = static_cast<uint32_t>(std::upper_bound(levels.begin(), levels.end(), i) - levels.begin()) - 1;
+		dirtyLevels[level].push_back(i);
+	}
+
+	// Изменён весь уровень - изменён и весь следующий: уровни считаются подряд, без списков
+	bool full = false;
+	for (uint32_t level = 0; level < levelTotal; level++) {
+		std::vector<uint32_t>& list = dirtyLevels[level];
+		full = full || list.size() == levels[level + 1] - levels[level];
+		uint32_t first = full ? levels[level] : 0;
+		uint32_t last = full ? levels[level + 1] : static_cast<uint32_t>(list.size());
+		if (first == last)
+			continue;
+
+		const uint32_t* dirtyList = full ? nullptr : list.data();
+		if (pool)
+			pool->parallelFor(first, last, grain, [this, dirtyList](uint32_t begin, uint32_t end) { updateSlice(dirtyList, begin, end); });
+		else
+			updateSlice(dirtyList, first, last);
+
+		if (full) {
+			std::fill(dirty.begin() + levels[level], dirty.begin() + levels[level + 1], 0);
+			list.clear();
+			continue;
+		}
+
+		// Пометка переходит только к детям изменённых узлов; снимается сразу после пересчёта
+		for (uint32_t i : list) {
+			dirty[i] = 0;
+			if (level + 1 < levelTotal)
+				for (uint32_t c = firstChild[i]; c < firstChild[i] + childCount[i]; c++)
+					if (!dirty[c]) {
+						dirty[c] = 1;
+						dirtyLevels[level + 1].push_back(c);
+					}
+		}
+		list.clear();
+	}
+	marked.clear();
+}
@@ -0,0 +1,114 @@
+#include "ShadowCascades.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+float sliceSphere(float tanHalfFovY, float aspect, float sliceNear, float sliceFar, float& depth) {
+	// Квадрат полудиагонали сечения на единицу глубины; центр равноудалён от углов обоих торцов.
+	// Если он выходит за дальний торец, сфера - описанная сфера дальнего торца
+	float k2 = tanHalfFovY * tanHalfFovY * (1.0f + aspect * aspect);
+	depth = 0.5f * (sliceNear + sliceFar) * (1.0f + k2);
+	if (depth >= sliceFar) {
+		depth = sliceFar;
+		return sliceFar * std::sqrt(k2);
+	}
+	return std::sqrt((sliceFar - depth) * (sliceFar - depth) + sliceFar * sliceFar * k2);
+}
+
+glm::mat4 lightRotation(const glm::vec3& direction) {
+	glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	return glm::lookAt(glm::vec3(0.0f), direction, up);
+}
+
+ShadowCascade fitCascade(const glm::vec3& center, float radius, const glm::mat4& lightRotation) {
+	// Центр в пространстве света сдвигается только на целые тексели
+	float texel = 2.0f * radius / SHADOW_MAP_SIZE;
+	glm::vec3 local = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+	local.x = std::floor(local.x / texel) * texel;
+	local.y = std::floor(local.y / texel) * texel;
+
+	// Вид смотрит вдоль -z: заслонки между светом и срезом - при z > 0
+	ShadowCascade cascade;
+	cascade.view = glm::translate(glm::mat4(1.0f), -local) * lightRotation;
+	cascade.proj = glm::orthoRH_ZO(-radius, radius, -radius, radius, -(radius + SHADOW_CASTER_DISTANCE), radius);
+	cascade.center = glm::vec3(glm::transpose(lightRotation) * glm::vec4(local, 1.0f));
+	cascade.radius = radius;
+	cascade.splitFar = 0.0f;
+	return cascade;
+}
+
+glm::mat4 shadowMatrix(const ShadowCascade& cascade) {
+	// NDC x, y [-1, 1] -> [0, 1]; глубина orthoRH_ZO уже в [0, 1]
+	glm::mat4 scaleBias = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f, 0.5f, 0.0f)) *
+		glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 0.5f, 1.0f));
+	return scaleBias * cascade.proj * cascade.view;
+}
+
+bool cascadeTouches(const ShadowCascade& cascade, const glm::vec3& center, float radius) {
+	// Объём вида каскада: |x|, |y| до стороны, глубина от -radius до radius + SHADOW_CASTER_DISTANCE (fitCascade)
+	glm::vec3 local = glm::vec3(cascade.view * glm::vec4(center, 1.0f));
+	float side = cascade.radius + radius;
+	return std::abs(local.x) <= side && std::abs(local.y) <= side &&
+		local.z >= -side && local.z <= side + SHADOW_CASTER_DISTANCE;
+}
+
+void ShadowCascades::setLight(const glm::vec3& direction) {
+	glm::vec3 normalized = glm::normalize(direction);
+	if (glm::dot(normalized, lightDirection) > 1.0f - 1e-6f)
+		return;
+	lightDirection = normalized;
+	rotation = lightRotation(lightDirection);
+	invalidate();
+}
+
+uint32_t ShadowCascades::update(const glm::mat4& view, float tanHalfFovY, float aspect, float znear, float zfar, uint64_t staticRevision) {
+	if (staticRevision != revision) {
+		revision = staticRevision;
+		invalidate();
+	}
+
+	glm::mat4 inverseView = glm::inverse(view);
+	glm::vec3 eye(inverseView[3]);
+	glm::vec3 forward = -glm::vec3(inverseView[2]);
+	float shadowFar = std::min(zfar, SHADOW_DISTANCE);
+
+	uint32_t redraw = 0;
+	float sliceNear = znear;
+	for (uint32_t i = 0; i < SHADOW_CASCADES; i++) {
+		// Практическое разбиение: смесь логарифмического и равномерного
+		float fraction = static_cast<float>(i + 1) / SHADOW_CASCADES;
+		float logSplit = znear * std::pow(shadowFar / znear, fraction);
+		float uniformSplit = znear + (shadowFar - znear) * fraction;
+		float sliceFar = SHADOW_SPLIT_LAMBDA * logSplit + (1.0f - SHADOW_SPLIT_LAMBDA) * uniformSplit;
+
+		float depth;
+		float radius = sliceSphere(tanHalfFovY, aspect, sliceNear, sliceFar, depth);
+		glm::vec3 center = eye + forward * depth;
+
+		if (i < SHADOW_CACHED_FROM) {
+			cascades[i] = fitCascade(center, radius, rotation);
+		} else {
+			// Сфера среза внутри кэшированного куба: сдвиг по каждой оси света не больше запаса
+			glm::vec3 offset = glm::mat3(rotation) * (center - cascades[i].center);
+			float margin = cascades[i].radius - radius;
+			bool inside = std::max(std::abs(offset.x), std::max(std::abs(offset.y), std::abs(offset.z))) <= margin;
+			if ((staticMask & (1u << i)) || !inside) {
+				cascades[i] = fitCascade(center, radius * (1.0f + SHADOW_CACHE_MARGIN), rotation);
+				redraw |= 1u << i;
+			}
+		}
+		cascades[i].splitFar = sliceFar;
+		sliceNear = sliceFar;
+	}
+	staticMask = 0;
+	return redraw;
+}
+
+glm::vec4 ShadowCascades::splits() const {
+	glm::vec4 result;
+	for (uint32_t i = 0; i < SHADOW_CASCADES; i++)
+		result[i] = cascades[i].splitFar;
+	return result;
+}
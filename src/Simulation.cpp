@@ -0,0 +1,87 @@
+#include "Simulation.hpp"
+#include "CpuProfiler.hpp"
+
+#include <algorithm>
+
+void Simulation::start(const SimulationState& initial, double step) {
+	state = initial;
+	this->step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(step));
+
+	Snapshot& snapshot = snapshots.back();
+	snapshot.previous = initial;
+	snapshot.current = initial;
+	snapshot.time = Clock::now();
+	snapshots.publish();
+
+	running = true;
+	worker = std::thread(&Simulation::loop, this);
+}
+
+void Simulation::stop() {
+	running = false;
+	if (worker.joinable())
+		worker.join();
+}
+
+void Simulation::loop() {
+	PROFILE_THREAD("simulation");
+	const int maxStepsPerWake = 8; // после долгой остановки время не догоняется лавиной шагов
+	float dt = std::chrono::duration<float>(step).count();
+	Clock::time_point next = Clock::now() + step;
+
+	while (running) {
+		std::this_thread::sleep_until(next);
+
+		int steps = 0;
+		Clock::time_point now = Clock::now();
+		while (next <= now && steps < maxStepsPerWake) {
+			PROFILE_SCOPE("simulation: tick");
+			SimulationState previous = state;
+			tick(state, input.load(std::memory_order_relaxed), dt);
+
+			Snapshot& snapshot = snapshots.back();
+			snapshot.previous = previous;
+			snapshot.current = state;
+			snapshot.time = next;
+			snapshots.publish();
+
+			next += step;
+			steps++;
+		}
+		if (next <= now)
+			next = now + step;
+	}
+}
+
+// Один шаг симуляции: движение камеры (WASD + пробел/Ctrl) и таймер анимации
+void Simulation::tick(SimulationState& state, uint32_t buttons, float dt) {
+	const float cameraSpeed = 2.5f * dt;
+	glm::vec3 right = glm::normalize(glm::cross(state.cameraFront, state.cameraUp));
+
+	if (buttons & INPUT_FORWARD) state.cameraPos += cameraSpeed * state.cameraFront;
+	if (buttons & INPUT_BACK) state.cameraPos -= cameraSpeed * state.cameraFront;
+	if (buttons & INPUT_LEFT) state.cameraPos -= right * cameraSpeed;
+	if (buttons & INPUT_RIGHT) state.cameraPos += right * cameraSpeed;
+	if (buttons & INPUT_UP) state.cameraPos += cameraSpeed * state.cameraUp;
+	if (buttons & INPUT_DOWN) state.cameraPos -= cameraSpeed * state.cameraUp;
+
+	state.animationTime += dt;
+}
+
+SimulationState Simulation::sample() {
+	snapshots.update();
+	const Snapshot& snapshot = snapshots.front();
+
+	// Доля шага, прошедшая после текущего состояния; интерполяция от предыдущего к текущему
+	float alpha = std::chrono::duration<float>(Clock::now() - snapshot.time).count()
+				/ std::chrono::duration<float>(step).count();
+	alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+
+	SimulationState result;
+	result.cameraPos = glm::mix(snapshot.previous.cameraPos, snapshot.current.cameraPos, alpha);
+	result.cameraFront = glm::normalize(glm::mix(snapshot.previous.cameraFront, snapshot.current.cameraFront, alpha));
+	result.cameraUp = glm::normalize(glm::mix(snapshot.previous.cameraUp, snapshot.current.cameraUp, alpha));
+	result.animationTime = snapshot.previous.animationTime
+						+ (snapshot.current.animationTime - snapshot.previous.animationTime) * alpha;
+	return result;
+}
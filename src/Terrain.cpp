@@ -0,0 +1,346 @@
+#include "Terrain.hpp"
+#include "CpuProfiler.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// Заголовок файла плитки
+typedef struct _HeightTileHeader
+{
+	char magic[4]; // "HTIL"
+	uint32_t version;
+	uint32_t size; // отсчётов по стороне
+	float minHeight;
+	float maxHeight;
+} HeightTileHeader;
+
+static const int32_t TILE = static_cast<int32_t>(TERRAIN_TILE);
+static const int32_t WINDOW = static_cast<int32_t>(TERRAIN_WINDOW);
+static const int32_t PREFETCH = 64; // вершин вокруг окна уровня, плитки которых читаются заранее
+
+// Деление и остаток с округлением вниз (для отрицательных координат)
+static int32_t floorDiv(int32_t value, int32_t divisor) {
+	return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static int32_t floorMod(int32_t value, int32_t divisor) {
+	return value - floorDiv(value, divisor) * divisor;
+}
+
+bool loadHeightTile(const std::string& path, std::vector<float>& heights) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	HeightTileHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::string(header.magic, 4) != "HTIL" ||
+		header.version != 1 || header.size != TERRAIN_TILE)
+		throw std::runtime_error("Invalid height tile: " + path);
+
+	std::vector<uint16_t> samples(TERRAIN_TILE * TERRAIN_TILE);
+	if (!file.read(reinterpret_cast<char*>(samples.data()), samples.size() * sizeof(uint16_t)))
+		throw std::runtime_error("Truncated height tile: " + path);
+
+	float scale = (header.maxHeight - header.minHeight) / 65535.0f;
+	heights.resize(samples.size());
+	for (size_t i = 0; i < samples.size(); i++)
+		heights[i] = header.minHeight + samples[i] * scale;
+	return true;
+}
+
+void saveHeightTile(const std::string& path, const std::vector<float>& heights, float minHeight, float maxHeight) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("Can't write height tile: " + path);
+
+	std::vector<uint16_t> samples(heights.size());
+	float scale = maxHeight > minHeight ? 65535.0f / (maxHeight - minHeight) : 0.0f;
+	for (size_t i = 0; i < heights.size(); i++)
+		samples[i] = static_cast<uint16_t>(std::lround(std::clamp((heights[i] - minHeight) * scale, 0.0f, 65535.0f)));
+
+	HeightTileHeader header = {{'H', 'T', 'I', 'L'}, 1, TERRAIN_TILE, minHeight, maxHeight};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(uint16_t));
+}
+
+std::string heightTilePath(const std::string& directory, uint32_t mip, int32_t x, int32_t z) {
+	return directory + "/" + std::to_string(mip) + "/" + std::to_string(x) + "_" + std::to_string(z) + ".tile";
+}
+
+void Terrain::start(const std::string& directory, float spacing, uint32_t capacity) {
+	this->directory = directory;
+	baseSpacing = spacing;
+	this->capacity = std::max(capacity, 4 * TERRAIN_LEVELS); // окну уровня нужно до 2 x 2 плиток
+
+	running = true;
+	loader = std::thread(&Terrain::loaderLoop, this);
+}
+
+void Terrain::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running)
+			return;
+		running = false;
+	}
+	wake.notify_all();
+	loader.join();
+	tiles.clear();
+	requests.clear();
+	requested.clear();
+	arrived.clear();
+	occluderMesh.clear();
+	occluderTriangles.clear();
+}
+
+size_t Terrain::residentTiles() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return tiles.size();
+}
+
+void Terrain::update(const glm::vec3& camera, std::vector<TerrainUpload>& uploads, std::vector<float>& heights) {
+	PROFILE_FUNCTION();
+	uploads.clear();
+	heights.clear();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	frame++;
+
+	// Пришедшая плитка заменяет нули в окне своего уровня: слой загружается заново
+	for (const TileKey& key : arrived) {
+		uint32_t level = std::get<0>(key);
+		glm::ivec2 base = origins[level] - 1;
+		int32_t x = std::get<1>(key) * TILE;
+		int32_t z = std::get<2>(key) * TILE;
+		if (x < base.x + WINDOW && x + TILE > base.x && z < base.y + WINDOW && z + TILE > base.y) {
+			loaded[level] = false;
+			heightRevision++;
+		}
+	}
+	arrived.clear();
+
+	bool occluderChanged = occluderMesh.empty();
+	for (uint32_t level = 0; level < TERRAIN_LEVELS; level++) {
+		size_t uploadCount = uploads.size();
+
+		// Центр - чётная вершина уровня: угол уровня l - 1 тогда попадает на вершину уровня l
+		float step = spacing(level);
+		glm::ivec2 center(2 * static_cast<int32_t>(std::floor(camera.x / (2.0f * step))),
+						  2 * static_cast<int32_t>(std::floor(camera.z / (2.0f * step))));
+		glm::ivec2 origin = center - glm::ivec2(2 * TERRAIN_BLOCK);
+
+		// Окно начинается на вершину раньше угла: нормалям края нужны соседи
+		glm::ivec2 base = origin - 1;
+		glm::ivec2 oldBase = origins[level] - 1;
+		glm::ivec2 delta = base - oldBase;
+
+		if (!loaded[level] || std::abs(delta.x) >= WINDOW / 2 || std::abs(delta.y) >= WINDOW / 2) {
+			uploadRegion(level, base.x, base.y, WINDOW, WINDOW, uploads, heights);
+			loaded[level] = true;
+		} else {
+			// Открывшиеся столбцы по всей высоте окна и открывшиеся ряды по всей ширине
+			if (delta.x > 0)
+				uploadRegion(level, oldBase.x + WINDOW, base.y, delta.x, WINDOW, uploads, heights);
+			else if (delta.x < 0)
+				uploadRegion(level, base.x, base.y, -delta.x, WINDOW, uploads, heights);
+			if (delta.y > 0)
+				uploadRegion(level, base.x, oldBase.y + WINDOW, WINDOW, delta.y, uploads, heights);
+			else if (delta.y < 0)
+				uploadRegion(level, base.x, base.y, WINDOW, -delta.y, uploads, heights);
+		}
+		origins[level] = origin;
+		if (level == TERRAIN_OCCLUDER_LEVEL && uploads.size() != uploadCount)
+			occluderChanged = true;
+
+		// Плитки вокруг окна - заранее, от мелкого уровня к крупному
+		for (int32_t z = floorDiv(base.y - PREFETCH, TILE); z <= floorDiv(base.y + WINDOW + PREFETCH - 1, TILE); z++)
+			for (int32_t x = floorDiv(base.x - PREFETCH, TILE); x <= floorDiv(base.x + WINDOW + PREFETCH - 1, TILE); x++)
+				request(TileKey(level, x, z));
+	}
+
+	if (occluderChanged)
+		buildOccluder();
+
+	evict();
+	wake.notify_one();
+}
+
+void Terrain::reload(uint32_t level) {
+	std::lock_guard<std::mutex> lock(mutex);
+	loaded[level] = false;
+}
+
+void Terrain::blocks(std::vector<TerrainBlock>& result) const {
+	const int32_t m = static_cast<int32_t>(TERRAIN_BLOCK);
+	result.clear();
+	result.push_back({0, origins[0], glm::ivec2(0), glm::uvec2(4 * m)});
+
+	for (uint32_t level = 1; level < TERRAIN_LEVELS; level++) {
+		// Область уровня l - 1 в ячейках уровня l: 2m x 2m со сдвигом m или m + 1
+		glm::ivec2 origin = origins[level];
+		glm::ivec2 hole = origins[level - 1] / 2 - origin;
+
+		result.push_back({level, origin, glm::ivec2(0, 0), glm::uvec2(4 * m, hole.y)});
+		result.push_back({level, origin, glm::ivec2(0, hole.y + 2 * m), glm::uvec2(4 * m, 2 * m - hole.y)});
+		result.push_back({level, origin, glm::ivec2(0, hole.y), glm::uvec2(hole.x, 2 * m)});
+		result.push_back({level, origin, glm::ivec2(hole.x + 2 * m, hole.y), glm::uvec2(2 * m - hole.x, 2 * m)});
+	}
+}
+
+void Terrain::uploadRegion(uint32_t level, int32_t x, int32_t z, uint32_t width, uint32_t height,
+						std::vector<TerrainUpload>& uploads, std::vector<float>& heights) {
+	// Разрез по границе окна в каждом направлении
+	int32_t texelX = floorMod(x, WINDOW);
+	int32_t texelZ = floorMod(z, WINDOW);
+	uint32_t widths[2] = {std::min<uint32_t>(width, WINDOW - texelX), 0};
+	uint32_t heightsZ[2] = {std::min<uint32_t>(height, WINDOW - texelZ), 0};
+	widths[1] = width - widths[0];
+	heightsZ[1] = height - heightsZ[0];
+
+	for (int iz = 0; iz < 2; iz++) {
+		for (int ix = 0; ix < 2; ix++) {
+			if (widths[ix] == 0 || heightsZ[iz] == 0)
+				continue;
+
+			int32_t vertexX = x + (ix ? static_cast<int32_t>(widths[0]) : 0);
+			int32_t vertexZ = z + (iz ? static_cast<int32_t>(heightsZ[0]) : 0);
+			TerrainUpload upload = {level, ix ? 0u : static_cast<uint32_t>(texelX), iz ? 0u : static_cast<uint32_t>(texelZ),
+									widths[ix], heightsZ[iz], heights.size()};
+			heights.resize(heights.size() + widths[ix] * heightsZ[iz]);
+			for (uint32_t row = 0; row < heightsZ[iz]; row++)
+				sampleRow(level, vertexX, vertexZ + row, widths[ix], heights.data() + upload.offset + row * widths[ix]);
+			uploads.push_back(upload);
+		}
+	}
+}
+
+void Terrain::buildOccluder() {
+	PROFILE_FUNCTION();
+	const uint32_t level = TERRAIN_OCCLUDER_LEVEL;
+	const uint32_t step = TERRAIN_OCCLUDER_STEP;
+	const uint32_t cells = 4 * TERRAIN_BLOCK / TERRAIN_OCCLUDER_STEP;
+	const uint32_t samples = cells * TERRAIN_OCCLUDER_STEP + 1;
+	glm::ivec2 origin = origins[level];
+
+	// Наименьшая высота каждой ячейки заслонки по всем её отсчётам, включая края:
+	// отсчёт на границе принадлежит обеим ячейкам
+	auto firstCell = [&](uint32_t sample) { return sample > 0 ? (sample - 1) / step : 0u; };
+	auto lastCell = [&](uint32_t sample) { return std::min(sample / step, cells - 1); };
+	std::vector<float> row(samples);
+	std::vector<float> cellLow(cells * cells, FLT_MAX);
+	for (uint32_t z = 0; z < samples; z++) {
+		sampleRow(level, origin.x, origin.y + static_cast<int32_t>(z), samples, row.data());
+		for (uint32_t cellZ = firstCell(z); cellZ <= lastCell(z); cellZ++)
+			for (uint32_t x = 0; x < samples; x++)
+				for (uint32_t cellX = firstCell(x); cellX <= lastCell(x); cellX++)
+					cellLow[cellZ * cells + cellX] = std::min(cellLow[cellZ * cells + cellX], row[x]);
+	}
+
+	// Вершина не выше ни одной из соседних ячеек: треугольники ячейки - под её отсчётами
+	float size = spacing(level);
+	occluderMesh.resize((cells + 1) * (cells + 1));
+	for (uint32_t z = 0; z <= cells; z++)
+		for (uint32_t x = 0; x <= cells; x++) {
+			float height = FLT_MAX;
+			for (uint32_t cellZ = z > 0 ? z - 1 : 0; cellZ <= std::min(z, cells - 1); cellZ++)
+				for (uint32_t cellX = x > 0 ? x - 1 : 0; cellX <= std::min(x, cells - 1); cellX++)
+					height = std::min(height, cellLow[cellZ * cells + cellX]);
+			occluderMesh[z * (cells + 1) + x] = glm::vec3((origin.x + static_cast<int32_t>(x * step)) * size, height,
+														 (origin.y + static_cast<int32_t>(z * step)) * size);
+		}
+
+	occluderTriangles.clear();
+	for (uint32_t z = 0; z < cells; z++)
+		for (uint32_t x = 0; x < cells; x++) {
+			uint32_t corner = z * (cells + 1) + x;
+			uint32_t quad[6] = {corner, corner + cells + 1, corner + 1, corner + 1, corner + cells + 1, corner + cells + 2};
+			occluderTriangles.insert(occluderTriangles.end(), quad, quad + 6);
+		}
+}
+
+void Terrain::sampleRow(uint32_t mip, int32_t x, int32_t z, uint32_t count, float* out) {
+	int32_t tileZ = floorDiv(z, TILE);
+	int32_t row = z - tileZ * TILE;
+
+	while (count > 0) {
+		int32_t tileX = floorDiv(x, TILE);
+		int32_t column = x - tileX * TILE;
+		uint32_t run = std::min<uint32_t>(count, TILE - column);
+
+		auto found = tiles.find(TileKey(mip, tileX, tileZ));
+		if (found != tiles.end() && !found->second.heights.empty()) {
+			memcpy(out, found->second.heights.data() + row * TILE + column, run * sizeof(float));
+		} else {
+			std::fill(out, out + run, 0.0f);
+		}
+		if (found != tiles.end())
+			found->second.lastUse = frame;
+		else
+			request(TileKey(mip, tileX, tileZ));
+
+		x += run;
+		out += run;
+		count -= run;
+	}
+}
+
+void Terrain::request(const TileKey& key) {
+	auto found = tiles.find(key);
+	if (found != tiles.end()) {
+		found->second.lastUse = frame;
+		return;
+	}
+	if (requested.insert(key).second)
+		requests.push_back(key);
+}
+
+void Terrain::evict() {
+	if (tiles.size() <= capacity)
+		return;
+
+	// Самые давние плитки, кроме использованных в этом кадре
+	std::vector<std::pair<uint64_t, TileKey>> order;
+	for (const auto& tile : tiles)
+		if (tile.second.lastUse < frame)
+			order.emplace_back(tile.second.lastUse, tile.first);
+	std::sort(order.begin(), order.end());
+
+	for (size_t i = 0; i < order.size() && tiles.size() > capacity; i++)
+		tiles.erase(order[i].second);
+}
+
+// Фоновый поток: чтение плиток по очереди запросов
+void Terrain::loaderLoop() {
+	PROFILE_THREAD("terrain loader");
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wake.wait(lock, [this]() { return !running || !requests.empty(); });
+		if (!running)
+			break;
+
+		TileKey key = requests.front();
+		requests.pop_front();
+
+		// Файл читается без блокировки: поток рендера тем временем выбирает высоты
+		lock.unlock();
+		Tile tile;
+		try {
+			PROFILE_SCOPE("terrain: load tile");
+			loadHeightTile(heightTilePath(directory, std::get<0>(key), std::get<1>(key), std::get<2>(key)), tile.heights);
+		} catch (const std::exception& e) {
+			std::cout << "Terrain tile skipped: " << e.what() << std::endl;
+			tile.heights.clear();
+		}
+		lock.lock();
+
+		tile.lastUse = frame;
+		tiles[key] = std::move(tile);
+		requested.erase(key);
+		arrived.push_back(key);
+	}
+}
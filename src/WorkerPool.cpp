@@ -0,0 +1,93 @@
+#include "WorkerPool.hpp"
+#include "CpuProfiler.hpp"
+
+#include <algorithm>
+
+void WorkerPool::start(uint32_t threadCount) {
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+	running = true;
+	for (uint32_t i = 0; i < threadCount; i++)
+		threads.emplace_back(&WorkerPool::workerLoop, this);
+}
+
+void WorkerPool::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wake.notify_all();
+	for (auto& thread : threads)
+		thread.join();
+	threads.clear();
+}
+
+void WorkerPool::parallelFor(uint32_t begin, uint32_t end, uint32_t grain, const Slice& slice) {
+	if (end <= begin)
+		return;
+	grain = std::max(1u, grain);
+	uint32_t count = (end - begin + grain - 1) / grain;
+
+	// Один участок или нет потоков - без передачи заданий
+	if (threads.empty() || count == 1) {
+		slice(begin, end);
+		return;
+	}
+
+	{
+		// Поток, проснувшийся к концу прошлого задания, может ещё читать его поля
+		std::unique_lock<std::mutex> lock(mutex);
+		while (active != 0) {
+			lock.unlock();
+			std::this_thread::yield();
+			lock.lock();
+		}
+
+		this->slice = &slice;
+		this->begin = begin;
+		this->end = end;
+		this->grain = grain;
+		sliceCount = count;
+		nextSlice.store(0, std::memory_order_relaxed);
+		pendingSlices.store(count, std::memory_order_relaxed);
+		generation++;
+	}
+	wake.notify_all();
+
+	runSlices();
+
+	// Оставшиеся участки короткие: ожидание без сна
+	while (pendingSlices.load(std::memory_order_acquire) != 0)
+		std::this_thread::yield();
+}
+
+void WorkerPool::runSlices() {
+	for (;;) {
+		uint32_t index = nextSlice.fetch_add(1, std::memory_order_relaxed);
+		if (index >= sliceCount)
+			return;
+		uint32_t sliceBegin = begin + index * grain;
+		(*slice)(sliceBegin, std::min(sliceBegin + grain, end));
+		pendingSlices.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void WorkerPool::workerLoop() {
+	PROFILE_THREAD("worker");
+	uint64_t seen = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		wake.wait(lock, [&] { return !running || generation != seen; });
+		if (!running)
+			return;
+		seen = generation;
+		active++;
+
+		lock.unlock();
+		runSlices();
+		lock.lock();
+
+		active--;
+	}
+}
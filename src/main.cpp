@@ -1,5 +1,5 @@
 #include "vk.hpp"
-#include <chrono>
+#include "FramePacer.hpp"
 
 #include <iostream>
 
@@ -8,10 +8,19 @@ void vkInit();
 void processInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GLFW_TRUE);
+
+    // F12 - выгрузка замеров CPU в trace.json (chrome://tracing, ui.perfetto.dev)
+    static bool dumpPressed = false;
+    bool dump = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+    if (dump && !dumpPressed && PROFILE_DUMP("trace.json"))
+        std::cout << "CPU trace written to trace.json" << std::endl;
+    dumpPressed = dump;
 }
 
 int main(int argc, char* argv[]) {
 
+	PROFILE_THREAD("main");
+
 	// Инициализация GLFW
 	glfwInit();
 
@@ -22,54 +31,63 @@ int main(int argc, char* argv[]) {
 
 		// Отключим создание контекста
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		// Отключим возможность изменения размеров окна
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+		// Размер окна можно менять: список показа пересоздаётся на лету
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 		// Создание окна
 		GLFWwindow* window = glfwCreateWindow(800, 600, "Vulkan window", nullptr, nullptr);
 
 		// Инициализация Vulkan API
 		vulkan.init(window);
 
-		// Переменные для FPS
-		auto lastTime_fps = std::chrono::high_resolution_clock::now();
-		auto lastFrameTime = lastTime_fps;
-		auto lastTime_frame = lastTime_fps;
-		int frameCount = 0;
-		float fpsUpdateInterval = 1.0f; // Обновлять FPS раз в секунду
+		// Планировщик кадров
+		FramePacer pacer;
+		const double target_fps = 144; // 0 - без ограничения
+		pacer.setTargetRate(target_fps);
+		pacer.setLatencyMode(LatencyMode::FenceBeforeInput);
+		// Внутреннее разрешение снижается, когда GPU не укладывается в период кадра
+		if (target_fps > 0)
+			vulkan.setFrameBudget(static_cast<float>(1000.0 / target_fps));
+		FrameStatistics stats;
+		std::vector<GpuScopeStatistics> gpuStats;
 
-		// Переменные для Кадра
-		const int target_fps = 1000;
-		float frameUpdateInterval = 1.0f / target_fps; // Обновлять Кадр раз в 0.01 секунду
 		// Жизненный цикл
 		while(!glfwWindowShouldClose(window)) {
-
-			auto currentTime = std::chrono::high_resolution_clock::now();
-
-			float deltaTime_frame = std::chrono::duration<float>(currentTime - lastTime_frame).count();
-			float deltaTime_fps = std::chrono::duration<float>(currentTime - lastTime_fps).count();
-			lastFrameTime = currentTime;
-
-			// Передаем дельту времени в Vulkan
-			vulkan.setDeltaTime(deltaTime_frame);
-
-			if (deltaTime_fps >= fpsUpdateInterval) {
-				std::cout << "FPS: " << frameCount << std::endl;
-				frameCount = 0;
-				// glm::vec3 temp_pos = vulkan.getCameraPos();
-				// std::cout << "Camera: (" << temp_pos.x << ", " << temp_pos.y << ", " << temp_pos.z << ")"<< std::endl;
-				lastTime_fps = currentTime;
+			{
+				PROFILE_SCOPE("pacer wait");
+				pacer.wait(); // Сон до срока кадра вместо активного ожидания
 			}
 
-			processInput(window);  // Вызываем обработчик ввода
-
-			if (deltaTime_frame >= frameUpdateInterval) {
-				vulkan.renderFrame();// Отрисовка кадра
-				frameCount++;
-				lastTime_frame = currentTime;
-			}
+			// Ввод читается после освобождения кадра GPU - меньше задержка от нажатия до изображения
+			if (pacer.latencyMode() == LatencyMode::FenceBeforeInput)
+				vulkan.waitForFrame();
 
 			glfwPollEvents();// Обработка событий
+			processInput(window);  // Вызываем обработчик ввода
 
+			// Симуляция идёт в своём потоке с фиксированным шагом, кадр только интерполирует её состояние
+			vulkan.renderFrame();// Отрисовка кадра
+
+			if (pacer.report(stats)) {
+				std::cout << "FPS: " << stats.fps
+						  << " frame: " << stats.meanMs << " ms"
+						  << " (min " << stats.minMs << ", max " << stats.maxMs
+						  << ", sd " << stats.deviationMs << ")" << std::endl;
+
+				vulkan.gpuStatistics(gpuStats);
+				for (auto& scope : gpuStats) {
+					std::cout << "  GPU " << scope.name << ": avg " << scope.avgMs << " ms"
+							  << " (min " << scope.minMs << ", p99 " << scope.p99Ms << ", max " << scope.maxMs << ")";
+					if (scope.vertexInvocations || scope.fragmentInvocations)
+						std::cout << " vs " << scope.vertexInvocations
+								  << " fs " << scope.fragmentInvocations
+								  << " clip " << scope.clippingInvocations << "/" << scope.clippingPrimitives;
+					std::cout << std::endl;
+				}
+
+				// Источники сверх CLUSTER_MAX_LIGHTS в кластере не освещают его
+				if (uint32_t overflow = vulkan.overflowedLightClusters())
+					std::cout << "  Light clusters over " << CLUSTER_MAX_LIGHTS << " lights: " << overflow << std::endl;
+			}
 		}
 
 		// Уничтожение окна
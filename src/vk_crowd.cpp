@@ -0,0 +1,202 @@
+#include "vk.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+// Шаг запекания: между кадрами шейдер интерполирует, 30 кадров в секунду достаточно
+static const float BAKE_FRAMES_PER_SECOND = 30.0f;
+static const float CROWD_BOUNDS_MARGIN = 1.25f; // сфера позы привязки не покрывает вытянутые руки и шаг
+
+// Толпа из scene.crowd экземпляров модели
+void Vulkan::createCrowd() {
+	PROFILE_FUNCTION();
+
+	// Запекание выполняется один раз: результат сохраняется рядом с моделью.
+	// Каталог модели может быть только для чтения - тогда запечённое живёт до выхода
+	std::string bakePath = scene.model + ".bake";
+	if (!loadBakedAnimations(bakePath, skeleton, clips, BAKE_FRAMES_PER_SECOND, bakedAnimations)) {
+		bakeAnimations(skeleton, clips, BAKE_FRAMES_PER_SECOND, bakedAnimations);
+		try {
+			saveBakedAnimations(bakePath, skeleton, clips, bakedAnimations);
+		} catch (const std::exception& e) {
+			std::cout << e.what() << std::endl;
+		}
+	}
+
+	// Экземпляры сеткой позади модели: клип, сдвиг и скорость случайны, дальше CPU их не трогает
+	std::vector<CrowdInstance>& instances = crowdInstances;
+	instances.resize(scene.crowd);
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const float spacing = 1.5f;
+	uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(scene.crowd))));
+	for (uint32_t i = 0; i < scene.crowd; i++) {
+		float x = (static_cast<float>(i % columns) - 0.5f * (columns - 1)) * spacing;
+		float z = -2.0f - static_cast<float>(i / columns) * spacing;
+		instances[i].placement = glm::vec4(x, 0.0f, z, unit(random) * glm::two_pi<float>());
+		instances[i].clip = i % static_cast<uint32_t>(bakedAnimations.clips.size());
+		instances[i].timeOffset = unit(random) * bakedAnimations.clips[instances[i].clip].duration;
+		instances[i].speed = 0.8f + 0.4f * unit(random);
+	}
+
+	// Ограничивающая сфера модели, общая для всех экземпляров: её проверяют оба способа отсечения
+	glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+	for (const Vertex& vertex : modelVertices) {
+		low = glm::min(low, vertex.position);
+		high = glm::max(high, vertex.position);
+	}
+	glm::vec3 center = 0.5f * (low + high);
+	float radius = 0.0f;
+	for (const Vertex& vertex : modelVertices)
+		radius = std::max(radius, glm::length(vertex.position - center));
+	crowdBounds = glm::vec4(center, radius * CROWD_BOUNDS_MARGIN);
+
+	// Постоянные данные загружаются один раз через промежуточный буфер
+	auto upload = [&](const void* data, VkDeviceSize size, VkBufferUsageFlags usage) {
+		BufferHandle staging = registry.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		memcpy(registry.map(staging), data, static_cast<size_t>(size));
+		BufferHandle buffer = registry.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		copyBuffer(registry.buffer(staging), registry.buffer(buffer), size);
+		registry.release(staging);
+		return buffer;
+	};
+	// Буфер экземпляров читает и шейдер отсечения
+	crowdInstanceBuffer = upload(instances.data(), sizeof(CrowdInstance) * instances.size(),
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	bakedRowBuffer = upload(bakedAnimations.rows.data(), sizeof(glm::vec4) * bakedAnimations.rows.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	bakedClipBuffer = upload(bakedAnimations.clips.data(), sizeof(BakedClip) * bakedAnimations.clips.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+	// Набор 1: строки палитр и таблица клипов
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	}
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &crowdSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create crowd descriptor set layout");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &crowdSetLayout;
+	if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, &crowdSet) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to allocate crowd descriptor set");
+	}
+
+	VkDescriptorBufferInfo bufferInfos[2] = {
+		{registry.buffer(bakedRowBuffer), 0, VK_WHOLE_SIZE},
+		{registry.buffer(bakedClipBuffer), 0, VK_WHOLE_SIZE}};
+	std::array<VkWriteDescriptorSet, 2> writes{};
+	for (uint32_t i = 0; i < writes.size(); i++) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = crowdSet;
+		writes[i].dstBinding = i;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].descriptorCount = 1;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	// Набор 0 общий с моделью: однородные данные кадра (время) и палитра
+	VkDescriptorSetLayout setLayouts[] = {descriptorSetLayout, crowdSetLayout};
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 2;
+	pipelineLayoutInfo.pSetLayouts = setLayouts;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &crowdPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create crowd pipeline layout");
+	}
+
+	crowdPipeline = buildCrowdPipeline();
+}
+
+// Конвейер толпы: вершины и веса модели плюс привязка экземпляров.
+// Конвейер теней - тот же вершинный шейдер без фрагментного
+VkPipeline Vulkan::buildCrowdPipeline(bool shadow) {
+	VkVertexInputBindingDescription bindings[3] = {};
+	bindings[0] = {0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX};
+	bindings[1] = {1, sizeof(SkinnedVertex), VK_VERTEX_INPUT_RATE_VERTEX};
+	bindings[2] = {2, sizeof(CrowdInstance), VK_VERTEX_INPUT_RATE_INSTANCE};
+
+	VkVertexInputAttributeDescription attributes[8] = {};
+	attributes[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)};
+	attributes[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)};
+	attributes[2] = {2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord)};
+	attributes[3] = {3, 1, VK_FORMAT_R16G16B16A16_UINT, offsetof(SkinnedVertex, joints)};
+	attributes[4] = {4, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(SkinnedVertex, weights)};
+	attributes[5] = {5, 2, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(CrowdInstance, placement)};
+	attributes[6] = {6, 2, VK_FORMAT_R32_UINT, offsetof(CrowdInstance, clip)};
+	attributes[7] = {7, 2, VK_FORMAT_R32G32_SFLOAT, offsetof(CrowdInstance, timeOffset)}; // сдвиг и скорость
+
+	VkPipelineVertexInputStateCreateInfo vertexInput{};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInput.vertexBindingDescriptionCount = 3;
+	vertexInput.pVertexBindingDescriptions = bindings;
+	vertexInput.vertexAttributeDescriptionCount = 8;
+	vertexInput.pVertexAttributeDescriptions = attributes;
+
+	if (shadow)
+		return buildShadowPipeline("build/shaders/crowd.spv", vertexInput, crowdPipelineLayout);
+	return buildGraphicsPipeline("build/shaders/crowd.spv", "build/shaders/frag.spv", &vertexInput, crowdPipelineLayout);
+}
+
+// Вся толпа - одна отрисовка с экземплярами; область просмотра уже задана проходом сцены.
+// С отсечением фаза рисует свой список экземпляров косвенной командой, число экземпляров записал GPU;
+// при отсечении на CPU - видимые экземпляры из участка кадра
+void Vulkan::recordCrowd(VkCommandBuffer commandBuffer, CullPhase phase) {
+	if (crowdPipeline == VK_NULL_HANDLE)
+		return;
+
+	bool culled = occlusionPipeline != VK_NULL_HANDLE;
+	bool cpuCulled = crowdVisibleBuffer.valid();
+	if (!culled && phase == CullPhase::Late)
+		return;
+	if (cpuCulled && crowdVisibleCount == 0)
+		return;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, crowdPipeline);
+
+	BufferHandle instances = cpuCulled ? crowdVisibleBuffer : !culled ? crowdInstanceBuffer :
+							phase == CullPhase::Early ? crowdEarlyBuffer : crowdLateBuffer;
+	VkBuffer vertexBuffers[] = {registry.buffer(modelVertexBuffer), registry.buffer(modelSkinBuffer), registry.buffer(instances)};
+	VkDeviceSize offsets[] = {0, 0, cpuCulled ? crowdVisibleOffset : 0};
+	vkCmdBindVertexBuffers(commandBuffer, 0, 3, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, registry.buffer(modelIndexBuffer), 0, VK_INDEX_TYPE_UINT32);
+
+	VkDescriptorSet sets[] = {descriptorSet, crowdSet};
+	uint32_t dynamicOffsets[] = {sceneUniformOffset, paletteOffset};
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, crowdPipelineLayout,
+							0, 2, sets, 2, dynamicOffsets);
+
+	if (culled) {
+		VkDeviceSize offset = static_cast<uint32_t>(phase) * sizeof(VkDrawIndexedIndirectCommand);
+		vkCmdDrawIndexedIndirect(commandBuffer, registry.buffer(crowdDrawBuffer), offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+	} else {
+		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(modelIndices.size()), cpuCulled ? crowdVisibleCount : scene.crowd, 0, 0, 0);
+	}
+}
+
+void Vulkan::destroyCrowd() {
+	if (crowdPipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(logicalDevice, crowdPipeline, nullptr);
+	if (crowdPipelineLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(logicalDevice, crowdPipelineLayout, nullptr);
+	if (crowdSetLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(logicalDevice, crowdSetLayout, nullptr);
+}
@@ -0,0 +1,146 @@
+#include "vk.hpp"
+
+#include <stdexcept>
+
+// Вершина сетки в буфере: высота и нормаль, упакованная октаэдрически в 2 x snorm16.
+// Положение в плоскости XZ не хранится - оно следует из номера вершины
+typedef struct _HeightfieldVertex
+{
+	float height;
+	uint32_t normal;
+} HeightfieldVertex;
+
+// Push-константы обеих стадий
+typedef struct _HeightfieldParams
+{
+	uint32_t size; // вершин по стороне
+	float spacing; // шаг сетки в метрах
+	float time;
+} HeightfieldParams;
+
+static const float HEIGHTFIELD_EXTENT = 64.0f; // сторона сетки в метрах при любом числе вершин
+static const uint32_t HEIGHTFIELD_GROUP = 16; // сторона рабочей группы heightfield.comp
+
+void Vulkan::createHeightfield() {
+	PROFILE_FUNCTION();
+
+	// Буфер только для GPU: CPU не пишет в него ни при создании, ни в кадре
+	VkDeviceSize size = sizeof(HeightfieldVertex) * scene.heightfield * scene.heightfield;
+	heightfieldBuffer = registry.createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	tracker.trackBuffer(registry.buffer(heightfieldBuffer));
+	renderGraph.bindBuffer(heightfieldResource, registry.buffer(heightfieldBuffer));
+
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &heightfieldSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create heightfield descriptor set layout");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &heightfieldSetLayout;
+	if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, &heightfieldSet) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to allocate heightfield descriptor set");
+	}
+
+	VkDescriptorBufferInfo bufferInfo = {registry.buffer(heightfieldBuffer), 0, VK_WHOLE_SIZE};
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = heightfieldSet;
+	write.dstBinding = 0;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.descriptorCount = 1;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+
+	// Вычислительный конвейер: только буфер сетки
+	VkPushConstantRange computeRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HeightfieldParams)};
+	VkPipelineLayoutCreateInfo computeLayoutInfo{};
+	computeLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	computeLayoutInfo.setLayoutCount = 1;
+	computeLayoutInfo.pSetLayouts = &heightfieldSetLayout;
+	computeLayoutInfo.pushConstantRangeCount = 1;
+	computeLayoutInfo.pPushConstantRanges = &computeRange;
+	if (vkCreatePipelineLayout(logicalDevice, &computeLayoutInfo, nullptr, &heightfieldComputeLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create heightfield compute pipeline layout");
+	}
+
+	// Графический конвейер: набор 0 общий с моделью (матрицы камеры), набор 1 - буфер сетки
+	VkDescriptorSetLayout setLayouts[] = {descriptorSetLayout, heightfieldSetLayout};
+	VkPushConstantRange vertexRange = {VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(HeightfieldParams)};
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 2;
+	pipelineLayoutInfo.pSetLayouts = setLayouts;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &vertexRange;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &heightfieldPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create heightfield pipeline layout");
+	}
+
+	heightfieldComputePipeline = buildComputePipeline("build/shaders/heightfield_comp.spv", heightfieldComputeLayout);
+	heightfieldPipeline = buildHeightfieldPipeline();
+}
+
+// Без вершинных привязок: вершинный шейдер читает буфер сетки по номерам вершины и экземпляра
+VkPipeline Vulkan::buildHeightfieldPipeline() {
+	VkPipelineVertexInputStateCreateInfo vertexInput{};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	return buildGraphicsPipeline("build/shaders/heightfield_vert.spv", "build/shaders/heightfield_frag.spv",
+								&vertexInput, heightfieldPipelineLayout, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+}
+
+// Вычислительный проход графа: поток на вершину
+void Vulkan::recordHeightfieldUpdate(VkCommandBuffer commandBuffer) {
+	HeightfieldParams params = {scene.heightfield, HEIGHTFIELD_EXTENT / (scene.heightfield - 1), animationTime};
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, heightfieldComputePipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, heightfieldComputeLayout,
+							0, 1, &heightfieldSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, heightfieldComputeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+
+	uint32_t groups = (scene.heightfield + HEIGHTFIELD_GROUP - 1) / HEIGHTFIELD_GROUP;
+	vkCmdDispatch(commandBuffer, groups, groups, 1);
+}
+
+// Ряд ячеек - экземпляр, полоса из 2 * size вершин; область просмотра уже задана проходом сцены
+void Vulkan::recordHeightfield(VkCommandBuffer commandBuffer) {
+	if (heightfieldPipeline == VK_NULL_HANDLE)
+		return;
+
+	HeightfieldParams params = {scene.heightfield, HEIGHTFIELD_EXTENT / (scene.heightfield - 1), animationTime};
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, heightfieldPipeline);
+
+	VkDescriptorSet sets[] = {descriptorSet, heightfieldSet};
+	uint32_t dynamicOffsets[] = {sceneUniformOffset, paletteOffset};
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, heightfieldPipelineLayout,
+							0, 2, sets, 2, dynamicOffsets);
+	vkCmdPushConstants(commandBuffer, heightfieldPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(params), &params);
+
+	vkCmdDraw(commandBuffer, 2 * scene.heightfield, scene.heightfield - 1, 0, 0);
+}
+
+void Vulkan::destroyHeightfield() {
+	if (heightfieldPipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(logicalDevice, heightfieldPipeline, nullptr);
+	if (heightfieldComputePipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(logicalDevice, heightfieldComputePipeline, nullptr);
+	if (heightfieldPipelineLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(logicalDevice, heightfieldPipelineLayout, nullptr);
+	if (heightfieldComputeLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(logicalDevice, heightfieldComputeLayout, nullptr);
+	if (heightfieldSetLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(logicalDevice, heightfieldSetLayout, nullptr);
+}
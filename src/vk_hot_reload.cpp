@@ -0,0 +1,165 @@
+#include "vk.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+
+#include <stb_image.h>
+
+// Регистрация отслеживаемых шейдеров и текстур
+void Vulkan::setupHotReload() {
+	PipelineBuild model = {&graphicsPipeline, [this]() { return buildGraphicsPipeline("build/shaders/vert.spv", "build/shaders/frag.spv"); }};
+	PipelineBuild crowd = {&crowdPipeline, [this]() { return buildCrowdPipeline(); }};
+	PipelineBuild field = {&heightfieldPipeline, [this]() { return buildHeightfieldPipeline(); }};
+	PipelineBuild fieldUpdate = {&heightfieldComputePipeline, [this]() {
+		return buildComputePipeline("build/shaders/heightfield_comp.spv", heightfieldComputeLayout); }};
+
+	// Фрагментный шейдер модели общий с толпой
+	std::vector<PipelineBuild> fragmentUsers = {model};
+	if (crowdPipeline != VK_NULL_HANDLE)
+		fragmentUsers.push_back(crowd);
+
+	watchShader("shaders/shader.vert", "build/shaders/vert.spv", {model});
+	watchShader("shaders/shader.frag", "build/shaders/frag.spv", fragmentUsers);
+	if (crowdPipeline != VK_NULL_HANDLE) {
+		std::vector<PipelineBuild> crowdUsers = {crowd};
+		if (crowdShadowPipeline != VK_NULL_HANDLE)
+			crowdUsers.push_back({&crowdShadowPipeline, [this]() { return buildCrowdPipeline(true); }});
+		watchShader("shaders/crowd.vert", "build/shaders/crowd.spv", crowdUsers);
+	}
+	if (shadowPipeline != VK_NULL_HANDLE) {
+		PipelineBuild modelShadow = {&shadowPipeline, [this]() { return buildModelShadowPipeline(); }};
+		watchShader("shaders/shadow.vert", "build/shaders/shadow.spv", {modelShadow});
+	}
+	if (heightfieldPipeline != VK_NULL_HANDLE) {
+		watchShader("shaders/heightfield.comp", "build/shaders/heightfield_comp.spv", {fieldUpdate});
+		watchShader("shaders/heightfield.vert", "build/shaders/heightfield_vert.spv", {field});
+		watchShader("shaders/heightfield.frag", "build/shaders/heightfield_frag.spv", {field});
+	}
+	if (occlusionPipeline != VK_NULL_HANDLE) {
+		PipelineBuild pyramid = {&depthPyramidPipeline, [this]() {
+			return buildComputePipeline("build/shaders/depth_pyramid.spv", depthPyramidLayout); }};
+		PipelineBuild cull = {&occlusionPipeline, [this]() {
+			return buildComputePipeline("build/shaders/occlusion_cull.spv", occlusionLayout); }};
+		watchShader("shaders/depth_pyramid.comp", "build/shaders/depth_pyramid.spv", {pyramid});
+		watchShader("shaders/occlusion_cull.comp", "build/shaders/occlusion_cull.spv", {cull});
+	}
+	if (lightCullPipeline != VK_NULL_HANDLE) {
+		PipelineBuild lightCull = {&lightCullPipeline, [this]() {
+			return buildComputePipeline("build/shaders/light_cull.spv", lightCullLayout); }};
+		watchShader("shaders/light_cull.comp", "build/shaders/light_cull.spv", {lightCull});
+	}
+	if (terrainPipeline != VK_NULL_HANDLE) {
+		PipelineBuild clipmap = {&terrainPipeline, [this]() { return buildTerrainPipeline(); }};
+		std::vector<PipelineBuild> vertexUsers = {clipmap};
+		if (terrainShadowPipeline != VK_NULL_HANDLE)
+			vertexUsers.push_back({&terrainShadowPipeline, [this]() { return buildTerrainPipeline(true); }});
+		watchShader("shaders/terrain.vert", "build/shaders/terrain_vert.spv", vertexUsers);
+		watchShader("shaders/terrain.frag", "build/shaders/terrain_frag.spv", {clipmap});
+	}
+
+	if (particlePipeline != VK_NULL_HANDLE) {
+		std::pair<const char*, VkPipeline*> stages[] = {
+			{"particle_kickoff", &particleKickoffPipeline}, {"particle_emit", &particleEmitPipeline},
+			{"particle_simulate", &particleSimulatePipeline}, {"particle_compact", &particleCompactPipeline}};
+		for (const auto& stage : stages) {
+			std::string name = stage.first;
+			PipelineBuild build = {stage.second, [this, name]() {
+				return buildComputePipeline(("build/shaders/" + name + ".spv").c_str(), particleComputeLayout); }};
+			watchShader(("shaders/" + name + ".comp").c_str(), ("build/shaders/" + name + ".spv").c_str(), {build});
+		}
+		if (particleSortPipeline != VK_NULL_HANDLE) {
+			PipelineBuild sort = {&particleSortPipeline, [this]() {
+				return buildComputePipeline("build/shaders/particle_sort.spv", particleSortLayout); }};
+			watchShader("shaders/particle_sort.comp", "build/shaders/particle_sort.spv", {sort});
+		}
+		PipelineBuild sprites = {&particlePipeline, [this]() { return buildParticlePipeline(); }};
+		watchShader("shaders/particle.vert", "build/shaders/particle_vert.spv", {sprites});
+		watchShader("shaders/particle.frag", "build/shaders/particle_frag.spv", {sprites});
+	}
+
+	// Диффузная текстура модели
+	hotReload.watch(scene.texture, [this]() -> HotReload::Commit {
+		// Чтение и распаковка изображения в фоновом потоке
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load(scene.texture.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		if (!pixels) {
+			std::cout << "Unable to reload texture image" << std::endl;
+			return HotReload::Commit();
+		}
+		VkDeviceSize imageSize = texWidth * texHeight * 4;
+
+		// Промежуточный буфер и новое изображение создаются здесь же: реестр допускает это из любого потока
+		BufferHandle stagingBuffer = registry.createBuffer(imageSize,
+					VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		memcpy(registry.map(stagingBuffer), pixels, static_cast<size_t>(imageSize));
+		stbi_image_free(pixels);
+
+		ImageHandle image = registry.createImage(texWidth, texHeight,
+					VK_FORMAT_R8G8B8A8_SRGB,
+					VK_IMAGE_TILING_OPTIMAL,
+					VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		ImageViewHandle imageView = registry.createImageView(image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		uint32_t width = static_cast<uint32_t>(texWidth);
+		uint32_t height = static_cast<uint32_t>(texHeight);
+		return [=](VkCommandBuffer commandBuffer) {
+			if (commandBuffer == VK_NULL_HANDLE) {
+				registry.destroyNow(imageView);
+				registry.destroyNow(image);
+				registry.destroyNow(stagingBuffer);
+				return;
+			}
+
+			// Загрузка записывается в буфер команд кадра перед проходом рендера - без ожидания очереди
+			recordTextureUpload(commandBuffer, registry.buffer(stagingBuffer), registry.image(image), width, height);
+
+			// Наборы сцены кадров в работе ещё ссылаются на старую текстуру: каждый слот переписывает
+			// свой набор (updateSceneSet), когда его прошлый кадр выполнен. Новых наборов не выделяется
+			registry.release(textureImageView);
+			registry.release(textureImage);
+			registry.release(stagingBuffer); // используется загрузкой этого кадра
+			textureImage = image;
+			textureImageView = imageView;
+		};
+	});
+}
+
+// Шейдер перекомпилируется, а конвейеры, которые его используют, собираются заново
+void Vulkan::watchShader(const char * source, const char * binary, const std::vector<PipelineBuild>& users) {
+	std::string sourcePath = source;
+	std::string binaryPath = binary;
+
+	hotReload.watch(sourcePath, [this, sourcePath, binaryPath, users]() -> HotReload::Commit {
+		if (!compileShader(sourcePath, binaryPath))
+			return HotReload::Commit();
+
+		// Новые конвейеры собираются все или ни одного
+		std::vector<VkPipeline> pipelines;
+		try {
+			for (const PipelineBuild& user : users)
+				pipelines.push_back(user.second());
+		} catch (...) {
+			for (VkPipeline pipeline : pipelines)
+				vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+			throw;
+		}
+
+		return [this, users, pipelines](VkCommandBuffer commandBuffer) {
+			for (size_t i = 0; i < users.size(); i++) {
+				if (commandBuffer == VK_NULL_HANDLE) {
+					vkDestroyPipeline(logicalDevice, pipelines[i], nullptr);
+					continue;
+				}
+
+				VkPipeline oldPipeline = *users[i].first;
+				registry.release([=]() {
+					vkDestroyPipeline(logicalDevice, oldPipeline, nullptr);
+				});
+				*users[i].first = pipelines[i];
+			}
+		};
+	});
+}
@@ -5,6 +5,7 @@
 #include <vector>
 #include <stdexcept>
 #include <array>  // Для std::array
+#include <algorithm>
 
 #include "macroses.hpp"
 
@@ -15,35 +16,112 @@
 
 // инициализация
 void Vulkan::init(GLFWwindow* window) {
+	PROFILE_FUNCTION();
+	PROFILE_PHASES(phase, "init: device");
 	this->window = window;
+	glfwSetWindowUserPointer(window, this);
+	glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
 	createInstance(); // Создание экземпяра
 	createWindowSurface(window); // Создание поверхности
 	// Расширения для устройства: имена задаются внутри фигурных скобок в кавычках
 	std::vector<const char*> deviceExtensions({"VK_KHR_swapchain"});
 	selectPhysicalDevice(deviceExtensions); // Выбор физического устройства
 	createLogicalDevice(deviceExtensions); // Создание физического устройства
+	PROFILE_NEXT(phase, "init: swapchain");
 	createSwapchain(window); // Создание списка показа
+	PROFILE_NEXT(phase, "init: resources");
+	initResources();
+}
+
+// Инициализация без окна: ни GLFW, ни поверхности, ни VK_KHR_swapchain.
+// Подходит для CI и программных реализаций (lavapipe)
+void Vulkan::initHeadless(uint32_t width, uint32_t height) {
+	PROFILE_FUNCTION();
+	PROFILE_PHASES(phase, "init: device");
+	headless = true;
+	window = nullptr;
+	surface.surface = VK_NULL_HANDLE;
+	surface.selectedExtent = {width, height};
+	surface.selectedFormat = {VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+	createInstance();
+	std::vector<const char*> deviceExtensions;
+	selectPhysicalDevice(deviceExtensions);
+	createLogicalDevice(deviceExtensions);
+	PROFILE_NEXT(phase, "init: resources");
+	initResources();
+}
+
+// Общая часть: всё, что не зависит от способа вывода кадров
+void Vulkan::initResources() {
+	PROFILE_FUNCTION();
+	PROFILE_PHASES(phase, "init: render graph");
+	cameraPos = scene.cameraPos;
+	cameraFront = scene.cameraFront;
+	workers.start(); // Параллельные участки работы кадра
+	modelNode = sceneGraph.create(); // Узел модели в графе сцены
+
+	timeline.init(logicalDevice, queue.descriptor); // Временная шкала очереди
+	registry.init(logicalDevice, physicalDevice.memory, &timeline); // Реестр ресурсов
 	createCommandPool(); // Создание пула команд
-    createDepthResources(); // Добавить эту строку
-	createRenderpass(); // Создание проходов рендера
-	createFramebuffers(); // Создание буферов кадра
+	if (headless)
+		createOffscreenTargets(); // Вместо изображений списка показа
+	profiler.init(logicalDevice, physicalDevice.properties,
+				physicalDevice.queueFamilyProperties[queue.index].timestampValidBits,
+				physicalDevice.features.pipelineStatisticsQuery, states.FRAMES_IN_FLIGHT); // Профилировщик GPU
+	renderGraph.init(logicalDevice, &registry, &tracker, states.DYNAMIC_RENDERING);
+	renderGraph.setProfiler(&profiler); // Замер каждого прохода
+	capture.init(&registry, &tracker, &timeline); // Потоки кодирования захваченных кадров
+	resolution.setBounds(glm::vec2(states.MIN_RENDER_SCALE), glm::vec2(states.MAX_RENDER_SCALE));
+	buildRenderGraph(); // Проходы кадра, глубина и проходы рендера
+	PROFILE_NEXT(phase, "init: pipelines");
 	createDescriptorSetLayout(); // <- Добавляем эту строку
 	createGraphicPipeline(); // Создание графического конвейера
+	PROFILE_NEXT(phase, "init: resources");
 	createTextureImage();
-	createVertexBuffer(); // Создание буфера вершин
-	createIndexBuffer(); // Создание буфера индексов
 	createUniformBuffer(); // <- Добавляем эту строку
 	createDescriptorPool();    // Добавьте эту строку
-	createDescriptorSet();     // Добавьте эту строку
+	createLights(); // Источники и буферы кластеров: набор 0 ссылается на них
+	createShadows(); // Карта теней: набор 0 читает её
 	createSyncObjects(); // Создание объектов синхронизации
-	loadModel("models/Model.fbx"); // Укажите путь к модели
+	createFrameContexts(); // Кадры в работе
+	createDescriptorSet(); // Набор сцены каждого кадра
+	PROFILE_NEXT(phase, "init: model");
+	loadModel(scene.model); // Укажите путь к модели
+	for (const std::string& path : scene.animations)
+		loadAnimations(path);
     createModelBuffers();
+	animator.init(&skeleton, &clips);
+	modelAnimation = animator.add(0); // Первый клип по кругу; без клипов - поза привязки
+	if (scene.crowd > 0)
+		createCrowd(); // Экземпляры с запечённой анимацией
+	if (scene.crowd > 0 && states.OCCLUSION_CULLING)
+		createOcclusion(); // Двухфазное отсечение толпы по пирамиде глубины
+	else if (scene.crowd > 0 && states.CPU_OCCLUSION_CULLING)
+		createCpuOcclusion(); // Отсечение толпы программным растеризатором
+	if (scene.heightfield > 1)
+		createHeightfield(); // Сетка высот, обновляемая вычислительным проходом
+	if (!scene.terrain.empty())
+		createTerrain(); // Клипмап ландшафта и чтение плиток
+	createShadowPipelines(); // Глубина модели, толпы и ландшафта в каскады
+	if (scene.particles > 0)
+		createParticles(); // Пул частиц, списки и вычислительные проходы
+	PROFILE_NEXT(phase, "init: threads");
+
+	// Запуск симуляции: шаг не зависит от частоты кадров
+	simulation.start({cameraPos, cameraFront, cameraUp, animationTime});
+
+	// Запуск горячей перезагрузки шейдеров и текстур
+	if (states.HOT_RELOAD && !headless) {
+		setupHotReload();
+		hotReload.start();
+	}
 }
 
 void Vulkan::createTextureImage() {
+    PROFILE_FUNCTION();
     // 1. Загрузка изображения из файла
     int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load("models/ork_body_D.png", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    stbi_uc* pixels = stbi_load(scene.texture.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
     VkDeviceSize imageSize = texWidth * texHeight * 4; // 4 байта на пиксель (RGBA)
 
     if (!pixels) {
@@ -51,95 +129,42 @@ void Vulkan::createTextureImage() {
     }
 
     // 2. Создание промежуточного буфера
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(imageSize,
+    BufferHandle stagingBuffer = registry.createBuffer(imageSize,
                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                stagingBuffer,
-                stagingBufferMemory);
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     // 3. Копирование данных в буфер
-    void* data;
-    vkMapMemory(logicalDevice, stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vkUnmapMemory(logicalDevice, stagingBufferMemory);
+    memcpy(registry.map(stagingBuffer), pixels, static_cast<size_t>(imageSize));
 
     // 4. Освобождение памяти изображения
     stbi_image_free(pixels);
 
     // 5. Создание VkImage для текстуры
-    createImage(texWidth, texHeight,
+    textureImage = registry.createImage(texWidth, texHeight,
                VK_FORMAT_R8G8B8A8_SRGB,
                VK_IMAGE_TILING_OPTIMAL,
                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-               textureImage,
-               textureImageMemory);
-
-    // 6. Переход изображения в оптимальный layout для копирования
-    transitionImageLayout(textureImage,
-                         VK_FORMAT_R8G8B8A8_SRGB,
-                         VK_IMAGE_LAYOUT_UNDEFINED,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    // 7. Копирование из буфера в изображение
-    copyBufferToImage(stagingBuffer,
-                     textureImage,
-                     static_cast<uint32_t>(texWidth),
-                     static_cast<uint32_t>(texHeight));
-
-    // 8. Переход в layout для шейдерного чтения
-    transitionImageLayout(textureImage,
-                         VK_FORMAT_R8G8B8A8_SRGB,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    // 9. Очистка staging буферов
-    vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-    vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
-
-    // 10. Создание image view
-    createImageView(textureImage,
-                   VK_FORMAT_R8G8B8A8_SRGB,
-                   VK_IMAGE_ASPECT_COLOR_BIT,
-                   &textureImageView);
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    // 11. Создание сэмплера текстуры
-    createTextureSampler();
-}
+    // 6. Копирование в изображение со сменой раскладок - одна отправка вместо трёх
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    recordTextureUpload(commandBuffer,
+                       registry.buffer(stagingBuffer),
+                       registry.image(textureImage),
+                       static_cast<uint32_t>(texWidth),
+                       static_cast<uint32_t>(texHeight));
+    endSingleTimeCommands(commandBuffer);
 
-uint32_t Vulkan::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice.device, &memProperties);
+    // 7. Очистка staging буферов
+    registry.release(stagingBuffer);
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) &&
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-
-    throw std::runtime_error("failed to find suitable memory type!");
-}
+    // 8. Создание image view
+    textureImageView = registry.createImageView(textureImage,
+                   VK_FORMAT_R8G8B8A8_SRGB,
+                   VK_IMAGE_ASPECT_COLOR_BIT);
 
-void Vulkan::createImageView(VkImage image, VkFormat format,
-                           VkImageAspectFlags aspectFlags,
-                           VkImageView* imageView) {
-    VkImageViewCreateInfo viewInfo{};
-    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image = image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = format;
-    viewInfo.subresourceRange.aspectMask = aspectFlags;
-    viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
-    viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
-
-    if (vkCreateImageView(logicalDevice, &viewInfo, nullptr, imageView) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create texture image view!");
-    }
+    // 9. Создание сэмплера текстуры
+    createTextureSampler();
 }
 
 VkCommandBuffer Vulkan::beginSingleTimeCommands() {
@@ -164,130 +189,19 @@ VkCommandBuffer Vulkan::beginSingleTimeCommands() {
 void Vulkan::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
     vkEndCommandBuffer(commandBuffer);
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(queue.descriptor, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(queue.descriptor);
+    // Ожидание только этой отправки, а не всей очереди
+    timeline.wait(timeline.submit(commandBuffer));
 
     vkFreeCommandBuffers(logicalDevice, commandPool, 1, &commandBuffer);
 }
 
-void Vulkan::createImage(uint32_t width, uint32_t height, VkFormat format,
-                        VkImageTiling tiling, VkImageUsageFlags usage,
-                        VkMemoryPropertyFlags properties,
-                        VkImage& image, VkDeviceMemory& imageMemory) {
-    VkImageCreateInfo imageInfo{};
-    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.extent.width = width;
-    imageInfo.extent.height = height;
-    imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
-    imageInfo.format = format;
-    imageInfo.tiling = tiling;
-    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = usage;
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateImage(logicalDevice, &imageInfo, nullptr, &image) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create image!");
-    }
-
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(logicalDevice, image, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate image memory!");
-    }
-
-    vkBindImageMemory(logicalDevice, image, imageMemory, 0);
-}
-
-void Vulkan::transitionImageLayout(VkImage image, VkFormat format,
-                                 VkImageLayout oldLayout, VkImageLayout newLayout) {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-
-    // Определяем aspect mask в зависимости от формата
-    if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-        if (format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT) {
-            barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-        }
-    } else {
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    }
-
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
-        newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
-    else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-             newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-    else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
-             newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
-                               VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    }
-    else {
-        throw std::invalid_argument("unsupported layout transition!");
-    }
-
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        sourceStage, destinationStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
-
-    endSingleTimeCommands(commandBuffer);
-}
-
-void Vulkan::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+// Запись загрузки текстуры из промежуточного буфера; барьеры строит трекер состояний
+void Vulkan::recordTextureUpload(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
+    tracker.trackImage(image, VK_IMAGE_ASPECT_COLOR_BIT);
+    tracker.use(image, ResourceUsage::TransferDst);
+    tracker.flush(commandBuffer);
 
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     region.imageSubresource.mipLevel = 0;
     region.imageSubresource.baseArrayLayer = 0;
@@ -295,16 +209,10 @@ void Vulkan::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, u
     region.imageOffset = {0, 0, 0};
     region.imageExtent = {width, height, 1};
 
-    vkCmdCopyBufferToImage(
-        commandBuffer,
-        buffer,
-        image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &region
-    );
+    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 
-    endSingleTimeCommands(commandBuffer);
+    tracker.use(image, ResourceUsage::FragmentShaderRead);
+    tracker.flush(commandBuffer);
 }
 
 void Vulkan::createTextureSampler() {
@@ -315,8 +223,8 @@ void Vulkan::createTextureSampler() {
     samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
     samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
     samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.anisotropyEnable = VK_TRUE;
-    samplerInfo.maxAnisotropy = 16.0f;
+    samplerInfo.anisotropyEnable = physicalDevice.features.samplerAnisotropy; // программные реализации могут её не иметь
+    samplerInfo.maxAnisotropy = std::min(16.0f, physicalDevice.properties.limits.maxSamplerAnisotropy);
     samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     samplerInfo.unnormalizedCoordinates = VK_FALSE;
     samplerInfo.compareEnable = VK_FALSE;
@@ -333,68 +241,64 @@ void Vulkan::createModelBuffers() {
     VkDeviceSize vertexBufferSize = sizeof(Vertex) * modelVertices.size();
 
     // Создаем промежуточный буфер (staging)
-    VkBuffer stagingVertexBuffer;
-    VkDeviceMemory stagingVertexBufferMemory;
-    createBuffer(vertexBufferSize,
+    BufferHandle stagingVertexBuffer = registry.createBuffer(vertexBufferSize,
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingVertexBuffer, stagingVertexBufferMemory);
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     // Копируем данные в staging буфер
-    void* vertexData;
-    vkMapMemory(logicalDevice, stagingVertexBufferMemory, 0, vertexBufferSize, 0, &vertexData);
-    memcpy(vertexData, modelVertices.data(), vertexBufferSize);
-    vkUnmapMemory(logicalDevice, stagingVertexBufferMemory);
+    memcpy(registry.map(stagingVertexBuffer), modelVertices.data(), vertexBufferSize);
 
     // Создаем конечный vertex buffer на GPU
-    createBuffer(vertexBufferSize,
+    modelVertexBuffer = registry.createBuffer(vertexBufferSize,
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        modelVertexBuffer, modelVertexBufferMemory);
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     // Копируем из staging в GPU буфер
-    copyBuffer(stagingVertexBuffer, modelVertexBuffer, vertexBufferSize);
+    copyBuffer(registry.buffer(stagingVertexBuffer), registry.buffer(modelVertexBuffer), vertexBufferSize);
+
+    // Поток скиннинга - вторая привязка вершин
+    VkDeviceSize skinBufferSize = sizeof(SkinnedVertex) * modelSkin.size();
+    BufferHandle stagingSkinBuffer = registry.createBuffer(skinBufferSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    memcpy(registry.map(stagingSkinBuffer), modelSkin.data(), skinBufferSize);
+    modelSkinBuffer = registry.createBuffer(skinBufferSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    copyBuffer(registry.buffer(stagingSkinBuffer), registry.buffer(modelSkinBuffer), skinBufferSize);
 
     // 2. Index Buffer (аналогично)
     VkDeviceSize indexBufferSize = sizeof(uint32_t) * modelIndices.size();
 
-    VkBuffer stagingIndexBuffer;
-    VkDeviceMemory stagingIndexBufferMemory;
-    createBuffer(indexBufferSize,
+    BufferHandle stagingIndexBuffer = registry.createBuffer(indexBufferSize,
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingIndexBuffer, stagingIndexBufferMemory);
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    void* indexData;
-    vkMapMemory(logicalDevice, stagingIndexBufferMemory, 0, indexBufferSize, 0, &indexData);
-    memcpy(indexData, modelIndices.data(), indexBufferSize);
-    vkUnmapMemory(logicalDevice, stagingIndexBufferMemory);
+    memcpy(registry.map(stagingIndexBuffer), modelIndices.data(), indexBufferSize);
 
-    createBuffer(indexBufferSize,
+    modelIndexBuffer = registry.createBuffer(indexBufferSize,
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        modelIndexBuffer, modelIndexBufferMemory);
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    copyBuffer(stagingIndexBuffer, modelIndexBuffer, indexBufferSize);
+    copyBuffer(registry.buffer(stagingIndexBuffer), registry.buffer(modelIndexBuffer), indexBufferSize);
 
     // 3. Очищаем staging буферы
-    vkDestroyBuffer(logicalDevice, stagingVertexBuffer, nullptr);
-    vkFreeMemory(logicalDevice, stagingVertexBufferMemory, nullptr);
-    vkDestroyBuffer(logicalDevice, stagingIndexBuffer, nullptr);
-    vkFreeMemory(logicalDevice, stagingIndexBufferMemory, nullptr);
+    registry.release(stagingVertexBuffer);
+    registry.release(stagingSkinBuffer);
+    registry.release(stagingIndexBuffer);
 }
 
 
 void Vulkan::createUniformBuffer() {
-	VkDeviceSize bufferSize = sizeof(glm::mat4) * 3 + sizeof(float) + sizeof(int); // model, view, proj + time
+	// model, view, proj + time + освещение (writeLightingUniforms) + солнце и каскады теней (updateShadows)
+	uniformSize = sizeof(glm::mat4) * 3 + 8 * sizeof(float) + 2 * sizeof(glm::vec4) + SHADOW_CASCADES * sizeof(glm::mat4);
+	paletteSize = sizeof(glm::mat4) * MAX_JOINTS; // палитра суставов
 
-	createBuffer(bufferSize,
+	// Один буфер на все кадры в работе, у каждого кадра свой участок
+	const VkDeviceSize arenaSize = 64 * 1024;
+	uniformBuffer = registry.createBuffer(arenaSize * states.FRAMES_IN_FLIGHT,
 			   VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			   uniformBuffer,
-			   uniformBufferMemory);
-
-	vkMapMemory(logicalDevice, uniformBufferMemory, 0, bufferSize, 0, &uniformBufferMapped);
+			   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 }
 
 void Vulkan::createDescriptorSetLayout() {
@@ -403,11 +307,19 @@ void Vulkan::createDescriptorSetLayout() {
     // Uniform buffer (binding 0)
     VkDescriptorSetLayoutBinding uboLayoutBinding{};
     uboLayoutBinding.binding = 0;
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; // смещение задаётся кадром
     uboLayoutBinding.descriptorCount = 1;
     uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
     bindings.push_back(uboLayoutBinding);
 
+    // Палитра суставов (binding 2): своё динамическое смещение
+    VkDescriptorSetLayoutBinding paletteLayoutBinding{};
+    paletteLayoutBinding.binding = 2;
+    paletteLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    paletteLayoutBinding.descriptorCount = 1;
+    paletteLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    bindings.push_back(paletteLayoutBinding);
+
     // Texture sampler (binding 1)
     VkDescriptorSetLayoutBinding samplerLayoutBinding{};
     samplerLayoutBinding.binding = 1;
@@ -416,6 +328,24 @@ void Vulkan::createDescriptorSetLayout() {
     samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
     bindings.push_back(samplerLayoutBinding);
 
+    // Источники, кластеры и общий список индексов освещения (binding 3-5)
+    for (uint32_t binding = 3; binding <= 5; binding++) {
+        VkDescriptorSetLayoutBinding lightLayoutBinding{};
+        lightLayoutBinding.binding = binding;
+        lightLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        lightLayoutBinding.descriptorCount = 1;
+        lightLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings.push_back(lightLayoutBinding);
+    }
+
+    // Карта теней: слой на каскад, сэмплер сравнения (binding 6)
+    VkDescriptorSetLayoutBinding shadowLayoutBinding{};
+    shadowLayoutBinding.binding = 6;
+    shadowLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    shadowLayoutBinding.descriptorCount = 1;
+    shadowLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings.push_back(shadowLayoutBinding);
+
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
@@ -426,65 +356,111 @@ void Vulkan::createDescriptorSetLayout() {
     }
 }
 
+// Изменение размера окна: список показа пересоздаётся в начале следующего кадра
+void Vulkan::framebufferResizeCallback(GLFWwindow* window, [[maybe_unused]] int width, [[maybe_unused]] int height) {
+	Vulkan* vulkan = static_cast<Vulkan*>(glfwGetWindowUserPointer(window));
+	vulkan->framebufferResized = true;
+}
+
+// Пересоздание списка показа, его видов, глубины и буферов кадра без полной переинициализации.
+// Конвейеры остаются действительными: область просмотра и отсечение - динамические состояния
+void Vulkan::recreateSwapchain() {
+	// Свёрнутое окно: ждём, пока у поверхности снова появится площадь
+	int width = 0, height = 0;
+	glfwGetFramebufferSize(window, &width, &height);
+	while (width == 0 || height == 0) {
+		glfwWaitEvents();
+		glfwGetFramebufferSize(window, &width, &height);
+	}
+	framebufferResized = false;
+
+	// Шкала покрывает работу GPU, но не показ: семафоры окончания рендера и сам список
+	// могут быть ещё заняты показом. Они живут до первого показа из нового списка
+	std::vector<VkImage> oldImages = swapChainImages;
+	retiredSwapchains.push_back({swapChain, swapChainImageViews, renderFinishedSemaphores});
+
+	createSwapchain(window);
+
+	for (auto image : oldImages)
+		tracker.forget(image);
+
+	createSyncObjects(); // Семафоры и значения шкалы по новым изображениям
+	buildRenderGraph(); // Глубина и буферы кадра нового размера
+
+	// Всё освобождённое использовалось только уже отправленными кадрами
+	registry.seal(timeline.submitted());
+}
+
+// Новый список показал изображение: показы из заменённых списков поставлены в очередь раньше.
+// Объекты уничтожаются после кадра, отправленного вслед за этим показом (его seal)
+void Vulkan::releaseRetiredSwapchains() {
+	VkDevice device = logicalDevice;
+	for (const RetiredSwapchain& retired : retiredSwapchains)
+		registry.release([=]() {
+			for (auto view : retired.views)
+				vkDestroyImageView(device, view, nullptr);
+			for (auto semaphore : retired.semaphores)
+				vkDestroySemaphore(device, semaphore, nullptr);
+			vkDestroySwapchainKHR(device, retired.swapChain, nullptr);
+		});
+	retiredSwapchains.clear();
+}
+
 // завершение работы
 void Vulkan::destroy() {
+	hotReload.stop(); // Остановка фонового потока перезагрузки
+	simulation.stop(); // Остановка потока симуляции
+	workers.stop(); // Остановка рабочих потоков
 	vkDeviceWaitIdle(logicalDevice); // Ожидание окончания асинхронных задач
 
-	vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
-
-	vkDestroyBuffer(logicalDevice, modelVertexBuffer, nullptr);
-	vkFreeMemory(logicalDevice, modelVertexBufferMemory, nullptr);
-	vkDestroyBuffer(logicalDevice, modelIndexBuffer, nullptr);
-	vkFreeMemory(logicalDevice, modelIndexBufferMemory, nullptr);
+	renderGraph.destroy(); // Временные изображения, буферы кадра и проходы рендера
+	profiler.destroy(); // Пулы запросов
+	capture.destroy(); // Дозапись захваченных кадров и буферы чтения
 
-	vkDestroySampler(logicalDevice, textureSampler, nullptr);
-	vkDestroyImageView(logicalDevice, textureImageView, nullptr);
-	vkDestroyImage(logicalDevice, textureImage, nullptr);
-	vkFreeMemory(logicalDevice, textureImageMemory, nullptr);
+	// Уничтожение всех буферов и изображений, включая ожидающие отложенного уничтожения
+	releaseRetiredSwapchains();
+	registry.destroy();
+	timeline.destroy();
 
-    vkDestroyImageView(logicalDevice, depthImageView, nullptr);
-    vkDestroyImage(logicalDevice, depthImage, nullptr);
-    vkFreeMemory(logicalDevice, depthImageMemory, nullptr);
+	vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
 
-	// Уничтожаем uniform buffer
-	vkDestroyBuffer(logicalDevice, uniformBuffer, nullptr);
-	vkFreeMemory(logicalDevice, uniformBufferMemory, nullptr);
+	vkDestroySampler(logicalDevice, textureSampler, nullptr);
 
 	// Уничтожаем layout дескрипторов
 	vkDestroyDescriptorSetLayout(logicalDevice, descriptorSetLayout, nullptr);
 
-
-	vkDestroyBuffer(logicalDevice, indexBuffer, nullptr); // Уничтожение буфера индексов
-	vkFreeMemory(logicalDevice, indexBufferMemory, nullptr); // Освобождение памяти буфера индексов
-
-	vkDestroyBuffer(logicalDevice, vertexBuffer, nullptr); // Уничтожение буфера вершин
-	vkFreeMemory(logicalDevice, vertexBufferMemory, nullptr); // Освобождение памяти буфера вершин
-
 	// Уничтожение объектов синхронизации
-	for (int i = 0; i < surface.imageCount; i++) {
-		vkDestroySemaphore(logicalDevice, renderFinishedSemaphores[i], nullptr);
-		vkDestroySemaphore(logicalDevice, imageAvailableSemaphores[i], nullptr);
-		vkDestroyFence(logicalDevice, inWorkFences[i], nullptr);
+	for (auto semaphore : renderFinishedSemaphores) {
+		vkDestroySemaphore(logicalDevice, semaphore, nullptr);
 	}
 
-	vkDestroyCommandPool(logicalDevice, commandPool, nullptr); // Уничтожение командного пула
-
-	// Уничтожение буферов кадра
-	for (auto framebuffer : swapChainFramebuffers) {
-		vkDestroyFramebuffer(logicalDevice, framebuffer, nullptr);
+	// Уничтожение кадров в работе
+	for (auto& frame : frames) {
+		vkDestroySemaphore(logicalDevice, frame.imageAvailable, nullptr);
+		vkDestroyCommandPool(logicalDevice, frame.commandPool, nullptr);
 	}
 
+	vkDestroyCommandPool(logicalDevice, commandPool, nullptr); // Уничтожение командного пула
+
 	vkDestroyPipeline(logicalDevice, graphicsPipeline, nullptr); // Уничтожение графического конвейера
 	vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr); // Уничтожение раскладки графического конвейера
-	vkDestroyRenderPass(logicalDevice, renderPass, nullptr); // Уничтожение проходов рендера
+	destroyCrowd(); // Конвейер и раскладки толпы
+	destroyOcclusion(); // Конвейеры и раскладки отсечения
+	destroyHeightfield(); // Конвейеры и раскладки сетки высот
+	destroyTerrain(); // Поток чтения плиток, конвейер и раскладки ландшафта
+	destroyLights(); // Конвейер и раскладки распределения источников
+	destroyShadows(); // Конвейеры глубины и сэмплер сравнения
+	destroyParticles(); // Конвейеры и раскладки частиц
+
+	// Уничтожение информации о изображениях списка показа (внеэкранные изображения уничтожил реестр)
+	if (!headless) {
+		for (auto & imageView : swapChainImageViews) {
+			vkDestroyImageView(logicalDevice, imageView, nullptr);
+		}
 
-	// Уничтожение информации о изображениях списка показа
-	for (auto & imageView : swapChainImageViews) {
-		vkDestroyImageView(logicalDevice, imageView, nullptr);
+		vkDestroySwapchainKHR(logicalDevice, swapChain, nullptr); // уничтожение цепочки показа
+		vkDestroySurfaceKHR(instance, surface.surface, nullptr); // уничтожение поверхности
 	}
-
-	vkDestroySwapchainKHR(logicalDevice, swapChain, nullptr); // уничтожение цепочки показа
-	vkDestroySurfaceKHR(instance, surface.surface, nullptr); // уничтожение поверхности
 	vkDestroyDevice(logicalDevice, nullptr); // Уничтожение логического устройства
 	vkDestroyInstance(instance, nullptr); // Уничтожение экземпляра Vulkan
 }
@@ -568,17 +544,18 @@ void Vulkan::createInstance() {
 	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	appInfo.pEngineName = "No Engine";
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	appInfo.apiVersion = VK_API_VERSION_1_0;
+	appInfo.apiVersion = VK_API_VERSION_1_3; // synchronization2
 
 	// Структура с данными
 	VkInstanceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	createInfo.pApplicationInfo = &appInfo;
 
-	// Расширения для glfw
+	// Расширения для glfw (без окна не нужны)
 	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	const char** glfwExtensions = nullptr;
+	if (!headless)
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 	// Инициализируем вектор расширений тем, что требуется для glfw
 	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 
@@ -594,20 +571,22 @@ void Vulkan::createInstance() {
 		"VK_LAYER_KHRONOS_validation"
 	};
 
-	if (states.VALIDATION) {
-		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
-		createInfo.ppEnabledLayerNames = validationLayers.data();
-	}
-
-	// Проверим доступность слоев
+	// Проверим доступность слоев: они нужны, только если проверка включена
 	std::vector<const char*> unavailableLayers;
-	if (!checkValidationLayerSupport(validationLayers, unavailableLayers)) {
+	bool layersAvailable = !states.VALIDATION || checkValidationLayerSupport(validationLayers, unavailableLayers);
+	if (!layersAvailable) {
 		std::cout << "Запрошены недоступные слои:\n";
 		// Цикл по недоступным слоям
 		for (const char* layer : unavailableLayers)
 			std::cout << layer << "\n";
-		// Отправим исключение об отсутствующем слое
-		throw std::runtime_error("Requested layer unavailable");
+		// Без окна (CI, программные реализации) слоёв часто нет: работаем без проверки
+		if (!headless)
+			throw std::runtime_error("Requested layer unavailable"); // Отправим исключение об отсутствующем слое
+	}
+
+	if (states.VALIDATION && layersAvailable) {
+		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+		createInfo.ppEnabledLayerNames = validationLayers.data();
 	}
 
 	// Создание экземпляра Vulkan
@@ -652,29 +631,39 @@ PhysicalDevice selectPhysicalDeviceByProperties(std::vector<VkPhysicalDevice> &
 					break;
 				}
 
-		// Получение информации о поверхности
-		VkSurfaceCapabilitiesKHR capabilities;
-		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface.surface, &capabilities);
-
-		// Получение форматов поверхности
-		uint32_t formatCount;
-		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface.surface, &formatCount, nullptr);
-		std::vector<VkSurfaceFormatKHR> formats(formatCount);
-		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface.surface, &formatCount, formats.data());
-
-		// Получение данных о поддерживаемых режимах показа
-		uint32_t presentModeCount;
-		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface.surface, &presentModeCount, nullptr);
-		std::vector<VkPresentModeKHR> presentModes(presentModeCount);
-		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface.surface, &presentModeCount, presentModes.data());
-
-		// Если есть форматы и режимы показа, то на данном устройстве можно создать список показа
-		bool swapchainSupport = formatCount && presentModeCount;
+		VkSurfaceCapabilitiesKHR capabilities{};
+		std::vector<VkSurfaceFormatKHR> formats;
+		std::vector<VkPresentModeKHR> presentModes;
+		// Без поверхности (режим без окна) список показа не нужен
+		bool swapchainSupport = surface.surface == VK_NULL_HANDLE;
+
+		if (surface.surface != VK_NULL_HANDLE) {
+			// Получение информации о поверхности
+			vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface.surface, &capabilities);
+
+			// Получение форматов поверхности
+			uint32_t formatCount;
+			vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface.surface, &formatCount, nullptr);
+			formats.resize(formatCount);
+			vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface.surface, &formatCount, formats.data());
+
+			// Получение данных о поддерживаемых режимах показа
+			uint32_t presentModeCount;
+			vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface.surface, &presentModeCount, nullptr);
+			presentModes.resize(presentModeCount);
+			vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface.surface, &presentModeCount, presentModes.data());
+
+			// Если есть форматы и режимы показа, то на данном устройстве можно создать список показа
+			swapchainSupport = formatCount && presentModeCount;
+		}
 
-		// Производим оценку
+		// Производим оценку. Без окна подходит и программная реализация (lavapipe, SwiftShader):
+		// геометрические шейдеры движок не использует, а первая куча у них - системная память
+		bool headless = surface.surface == VK_NULL_HANDLE;
 		if (availableExtensionsCount == requestedExtensions.size()
-		&&  result.features.geometryShader
-		&&  4000 < result.memory.memoryHeaps[0].size / 1000 / 1000
+		&&  (headless || result.features.geometryShader)
+		&&  result.properties.apiVersion >= VK_API_VERSION_1_3
+		&&  (headless || 4000 < result.memory.memoryHeaps[0].size / 1000 / 1000)
 		&&  swapchainSupport
 		) {
 			// Заполним данные о поверхности
@@ -718,9 +707,10 @@ void Vulkan::pickQueues() {
 	queue.index = -1;
 
 	for (int i = 0; i < physicalDevice.queueFamilyProperties.size(); i++) {
-		// Проверка возможности вывода
-		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice.device, i, surface.surface, &presentSupport);
+		// Проверка возможности вывода (без поверхности не требуется)
+		VkBool32 presentSupport = surface.surface == VK_NULL_HANDLE;
+		if (surface.surface != VK_NULL_HANDLE)
+			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice.device, i, surface.surface, &presentSupport);
 		// Проверка поддержки очередью графических операций
 		if (physicalDevice.queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT
 		&&  presentSupport
@@ -760,11 +750,25 @@ void Vulkan::createLogicalDevice(std::vector<const char*> &deviceExtensions) {
 
     // Включим фичу анизотропной фильтрации
     VkPhysicalDeviceFeatures deviceFeatures{};
-    deviceFeatures.samplerAnisotropy = VK_TRUE;  // ← Это важно!
+    deviceFeatures.samplerAnisotropy = physicalDevice.features.samplerAnisotropy;  // ← Это важно!
+    deviceFeatures.pipelineStatisticsQuery = physicalDevice.features.pipelineStatisticsQuery; // Статистика конвейера для профилировщика
+
+    // Барьеры записываются через vkCmdPipelineBarrier2, проходы - через vkCmdBeginRendering
+    VkPhysicalDeviceVulkan13Features features13{};
+    features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    features13.synchronization2 = VK_TRUE;
+    features13.dynamicRendering = VK_TRUE;
+
+    // Завершение работы GPU отслеживается семафорами временной шкалы
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.pNext = &features13;
+    features12.timelineSemaphore = VK_TRUE;
 
     // Данные о создаваемом логическом устройстве
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &features12;
     createInfo.pQueueCreateInfos = &queueCreateInfo;
     createInfo.queueCreateInfoCount = 1;
     createInfo.enabledExtensionCount = deviceExtensions.size();
@@ -789,6 +793,23 @@ void Vulkan::createWindowSurface(GLFWwindow* window) {
 	}
 }
 
+// Внеэкранные изображения вместо списка показа: по одному на кадр в работе.
+// Кроме вывода сцены служат источником копирования для чтения кадров на CPU
+void Vulkan::createOffscreenTargets() {
+	for (uint32_t i = 0; i < states.FRAMES_IN_FLIGHT; i++) {
+		ImageHandle image = registry.createImage(surface.selectedExtent.width, surface.selectedExtent.height,
+					surface.selectedFormat.format, VK_IMAGE_TILING_OPTIMAL,
+					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		ImageViewHandle view = registry.createImageView(image, surface.selectedFormat.format, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		offscreenImages.push_back(image);
+		offscreenViews.push_back(view);
+		swapChainImages.push_back(registry.image(image));
+		swapChainImageViews.push_back(registry.view(view));
+	}
+}
+
 // Создание цепочки показа
 void Vulkan::createSwapchain(GLFWwindow* window) {
 	// Выбор формата
@@ -812,6 +833,8 @@ void Vulkan::createSwapchain(GLFWwindow* window) {
 	}
 
 	// Выбор разрешения изображений
+	// Возможности поверхности меняются вместе с размером окна
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice.device, surface.surface, &surface.capabilities);
 	// Разрешение окна
 	int width, height;
 	glfwGetFramebufferSize(window, &width, &height);
@@ -822,8 +845,8 @@ void Vulkan::createSwapchain(GLFWwindow* window) {
 	// Выбор количества изображений в списке показа
 	surface.imageCount = surface.capabilities.minImageCount + 1;
 	// Если есть ограничение по максимуму изображений - применим его
-	if (surface.capabilities.maxImageCount)
-		surface.imageCount %= surface.capabilities.maxImageCount;
+	if (surface.capabilities.maxImageCount && surface.imageCount > surface.capabilities.maxImageCount)
+		surface.imageCount = surface.capabilities.maxImageCount;
 
 	// Заполнение данных о создаваемом списке показа
 	VkSwapchainCreateInfoKHR createInfo{};
@@ -835,12 +858,16 @@ void Vulkan::createSwapchain(GLFWwindow* window) {
 	createInfo.imageExtent = surface.selectedExtent;
 	createInfo.imageArrayLayers = 1;
 	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	if (states.DYNAMIC_RESOLUTION)
+		createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT; // приёмник растяжения сцены
+	if (surface.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+		createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // источник захвата кадров
 	createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	createInfo.preTransform = surface.capabilities.currentTransform;
 	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	createInfo.presentMode = surface.selectedPresentMode;
 	createInfo.clipped = VK_TRUE;
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	createInfo.oldSwapchain = swapChain; // при пересоздании старые изображения остаются в работе
 
 	// Создание списка показа
 	if (vkCreateSwapchainKHR(logicalDevice, &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
@@ -879,73 +906,6 @@ void Vulkan::createSwapchain(GLFWwindow* window) {
 	}
 }
 
-// Создание проходов рендера
-void Vulkan::createRenderpass() {
-    // Attachment для цвета
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = surface.selectedFormat.format;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    // Attachment для глубины
-    VkAttachmentDescription depthAttachment{};
-    depthAttachment.format = findDepthFormat();
-    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // References
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference depthAttachmentRef{};
-    depthAttachmentRef.attachment = 1;
-    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // Subpass
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-    subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-    // Dependencies
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-    // Массив attachments
-    std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
-
-    // Render pass info
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-    renderPassInfo.pAttachments = attachments.data();
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
-
-    if (vkCreateRenderPass(logicalDevice, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-        throw std::runtime_error("Unable to create render pass");
-    }
-}
-
 #include <fstream>
 // Считывание бинарного файла, содержащего шейдер
 void readFile(const char * filename, std::vector<char>& buffer) {
@@ -991,89 +951,75 @@ VkShaderModule Vulkan::createShaderModule(const char * filename) {
 	return shaderModule;
 }
 
-void Vulkan::createDepthResources() {
-    VkFormat depthFormat = findDepthFormat();
-
-    createImage(
-        surface.selectedExtent.width,
-        surface.selectedExtent.height,
-        depthFormat,
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        depthImage,
-        depthImageMemory
-    );
-
-    createImageView(
-        depthImage,
-        depthFormat,
-        VK_IMAGE_ASPECT_DEPTH_BIT,
-        &depthImageView
-    );
-
-    transitionImageLayout(
-        depthImage,
-        depthFormat,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    );
-}
-
 VkFormat Vulkan::findDepthFormat() {
     return VK_FORMAT_D32_SFLOAT; // Или другой подходящий формат
 }
 
 // Создание графического конвеера
 void Vulkan::createGraphicPipeline() {
+	// раскладка конвейера
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;  // ← Количество макетов дескрипторов
+	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;  // ← Ваш макет дескриптора
+	pipelineLayoutInfo.pushConstantRangeCount = 0;  // (если не используете push-константы)
+
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Unable to create pipeline layout");
+	}
+
+	graphicsPipeline = buildGraphicsPipeline("build/shaders/vert.spv", "build/shaders/frag.spv");
+}
+
+// Сборка графического конвейера из шейдеров. Раскладка и проходы рендера должны быть созданы.
+// Без vertexInput и layout - входные данные и раскладка модели.
+// Может вызываться из фонового потока горячей перезагрузки
+VkPipeline Vulkan::buildGraphicsPipeline(const char * vertPath, const char * fragPath,
+		const VkPipelineVertexInputStateCreateInfo* vertexInput, VkPipelineLayout layout, VkPrimitiveTopology topology,
+		bool transparent) {
 	// Входные данные вершин
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	// Привязка
-    VkVertexInputBindingDescription bindingDescription{};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	// Привязки: вершины и поток скиннинга
+    VkVertexInputBindingDescription bindingDescriptions[2] = {};
+    bindingDescriptions[0] = {0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX};
+    bindingDescriptions[1] = {1, sizeof(SkinnedVertex), VK_VERTEX_INPUT_RATE_VERTEX};
 
-    // Описание атрибута (только позиция)
-	VkVertexInputAttributeDescription attributeDescriptions[3] = {};
+    // Описание атрибутов
+	VkVertexInputAttributeDescription attributeDescriptions[5] = {};
 	attributeDescriptions[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)};
 	attributeDescriptions[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)};
 	attributeDescriptions[2] = {2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord)};
-	vertexInputInfo.vertexAttributeDescriptionCount = 3;
+	attributeDescriptions[3] = {3, 1, VK_FORMAT_R16G16B16A16_UINT, offsetof(SkinnedVertex, joints)};
+	attributeDescriptions[4] = {4, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(SkinnedVertex, weights)};
+	vertexInputInfo.vertexAttributeDescriptionCount = 5;
 
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.vertexBindingDescriptionCount = 2;
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions;
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions;
+	if (vertexInput)
+		vertexInputInfo = *vertexInput;
 
 	// Входной сборщик
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.topology = topology;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	// Область просмотра
-	VkViewport viewport{};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = surface.selectedExtent.width;
-	viewport.height = surface.selectedExtent.height;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	// Прямоугольник отсечения
-	VkRect2D scissor{};
-	scissor.offset = {0, 0};
-	scissor.extent = surface.selectedExtent;
-
-	// Состояние области просмотра
+	// Состояние области просмотра: сами область и отсечение задаются при записи команд,
+	// поэтому конвейер переживает изменение размера списка показа
 	VkPipelineViewportStateCreateInfo viewportState{};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+
+	VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
 
 	// Растеризатор
 	VkPipelineRasterizationStateCreateInfo rasterizer{};
@@ -1082,7 +1028,7 @@ void Vulkan::createGraphicPipeline() {
 	rasterizer.rasterizerDiscardEnable = VK_FALSE;
 	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
 	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterizer.cullMode = transparent ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT; // спрайты не отсекаются
 	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 	rasterizer.depthBiasEnable = VK_FALSE;
 
@@ -1096,6 +1042,16 @@ void Vulkan::createGraphicPipeline() {
 	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
 	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 	colorBlendAttachment.blendEnable = VK_FALSE;
+	if (transparent) {
+		// Обычное смешивание по альфе поверх непрозрачной сцены
+		colorBlendAttachment.blendEnable = VK_TRUE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	}
 
 	// Глобальные настройки смешивания цветов
 	VkPipelineColorBlendStateCreateInfo colorBlending{};
@@ -1109,21 +1065,15 @@ void Vulkan::createGraphicPipeline() {
 	colorBlending.blendConstants[2] = 0.0f;
 	colorBlending.blendConstants[3] = 0.0f;
 
-	// раскладка конвейера
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;  // ← Количество макетов дескрипторов
-	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;  // ← Ваш макет дескриптора
-	pipelineLayoutInfo.pushConstantRangeCount = 0;  // (если не используете push-константы)
-
-	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Unable to create pipeline layout");
-	}
-
 	// Создание шейдеров
-	VkShaderModule vertShaderModule = createShaderModule("build/shaders/vert.spv");
-	VkShaderModule fragShaderModule = createShaderModule("build/shaders/frag.spv");
+	VkShaderModule vertShaderModule = createShaderModule(vertPath);
+	VkShaderModule fragShaderModule;
+	try {
+		fragShaderModule = createShaderModule(fragPath);
+	} catch (...) {
+		vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
+		throw;
+	}
 
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
 	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -1144,7 +1094,7 @@ void Vulkan::createGraphicPipeline() {
     VkPipelineDepthStencilStateCreateInfo depthStencil{};
     depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
     depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = transparent ? VK_FALSE : VK_TRUE;
     depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
     depthStencil.depthBoundsTestEnable = VK_FALSE;
     depthStencil.minDepthBounds = 0.0f;
@@ -1159,70 +1109,63 @@ void Vulkan::createGraphicPipeline() {
 	pipelineInfo.pVertexInputState = &vertexInputInfo;
 	pipelineInfo.pInputAssemblyState = &inputAssembly;
 	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDynamicState = &dynamicState;
 	pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pDepthStencilState = &depthStencil;
 	pipelineInfo.pMultisampleState = &multisampling;
 	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.layout = layout != VK_NULL_HANDLE ? layout : pipelineLayout;
 	pipelineInfo.renderPass = renderPass;
 	pipelineInfo.subpass = 0;
+
+	// При динамическом рендере конвейер описывает форматы вложений вместо прохода рендера
+	VkPipelineRenderingCreateInfo renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	renderingInfo.colorAttachmentCount = static_cast<uint32_t>(sceneColorFormats.size());
+	renderingInfo.pColorAttachmentFormats = sceneColorFormats.data();
+	renderingInfo.depthAttachmentFormat = sceneDepthFormat;
+	if (states.DYNAMIC_RENDERING) {
+		pipelineInfo.pNext = &renderingInfo;
+		pipelineInfo.renderPass = VK_NULL_HANDLE;
+	}
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
 	// Создание графического конвейера
-	if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-		throw std::runtime_error("Unable to create graphics pipeline");
-	}
+	VkPipeline pipeline;
+	VkResult result = vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
 
 	// Удаление шейдерных модулей
 	vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
 	vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
-}
 
-// Создание произвольного буфера данных
-void Vulkan::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
-	// Информация о создаваемом буфере
-	VkBufferCreateInfo bufferInfo{};
-	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	bufferInfo.size = size;
-	bufferInfo.usage = usage;
-	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	// Создание буфера
-	if (vkCreateBuffer(logicalDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
-		throw std::runtime_error("Unable to create buffer");
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create graphics pipeline");
 	}
 
-	// Требования к памяти
-	VkMemoryRequirements memRequirements;
-	vkGetBufferMemoryRequirements(logicalDevice, buffer, &memRequirements);
+	return pipeline;
+}
 
-	// Поиск индекса типа подходящей памяти
-	uint32_t index_memory;
-	for (index_memory = 0; index_memory < physicalDevice.memory.memoryTypeCount; index_memory++) {
-		if ((memRequirements.memoryTypeBits & (1 << index_memory))
-		&&  (physicalDevice.memory.memoryTypes[index_memory].propertyFlags & properties) == properties
-		) {
-			break;
-		}
-	}
+// Сборка вычислительного конвейера. Может вызываться из фонового потока горячей перезагрузки
+VkPipeline Vulkan::buildComputePipeline(const char * compPath, VkPipelineLayout layout) {
+	VkShaderModule compShaderModule = createShaderModule(compPath);
 
-	// Если индекс равен размеру массива - поиск не удался и нужно выдать исключение
-	if (index_memory == physicalDevice.memory.memoryTypeCount)
-		throw std::runtime_error("Unable to find suitable memory type");
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = compShaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = layout;
 
-	// Информация о выделяемой памяти
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = index_memory;
+	VkPipeline pipeline;
+	VkResult result = vkCreateComputePipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+	vkDestroyShaderModule(logicalDevice, compShaderModule, nullptr);
 
-	// Выделение памяти
-	if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-		throw std::runtime_error("Unable to allocate buffer memory");
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create compute pipeline");
 	}
 
-	// Привязка выделенной памяти к буферу
-	vkBindBufferMemory(logicalDevice, buffer, bufferMemory, 0);
+	return pipeline;
 }
 
 // Создание пула команд
@@ -1235,19 +1178,6 @@ void Vulkan::createCommandPool() {
     if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
         throw std::runtime_error("Unable to create graphics command pool");
     }
-
-    // Выделение буферов команд
-    commandBuffers.resize(swapChainImages.size());
-
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;  // ← Используем созданный commandPool
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
-
-    if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("Unable to allocate command buffers");
-    }
 }
 
 // Копирование между буферами данных
@@ -1277,145 +1207,85 @@ void Vulkan::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize siz
 	// Конец записи команд
 	vkEndCommandBuffer(commandBuffer);
 
-	// Информация о запускаемых буферах команд
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
-
-	// Запуск командного буфера копирования и ожидание завершения
-	vkQueueSubmit(queue.descriptor, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(queue.descriptor);
+	// Запуск командного буфера копирования и ожидание его значения на шкале
+	timeline.wait(timeline.submit(commandBuffer));
 
 	// Освобождение командного буфера копирования
 	vkFreeCommandBuffers(logicalDevice, commandPool, 1, &commandBuffer);
 }
 
-// Создание вершинного буфера
-void Vulkan::createVertexBuffer() {
-	vertices.clear();
-	for (int i = 0; i < size_of_field; i++) {
-		for (int j = 0; j < size_of_field; j++) {
-			vertices.push_back({
-				{((float)i)/size_of_field, ((float)j)/size_of_field, 0.0f}  // Z будет вычисляться в шейдере
-			});
-		}
-	}
-
-	VkDeviceSize bufferSize = sizeof(Vertex) * vertices.size();
-	createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBuffer, vertexBufferMemory);
-
-	// Теперь updateVertexBuffer() не нужен, так как анимация полностью в шейдере
-	void* data;
-	vkMapMemory(logicalDevice, vertexBufferMemory, 0, bufferSize, 0, &data);
-	// Копирование вершин в промежуточный буфер
-	memcpy(data, vertices.data(), (size_t) bufferSize);
-	// Прекращение отображения памяти буфера
-	vkUnmapMemory(logicalDevice, vertexBufferMemory);
-}
-
-// Создание буфера индексов
-void Vulkan::createIndexBuffer() {
+// Создание объектов синхронизации
+void Vulkan::createSyncObjects() {
+	// Семафор окончания рендера ждёт показ, поэтому он принадлежит изображению, а не кадру
+	renderFinishedSemaphores.resize(swapChainImages.size());
+	imageValues.assign(swapChainImages.size(), 0);
 
-	std::vector<uint32_t> indices((size_of_field-1)*(size_of_field-1)*6);
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	for (int i = 0; i < (size_of_field-1); i++) {
-		for (int j = 0; j < (size_of_field-1); j++) {
-			indices[0 + 6 * (i * (size_of_field-1) + j)] = i * size_of_field + j;
-			indices[1 + 6 * (i * (size_of_field-1) + j)] = (i + 1) * size_of_field + j;
-			indices[2 + 6 * (i * (size_of_field-1) + j)] = (i + 1) * size_of_field + j + 1;
-			indices[3 + 6 * (i * (size_of_field-1) + j)] = i * size_of_field + j;
-			indices[4 + 6 * (i * (size_of_field-1) + j)] = (i + 1) * size_of_field + j + 1;
-			indices[5 + 6 * (i * (size_of_field-1) + j)] = i * size_of_field + j + 1;
+	for (auto& semaphore : renderFinishedSemaphores) {
+		if (vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("Unable to create synchronization objects for swap chain image");
 		}
 	}
-
-	VkDeviceSize bufferSize = sizeof(uint32_t) * indices.size();
-
-	// Промежуточный буфер для переноса на устройство
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-	// Отображение памяти буфера
-	void* data;
-	vkMapMemory(logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-	// Копирование вершин в промежуточный буфер
-	memcpy(data, indices.data(), (size_t) bufferSize);
-	// Прекращение отображения памяти буфера
-	vkUnmapMemory(logicalDevice, stagingBufferMemory);
-
-	// Создание буфера вершин
-	createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
-	// Копирование из промежуточного в буфер вершин
-	copyBuffer(stagingBuffer, indexBuffer, bufferSize);
-
-	// Освобождение памяти и уничтожение буферов
-	vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
 }
 
-// Создание объектов синхронизации
-void Vulkan::createSyncObjects() {
-	imageAvailableSemaphores.resize(surface.imageCount);
-	renderFinishedSemaphores.resize(surface.imageCount);
-	inWorkFences.resize(surface.imageCount);
+void Vulkan::createFrameContexts() {
+	frames.resize(states.FRAMES_IN_FLIGHT);
 
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	// Пул каждого кадра сбрасывается целиком, буферы команд по отдельности не сбрасываются
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = queue.index;
+
+	VkDeviceSize arenaSize = registry.bufferSize(uniformBuffer) / states.FRAMES_IN_FLIGHT;
 
-	for (int i = 0; i < surface.imageCount; i++) {
-		if (vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS
-		||  vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS
-		||  vkCreateFence(logicalDevice, &fenceInfo, nullptr, &inWorkFences[i]) != VK_SUCCESS
+	for (uint32_t i = 0; i < frames.size(); i++) {
+		FrameContext& frame = frames[i];
+		if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS
+		||  vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &frame.imageAvailable) != VK_SUCCESS
 		) {
 			throw std::runtime_error("Unable to create synchronization objects for frame");
 		}
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = frame.commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &frame.commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Unable to allocate command buffers");
+		}
+
+		frame.uniforms.init(registry.buffer(uniformBuffer), registry.map(uniformBuffer),
+							arenaSize * i, arenaSize,
+							physicalDevice.properties.limits.minUniformBufferOffsetAlignment);
 	}
 }
 
 // Создание буферов кадра
-void Vulkan::createFramebuffers() {
-    swapChainFramebuffers.resize(swapChainImageViews.size());
-
-    for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-        std::array<VkImageView, 2> attachments = {
-            swapChainImageViews[i],
-            depthImageView
-        };
-
-        VkFramebufferCreateInfo framebufferInfo{};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        framebufferInfo.pAttachments = attachments.data();
-        framebufferInfo.width = surface.selectedExtent.width;
-        framebufferInfo.height = surface.selectedExtent.height;
-        framebufferInfo.layers = 1;
-
-        if (vkCreateFramebuffer(logicalDevice, &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("Unable to create framebuffer");
-        }
-    }
-}
-
 void Vulkan::createDescriptorPool() {
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = 1;
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = 1;
+    // Наборы выделяются один раз и не освобождаются: пирамида глубины и перезагрузка текстуры переписывают их
+    std::array<VkDescriptorPoolSize, 4> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSizes[0].descriptorCount = 2 * states.FRAMES_IN_FLIGHT;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; // текстура модели и карта теней в наборах сцены, слои высот ландшафта, пирамида глубины
+    poolSizes[1].descriptorCount = 2 * states.FRAMES_IN_FLIGHT + 1 + states.FRAMES_IN_FLIGHT * (MAX_PYRAMID_LEVELS + 1);
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; // анимация толпы, сетка высот, отсечение, освещение в наборах сцены и распределение, частицы
+    poolSizes[2].descriptorCount = 3 + 5 * states.FRAMES_IN_FLIGHT + 3 * states.FRAMES_IN_FLIGHT + 4 + 7;
+    poolSizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE; // уровни пирамиды глубины
+    poolSizes[3].descriptorCount = states.FRAMES_IN_FLIGHT * MAX_PYRAMID_LEVELS;
 
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = 1;
+    poolInfo.maxSets = states.FRAMES_IN_FLIGHT + 5 + states.FRAMES_IN_FLIGHT * (MAX_PYRAMID_LEVELS + 1); // наборы сцены по кадрам, толпа, сетка, освещение, ландшафт, частицы, пирамида по кадрам
 
     if (vkCreateDescriptorPool(logicalDevice, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
         throw std::runtime_error("failed to create descriptor pool!");
@@ -1423,6 +1293,36 @@ void Vulkan::createDescriptorPool() {
 }
 
 void Vulkan::createDescriptorSet() {
+    for (FrameContext& frame : frames) {
+        frame.sceneSet = allocateDescriptorSet(registry.view(textureImageView));
+        frame.sceneTexture = textureImageView;
+    }
+    descriptorSet = frames[0].sceneSet;
+}
+
+// Набор слота используется только кадрами этого слота: после ожидания кадра его можно переписать
+void Vulkan::updateSceneSet(FrameContext& frame) {
+    if (frame.sceneTexture != textureImageView) {
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = registry.view(textureImageView);
+        imageInfo.sampler = textureSampler;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = frame.sceneSet;
+        write.dstBinding = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = 1;
+        write.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+        frame.sceneTexture = textureImageView;
+    }
+    descriptorSet = frame.sceneSet;
+}
+
+// Выделение и заполнение набора дескрипторов для заданной текстуры
+VkDescriptorSet Vulkan::allocateDescriptorSet(VkImageView imageView) {
     VkDescriptorSetLayout layouts[] = {descriptorSetLayout};
     VkDescriptorSetAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -1430,28 +1330,46 @@ void Vulkan::createDescriptorSet() {
     allocInfo.descriptorSetCount = 1;
     allocInfo.pSetLayouts = layouts;
 
+    VkDescriptorSet descriptorSet;
     if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, &descriptorSet) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate descriptor sets!");
     }
 
     // Uniform buffer
     VkDescriptorBufferInfo bufferInfo{};
-    bufferInfo.buffer = uniformBuffer;
+    bufferInfo.buffer = registry.buffer(uniformBuffer);
     bufferInfo.offset = 0;
-    bufferInfo.range = sizeof(glm::mat4) * 3 + sizeof(float);
+    bufferInfo.range = uniformSize;
+
+    VkDescriptorBufferInfo paletteInfo{};
+    paletteInfo.buffer = registry.buffer(uniformBuffer);
+    paletteInfo.offset = 0;
+    paletteInfo.range = paletteSize;
 
     // Texture sampler
     VkDescriptorImageInfo imageInfo{};
     imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = textureImageView;
+    imageInfo.imageView = imageView;
     imageInfo.sampler = textureSampler;
 
-    std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+    // Освещение
+    VkDescriptorBufferInfo lightInfos[3] = {
+        {registry.buffer(lightBuffer), 0, VK_WHOLE_SIZE},
+        {registry.buffer(lightClusterBuffer), 0, VK_WHOLE_SIZE},
+        {registry.buffer(lightIndexBuffer), 0, VK_WHOLE_SIZE}};
+
+    // Карта теней
+    VkDescriptorImageInfo shadowInfo{};
+    shadowInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    shadowInfo.imageView = registry.view(shadowMapView);
+    shadowInfo.sampler = shadowSampler;
+
+    std::array<VkWriteDescriptorSet, 7> descriptorWrites{};
     descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[0].dstSet = descriptorSet;
     descriptorWrites[0].dstBinding = 0;
     descriptorWrites[0].dstArrayElement = 0;
-    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     descriptorWrites[0].descriptorCount = 1;
     descriptorWrites[0].pBufferInfo = &bufferInfo;
 
@@ -1463,6 +1381,34 @@ void Vulkan::createDescriptorSet() {
     descriptorWrites[1].descriptorCount = 1;
     descriptorWrites[1].pImageInfo = &imageInfo;
 
+    descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[2].dstSet = descriptorSet;
+    descriptorWrites[2].dstBinding = 2;
+    descriptorWrites[2].dstArrayElement = 0;
+    descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrites[2].descriptorCount = 1;
+    descriptorWrites[2].pBufferInfo = &paletteInfo;
+
+    for (uint32_t i = 0; i < 3; i++) {
+        descriptorWrites[3 + i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[3 + i].dstSet = descriptorSet;
+        descriptorWrites[3 + i].dstBinding = 3 + i;
+        descriptorWrites[3 + i].dstArrayElement = 0;
+        descriptorWrites[3 + i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[3 + i].descriptorCount = 1;
+        descriptorWrites[3 + i].pBufferInfo = &lightInfos[i];
+    }
+
+    descriptorWrites[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[6].dstSet = descriptorSet;
+    descriptorWrites[6].dstBinding = 6;
+    descriptorWrites[6].dstArrayElement = 0;
+    descriptorWrites[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrites[6].descriptorCount = 1;
+    descriptorWrites[6].pImageInfo = &shadowInfo;
+
     vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(descriptorWrites.size()),
                          descriptorWrites.data(), 0, nullptr);
+
+    return descriptorSet;
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "vk.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// Push-константы распределения источников
+typedef struct _LightCullParams
+{
+	glm::mat4 view;
+	glm::vec4 projection; // proj[0][0], proj[1][1], ближняя и дальняя плоскости
+	uint32_t lightCount;
+	uint32_t frame; // слот кадра в счётчике переполнений
+} LightCullParams;
+
+static const uint32_t LIGHT_CULL_GROUP = 64; // кластеров на рабочую группу light_cull.comp
+static const float LIGHT_AMBIENT = 0.15f; // фоновое освещение при источниках
+static const float SUN_AMBIENT = 0.25f; // при одном солнце
+
+// Буферы создаются и без источников: их читает набор 0, фрагментный шейдер при нуле источников
+// их не трогает
+void Vulkan::createLights() {
+	PROFILE_FUNCTION();
+
+	// Источники над моделью и толпой: толпа стоит сеткой с шагом 1.5 позади модели (createCrowd)
+	uint32_t count = std::min(scene.lights, MAX_LIGHTS);
+	float half = 4.0f + 0.75f * std::sqrt(static_cast<float>(scene.crowd));
+	generateLights(count, glm::vec3(-half, 0.3f, -2.0f - 2.0f * half), glm::vec3(half, 3.5f, 4.0f), 1, lights);
+
+	// Источники неизменны и загружаются один раз
+	VkDeviceSize lightsSize = sizeof(Light) * std::max<size_t>(lights.size(), 1);
+	lightBuffer = registry.createBuffer(lightsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (!lights.empty()) {
+		BufferHandle staging = registry.createBuffer(lightsSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		memcpy(registry.map(staging), lights.data(), static_cast<size_t>(lightsSize));
+		copyBuffer(registry.buffer(staging), registry.buffer(lightBuffer), lightsSize);
+		registry.release(staging);
+	}
+
+	lightClusterBuffer = registry.createBuffer(sizeof(LightCluster) * CLUSTER_COUNT,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	lightIndexBuffer = registry.createBuffer(sizeof(uint32_t) * (1 + LIGHT_INDEX_CAPACITY),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	// Счётчики переполнений пишет GPU и читает CPU без копирования, по одному на слот кадра
+	VkDeviceSize overflowSize = sizeof(uint32_t) * states.FRAMES_IN_FLIGHT;
+	lightOverflowBuffer = registry.createBuffer(overflowSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	memset(registry.map(lightOverflowBuffer), 0, static_cast<size_t>(overflowSize));
+	std::pair<BufferHandle, GraphResource> buffers[] = {
+		{lightClusterBuffer, lightClusterResource}, {lightIndexBuffer, lightIndexResource},
+		{lightOverflowBuffer, lightOverflowResource}};
+	for (const auto& buffer : buffers) {
+		tracker.trackBuffer(registry.buffer(buffer.first));
+		renderGraph.bindBuffer(buffer.second, registry.buffer(buffer.first));
+	}
+
+	if (lights.empty())
+		return;
+
+	// Источники, кластеры, общий список индексов и счётчики переполнений
+	std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); i++)
+		bindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &lightCullSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create light culling descriptor set layout");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &lightCullSetLayout;
+	if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, &lightCullSet) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to allocate light culling descriptor set");
+	}
+
+	VkDescriptorBufferInfo bufferInfos[4] = {
+		{registry.buffer(lightBuffer), 0, VK_WHOLE_SIZE},
+		{registry.buffer(lightClusterBuffer), 0, VK_WHOLE_SIZE},
+		{registry.buffer(lightIndexBuffer), 0, VK_WHOLE_SIZE},
+		{registry.buffer(lightOverflowBuffer), 0, VK_WHOLE_SIZE}};
+	std::array<VkWriteDescriptorSet, 4> writes{};
+	for (uint32_t i = 0; i < writes.size(); i++) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = lightCullSet;
+		writes[i].dstBinding = i;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].descriptorCount = 1;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	VkPushConstantRange range = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(LightCullParams)};
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &lightCullSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &range;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &lightCullLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create light culling pipeline layout");
+	}
+
+	lightCullPipeline = buildComputePipeline("build/shaders/light_cull.spv", lightCullLayout);
+}
+
+// Однородные данные освещения после time: число источников, параметры срезов и фон.
+// Без источников и солнца фон 1 - цвет текстуры как до освещения
+void Vulkan::writeLightingUniforms(char* uniformData) {
+	uint32_t lightCount = lightCullPipeline != VK_NULL_HANDLE ? static_cast<uint32_t>(lights.size()) : 0;
+	glm::vec2 clusterDepth = clusterDepthParams(lightFrustum.znear, lightFrustum.zfar);
+	float ambient = lightCount > 0 ? LIGHT_AMBIENT : shadowPipeline != VK_NULL_HANDLE ? SUN_AMBIENT : 1.0f;
+
+	// Смещения по std140: uint сразу за float, vec2 выровнен по 8 байтам
+	char* lighting = uniformData + 3 * sizeof(glm::mat4) + sizeof(float);
+	memcpy(lighting, &lightCount, sizeof(uint32_t));
+	memcpy(lighting + sizeof(uint32_t), &clusterDepth, sizeof(glm::vec2));
+	memcpy(lighting + sizeof(uint32_t) + sizeof(glm::vec2), &ambient, sizeof(float));
+}
+
+// Проход графа перед распределением: счётчик общего списка
+void Vulkan::recordLightReset(VkCommandBuffer commandBuffer) {
+	vkCmdFillBuffer(commandBuffer, registry.buffer(lightIndexBuffer), 0, sizeof(uint32_t), 0);
+}
+
+// Кластеры строятся по виду и проекции кадра, которые записаны в однородные данные
+void Vulkan::recordLightCull(VkCommandBuffer commandBuffer) {
+	if (lightCullPipeline == VK_NULL_HANDLE)
+		return;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, lightCullPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, lightCullLayout, 0, 1, &lightCullSet, 0, nullptr);
+
+	LightCullParams params;
+	params.view = lightFrustum.view;
+	params.projection = glm::vec4(lightFrustum.p00, lightFrustum.p11, lightFrustum.znear, lightFrustum.zfar);
+	params.lightCount = static_cast<uint32_t>(lights.size());
+	params.frame = currentFrame;
+	vkCmdPushConstants(commandBuffer, lightCullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+	vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + LIGHT_CULL_GROUP - 1) / LIGHT_CULL_GROUP, 1, 1);
+}
+
+// Кадр слота выполнен, граф поставил барьер к чтению на CPU в его конце
+void Vulkan::readLightOverflow() {
+	if (lightCullPipeline == VK_NULL_HANDLE)
+		return;
+
+	uint32_t* counters = static_cast<uint32_t*>(registry.map(lightOverflowBuffer));
+	lightOverflow = std::max(lightOverflow, counters[currentFrame]);
+	counters[currentFrame] = 0;
+}
+
+uint32_t Vulkan::overflowedLightClusters() {
+	uint32_t overflow = lightOverflow;
+	lightOverflow = 0;
+	return overflow;
+}
+
+void Vulkan::destroyLights() {
+	if (lightCullPipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(logicalDevice, lightCullPipeline, nullptr);
+	if (lightCullLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(logicalDevice, lightCullLayout, nullptr);
+	if (lightCullSetLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(logicalDevice, lightCullSetLayout, nullptr);
+}
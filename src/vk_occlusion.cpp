@@ -0,0 +1,321 @@
+#include "vk.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+// Push-константы построения уровня пирамиды
+typedef struct _DepthPyramidParams
+{
+	glm::ivec2 sourceSize; // читаемая область источника: внутреннее разрешение для уровня 0
+	glm::ivec2 targetSize;
+} DepthPyramidParams;
+
+// Push-константы отсечения
+typedef struct _OcclusionParams
+{
+	glm::mat4 view;
+	glm::vec4 projection; // proj[0][0], proj[1][1], proj[2][2], proj[3][2]
+	glm::vec4 bounds; // сфера модели
+	glm::uvec2 pyramidSize;
+	float znear;
+	uint32_t count;
+	uint32_t phase;
+} OcclusionParams;
+
+static const uint32_t OCCLUSION_GROUP = 64; // экземпляров на рабочую группу occlusion_cull.comp
+static const uint32_t DEPTH_PYRAMID_GROUP = 8; // сторона рабочей группы depth_pyramid.comp
+static const uint32_t OCCLUSION_RASTER_WIDTH = 256; // буфер программного растеризатора
+static const uint32_t OCCLUSION_RASTER_HEIGHT = 128;
+static const uint32_t CPU_OCCLUSION_GRAIN = 256; // экземпляров на участок рабочего потока
+
+void Vulkan::createOcclusion() {
+	PROFILE_FUNCTION();
+
+	// Буферы только для GPU
+	VkDeviceSize instancesSize = sizeof(CrowdInstance) * scene.crowd;
+	crowdVisibilityBuffer = registry.createBuffer(sizeof(uint32_t) * scene.crowd,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	crowdDrawBuffer = registry.createBuffer(2 * sizeof(VkDrawIndexedIndirectCommand),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	crowdEarlyBuffer = registry.createBuffer(instancesSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	crowdLateBuffer = registry.createBuffer(instancesSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// В первом кадре видимых в прошлом нет: всю толпу в поле зрения рисует поздняя фаза
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	vkCmdFillBuffer(commandBuffer, registry.buffer(crowdVisibilityBuffer), 0, VK_WHOLE_SIZE, 0);
+	endSingleTimeCommands(commandBuffer);
+
+	std::pair<BufferHandle, GraphResource> buffers[] = {
+		{crowdVisibilityBuffer, crowdVisibilityResource}, {crowdDrawBuffer, crowdDrawResource},
+		{crowdEarlyBuffer, crowdEarlyResource}, {crowdLateBuffer, crowdLateResource}};
+	for (const auto& buffer : buffers) {
+		tracker.trackBuffer(registry.buffer(buffer.first));
+		renderGraph.bindBuffer(buffer.second, registry.buffer(buffer.first));
+	}
+
+	// Уровень пирамиды: источник (глубина или предыдущий уровень) и записываемый уровень
+	std::array<VkDescriptorSetLayoutBinding, 2> pyramidBindings{};
+	pyramidBindings[0] = {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+	pyramidBindings[1] = {1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(pyramidBindings.size());
+	layoutInfo.pBindings = pyramidBindings.data();
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &depthPyramidSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create depth pyramid descriptor set layout");
+	}
+
+	// Отсечение: экземпляры, флаги видимости, команды, списки фаз и пирамида
+	std::array<VkDescriptorSetLayoutBinding, 6> cullBindings{};
+	for (uint32_t i = 0; i < cullBindings.size(); i++)
+		cullBindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+	cullBindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	layoutInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+	layoutInfo.pBindings = cullBindings.data();
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &occlusionSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create occlusion descriptor set layout");
+	}
+
+	VkPushConstantRange pyramidRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthPyramidParams)};
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &depthPyramidSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pyramidRange;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &depthPyramidLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create depth pyramid pipeline layout");
+	}
+
+	VkPushConstantRange cullRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(OcclusionParams)};
+	pipelineLayoutInfo.pSetLayouts = &occlusionSetLayout;
+	pipelineLayoutInfo.pPushConstantRanges = &cullRange;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &occlusionLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create occlusion pipeline layout");
+	}
+
+	depthPyramidPipeline = buildComputePipeline("build/shaders/depth_pyramid.spv", depthPyramidLayout);
+	occlusionPipeline = buildComputePipeline("build/shaders/occlusion_cull.spv", occlusionLayout);
+
+	// Наборы на наибольшее число уровней выделяются один раз на слот кадра: пересоздание пирамиды
+	// их не трогает, слот переписывает свои после ожидания своего кадра (updatePyramidSets)
+	std::vector<VkDescriptorSetLayout> layouts(MAX_PYRAMID_LEVELS, depthPyramidSetLayout);
+	layouts.push_back(occlusionSetLayout);
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+	allocInfo.pSetLayouts = layouts.data();
+	for (FrameContext& frame : frames) {
+		std::vector<VkDescriptorSet> sets(layouts.size());
+		if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, sets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("Unable to allocate depth pyramid descriptor sets");
+		}
+		frame.pyramidSets.assign(sets.begin(), sets.end() - 1);
+		frame.occlusionSet = sets.back();
+		frame.pyramidGeneration = 0;
+	}
+
+	createDepthPyramid();
+}
+
+// Вызывается после компиляции графа: вид глубины сцены меняется вместе с графом.
+// Прежняя пирамида освобождается, когда завершатся кадры в работе, - их наборы ещё ссылаются на неё
+void Vulkan::createDepthPyramid() {
+	if (depthPyramid.valid()) {
+		tracker.forget(registry.image(depthPyramid));
+		for (ImageViewHandle view : depthPyramidLevelViews)
+			registry.release(view);
+		registry.release(depthPyramidView);
+		registry.release(depthPyramid);
+	}
+
+	depthPyramid = registry.createImage(depthPyramidExtent.width, depthPyramidExtent.height, VK_FORMAT_R32_SFLOAT,
+				VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthPyramidLevels);
+	depthPyramidView = registry.createImageView(depthPyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_VIEW_TYPE_2D, 0, depthPyramidLevels);
+	depthPyramidLevelViews.resize(depthPyramidLevels);
+	for (uint32_t level = 0; level < depthPyramidLevels; level++)
+		depthPyramidLevelViews[level] = registry.createImageView(depthPyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT,
+					VK_IMAGE_VIEW_TYPE_2D, level, 1);
+	tracker.trackImage(registry.image(depthPyramid), VK_IMAGE_ASPECT_COLOR_BIT, depthPyramidLevels);
+	renderGraph.bindImage(depthPyramidResource, registry.image(depthPyramid), registry.view(depthPyramidView));
+	depthPyramidGeneration++;
+}
+
+// Наборы слота используются только кадрами этого слота: после ожидания кадра их можно переписать
+void Vulkan::updatePyramidSets(FrameContext& frame) {
+	if (occlusionPipeline == VK_NULL_HANDLE || frame.pyramidGeneration == depthPyramidGeneration)
+		return;
+	frame.pyramidGeneration = depthPyramidGeneration;
+
+	// Уровень 0 читает глубину сцены, уровень l - готовый уровень l - 1.
+	// Фильтрация не нужна: шейдеры читают тексели texelFetch
+	std::vector<VkDescriptorImageInfo> imageInfos(2 * depthPyramidLevels + 1);
+	std::vector<VkWriteDescriptorSet> writes;
+	for (uint32_t level = 0; level < depthPyramidLevels; level++) {
+		VkDescriptorImageInfo& source = imageInfos[2 * level];
+		VkDescriptorImageInfo& target = imageInfos[2 * level + 1];
+		source.sampler = textureSampler;
+		source.imageView = level == 0 ? renderGraph.view(sceneDepth) : registry.view(depthPyramidLevelViews[level - 1]);
+		source.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		target.imageView = registry.view(depthPyramidLevelViews[level]);
+		target.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = frame.pyramidSets[level];
+		write.descriptorCount = 1;
+		write.dstBinding = 0;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.pImageInfo = &source;
+		writes.push_back(write);
+		write.dstBinding = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		write.pImageInfo = &target;
+		writes.push_back(write);
+	}
+
+	VkDescriptorImageInfo& pyramid = imageInfos.back();
+	pyramid.sampler = textureSampler;
+	pyramid.imageView = registry.view(depthPyramidView);
+	pyramid.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorBufferInfo bufferInfos[5] = {
+		{registry.buffer(crowdInstanceBuffer), 0, VK_WHOLE_SIZE},
+		{registry.buffer(crowdVisibilityBuffer), 0, VK_WHOLE_SIZE},
+		{registry.buffer(crowdDrawBuffer), 0, VK_WHOLE_SIZE},
+		{registry.buffer(crowdEarlyBuffer), 0, VK_WHOLE_SIZE},
+		{registry.buffer(crowdLateBuffer), 0, VK_WHOLE_SIZE}};
+	for (uint32_t i = 0; i < 6; i++) {
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = frame.occlusionSet;
+		write.dstBinding = i;
+		write.descriptorCount = 1;
+		if (i < 5) {
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.pBufferInfo = &bufferInfos[i];
+		} else {
+			write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			write.pImageInfo = &pyramid;
+		}
+		writes.push_back(write);
+	}
+	vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+// Проход графа перед ранней фазой: число индексов постоянно, число экземпляров набирают шейдеры
+void Vulkan::recordOcclusionReset(VkCommandBuffer commandBuffer) {
+	VkDrawIndexedIndirectCommand commands[2] = {};
+	commands[0].indexCount = static_cast<uint32_t>(modelIndices.size());
+	commands[1].indexCount = static_cast<uint32_t>(modelIndices.size());
+	vkCmdUpdateBuffer(commandBuffer, registry.buffer(crowdDrawBuffer), 0, sizeof(commands), commands);
+}
+
+// Ранняя фаза выбирает видимых в прошлом кадре в пирамиде зрения,
+// поздняя проверяет всех по пирамиде и обновляет флаги видимости
+void Vulkan::recordOcclusionCull(VkCommandBuffer commandBuffer, CullPhase phase) {
+	OcclusionParams params;
+	params.view = viewMatrix;
+	params.projection = glm::vec4(projMatrix[0][0], projMatrix[1][1], projMatrix[2][2], projMatrix[3][2]);
+	params.bounds = crowdBounds;
+	params.pyramidSize = glm::uvec2(depthPyramidExtent.width, depthPyramidExtent.height);
+	params.znear = 0.1f;
+	params.count = scene.crowd;
+	params.phase = static_cast<uint32_t>(phase);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusionPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusionLayout, 0, 1, &frames[currentFrame].occlusionSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, occlusionLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+	vkCmdDispatch(commandBuffer, (scene.crowd + OCCLUSION_GROUP - 1) / OCCLUSION_GROUP, 1, 1);
+}
+
+// Уровни по очереди: каждый после записи переводится в чтение для следующего и для отсечения
+void Vulkan::recordDepthPyramid(VkCommandBuffer commandBuffer) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidPipeline);
+
+	const std::vector<VkDescriptorSet>& sets = frames[currentFrame].pyramidSets;
+	VkImage image = registry.image(depthPyramid);
+	glm::ivec2 source(renderExtent.width, renderExtent.height);
+	for (uint32_t level = 0; level < depthPyramidLevels; level++) {
+		glm::ivec2 target(std::max(1u, depthPyramidExtent.width >> level), std::max(1u, depthPyramidExtent.height >> level));
+		DepthPyramidParams params = {source, target};
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidLayout,
+								0, 1, &sets[level], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, depthPyramidLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+		vkCmdDispatch(commandBuffer, (target.x + DEPTH_PYRAMID_GROUP - 1) / DEPTH_PYRAMID_GROUP,
+					(target.y + DEPTH_PYRAMID_GROUP - 1) / DEPTH_PYRAMID_GROUP, 1);
+
+		tracker.use(image, resourceState(ResourceUsage::ComputeShaderRead), level, 1);
+		tracker.flush(commandBuffer);
+		source = target;
+	}
+}
+
+// Проход поздней фазы загружает цвет и глубину ранней
+void Vulkan::recordSceneLate(VkCommandBuffer commandBuffer) {
+	setSceneViewport(commandBuffer);
+	recordCrowd(commandBuffer, CullPhase::Late);
+}
+
+void Vulkan::destroyOcclusion() {
+	if (occlusionPipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(logicalDevice, occlusionPipeline, nullptr);
+	if (depthPyramidPipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(logicalDevice, depthPyramidPipeline, nullptr);
+	if (occlusionLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(logicalDevice, occlusionLayout, nullptr);
+	if (depthPyramidLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(logicalDevice, depthPyramidLayout, nullptr);
+	if (occlusionSetLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(logicalDevice, occlusionSetLayout, nullptr);
+	if (depthPyramidSetLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(logicalDevice, depthPyramidSetLayout, nullptr);
+}
+
+void Vulkan::createCpuOcclusion() {
+	occlusionRasterizer.resize(OCCLUSION_RASTER_WIDTH, OCCLUSION_RASTER_HEIGHT);
+	crowdVisible.assign(scene.crowd, 0);
+	crowdVisibleBuffer = registry.createBuffer(sizeof(CrowdInstance) * scene.crowd * states.FRAMES_IN_FLIGHT,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+// Вызывается после ожидания кадра: его участок буфера видимых свободен.
+// Экземпляр проверяется прямоугольником, описанным вокруг его сферы
+void Vulkan::cullCrowdOnCpu() {
+	if (!crowdVisibleBuffer.valid())
+		return;
+	PROFILE_FUNCTION();
+
+	glm::mat4 viewProj = projMatrix * viewMatrix;
+	occlusionRasterizer.clear();
+	occlusionRasterizer.render(terrain.occluderVertices(), terrain.occluderIndices(), viewProj, &workers);
+
+	glm::vec3 bounds = glm::vec3(crowdBounds);
+	glm::vec3 extent(crowdBounds.w);
+	workers.parallelFor(0, scene.crowd, CPU_OCCLUSION_GRAIN, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const glm::vec4& placement = crowdInstances[i].placement;
+			float s = std::sin(placement.w);
+			float c = std::cos(placement.w);
+			glm::vec3 center = glm::vec3(c * bounds.x + s * bounds.z, bounds.y, -s * bounds.x + c * bounds.z) + glm::vec3(placement);
+			crowdVisible[i] = occlusionRasterizer.visible(center - extent, center + extent, viewProj) ? 1 : 0;
+		}
+	});
+
+	// Порядок экземпляров сохраняется
+	crowdVisibleOffset = sizeof(CrowdInstance) * scene.crowd * currentFrame;
+	CrowdInstance* target = reinterpret_cast<CrowdInstance*>(static_cast<char*>(registry.map(crowdVisibleBuffer)) + crowdVisibleOffset);
+	crowdVisibleCount = 0;
+	for (uint32_t i = 0; i < scene.crowd; i++)
+		if (crowdVisible[i])
+			target[crowdVisibleCount++] = crowdInstances[i];
+}
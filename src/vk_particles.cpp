@@ -0,0 +1,225 @@
+#include "vk.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <stdexcept>
+
+// Push-константы шага сортировки
+typedef struct _ParticleSortParams
+{
+	uint32_t mode;
+	uint32_t k;
+	uint32_t j;
+} ParticleSortParams;
+
+static const float PARTICLE_SPREAD = 1.5f; // горизонтальная скорость фонтана, м/с
+static const uint32_t PARTICLE_BINDINGS = 7; // пул, свободные, живые, счётчики, запуски, отрисовка, список видимых
+
+void Vulkan::createParticles() {
+	PROFILE_FUNCTION();
+
+	particleCapacity = std::min(scene.particles, MAX_PARTICLES);
+	VkDeviceSize deadSize = sizeof(uint32_t) * particleCapacity;
+
+	// Буферы только для GPU: CPU один раз пишет список свободных и счётчики
+	particleBuffer = registry.createBuffer(sizeof(Particle) * particleCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	particleDeadBuffer = registry.createBuffer(deadSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	particleAliveBuffer = registry.createBuffer(2 * sizeof(uint32_t) * particleCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	particleCounterBuffer = registry.createBuffer(sizeof(ParticleCounters),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	particleDispatchBuffer = registry.createBuffer(sizeof(ParticleDispatch),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	particleDrawBuffer = registry.createBuffer(sizeof(VkDrawIndirectCommand),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	particleDrawListBuffer = registry.createBuffer(sizeof(glm::uvec2) * particleCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// Все частицы свободны. Текущий список - 1: начальный проход первого кадра переключит на 0
+	BufferHandle staging = registry.createBuffer(deadSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	uint32_t* dead = static_cast<uint32_t*>(registry.map(staging));
+	std::iota(dead, dead + particleCapacity, 0u);
+	ParticleCounters counters = {1, {0, 0}, particleCapacity, 0};
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	vkCmdUpdateBuffer(commandBuffer, registry.buffer(particleCounterBuffer), 0, sizeof(counters), &counters);
+	VkBufferCopy region = {0, 0, deadSize};
+	vkCmdCopyBuffer(commandBuffer, registry.buffer(staging), registry.buffer(particleDeadBuffer), 1, &region);
+	endSingleTimeCommands(commandBuffer);
+	registry.release(staging);
+
+	std::pair<BufferHandle, GraphResource> buffers[PARTICLE_BINDINGS] = {
+		{particleBuffer, particleResource}, {particleDeadBuffer, particleDeadResource},
+		{particleAliveBuffer, particleAliveResource}, {particleCounterBuffer, particleCounterResource},
+		{particleDispatchBuffer, particleDispatchResource}, {particleDrawBuffer, particleDrawResource},
+		{particleDrawListBuffer, particleDrawListResource}};
+	for (const auto& buffer : buffers) {
+		tracker.trackBuffer(registry.buffer(buffer.first));
+		renderGraph.bindBuffer(buffer.second, registry.buffer(buffer.first));
+	}
+
+	// Один набор на все проходы: вершинный шейдер читает пул и список видимых
+	std::array<VkDescriptorSetLayoutBinding, PARTICLE_BINDINGS> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); i++)
+		bindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT, nullptr};
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &particleSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create particle descriptor set layout");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &particleSetLayout;
+	if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, &particleSet) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to allocate particle descriptor set");
+	}
+
+	std::array<VkDescriptorBufferInfo, PARTICLE_BINDINGS> bufferInfos{};
+	std::array<VkWriteDescriptorSet, PARTICLE_BINDINGS> writes{};
+	for (uint32_t i = 0; i < writes.size(); i++) {
+		bufferInfos[i] = {registry.buffer(buffers[i].first), 0, VK_WHOLE_SIZE};
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = particleSet;
+		writes[i].dstBinding = i;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].descriptorCount = 1;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	VkPushConstantRange computeRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ParticleParams)};
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &particleSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &computeRange;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &particleComputeLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create particle compute pipeline layout");
+	}
+
+	VkPushConstantRange sortRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ParticleSortParams)};
+	pipelineLayoutInfo.pPushConstantRanges = &sortRange;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &particleSortLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create particle sort pipeline layout");
+	}
+
+	// Графический конвейер: набор 0 общий с моделью (матрицы камеры), набор 1 - буферы частиц
+	VkDescriptorSetLayout setLayouts[] = {descriptorSetLayout, particleSetLayout};
+	pipelineLayoutInfo.setLayoutCount = 2;
+	pipelineLayoutInfo.pSetLayouts = setLayouts;
+	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &particlePipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create particle pipeline layout");
+	}
+
+	particleKickoffPipeline = buildComputePipeline("build/shaders/particle_kickoff.spv", particleComputeLayout);
+	particleEmitPipeline = buildComputePipeline("build/shaders/particle_emit.spv", particleComputeLayout);
+	particleSimulatePipeline = buildComputePipeline("build/shaders/particle_simulate.spv", particleComputeLayout);
+	particleCompactPipeline = buildComputePipeline("build/shaders/particle_compact.spv", particleComputeLayout);
+	if (states.PARTICLE_SORT) {
+		particleSortPipeline = buildComputePipeline("build/shaders/particle_sort.spv", particleSortLayout);
+		particleSortSteps(particleCapacity, particleSortSchedule);
+	}
+	particlePipeline = buildParticlePipeline();
+}
+
+// Без вершинных привязок: спрайт строится по номеру вершины, частица - по номеру экземпляра
+VkPipeline Vulkan::buildParticlePipeline() {
+	VkPipelineVertexInputStateCreateInfo vertexInput{};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	return buildGraphicsPipeline("build/shaders/particle_vert.spv", "build/shaders/particle_frag.spv",
+								&vertexInput, particlePipelineLayout, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, true);
+}
+
+// После ожидания кадра: шаг по времени анимации и запрос рождений с переносом дробной части
+void Vulkan::updateParticles() {
+	if (particlePipeline == VK_NULL_HANDLE)
+		return;
+
+	float step = std::clamp(animationTime - particleTime, 0.0f, PARTICLE_MAX_STEP);
+	particleTime = animationTime;
+	particleEmitCarry += particleEmitRate(particleCapacity) * step;
+	uint32_t request = static_cast<uint32_t>(particleEmitCarry);
+	particleEmitCarry -= request;
+
+	particleParams.viewProj = projMatrix * viewMatrix;
+	particleParams.emitter = glm::vec4(scene.emitter, PARTICLE_SPREAD);
+	particleParams.camera = glm::vec4(cameraPos, step);
+	particleParams.capacity = particleCapacity;
+	particleParams.emitRequest = request;
+	particleParams.seed++;
+}
+
+// Начальный проход графа: один поток готовит списки и аргументы остальных
+void Vulkan::recordParticleKickoff(VkCommandBuffer commandBuffer) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleKickoffPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleComputeLayout, 0, 1, &particleSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, particleComputeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(particleParams), &particleParams);
+	vkCmdDispatch(commandBuffer, 1, 1, 1);
+}
+
+// Рождение, симуляция или сжатие: число групп записал начальный проход
+void Vulkan::recordParticleStage(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkDeviceSize dispatchOffset) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleComputeLayout, 0, 1, &particleSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, particleComputeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(particleParams), &particleParams);
+	vkCmdDispatchIndirect(commandBuffer, registry.buffer(particleDispatchBuffer), dispatchOffset);
+}
+
+// Шаги сортировки по расписанию на весь пул; число видимых шейдер читает из команды
+// отрисовки, группы за ним выходят сразу. Между шагами - барьер записи списка видимых
+void Vulkan::recordParticleSort(VkCommandBuffer commandBuffer) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleSortPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleSortLayout, 0, 1, &particleSet, 0, nullptr);
+
+	VkBuffer drawList = registry.buffer(particleDrawListBuffer);
+	uint32_t groups = particleSortSchedule.back().k / PARTICLE_SORT_BLOCK;
+	for (size_t i = 0; i < particleSortSchedule.size(); i++) {
+		if (i > 0) {
+			tracker.use(drawList, ResourceUsage::ComputeShaderReadWrite);
+			tracker.flush(commandBuffer);
+		}
+		const ParticleSortStep& step = particleSortSchedule[i];
+		ParticleSortParams params = {static_cast<uint32_t>(step.mode), step.k, step.j};
+		vkCmdPushConstants(commandBuffer, particleSortLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+		vkCmdDispatch(commandBuffer, groups, 1, 1);
+	}
+}
+
+// Проход после непрозрачной сцены: один косвенный вызов, число экземпляров записало сжатие
+void Vulkan::recordParticleDraw(VkCommandBuffer commandBuffer) {
+	setSceneViewport(commandBuffer);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, particlePipeline);
+
+	VkDescriptorSet sets[] = {descriptorSet, particleSet};
+	uint32_t dynamicOffsets[] = {sceneUniformOffset, paletteOffset};
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, particlePipelineLayout,
+							0, 2, sets, 2, dynamicOffsets);
+	vkCmdDrawIndirect(commandBuffer, registry.buffer(particleDrawBuffer), 0, 1, sizeof(VkDrawIndirectCommand));
+}
+
+void Vulkan::destroyParticles() {
+	VkPipeline pipelines[] = {particlePipeline, particleSortPipeline, particleCompactPipeline,
+							  particleSimulatePipeline, particleEmitPipeline, particleKickoffPipeline};
+	for (VkPipeline pipeline : pipelines)
+		if (pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+	VkPipelineLayout layouts[] = {particlePipelineLayout, particleSortLayout, particleComputeLayout};
+	for (VkPipelineLayout layout : layouts)
+		if (layout != VK_NULL_HANDLE)
+			vkDestroyPipelineLayout(logicalDevice, layout, nullptr);
+	if (particleSetLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(logicalDevice, particleSetLayout, nullptr);
+}
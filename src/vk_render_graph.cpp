@@ -0,0 +1,238 @@
+#include "vk.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Объявление проходов кадра.
+// Глубина - временное изображение графа: без отсечения по пирамиде глубины содержимое после прохода
+// сцены не нужно, поэтому граф не сохраняет его (DONT_CARE) и размещает в лениво выделяемой памяти,
+// если она есть; с отсечением её читают построение пирамиды и поздняя фаза.
+// При динамическом разрешении цели сцены имеют наибольший размер, кадр рисуется в их часть
+// (область просмотра), и смена масштаба не требует пересборки графа
+void Vulkan::buildRenderGraph() {
+	renderGraph.reset();
+
+	VkExtent2D extent = surface.selectedExtent;
+
+	// После захвата содержимое изображения не определено, семафор захвата ожидается на стадии вывода цвета.
+	// Внеэкранное изображение ничего не ждёт (его освобождение проверено на CPU) и после кадра
+	// остаётся источником копирования
+	ResourceState acquired = {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED};
+	if (headless)
+		acquired.stages = VK_PIPELINE_STAGE_2_NONE;
+	backbuffer = renderGraph.importImage("backbuffer",
+				{extent, surface.selectedFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 0},
+				headless ? ResourceUsage::TransferSrc : ResourceUsage::Present, &acquired);
+
+	VkExtent2D targetExtent = states.DYNAMIC_RESOLUTION ? resolution.maxExtent(extent) : extent;
+	sceneColor = states.DYNAMIC_RESOLUTION
+		? renderGraph.createImage("sceneColor", {targetExtent, surface.selectedFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 0})
+		: backbuffer;
+
+	sceneDepth = renderGraph.createImage("depth",
+				{targetExtent, findDepthFormat(), VK_IMAGE_ASPECT_DEPTH_BIT, 0});
+
+	// Отсечение толпы: ранняя фаза рисует видимых в прошлом кадре, после неё строится пирамида
+	// наибольших глубин, поздняя фаза дорисовывает ставших видимыми
+	bool occlusion = states.OCCLUSION_CULLING && scene.crowd > 0;
+	if (occlusion) {
+		crowdVisibilityResource = renderGraph.importBuffer("crowd visibility", ResourceUsage::ComputeShaderReadWrite);
+		crowdDrawResource = renderGraph.importBuffer("crowd draws", ResourceUsage::IndirectBuffer);
+		crowdEarlyResource = renderGraph.importBuffer("crowd early", ResourceUsage::VertexBuffer);
+		crowdLateResource = renderGraph.importBuffer("crowd late", ResourceUsage::VertexBuffer);
+		if (crowdVisibilityBuffer.valid()) {
+			renderGraph.bindBuffer(crowdVisibilityResource, registry.buffer(crowdVisibilityBuffer));
+			renderGraph.bindBuffer(crowdDrawResource, registry.buffer(crowdDrawBuffer));
+			renderGraph.bindBuffer(crowdEarlyResource, registry.buffer(crowdEarlyBuffer));
+			renderGraph.bindBuffer(crowdLateResource, registry.buffer(crowdLateBuffer));
+		}
+
+		// Степень двойки по каждой оси: уровни делятся ровно пополам
+		depthPyramidExtent = {1u << static_cast<uint32_t>(std::log2(targetExtent.width)),
+							  1u << static_cast<uint32_t>(std::log2(targetExtent.height))};
+		depthPyramidLevels = static_cast<uint32_t>(std::log2(std::max(depthPyramidExtent.width, depthPyramidExtent.height))) + 1;
+		depthPyramidResource = renderGraph.importImage("depth pyramid",
+					{depthPyramidExtent, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 0}, ResourceUsage::ComputeShaderRead);
+
+		renderGraph.addPass("cull reset", [this](VkCommandBuffer commandBuffer) { recordOcclusionReset(commandBuffer); })
+			.write(crowdDrawResource, ResourceUsage::TransferDst);
+		renderGraph.addPass("cull early", [this](VkCommandBuffer commandBuffer) { recordOcclusionCull(commandBuffer, CullPhase::Early); })
+			.read(crowdVisibilityResource, ResourceUsage::ComputeShaderRead)
+			.write(crowdDrawResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(crowdEarlyResource, ResourceUsage::ComputeShaderWrite);
+	}
+
+	// Источники раздаются по кластерам до прохода сцены: сброс счётчика общего списка, затем распределение
+	bool lighting = scene.lights > 0;
+	if (lighting) {
+		lightClusterResource = renderGraph.importBuffer("light clusters", ResourceUsage::FragmentShaderRead);
+		lightIndexResource = renderGraph.importBuffer("light indices", ResourceUsage::FragmentShaderRead);
+		lightOverflowResource = renderGraph.importBuffer("light overflow", ResourceUsage::HostRead);
+		if (lightClusterBuffer.valid()) {
+			renderGraph.bindBuffer(lightClusterResource, registry.buffer(lightClusterBuffer));
+			renderGraph.bindBuffer(lightIndexResource, registry.buffer(lightIndexBuffer));
+			renderGraph.bindBuffer(lightOverflowResource, registry.buffer(lightOverflowBuffer));
+		}
+		renderGraph.addPass("light reset", [this](VkCommandBuffer commandBuffer) { recordLightReset(commandBuffer); })
+			.write(lightIndexResource, ResourceUsage::TransferDst);
+		renderGraph.addPass("light cull", [this](VkCommandBuffer commandBuffer) { recordLightCull(commandBuffer); })
+			.write(lightClusterResource, ResourceUsage::ComputeShaderWrite)
+			.write(lightIndexResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(lightOverflowResource, ResourceUsage::ComputeShaderReadWrite);
+	}
+
+	// Сетка высот пересчитывается до прохода сцены; граф ставит барьер запись -> чтение в вершинном шейдере
+	if (scene.heightfield > 1) {
+		heightfieldResource = renderGraph.importBuffer("heightfield", ResourceUsage::VertexShaderRead);
+		if (heightfieldBuffer.valid())
+			renderGraph.bindBuffer(heightfieldResource, registry.buffer(heightfieldBuffer));
+		renderGraph.addPass("heightfield", [this](VkCommandBuffer commandBuffer) { recordHeightfieldUpdate(commandBuffer); })
+			.write(heightfieldResource, ResourceUsage::ComputeShaderWrite);
+	}
+
+	// Слои высот ландшафта: загрузка открывшихся рядов до прохода сцены
+	if (!scene.terrain.empty()) {
+		terrainResource = renderGraph.importImage("terrain",
+					{{TERRAIN_WINDOW, TERRAIN_WINDOW}, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 0},
+					ResourceUsage::VertexShaderRead);
+		if (terrainImage.valid())
+			renderGraph.bindImage(terrainResource, registry.image(terrainImage), registry.view(terrainView));
+		renderGraph.addPass("terrain upload", [this](VkCommandBuffer commandBuffer) { recordTerrainUpload(commandBuffer); })
+			.write(terrainResource, ResourceUsage::TransferDst);
+	}
+
+	// Каскады теней до прохода сцены; слои между вложением и копированием кэша проход переводит сам
+	uint32_t shadowSize = states.SHADOWS ? SHADOW_MAP_SIZE : 1;
+	shadowResource = renderGraph.importImage("shadow map",
+				{{shadowSize, shadowSize}, VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 0}, ResourceUsage::DepthShaderRead);
+	if (shadowMap.valid())
+		renderGraph.bindImage(shadowResource, registry.image(shadowMap), registry.view(shadowMapView));
+	renderGraph.addPass("shadows", [this](VkCommandBuffer commandBuffer) { recordShadows(commandBuffer); })
+		.write(shadowResource, ResourceUsage::DepthAttachment);
+
+	// Частицы: начальный проход, рождение, симуляция и сжатие с косвенными запусками, затем
+	// сортировка видимых; рисуются отдельным проходом поверх непрозрачной сцены
+	bool particles = scene.particles > 0;
+	if (particles) {
+		particleResource = renderGraph.importBuffer("particles", ResourceUsage::VertexShaderRead);
+		particleDeadResource = renderGraph.importBuffer("particle dead list", ResourceUsage::ComputeShaderReadWrite);
+		particleAliveResource = renderGraph.importBuffer("particle alive lists", ResourceUsage::ComputeShaderReadWrite);
+		particleCounterResource = renderGraph.importBuffer("particle counters", ResourceUsage::ComputeShaderReadWrite);
+		particleDispatchResource = renderGraph.importBuffer("particle dispatch", ResourceUsage::IndirectBuffer);
+		particleDrawResource = renderGraph.importBuffer("particle draw", ResourceUsage::IndirectBuffer);
+		particleDrawListResource = renderGraph.importBuffer("particle draw list", ResourceUsage::VertexShaderRead);
+		if (particleBuffer.valid()) {
+			renderGraph.bindBuffer(particleResource, registry.buffer(particleBuffer));
+			renderGraph.bindBuffer(particleDeadResource, registry.buffer(particleDeadBuffer));
+			renderGraph.bindBuffer(particleAliveResource, registry.buffer(particleAliveBuffer));
+			renderGraph.bindBuffer(particleCounterResource, registry.buffer(particleCounterBuffer));
+			renderGraph.bindBuffer(particleDispatchResource, registry.buffer(particleDispatchBuffer));
+			renderGraph.bindBuffer(particleDrawResource, registry.buffer(particleDrawBuffer));
+			renderGraph.bindBuffer(particleDrawListResource, registry.buffer(particleDrawListBuffer));
+		}
+
+		renderGraph.addPass("particle kickoff", [this](VkCommandBuffer commandBuffer) { recordParticleKickoff(commandBuffer); })
+			.write(particleCounterResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(particleDispatchResource, ResourceUsage::ComputeShaderWrite)
+			.write(particleDrawResource, ResourceUsage::ComputeShaderWrite);
+		renderGraph.addPass("particle emit", [this](VkCommandBuffer commandBuffer) {
+				recordParticleStage(commandBuffer, particleEmitPipeline, offsetof(ParticleDispatch, emit)); })
+			.read(particleDispatchResource, ResourceUsage::IndirectBuffer)
+			.write(particleCounterResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(particleDeadResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(particleAliveResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(particleResource, ResourceUsage::ComputeShaderWrite);
+		renderGraph.addPass("particle simulate", [this](VkCommandBuffer commandBuffer) {
+				recordParticleStage(commandBuffer, particleSimulatePipeline, offsetof(ParticleDispatch, simulate)); })
+			.read(particleDispatchResource, ResourceUsage::IndirectBuffer)
+			.read(particleCounterResource, ResourceUsage::ComputeShaderRead)
+			.read(particleAliveResource, ResourceUsage::ComputeShaderRead)
+			.write(particleResource, ResourceUsage::ComputeShaderReadWrite);
+		renderGraph.addPass("particle compact", [this](VkCommandBuffer commandBuffer) {
+				recordParticleStage(commandBuffer, particleCompactPipeline, offsetof(ParticleDispatch, simulate)); })
+			.read(particleDispatchResource, ResourceUsage::IndirectBuffer)
+			.read(particleResource, ResourceUsage::ComputeShaderRead)
+			.write(particleCounterResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(particleDeadResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(particleAliveResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(particleDrawResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(particleDrawListResource, ResourceUsage::ComputeShaderWrite);
+		if (states.PARTICLE_SORT)
+			renderGraph.addPass("particle sort", [this](VkCommandBuffer commandBuffer) { recordParticleSort(commandBuffer); })
+				.read(particleDrawResource, ResourceUsage::ComputeShaderRead)
+				.write(particleDrawListResource, ResourceUsage::ComputeShaderReadWrite);
+	}
+
+	PassBuilder scenePass = renderGraph.addPass("scene", [this](VkCommandBuffer commandBuffer) { recordScene(commandBuffer); })
+		.color(sceneColor, VK_ATTACHMENT_LOAD_OP_CLEAR, {{0.0f, 0.0f, 0.0f, 1.0f}})
+		.depth(sceneDepth, VK_ATTACHMENT_LOAD_OP_CLEAR, {1.0f, 0}) // Глубина очищается в 1.0 (дальняя плоскость)
+		.read(shadowResource, ResourceUsage::DepthShaderRead);
+	if (scene.heightfield > 1)
+		scenePass.read(heightfieldResource, ResourceUsage::VertexShaderRead);
+	if (!scene.terrain.empty())
+		scenePass.read(terrainResource, ResourceUsage::VertexShaderRead);
+	if (lighting)
+		scenePass.read(lightClusterResource, ResourceUsage::FragmentShaderRead)
+			.read(lightIndexResource, ResourceUsage::FragmentShaderRead);
+	if (occlusion)
+		scenePass.read(crowdEarlyResource, ResourceUsage::VertexBuffer)
+			.read(crowdDrawResource, ResourceUsage::IndirectBuffer);
+
+	// Глубина дальняя при clear 1.0 и сравнении LESS: уровень пирамиды хранит наибольшую глубину области
+	if (occlusion) {
+		renderGraph.addPass("depth pyramid", [this](VkCommandBuffer commandBuffer) { recordDepthPyramid(commandBuffer); })
+			.read(sceneDepth, ResourceUsage::DepthShaderRead)
+			.write(depthPyramidResource, ResourceUsage::ComputeShaderWrite);
+		renderGraph.addPass("cull late", [this](VkCommandBuffer commandBuffer) { recordOcclusionCull(commandBuffer, CullPhase::Late); })
+			.read(depthPyramidResource, ResourceUsage::ComputeShaderRead)
+			.write(crowdVisibilityResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(crowdDrawResource, ResourceUsage::ComputeShaderReadWrite)
+			.write(crowdLateResource, ResourceUsage::ComputeShaderWrite);
+		PassBuilder latePass = renderGraph.addPass("scene late", [this](VkCommandBuffer commandBuffer) { recordSceneLate(commandBuffer); })
+			.color(sceneColor, VK_ATTACHMENT_LOAD_OP_LOAD)
+			.depth(sceneDepth, VK_ATTACHMENT_LOAD_OP_LOAD)
+			.read(crowdLateResource, ResourceUsage::VertexBuffer)
+			.read(crowdDrawResource, ResourceUsage::IndirectBuffer)
+			.read(shadowResource, ResourceUsage::DepthShaderRead);
+		if (lighting)
+			latePass.read(lightClusterResource, ResourceUsage::FragmentShaderRead)
+				.read(lightIndexResource, ResourceUsage::FragmentShaderRead);
+	}
+
+	// Глубина непрозрачной сцены только проверяется: спрайты не заслоняют друг друга
+	if (particles)
+		renderGraph.addPass("particles", [this](VkCommandBuffer commandBuffer) { recordParticleDraw(commandBuffer); })
+			.color(sceneColor, VK_ATTACHMENT_LOAD_OP_LOAD)
+			.depth(sceneDepth, VK_ATTACHMENT_LOAD_OP_LOAD, {1.0f, 0}, true)
+			.read(particleResource, ResourceUsage::VertexShaderRead)
+			.read(particleDrawListResource, ResourceUsage::VertexShaderRead)
+			.read(particleDrawResource, ResourceUsage::IndirectBuffer);
+
+	if (states.DYNAMIC_RESOLUTION)
+		renderGraph.addPass("upscale", [this](VkCommandBuffer commandBuffer) { recordUpscale(commandBuffer); })
+			.read(sceneColor, ResourceUsage::TransferSrc)
+			.write(backbuffer, ResourceUsage::TransferDst);
+
+	renderGraph.compile();
+	renderPass = renderGraph.renderPass("scene");
+	renderGraph.attachmentFormats("scene", sceneColorFormats, sceneDepthFormat);
+
+	// Наборы пирамиды ссылаются на вид глубины, созданный компиляцией
+	if (occlusion && occlusionPipeline != VK_NULL_HANDLE)
+		createDepthPyramid();
+}
+
+// Растяжение внутреннего разрешения на изображение списка показа с билинейной фильтрацией
+void Vulkan::recordUpscale(VkCommandBuffer commandBuffer) {
+	VkImageBlit region{};
+	region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.srcOffsets[1] = {static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1};
+	region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.dstOffsets[1] = {static_cast<int32_t>(surface.selectedExtent.width), static_cast<int32_t>(surface.selectedExtent.height), 1};
+
+	vkCmdBlitImage(commandBuffer,
+				renderGraph.image(sceneColor), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				renderGraph.image(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &region, VK_FILTER_LINEAR);
+}
@@ -0,0 +1,357 @@
+#include "vk.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+static const VkFormat SHADOW_FORMAT = VK_FORMAT_D32_SFLOAT;
+static const float SUN_INTENSITY = 0.75f; // рассеянный свет солнца, фон - в writeLightingUniforms
+static const uint32_t SHADOW_CULL_GRAIN = 256; // экземпляров толпы на участок рабочего потока
+
+// Карта теней есть и без теней: набор 0 ссылается на неё, шейдеры при нулевой яркости солнца
+// её не читают. Тогда слои занимают по текселю
+void Vulkan::createShadows() {
+	PROFILE_FUNCTION();
+	shadowCascades.setLight(-scene.sun);
+
+	uint32_t size = states.SHADOWS ? SHADOW_MAP_SIZE : 1;
+	shadowMap = registry.createImage(size, size, SHADOW_FORMAT, VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1, SHADOW_CASCADES);
+	shadowMapView = registry.createImageView(shadowMap, SHADOW_FORMAT, VK_IMAGE_ASPECT_DEPTH_BIT,
+				VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, 1, 0, SHADOW_CASCADES);
+	for (uint32_t layer = 0; layer < SHADOW_CASCADES; layer++)
+		shadowLayerViews.push_back(registry.createImageView(shadowMap, SHADOW_FORMAT, VK_IMAGE_ASPECT_DEPTH_BIT,
+					VK_IMAGE_VIEW_TYPE_2D, 0, 1, layer, 1));
+	tracker.trackImage(registry.image(shadowMap), VK_IMAGE_ASPECT_DEPTH_BIT, 1, SHADOW_CASCADES);
+	renderGraph.bindImage(shadowResource, registry.image(shadowMap), registry.view(shadowMapView));
+
+	// Глубина ландшафта кэшируемых каскадов живёт между кадрами и копируется в их слои
+	const uint32_t cached = SHADOW_CASCADES - SHADOW_CACHED_FROM;
+	shadowStaticMap = registry.createImage(size, size, SHADOW_FORMAT, VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1, cached);
+	for (uint32_t layer = 0; layer < cached; layer++)
+		shadowStaticViews.push_back(registry.createImageView(shadowStaticMap, SHADOW_FORMAT, VK_IMAGE_ASPECT_DEPTH_BIT,
+					VK_IMAGE_VIEW_TYPE_2D, 0, 1, layer, 1));
+	tracker.trackImage(registry.image(shadowStaticMap), VK_IMAGE_ASPECT_DEPTH_BIT, 1, cached);
+
+	// Сравнение с глубиной карты и билинейная фильтрация результатов; вне карты - свет
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	samplerInfo.maxLod = 0.0f;
+	if (vkCreateSampler(logicalDevice, &samplerInfo, nullptr, &shadowSampler) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create shadow sampler");
+	}
+}
+
+void Vulkan::createShadowPipelines() {
+	if (!states.SHADOWS)
+		return;
+
+	shadowPipeline = buildModelShadowPipeline();
+	if (crowdPipeline != VK_NULL_HANDLE)
+		crowdShadowPipeline = buildCrowdPipeline(true);
+	if (terrainPipeline != VK_NULL_HANDLE)
+		terrainShadowPipeline = buildTerrainPipeline(true);
+
+	// Списки заслонок толпы пишет CPU до записи команд, как списки отсечения по камере
+	if (crowdShadowPipeline != VK_NULL_HANDLE) {
+		crowdShadowMask.assign(scene.crowd, 0);
+		crowdShadowBuffer = registry.createBuffer(sizeof(CrowdInstance) * scene.crowd * SHADOW_CASCADES * states.FRAMES_IN_FLIGHT,
+					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	}
+}
+
+// Конвейер глубины: только вершинный шейдер, вложение глубины формата карты теней.
+// Обе стороны треугольников - заслонки; наклонное смещение глубины против самозатенения
+VkPipeline Vulkan::buildShadowPipeline(const char * vertPath, const VkPipelineVertexInputStateCreateInfo& vertexInput,
+		VkPipelineLayout layout, VkPrimitiveTopology topology) {
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = topology;
+
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+	VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterizer.depthBiasEnable = VK_TRUE;
+	rasterizer.depthBiasConstantFactor = 2.0f;
+	rasterizer.depthBiasSlopeFactor = 2.5f;
+
+	VkPipelineMultisampleStateCreateInfo multisampling{};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.maxDepthBounds = 1.0f;
+
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+
+	VkShaderModule vertShaderModule = createShaderModule(vertPath);
+	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertShaderStageInfo.module = vertShaderModule;
+	vertShaderStageInfo.pName = "main";
+
+	// Каскады рисуются вне графа через vkCmdBeginRendering: без проходов рендера
+	VkPipelineRenderingCreateInfo renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	renderingInfo.depthAttachmentFormat = SHADOW_FORMAT;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.pNext = &renderingInfo;
+	pipelineInfo.stageCount = 1;
+	pipelineInfo.pStages = &vertShaderStageInfo;
+	pipelineInfo.pVertexInputState = &vertexInput;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.layout = layout;
+
+	VkPipeline pipeline;
+	VkResult result = vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+	vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create shadow pipeline");
+	}
+	return pipeline;
+}
+
+// Модель: из потока вершин читается только положение, из потока скиннинга - суставы и веса
+VkPipeline Vulkan::buildModelShadowPipeline() {
+	VkVertexInputBindingDescription bindings[2] = {};
+	bindings[0] = {0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX};
+	bindings[1] = {1, sizeof(SkinnedVertex), VK_VERTEX_INPUT_RATE_VERTEX};
+
+	VkVertexInputAttributeDescription attributes[3] = {};
+	attributes[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)};
+	attributes[1] = {3, 1, VK_FORMAT_R16G16B16A16_UINT, offsetof(SkinnedVertex, joints)};
+	attributes[2] = {4, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(SkinnedVertex, weights)};
+
+	VkPipelineVertexInputStateCreateInfo vertexInput{};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInput.vertexBindingDescriptionCount = 2;
+	vertexInput.pVertexBindingDescriptions = bindings;
+	vertexInput.vertexAttributeDescriptionCount = 3;
+	vertexInput.pVertexAttributeDescriptions = attributes;
+
+	return buildShadowPipeline("build/shaders/shadow.spv", vertexInput, pipelineLayout);
+}
+
+// Солнце, границы и матрицы каскадов - после данных освещения; вид и проекция каждого каскада -
+// в своей копии данных сцены, её выбирает динамическое смещение при отрисовке заслонок
+void Vulkan::updateShadows(FrameContext& frame, char* uniformData) {
+	glm::vec4 sun(-shadowCascades.direction(), shadowPipeline != VK_NULL_HANDLE ? SUN_INTENSITY : 0.0f);
+	glm::vec4 splits(0.0f);
+	glm::mat4 matrices[SHADOW_CASCADES];
+	for (glm::mat4& matrix : matrices)
+		matrix = glm::mat4(1.0f);
+
+	if (shadowPipeline != VK_NULL_HANDLE) {
+		// Угол обзора и стороны - из проекции кадра (p11 < 0 из-за отражённого Y)
+		float tanHalfFovY = 1.0f / std::abs(lightFrustum.p11);
+		float aspect = std::abs(lightFrustum.p11) / lightFrustum.p00;
+		// Маска копится до записи прохода: кадр, пропущенный при захвате изображения, её не теряет
+		shadowRedraw |= shadowCascades.update(viewMatrix, tanHalfFovY, aspect, lightFrustum.znear, lightFrustum.zfar, terrain.revision());
+		splits = shadowCascades.splits();
+		for (uint32_t i = 0; i < SHADOW_CASCADES; i++)
+			matrices[i] = shadowMatrix(shadowCascades.cascade(i));
+	}
+
+	// Смещения по std140: vec4 выровнен по 16 байтам после ambient
+	char* shadowing = uniformData + 3 * sizeof(glm::mat4) + 8 * sizeof(float);
+	memcpy(shadowing, &sun, sizeof(glm::vec4));
+	memcpy(shadowing + sizeof(glm::vec4), &splits, sizeof(glm::vec4));
+	memcpy(shadowing + 2 * sizeof(glm::vec4), matrices, sizeof(matrices));
+
+	if (shadowPipeline == VK_NULL_HANDLE)
+		return;
+
+	for (uint32_t i = 0; i < SHADOW_CASCADES; i++) {
+		const ShadowCascade& cascade = shadowCascades.cascade(i);
+		VkDeviceSize offset;
+		char* cascadeData = static_cast<char*>(frame.uniforms.allocate(uniformSize, offset));
+		memcpy(cascadeData, uniformData, static_cast<size_t>(uniformSize));
+		memcpy(cascadeData + sizeof(glm::mat4), &cascade.view, sizeof(glm::mat4));
+		memcpy(cascadeData + 2 * sizeof(glm::mat4), &cascade.proj, sizeof(glm::mat4));
+		shadowUniformOffsets[i] = static_cast<uint32_t>(offset);
+	}
+	cullShadowCasters();
+}
+
+// Вызывается после ожидания кадра: участки кадра свободны. Сфера экземпляра проверяется
+// против объёма каждого каскада; порядок экземпляров в списках сохраняется
+void Vulkan::cullShadowCasters() {
+	if (!crowdShadowBuffer.valid())
+		return;
+	PROFILE_FUNCTION();
+
+	glm::vec3 bounds = glm::vec3(crowdBounds);
+	workers.parallelFor(0, scene.crowd, SHADOW_CULL_GRAIN, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const glm::vec4& placement = crowdInstances[i].placement;
+			float s = std::sin(placement.w);
+			float c = std::cos(placement.w);
+			glm::vec3 center = glm::vec3(c * bounds.x + s * bounds.z, bounds.y, -s * bounds.x + c * bounds.z) + glm::vec3(placement);
+			uint8_t mask = 0;
+			for (uint32_t cascade = 0; cascade < SHADOW_CASCADES; cascade++)
+				if (cascadeTouches(shadowCascades.cascade(cascade), center, crowdBounds.w))
+					mask |= static_cast<uint8_t>(1u << cascade);
+			crowdShadowMask[i] = mask;
+		}
+	});
+
+	char* mapped = static_cast<char*>(registry.map(crowdShadowBuffer));
+	for (uint32_t cascade = 0; cascade < SHADOW_CASCADES; cascade++) {
+		crowdShadowOffsets[cascade] = sizeof(CrowdInstance) * scene.crowd * (currentFrame * SHADOW_CASCADES + cascade);
+		CrowdInstance* target = reinterpret_cast<CrowdInstance*>(mapped + crowdShadowOffsets[cascade]);
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < scene.crowd; i++)
+			if (crowdShadowMask[i] & (1u << cascade))
+				target[count++] = crowdInstances[i];
+		crowdShadowCounts[cascade] = count;
+	}
+}
+
+// Слой карты - единственное вложение; область просмотра - весь слой
+static void beginShadowRendering(VkCommandBuffer commandBuffer, VkImageView view, VkAttachmentLoadOp loadOp) {
+	VkRenderingAttachmentInfo depthAttachment{};
+	depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	depthAttachment.imageView = view;
+	depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.loadOp = loadOp;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.clearValue.depthStencil = {1.0f, 0};
+
+	VkRenderingInfo renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderingInfo.renderArea.extent = {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE};
+	renderingInfo.layerCount = 1;
+	renderingInfo.pDepthAttachment = &depthAttachment;
+	vkCmdBeginRendering(commandBuffer, &renderingInfo);
+
+	VkViewport viewport{};
+	viewport.width = static_cast<float>(SHADOW_MAP_SIZE);
+	viewport.height = static_cast<float>(SHADOW_MAP_SIZE);
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.extent = {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE};
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+// Проход графа: граф перевёл карту во вложение глубины, слои между вложением и копированием
+// переводит сам проход. Ландшафт кэшируемых каскадов перерисовывается по маске shadowRedraw,
+// остальное время его глубина только копируется
+void Vulkan::recordShadows(VkCommandBuffer commandBuffer) {
+	if (shadowPipeline == VK_NULL_HANDLE)
+		return;
+
+	VkImage map = registry.image(shadowMap);
+	VkImage staticMap = registry.image(shadowStaticMap);
+	const uint32_t cached = SHADOW_CASCADES - SHADOW_CACHED_FROM;
+
+	for (uint32_t i = SHADOW_CACHED_FROM; i < SHADOW_CASCADES; i++) {
+		if (!(shadowRedraw & (1u << i)))
+			continue;
+		uint32_t layer = i - SHADOW_CACHED_FROM;
+		tracker.use(staticMap, resourceState(ResourceUsage::DepthAttachment), 0, 1, layer, 1);
+		tracker.flush(commandBuffer);
+		beginShadowRendering(commandBuffer, registry.view(shadowStaticViews[layer]), VK_ATTACHMENT_LOAD_OP_CLEAR);
+		recordTerrain(commandBuffer, terrainShadowPipeline, shadowUniformOffsets[i]);
+		vkCmdEndRendering(commandBuffer);
+	}
+	shadowRedraw = 0;
+
+	tracker.use(staticMap, resourceState(ResourceUsage::TransferSrc), 0, 1, 0, cached);
+	tracker.use(map, resourceState(ResourceUsage::TransferDst), 0, 1, SHADOW_CACHED_FROM, cached);
+	tracker.flush(commandBuffer);
+
+	VkImageCopy region{};
+	region.srcSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, cached};
+	region.dstSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, SHADOW_CACHED_FROM, cached};
+	region.extent = {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 1};
+	vkCmdCopyImage(commandBuffer, staticMap, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, map, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	tracker.use(map, resourceState(ResourceUsage::DepthAttachment), 0, 1, SHADOW_CACHED_FROM, cached);
+	tracker.flush(commandBuffer);
+
+	for (uint32_t i = 0; i < SHADOW_CASCADES; i++) {
+		bool cachedCascade = i >= SHADOW_CACHED_FROM;
+		beginShadowRendering(commandBuffer, registry.view(shadowLayerViews[i]),
+					cachedCascade ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR);
+		recordShadowCasters(commandBuffer, i, !cachedCascade);
+		vkCmdEndRendering(commandBuffer);
+	}
+}
+
+// Заслонки каскада: модель, экземпляры толпы, задевающие каскад (cullShadowCasters), и ландшафт
+void Vulkan::recordShadowCasters(VkCommandBuffer commandBuffer, uint32_t cascade, bool terrainCasters) {
+	uint32_t dynamicOffsets[] = {shadowUniformOffsets[cascade], paletteOffset};
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowPipeline);
+	VkBuffer vertexBuffers[] = {registry.buffer(modelVertexBuffer), registry.buffer(modelSkinBuffer), VK_NULL_HANDLE};
+	VkDeviceSize offsets[] = {0, 0, 0};
+	vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, registry.buffer(modelIndexBuffer), 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 2, dynamicOffsets);
+	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(modelIndices.size()), 1, 0, 0, 0);
+
+	if (crowdShadowPipeline != VK_NULL_HANDLE && crowdShadowCounts[cascade] > 0) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, crowdShadowPipeline);
+		vertexBuffers[2] = registry.buffer(crowdShadowBuffer);
+		offsets[2] = crowdShadowOffsets[cascade];
+		vkCmdBindVertexBuffers(commandBuffer, 0, 3, vertexBuffers, offsets);
+		VkDescriptorSet sets[] = {descriptorSet, crowdSet};
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, crowdPipelineLayout, 0, 2, sets, 2, dynamicOffsets);
+		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(modelIndices.size()), crowdShadowCounts[cascade], 0, 0, 0);
+	}
+
+	if (terrainCasters)
+		recordTerrain(commandBuffer, terrainShadowPipeline, shadowUniformOffsets[cascade]);
+}
+
+void Vulkan::destroyShadows() {
+	VkPipeline pipelines[] = {shadowPipeline, crowdShadowPipeline, terrainShadowPipeline};
+	for (VkPipeline pipeline : pipelines)
+		if (pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+	if (shadowSampler != VK_NULL_HANDLE)
+		vkDestroySampler(logicalDevice, shadowSampler, nullptr);
+}
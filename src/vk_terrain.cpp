@@ -0,0 +1,173 @@
+#include "vk.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+// Push-константы блока кольца
+typedef struct _TerrainParams
+{
+	glm::ivec2 origin; // угол сетки уровня в вершинах уровня
+	glm::ivec2 offset; // первая ячейка блока
+	uint32_t level;
+	float spacing;
+	uint32_t morph; // 1 - край уровня перетекает в высоты следующего, у внешнего кольца 0
+} TerrainParams;
+
+static const VkDeviceSize TERRAIN_FRAME_UPLOAD = sizeof(float) * TERRAIN_LEVELS * TERRAIN_WINDOW * TERRAIN_WINDOW; // все слои целиком
+
+void Vulkan::createTerrain() {
+	PROFILE_FUNCTION();
+	terrain.start(scene.terrain);
+	farPlane = terrain.extent();
+
+	// Слой на уровень; тексели читаются texelFetch, фильтрация не нужна
+	terrainImage = registry.createImage(TERRAIN_WINDOW, TERRAIN_WINDOW, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				1, TERRAIN_LEVELS);
+	terrainView = registry.createImageView(terrainImage, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, 1, 0, TERRAIN_LEVELS);
+	tracker.trackImage(registry.image(terrainImage), VK_IMAGE_ASPECT_COLOR_BIT, 1, TERRAIN_LEVELS);
+	renderGraph.bindImage(terrainResource, registry.image(terrainImage), registry.view(terrainView));
+
+	terrainStaging = registry.createBuffer(TERRAIN_FRAME_UPLOAD * states.FRAMES_IN_FLIGHT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &terrainSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create terrain descriptor set layout");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &terrainSetLayout;
+	if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, &terrainSet) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to allocate terrain descriptor set");
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = registry.view(terrainView);
+	imageInfo.sampler = textureSampler;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = terrainSet;
+	write.dstBinding = 0;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.descriptorCount = 1;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+
+	VkDescriptorSetLayout setLayouts[] = {descriptorSetLayout, terrainSetLayout};
+	VkPushConstantRange range = {VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(TerrainParams)};
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 2;
+	pipelineLayoutInfo.pSetLayouts = setLayouts;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &range;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &terrainPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Unable to create terrain pipeline layout");
+	}
+
+	terrainPipeline = buildTerrainPipeline();
+}
+
+// Как и сетка высот - без вершинных привязок, вершины строятся по номерам
+VkPipeline Vulkan::buildTerrainPipeline(bool shadow) {
+	VkPipelineVertexInputStateCreateInfo vertexInput{};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	if (shadow)
+		return buildShadowPipeline("build/shaders/terrain_vert.spv", vertexInput, terrainPipelineLayout,
+								VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+	return buildGraphicsPipeline("build/shaders/terrain_vert.spv", "build/shaders/terrain_frag.spv",
+								&vertexInput, terrainPipelineLayout, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+}
+
+// Вызывается после ожидания кадра: его участок буфера загрузки свободен
+void Vulkan::updateTerrain() {
+	if (terrainPipeline == VK_NULL_HANDLE)
+		return;
+
+	// Загрузки прошлого вызова не записаны: кадр пропущен (устаревший список показа), а начала
+	// уровней уже сдвинуты. Эти уровни загружаются заново целиком - буфер загрузки вмещает все слои
+	for (const VkBufferImageCopy& copy : terrainCopies)
+		terrain.reload(copy.imageSubresource.baseArrayLayer);
+	terrainCopies.clear();
+
+	terrain.update(cameraPos, terrainUploads, terrainHeights);
+	terrain.blocks(terrainBlocks);
+
+	VkDeviceSize frameOffset = TERRAIN_FRAME_UPLOAD * currentFrame;
+	if (!terrainHeights.empty())
+		memcpy(static_cast<char*>(registry.map(terrainStaging)) + frameOffset, terrainHeights.data(), terrainHeights.size() * sizeof(float));
+
+	for (const TerrainUpload& upload : terrainUploads) {
+		VkBufferImageCopy copy{};
+		copy.bufferOffset = frameOffset + upload.offset * sizeof(float);
+		copy.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, upload.level, 1};
+		copy.imageOffset = {static_cast<int32_t>(upload.x), static_cast<int32_t>(upload.z), 0};
+		copy.imageExtent = {upload.width, upload.height, 1};
+		terrainCopies.push_back(copy);
+	}
+}
+
+// Проход графа: открывшиеся ряды и столбцы слоёв
+void Vulkan::recordTerrainUpload(VkCommandBuffer commandBuffer) {
+	if (terrainCopies.empty())
+		return;
+
+	vkCmdCopyBufferToImage(commandBuffer, registry.buffer(terrainStaging), registry.image(terrainImage),
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(terrainCopies.size()), terrainCopies.data());
+	terrainCopies.clear(); // записаны: следующий updateTerrain() не считает их потерянными
+}
+
+// Блок кольца - экземпляры-столбцы полос треугольников; область просмотра уже задана проходом сцены
+void Vulkan::recordTerrain(VkCommandBuffer commandBuffer) {
+	recordTerrain(commandBuffer, terrainPipeline, sceneUniformOffset);
+}
+
+// Те же блоки конвейером и однородными данными каскада теней
+void Vulkan::recordTerrain(VkCommandBuffer commandBuffer, VkPipeline pipeline, uint32_t uniformOffset) {
+	if (pipeline == VK_NULL_HANDLE)
+		return;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+	VkDescriptorSet sets[] = {descriptorSet, terrainSet};
+	uint32_t dynamicOffsets[] = {uniformOffset, paletteOffset};
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, terrainPipelineLayout,
+							0, 2, sets, 2, dynamicOffsets);
+
+	for (const TerrainBlock& block : terrainBlocks) {
+		if (block.cells.x == 0 || block.cells.y == 0)
+			continue;
+
+		TerrainParams params = {block.origin, block.offset, block.level, terrain.spacing(block.level),
+								block.level + 1 < TERRAIN_LEVELS ? 1u : 0u};
+		vkCmdPushConstants(commandBuffer, terrainPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(params), &params);
+		vkCmdDraw(commandBuffer, 2 * (block.cells.y + 1), block.cells.x, 0, 0);
+	}
+}
+
+void Vulkan::destroyTerrain() {
+	terrain.stop();
+	if (terrainPipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(logicalDevice, terrainPipeline, nullptr);
+	if (terrainPipelineLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(logicalDevice, terrainPipelineLayout, nullptr);
+	if (terrainSetLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(logicalDevice, terrainSetLayout, nullptr);
+}
@@ -8,14 +8,19 @@
 
 #include "macroses.hpp"
 
+#include "assimp/config.h"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>  // Для rotate, lookAt, perspective
 #include <glm/gtc/type_ptr.hpp>         // Для работы с матрицами
 
 void Vulkan::loadModel(const std::string& path) {
+	PROFILE_FUNCTION();
 	Assimp::Importer importer;
+	// Вспомогательные узлы поворотных точек FBX не создаются: каналы анимации ложатся прямо на суставы
+	importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
 	const aiScene* scene = importer.ReadFile(path,
-		aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
+		aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals | aiProcess_LimitBoneWeights);
 
 	if (!scene || !scene->mRootNode) {
 		throw std::runtime_error("Failed to load model: " + std::string(importer.GetErrorString()));
@@ -51,6 +56,21 @@ void Vulkan::loadModel(const std::string& path) {
 			modelIndices.push_back(face.mIndices[j]);
 		}
 	}
+
+	// Скелет, веса вершин и клипы самой модели
+	loadSkeleton(scene, mesh, skeleton, modelSkin);
+	loadAnimationClips(scene, skeleton, clips);
+}
+
+// Клипы из отдельного файла: каналы сопоставляются суставам по именам узлов
+void Vulkan::loadAnimations(const std::string& path) {
+	Assimp::Importer importer;
+	importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
+	const aiScene* scene = importer.ReadFile(path, 0);
+	if (!scene) {
+		throw std::runtime_error("Failed to load animations: " + std::string(importer.GetErrorString()));
+	}
+	loadAnimationClips(scene, skeleton, clips);
 }
 
 glm::vec3 hsvToRgb(glm::vec3 in) {
@@ -106,109 +126,163 @@ glm::vec3 hsvToRgb(glm::vec3 in) {
 	}
 	return out;
 }
+// Ожидание, пока GPU освободит ресурсы следующего кадра. Вызывается до чтения ввода,
+// чтобы ввод сэмплировался непосредственно перед записью кадра
+void Vulkan::waitForFrame() {
+	timeline.wait(frames[currentFrame].timelineValue);
+}
+
 // Рендер кадра
 void Vulkan::renderFrame() {
-	// 1. Обновляем камеру (WASD + пробел/Ctrl)
-	const float cameraSpeed = 2.5f * deltaTime;
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) cameraPos += cameraSpeed * cameraFront;
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) cameraPos -= cameraSpeed * cameraFront;
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) cameraPos += cameraSpeed * cameraUp;
-	if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) cameraPos -= cameraSpeed * cameraUp;
+	PROFILE_FUNCTION();
+	PROFILE_PHASES(phase, "input");
+
+	// 1. Передаём кнопки симуляции (GLFW опрашивается в потоке окна) и берём интерполированное состояние
+	uint32_t buttons = 0;
+	if (window) {
+		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) buttons |= INPUT_FORWARD;
+		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) buttons |= INPUT_BACK;
+		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) buttons |= INPUT_LEFT;
+		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) buttons |= INPUT_RIGHT;
+		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) buttons |= INPUT_UP;
+		if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) buttons |= INPUT_DOWN;
+	}
+	simulation.setInput(buttons);
+
+	SimulationState state = simulation.sample();
+	cameraPos = state.cameraPos;
+	cameraFront = state.cameraFront;
+	cameraUp = state.cameraUp;
+	animationTime = state.animationTime;
+	if (fixedTimeStep > 0.0f)
+		animationTime = fixedFrame++ * fixedTimeStep; // кадры захвата не зависят от скорости рендера
 
 	// 2. Обновляем матрицы
-	modelMatrix = glm::rotate(glm::mat4(1.0f), animationTime * glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	PROFILE_NEXT(phase, "matrices");
+	// Поза модели: выборка клипов и палитра в рабочих потоках
+	animator.update(animationTime - previousAnimationTime, &workers);
+	previousAnimationTime = animationTime;
+
+	sceneGraph.setLocal(modelNode, glm::rotate(glm::mat4(1.0f), animationTime * glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+	sceneGraph.update(&workers);
+	modelMatrix = sceneGraph.world(modelNode);
 	viewMatrix = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-	projMatrix = glm::perspective(glm::radians(45.0f), surface.selectedExtent.width / (float)surface.selectedExtent.height, 0.1f, 100.0f);
+	projMatrix = glm::perspective(glm::radians(45.0f), surface.selectedExtent.width / (float)surface.selectedExtent.height, 0.1f, farPlane);
 	projMatrix[1][1] *= -1; // Инвертируем Y для Vulkan
-
-	// 3. Копируем матрицы в uniform buffer
-	memcpy(uniformBufferMapped, &modelMatrix, sizeof(glm::mat4));
-	memcpy((char*)uniformBufferMapped + sizeof(glm::mat4), &viewMatrix, sizeof(glm::mat4));
-	memcpy((char*)uniformBufferMapped + 2*sizeof(glm::mat4), &projMatrix, sizeof(glm::mat4));
-	memcpy((char*)uniformBufferMapped + 3*sizeof(glm::mat4), &animationTime, sizeof(float));
-
-	// 1. Обновляем таймер анимации
-	animationTime += deltaTime;
-
-	vkWaitForFences(logicalDevice, 1, &inWorkFences[currentFrame], VK_TRUE, UINT64_MAX);
-	vkResetFences(logicalDevice, 1, &inWorkFences[currentFrame]);
-
+	lightFrustum = clusterFrustum(viewMatrix, projMatrix);
+
+	FrameContext& frame = frames[currentFrame];
+
+	PROFILE_NEXT(phase, "frame wait");
+	timeline.wait(frame.timelineValue);
+
+	// Ресурсы, значения шкалы которых GPU уже достиг, больше не используются
+	registry.collect();
+	capture.poll(); // Готовые буферы захвата - на кодирование
+	readLightOverflow(); // Переполненные кластеры прошлого кадра слота
+
+	// 3. Копируем матрицы в участок uniform buffer этого кадра: предыдущий кадр может ещё читать свой
+	frame.uniforms.reset();
+	VkDeviceSize uniformOffset;
+	char* uniformData = static_cast<char*>(frame.uniforms.allocate(uniformSize, uniformOffset));
+	memcpy(uniformData, &modelMatrix, sizeof(glm::mat4));
+	memcpy(uniformData + sizeof(glm::mat4), &viewMatrix, sizeof(glm::mat4));
+	memcpy(uniformData + 2*sizeof(glm::mat4), &projMatrix, sizeof(glm::mat4));
+	memcpy(uniformData + 3*sizeof(glm::mat4), &animationTime, sizeof(float));
+	writeLightingUniforms(uniformData);
+	sceneUniformOffset = static_cast<uint32_t>(uniformOffset);
+	updateShadows(frame, uniformData); // Каскады и их копии данных сцены
+
+	// Палитра суставов модели; участок полного размера - его читает дескриптор
+	char* paletteData = static_cast<char*>(frame.uniforms.allocate(paletteSize, uniformOffset));
+	memcpy(paletteData, animator.palette(modelAnimation), skeleton.size() * sizeof(glm::mat4));
+	paletteOffset = static_cast<uint32_t>(uniformOffset);
+
+	updateTerrain(); // Высоты открывшихся рядов - в участок загрузки этого кадра
+	cullCrowdOnCpu(); // Видимые экземпляры толпы - в участок этого кадра
+	updateParticles(); // Шаг и запрос рождений частиц - push-константы проходов
+
+	PROFILE_NEXT(phase, "acquire");
 	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(logicalDevice, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("Unable to acquire swap chain image");
+	VkResult result = VK_SUCCESS;
+	if (headless) {
+		// Внеэкранные изображения по кругу
+		imageIndex = nextOffscreenImage;
+		nextOffscreenImage = (nextOffscreenImage + 1) % swapChainImages.size();
+	} else {
+		result = vkAcquireNextImageKHR(logicalDevice, swapChain, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+
+		// Устаревший список показа: семафор захвата не сигналится, кадр пропускается.
+		// При SUBOPTIMAL изображение захвачено - кадр рисуется, пересоздание после показа
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+			recreateSwapchain();
+			return;
+		}
+		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+			throw std::runtime_error("Unable to acquire swap chain image");
+		}
 	}
 
-	vkResetCommandBuffer(commandBuffers[currentFrame], 0);
+	// Изображение может ещё использоваться другим кадром в работе (кадров больше, чем изображений,
+	// или изображения возвращаются не по порядку)
+	timeline.wait(imageValues[imageIndex]);
+
+	PROFILE_NEXT(phase, "record");
+	vkResetCommandPool(logicalDevice, frame.commandPool, 0);
 	VkCommandBufferBeginInfo beginInfo{};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-	if (vkBeginCommandBuffer(commandBuffers[currentFrame], &beginInfo) != VK_SUCCESS) {
+	if (vkBeginCommandBuffer(frame.commandBuffer, &beginInfo) != VK_SUCCESS) {
 		throw std::runtime_error("Unable to begin recording command buffer");
 	}
 
-	VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
-
-    std::array<VkClearValue, 2> clearValues{};
-    clearValues[0].color = {0.0f, 0.0f, 0.0f, 1.0f};
-    clearValues[1].depthStencil = {1.0f, 0}; // Глубина очищается в 1.0 (дальняя плоскость)
-
-	VkRenderPassBeginInfo renderPassInfo{};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = renderPass;
-	renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
-	renderPassInfo.renderArea.offset = {0, 0};
-	renderPassInfo.renderArea.extent = surface.selectedExtent;
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
-
-	vkCmdBeginRenderPass(commandBuffers[currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-	vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-
-	VkBuffer vertexBuffers[] = {modelVertexBuffer};
-	VkDeviceSize offsets[] = {0};
+	// Прошлый кадр этого слота завершён - профилировщик читает его замеры без ожидания,
+	// регулятор по времени GPU выбирает разрешение этого кадра
+	profiler.beginFrame(frame.commandBuffer, currentFrame);
+	resolution.update(profiler.frameTime());
+	renderExtent = states.DYNAMIC_RESOLUTION && !capture.active() ? resolution.extent(surface.selectedExtent) : surface.selectedExtent;
 
-	vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
-	vkCmdBindIndexBuffer(commandBuffers[currentFrame], modelIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	// Граница кадра: подмена перезагруженных конвейеров и текстур
+	if (states.HOT_RELOAD)
+		hotReload.applyPending(frame.commandBuffer);
+	updateSceneSet(frame); // Текстура, перезагруженная в кадре другого слота
+	updatePyramidSets(frame); // Пирамида, пересозданная вместе с графом
 
-	vkCmdBindDescriptorSets(commandBuffers[currentFrame],
-						  VK_PIPELINE_BIND_POINT_GRAPHICS,
-						  pipelineLayout,
-						  0, 1, &descriptorSet,
-						  0, nullptr);
+	// Проходы кадра: барьеры, проходы рендера и буферы кадра строит граф
+	renderGraph.bindImage(backbuffer, swapChainImages[imageIndex], swapChainImageViews[imageIndex]);
+	renderGraph.execute(frame.commandBuffer);
+	capture.record(frame.commandBuffer, swapChainImages[imageIndex], surface.selectedExtent,
+				headless ? ResourceUsage::TransferSrc : ResourceUsage::Present);
 
-	vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(modelIndices.size()), 1, 0, 0, 0);
+	profiler.endFrame(frame.commandBuffer);
 
-	vkCmdEndRenderPass(commandBuffers[currentFrame]);
-
-	if (vkEndCommandBuffer(commandBuffers[currentFrame]) != VK_SUCCESS) {
+	if (vkEndCommandBuffer(frame.commandBuffer) != VK_SUCCESS) {
 		throw std::runtime_error("Unable to record command buffer");
 	}
 
-	VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
-
-	if (vkQueueSubmit(queue.descriptor, 1, &submitInfo, inWorkFences[currentFrame]) != VK_SUCCESS) {
-		throw std::runtime_error("Unable to submit draw command buffer");
+	PROFILE_NEXT(phase, "submit");
+	// Захват и показ работают только с бинарными семафорами; завершение кадра - значение шкалы
+	VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[imageIndex]};
+	std::vector<VkSemaphoreSubmitInfo> waits, signals;
+	if (!headless) {
+		waits.push_back(GpuTimeline::binary(frame.imageAvailable, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT));
+		signals.push_back(GpuTimeline::binary(signalSemaphores[0], VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT));
 	}
+	uint64_t value = timeline.submit(frame.commandBuffer, waits, signals);
+	frame.timelineValue = value;
+	imageValues[imageIndex] = value;
+	capture.submitted(value);
+
+	// Освобождённое во время записи уничтожается после выполнения этого кадра
+	registry.seal(value);
+
+	currentFrame = (currentFrame + 1) % states.FRAMES_IN_FLIGHT;
 
-	currentFrame = (currentFrame + 1) % surface.imageCount;
+	if (headless)
+		return; // показывать некуда
 
+	PROFILE_NEXT(phase, "present");
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.waitSemaphoreCount = 1;
@@ -217,11 +291,67 @@ void Vulkan::renderFrame() {
 	presentInfo.pSwapchains = &swapChain;
 	presentInfo.pImageIndices = &imageIndex;
 
-	if (vkQueuePresentKHR(queue.descriptor, &presentInfo) != VK_SUCCESS) {
+	result = vkQueuePresentKHR(queue.descriptor, &presentInfo);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
+		recreateSwapchain();
+	} else if (result != VK_SUCCESS) {
 		throw std::runtime_error("Unable to present swap chain image");
+	} else {
+		releaseRetiredSwapchains(); // Показ из текущего списка в очереди после показов из заменённых
 	}
 }
 
+// Отрисовка модели в проходе сцены
+void Vulkan::recordScene(VkCommandBuffer commandBuffer) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+	setSceneViewport(commandBuffer);
+
+	VkBuffer vertexBuffers[] = {registry.buffer(modelVertexBuffer), registry.buffer(modelSkinBuffer)};
+	VkDeviceSize offsets[] = {0, 0};
+
+	vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, registry.buffer(modelIndexBuffer), 0, VK_INDEX_TYPE_UINT32);
+
+	uint32_t dynamicOffsets[] = {sceneUniformOffset, paletteOffset}; // по порядку привязок
+	vkCmdBindDescriptorSets(commandBuffer,
+						  VK_PIPELINE_BIND_POINT_GRAPHICS,
+						  pipelineLayout,
+						  0, 1, &descriptorSet,
+						  2, dynamicOffsets);
+
+	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(modelIndices.size()), 1, 0, 0, 0);
+
+	recordCrowd(commandBuffer, CullPhase::Early);
+	recordHeightfield(commandBuffer);
+	recordTerrain(commandBuffer);
+}
+
+// Динамические область просмотра и отсечение по внутреннему разрешению кадра
+void Vulkan::setSceneViewport(VkCommandBuffer commandBuffer) {
+	VkViewport viewport{};
+	viewport.width = static_cast<float>(renderExtent.width);
+	viewport.height = static_cast<float>(renderExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.extent = renderExtent;
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
 glm::vec3 Vulkan::getCameraPos() const {
 	return cameraPos;
-}
\ No newline at end of file
+}
+
+void Vulkan::startCapture(const std::string& directory, CaptureFormat format) {
+	if (!headless && !(surface.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+		throw std::runtime_error("Swap chain images can't be copied for capture");
+	capture.start(directory, format, surface.selectedExtent, surface.selectedFormat.format,
+				states.FRAMES_IN_FLIGHT + 2); // кадры в работе и два кодируемых
+}
+
+uint32_t Vulkan::finishCapture() {
+	capture.finish();
+	return capture.written();
+}